@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+Prebuilt artifact cache for Arrow and dependency installs
+
+A finished install tree is packed into a content-addressed archive, named
+after a hash of everything that went into the build: the source commit,
+the CMake options, the compiler, the profile and the platform. Archives
+are kept in ~/.doracxx/artifacts, so an install removed by `doracxx clean`
+comes back without rebuilding. They can also be pulled from and pushed to
+a shared remote, configured by the [artifacts] section:
+
+    remote = "https://cache.example.com/doracxx"   # GET, and PUT when pushing
+    remote = "s3://bucket/doracxx"                 # through the aws CLI
+    remote = "/mnt/shared/doracxx"                 # or file:///mnt/shared/doracxx
+
+so a fresh builder downloads a prebuilt Arrow instead of compiling it.
+HTTP requests send DORACXX_ARTIFACTS_TOKEN, when set, as a bearer token.
+
+Install trees are archived relative to their root and restored at the
+same place in the cache; the files doracxx uses (headers, libraries and
+CMake package files) do not depend on where the cache is.
+"""
+
+import hashlib
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tarfile
+import urllib.request
+from pathlib import Path
+from typing import Optional
+
+try:
+    from .cache import get_doracxx_cache_dir
+    from .toolchain import compiler_version
+except ImportError:
+    from cache import get_doracxx_cache_dir
+    from toolchain import compiler_version
+
+ARTIFACTS_DIR = "artifacts"
+ARCHIVE_SUFFIX = ".tar.gz"
+
+
+def artifact_name(kind: str, **inputs) -> str:
+    """Archive name for an install of kind built from inputs (JSON-serializable values)"""
+    inputs = dict(inputs, platform=f"{sys.platform}-{platform.machine().lower()}")
+    digest = hashlib.sha256(json.dumps(inputs, sort_keys=True).encode("utf-8")).hexdigest()
+    return f"{kind}-{digest[:32]}"
+
+
+def cmake_compiler_identity(cxx_compiler: Optional[str] = None) -> str:
+    """Version banner of the C++ compiler CMake will pick (cxx_compiler, else $CXX, else the default)"""
+    compiler = cxx_compiler or os.environ.get("CXX")
+    if not compiler:
+        for candidate in (["cl"] if os.name == "nt" else []) + ["c++", "g++", "clang++"]:
+            if shutil.which(candidate):
+                compiler = candidate
+                break
+    if not compiler:
+        return "unknown"
+    kind = "msvc" if Path(compiler).stem.lower() == "cl" else "gcc"
+    return compiler_version(shutil.which(compiler) or compiler, kind).splitlines()[0]
+
+
+def _safe_extract(archive: Path, dest: Path):
+    with tarfile.open(archive, "r:gz") as tar:
+        if hasattr(tarfile, "data_filter"):
+            tar.extractall(dest, filter="data")
+            return
+        root = dest.resolve()
+        for member in tar.getmembers():
+            target = (dest / member.name).resolve()
+            if root not in target.parents and target != root:
+                raise RuntimeError(f"unsafe path in {archive.name}: {member.name}")
+        tar.extractall(dest)
+
+
+class ArtifactStore:
+    """Local archive directory plus an optional remote to pull from and push to"""
+
+    def __init__(self, remote: Optional[str] = None, push: bool = False, enabled: bool = True,
+                 local_dir: Optional[Path] = None):
+        self.remote = remote.rstrip("/") if remote else None
+        self.push = push
+        self.enabled = enabled
+        self.local_dir = local_dir or get_doracxx_cache_dir() / ARTIFACTS_DIR
+
+    @classmethod
+    def from_config(cls, config) -> "ArtifactStore":
+        """Store for an ArtifactsConfig (None for the defaults)"""
+        if config is None:
+            return cls()
+        return cls(config.remote, config.push, config.enabled)
+
+    def restore(self, name: str, install_dir: Path) -> bool:
+        """Unpack the archive called name into install_dir, downloading it if needed; False if there is none"""
+        if not self.enabled:
+            return False
+        archive = self.local_dir / (name + ARCHIVE_SUFFIX)
+        if not archive.exists() and self.remote:
+            try:
+                self._download(name + ARCHIVE_SUFFIX, archive)
+            except Exception as e:
+                print(f"[ARTIFACT] {name} not available from {self.remote} ({e})")
+        if not archive.exists():
+            return False
+
+        tmp = install_dir.with_name(install_dir.name + f".restore{os.getpid()}")
+        shutil.rmtree(tmp, ignore_errors=True)
+        try:
+            _safe_extract(archive, tmp)
+            if install_dir.exists():
+                shutil.rmtree(install_dir)
+            os.replace(tmp, install_dir)
+        except (OSError, tarfile.TarError, RuntimeError) as e:
+            print(f"[WARN] Could not restore {archive}: {e}")
+            shutil.rmtree(tmp, ignore_errors=True)
+            archive.unlink(missing_ok=True)
+            return False
+        print(f"[ARTIFACT] Restored prebuilt {name} into {install_dir}")
+        return True
+
+    def save(self, name: str, install_dir: Path):
+        """Pack install_dir as the archive called name, and upload it when pushing"""
+        if not self.enabled or not install_dir.is_dir():
+            return
+        self.local_dir.mkdir(parents=True, exist_ok=True)
+        archive = self.local_dir / (name + ARCHIVE_SUFFIX)
+        tmp = archive.with_name(archive.name + f".tmp{os.getpid()}")
+        try:
+            with tarfile.open(tmp, "w:gz") as tar:
+                for item in sorted(install_dir.iterdir()):
+                    tar.add(item, arcname=item.name)
+            os.replace(tmp, archive)
+        except OSError as e:
+            print(f"[WARN] Could not archive {install_dir}: {e}")
+            tmp.unlink(missing_ok=True)
+            return
+        print(f"[ARTIFACT] Archived {install_dir} as {archive.name} ({archive.stat().st_size / (1024 * 1024):.1f} MB)")
+        if self.remote and self.push:
+            try:
+                self._upload(archive)
+                print(f"[ARTIFACT] Pushed {archive.name} to {self.remote}")
+            except Exception as e:
+                print(f"[WARN] Could not push {archive.name} to {self.remote}: {e}")
+
+    def _request(self, url: str, method: str = "GET", data=None) -> urllib.request.Request:
+        request = urllib.request.Request(url, data=data, method=method)
+        token = os.environ.get("DORACXX_ARTIFACTS_TOKEN")
+        if token:
+            request.add_header("Authorization", f"Bearer {token}")
+        return request
+
+    def _remote_dir(self) -> Path:
+        return Path(self.remote[len("file://"):] if self.remote.startswith("file://") else self.remote)
+
+    def _download(self, file_name: str, archive: Path):
+        archive.parent.mkdir(parents=True, exist_ok=True)
+        tmp = archive.with_name(archive.name + f".tmp{os.getpid()}")
+        try:
+            if self.remote.startswith(("http://", "https://")):
+                with urllib.request.urlopen(self._request(f"{self.remote}/{file_name}"), timeout=60) as response, \
+                        open(tmp, "wb") as out:
+                    shutil.copyfileobj(response, out)
+            elif self.remote.startswith("s3://"):
+                subprocess.run(["aws", "s3", "cp", "--only-show-errors", f"{self.remote}/{file_name}", str(tmp)],
+                               check=True)
+            else:
+                shutil.copyfile(self._remote_dir() / file_name, tmp)
+            os.replace(tmp, archive)
+            print(f"[ARTIFACT] Downloaded {file_name} from {self.remote}")
+        finally:
+            tmp.unlink(missing_ok=True)
+
+    def _upload(self, archive: Path):
+        if self.remote.startswith(("http://", "https://")):
+            with open(archive, "rb") as f:
+                request = self._request(f"{self.remote}/{archive.name}", "PUT", f)
+                request.add_header("Content-Length", str(archive.stat().st_size))
+                urllib.request.urlopen(request, timeout=300).close()
+        elif self.remote.startswith("s3://"):
+            subprocess.run(["aws", "s3", "cp", "--only-show-errors", str(archive), f"{self.remote}/{archive.name}"],
+                           check=True)
+        else:
+            remote_dir = self._remote_dir()
+            remote_dir.mkdir(parents=True, exist_ok=True)
+            tmp = remote_dir / f"{archive.name}.tmp{os.getpid()}"
+            shutil.copyfile(archive, tmp)
+            os.replace(tmp, remote_dir / archive.name)
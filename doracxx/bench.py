@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""
+Micro-benchmarks of a node's processing code: `doracxx bench`
+
+The node's sources, minus the ones defining main(), are built with the
+[bench] sources (DORACXX_BENCHMARK functions, see doracxx_bench.h) and a
+generated main into target/<profile>/<node>-bench. Running it feeds every
+benchmark synthetic or recorded inputs without a dataflow and reports
+throughput, latency percentiles and allocations per event. The results are
+written as JSON and compared against a baseline, failing when a benchmark got
+slower than [bench] max_regression allows, so CI catches regressions.
+"""
+
+import argparse
+import dataclasses
+import fnmatch
+import json
+import os
+import re
+import subprocess
+import sys
+from pathlib import Path
+from typing import List, Optional
+
+try:
+    from .build_cxx_node import compile_node, discover_node_sources
+    from .config import load_config, DoracxxConfig, find_project_root, validate_config
+    from .pch import write_if_changed
+except ImportError:
+    # When run directly, import from the same directory
+    sys.path.insert(0, str(Path(__file__).parent))
+    from build_cxx_node import compile_node, discover_node_sources
+    from config import load_config, DoracxxConfig, find_project_root, validate_config
+    from pch import write_if_changed
+
+BENCH_DIR = "bench"  # Under target/<profile>: manifest, objects, generated main, results
+BENCH_MAIN_SOURCE = "doracxx_bench_main.cc"
+BENCH_MAIN = """// Generated by doracxx bench: entry point of the bench executable
+#define DORACXX_BENCH_MAIN
+#include "doracxx_bench.h"
+"""
+
+_MAIN_RE = re.compile(r"^\s*(?:int|auto)\s+main\s*\(", re.MULTILINE)
+
+# Results compared against the baseline: key, label, whether higher is better
+COMPARED_METRICS = [
+    ("events_per_second", "throughput", True),
+    ("p50_ns", "p50 latency", False),
+    ("p99_ns", "p99 latency", False),
+    ("allocations_per_event", "allocations per event", False),
+]
+
+
+def defines_main(path: Path) -> bool:
+    """Whether a source file defines main(), and so cannot go into the bench executable"""
+    try:
+        return bool(_MAIN_RE.search(path.read_text(encoding="utf-8", errors="replace")))
+    except OSError:
+        return False
+
+
+def bench_sources(node_dir: Path, config: DoracxxConfig) -> List[Path]:
+    """Sources of the bench executable, without the generated main
+
+    The node's sources go in, except those defining main() and the ones
+    matching [bench] exclude_sources, followed by the [bench] sources.
+    """
+    srcs = []
+    for src in discover_node_sources(node_dir, config):
+        relative = src.relative_to(node_dir).as_posix()
+        if any(fnmatch.fnmatch(relative, pattern) for pattern in config.bench.exclude_sources):
+            print(f"[EXCLUDE] Excluding source file from the benchmarks: {relative}")
+        elif defines_main(src):
+            print(f"[BENCH] Leaving out {relative} (defines main)")
+        else:
+            srcs.append(src)
+
+    benchmarks = []
+    for pattern in config.bench.sources:
+        matched = sorted(node_dir.glob(pattern)) if any(c in pattern for c in "*?[") else [node_dir / pattern]
+        benchmarks.extend(p for p in matched if p.is_file() and p not in srcs and p not in benchmarks)
+    if not benchmarks:
+        raise RuntimeError(f"no benchmark sources found (looked for {', '.join(config.bench.sources)})")
+    return srcs + benchmarks
+
+
+def bench_build_config(config: DoracxxConfig, srcs: List[Path]) -> DoracxxConfig:
+    """The node's configuration, building srcs into a single executable
+
+    CPU variants and PGO are left out: the bench measures one build of the
+    code, and the node's profile data does not belong to it.
+    """
+    build = dataclasses.replace(config.build, sources=[str(src) for src in srcs], exclude_sources=None,
+                                cpu_variants=[], pgo=None)
+    return dataclasses.replace(config, build=build)
+
+
+def harness_args(config: DoracxxConfig, args: argparse.Namespace, node_dir: Path, results_path: Path) -> List[str]:
+    """Command line of the bench executable: [bench] settings, overridden by the CLI"""
+    bench = config.bench
+    sizes = args.sizes or ",".join(str(size) for size in bench.sizes)
+    rate = args.rate if args.rate is not None else bench.rate
+    cmd = ["--events", str(args.events or bench.events),
+           "--warmup", str(args.warmup if args.warmup is not None else bench.warmup),
+           "--sizes", sizes,
+           "--rate", f"{rate:g}",
+           "--json", str(results_path)]
+    replay = args.replay or bench.replay
+    if replay:
+        cmd += ["--replay", str(node_dir / replay)]
+    if args.realtime:
+        cmd.append("--realtime")
+    if args.filter:
+        cmd += ["--filter", args.filter]
+    return cmd
+
+
+def compare_results(results: dict, baseline: dict, max_regression: float) -> List[str]:
+    """Regressions of results against a baseline, one message each
+
+    A metric regresses when it is worse than the baseline by more than
+    max_regression percent; allocations also need to grow by at least one per
+    event, since a count does not jitter like a time. Benchmarks only present
+    on one side are not compared.
+    """
+    previous = {bench["name"]: bench for bench in baseline.get("benchmarks", [])}
+    margin = max_regression / 100.0
+    regressions = []
+    for bench in results.get("benchmarks", []):
+        old = previous.get(bench["name"])
+        if old is None:
+            continue
+        for key, label, higher_is_better in COMPARED_METRICS:
+            before, after = old.get(key), bench.get(key)
+            if before is None or after is None:
+                continue
+            if higher_is_better:
+                worse = after < before * (1 - margin)
+            else:
+                worse = after > before * (1 + margin)
+            if key == "allocations_per_event":
+                worse = worse and after - before >= 1
+            if worse:
+                change = (after - before) / before * 100 if before else float("inf")
+                regressions.append(f"{bench['name']}: {label} {before:g} -> {after:g} ({change:+.1f}%)")
+    return regressions
+
+
+def print_comparison(results: dict, baseline: dict):
+    """Print how each benchmark changed since the baseline"""
+    previous = {bench["name"]: bench for bench in baseline.get("benchmarks", [])}
+    for bench in results.get("benchmarks", []):
+        old = previous.get(bench["name"])
+        if old is None:
+            print(f"[BENCH] {bench['name']}: not in the baseline")
+            continue
+        changes = []
+        for key, label, _ in COMPARED_METRICS:
+            before, after = old.get(key), bench.get(key)
+            if before and after is not None:
+                changes.append(f"{label} {(after - before) / before * 100:+.1f}%")
+            elif before is not None and after is not None:
+                changes.append(f"{label} {before:g} -> {after:g}")
+        print(f"[BENCH] {bench['name']}: {', '.join(changes)}")
+
+
+def find_node_dir(node_dir: Optional[str]) -> Path:
+    """--node-dir, or the current directory or project root holding doracxx.toml"""
+    if node_dir:
+        return Path(node_dir).resolve()
+    current_dir = Path.cwd()
+    for candidate in [current_dir, find_project_root(current_dir)]:
+        if (candidate / "doracxx.toml").exists():
+            print(f"[AUTO] Auto-detected node directory: {candidate}")
+            return candidate
+    print("[ERROR] No doracxx.toml found in current directory or project root.")
+    print("   Please specify --node-dir or run from a directory containing doracxx.toml")
+    sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(prog="doracxx bench",
+                                     description="Build and run the node's DORACXX_BENCHMARK micro-benchmarks")
+    parser.add_argument("--node-dir", default=None, help="directory containing the node (defaults to current directory if it contains doracxx.toml)")
+    parser.add_argument("--config", default=None, help="path to doracxx.toml configuration file")
+    parser.add_argument("--profile", default="release", help="build profile (default: release, so the measured code is optimized)")
+    parser.add_argument("--dora-target", default=None, help="Dora target directory (defaults to DORA_TARGET_DIR or the prepared Dora)")
+    parser.add_argument("--refresh", action="store_true", help="re-resolve Dora, Arrow, dependencies and flags instead of reusing the build manifest")
+    parser.add_argument("-j", "--jobs", type=int, default=None, help="number of parallel compile jobs")
+    parser.add_argument("--no-build", action="store_true", help="run the bench executable built last time")
+    parser.add_argument("--filter", default=None, help="only run benchmarks whose name contains this text")
+    parser.add_argument("--events", type=int, default=None, help="timed inputs per benchmark (overrides [bench] events)")
+    parser.add_argument("--warmup", type=int, default=None, help="untimed inputs before them (overrides [bench] warmup)")
+    parser.add_argument("--sizes", default=None, help="comma-separated synthetic input sizes in bytes (overrides [bench] sizes)")
+    parser.add_argument("--rate", type=float, default=None, help="inputs per second, 0 for back to back (overrides [bench] rate)")
+    parser.add_argument("--replay", default=None, help="replay a doracxx::bench::Recorder file instead of synthetic inputs")
+    parser.add_argument("--realtime", action="store_true", help="replay at the recorded pace")
+    parser.add_argument("--output", default=None, help="results file (default: target/<profile>/bench/results.json)")
+    parser.add_argument("--baseline", default=None, help="results to compare against (overrides [bench] baseline)")
+    parser.add_argument("--save-baseline", action="store_true", help="write the results to the baseline file instead of comparing")
+    parser.add_argument("--max-regression", type=float, default=None, help="percent a metric may get worse (overrides [bench] max_regression)")
+    args = parser.parse_args()
+
+    node_dir = find_node_dir(args.node_dir)
+    project_root = find_project_root(node_dir)
+    config_path = Path(args.config) if args.config else next(
+        (p for p in [node_dir / "doracxx.toml", project_root / "doracxx.toml"] if p.exists()), None)
+    if config_path is None:
+        print("[ERROR] doracxx bench needs a doracxx.toml")
+        sys.exit(1)
+    config = load_config(config_path)
+    problems = [w for w in validate_config(config) if w.startswith("bench ")]
+    if problems:
+        for problem in problems:
+            print(f"[ERROR] {problem}")
+        sys.exit(1)
+
+    bench_dir = project_root / "target" / args.profile / BENCH_DIR
+    bench_dir.mkdir(parents=True, exist_ok=True)
+    out_name = f"{config.node.name}-bench"
+    exe = project_root / "target" / args.profile / (out_name + (".exe" if os.name == "nt" else ""))
+
+    if not args.no_build:
+        main_source = bench_dir / BENCH_MAIN_SOURCE
+        write_if_changed(main_source, BENCH_MAIN)
+        try:
+            srcs = bench_sources(node_dir, config) + [main_source]
+            compile_node(node_dir, node_dir / "build", out_name, args.profile,
+                         args.dora_target or os.environ.get("DORA_TARGET_DIR"),
+                         extras=["-l", "dora_node_api_cxx"], config=bench_build_config(config, srcs),
+                         jobs=args.jobs, refresh=args.refresh, target_subdir=BENCH_DIR)
+        except Exception as e:
+            print(f"[ERROR] bench build failed: {e}")
+            sys.exit(1)
+    elif not exe.exists():
+        print(f"[ERROR] {exe} does not exist; run doracxx bench without --no-build first")
+        sys.exit(1)
+
+    results_path = Path(args.output).resolve() if args.output else bench_dir / "results.json"
+    cmd = [str(exe)] + harness_args(config, args, node_dir, results_path)
+    print("[BENCH] Running:", " ".join(cmd))
+    code = subprocess.run(cmd, cwd=node_dir).returncode
+    if code != 0 or not results_path.exists():
+        print(f"[ERROR] benchmarks failed (exit code {code})")
+        sys.exit(code or 1)
+    results = json.loads(results_path.read_text(encoding="utf-8"))
+    print(f"[BENCH] Results: {results_path}")
+
+    baseline_name = args.baseline or config.bench.baseline
+    if not baseline_name:
+        if args.save_baseline:
+            print("[ERROR] --save-baseline needs --baseline or [bench] baseline")
+            sys.exit(1)
+        return
+    baseline_path = node_dir / baseline_name
+    if args.save_baseline:
+        baseline_path.parent.mkdir(parents=True, exist_ok=True)
+        baseline_path.write_text(json.dumps(results, indent=2) + "\n", encoding="utf-8")
+        print(f"[BENCH] Saved baseline: {baseline_path}")
+        return
+    if not baseline_path.exists():
+        print(f"[WARN] Baseline {baseline_path} does not exist yet; save one with --save-baseline")
+        return
+
+    baseline = json.loads(baseline_path.read_text(encoding="utf-8"))
+    max_regression = args.max_regression if args.max_regression is not None else config.bench.max_regression
+    print_comparison(results, baseline)
+    regressions = compare_results(results, baseline, max_regression)
+    if regressions:
+        for regression in regressions:
+            print(f"[REGRESSION] {regression}")
+        print(f"[ERROR] {len(regressions)} metric(s) regressed by more than {max_regression:g}% against {baseline_path}")
+        sys.exit(1)
+    print(f"[OK] No regression against {baseline_path} (max {max_regression:g}%)")
+
+
+if __name__ == "__main__":
+    main()
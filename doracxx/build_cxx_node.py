@@ -1,28 +1,61 @@
 #!/usr/bin/env python3
+import json
 import os
 import shutil
 import subprocess
 import sys
-import urllib.request
-import zipfile
-import tarfile
 from pathlib import Path
 import tempfile
+import threading
 import argparse
 from typing import Optional, Union, List
 
 # Import cache functions with proper path handling for different execution contexts
 try:
-    from .cache import get_doracxx_cache_dir, get_dora_cache_path, get_arrow_cache_path
-    from .config import load_config, DoracxxConfig, Toolchain, find_project_root
-    from .dependencies import setup_dependencies
+    from .cache import get_doracxx_cache_dir, get_dora_cache_path, get_arrow_cache_path, arrow_install_name, cache_lock
+    from .config import load_config, DoracxxConfig, Toolchain, BuildSystem, CompilerCache, find_project_root, LOG_LEVELS, BenchConfig
+    from .dependencies import setup_dependencies, dependencies_need_build
+    from .incremental import (BuildState, STATE_FILE, plan_translation_units, compile_translation_units, flags_hash,
+                              remove_stale_objects, resolve_link_inputs, link_is_up_to_date, record_link)
+    from .jobs import JobScheduler, default_job_count
+    from .ninja_backend import find_ninja, generate_ninja, write_ninja_file, ninja_command
+    from .object_cache import setup_compiler_cache
+    from .pch import plan_pch, apply_pch, write_if_changed
+    from .manifest import BuildManifest, MANIFEST_FILE, build_fingerprint
+    from .toolchain import compiler_family, compiler_target_arch
+    from .optimization import node_optimization_flags, merge_flags, pgo_dir, prepare_profile_data
+    from .cpu import cpu_flags, arrow_simd_level, order_variants, variant_id, variant_name, render_launcher, LAUNCHER_SOURCE
+    from .timings import TIMINGS, phase, timed, time_trace_flags, write_report
+    from .git_mirror import checkout as git_checkout, remote_commit, head_commit
+    from .artifacts import ArtifactStore
+    from .prepare import PrepareGraph
+    from .prepare_arrow import arrow_component_libraries
+    from .size import LINK_MAP_FILE, link_map_flags, post_link_commands, print_size_report
+    from .linker import select_linker, linker_flags, linker_binaries
 except ImportError:
     # When run directly, import from the same directory
     import sys
     sys.path.insert(0, str(Path(__file__).parent))
-    from cache import get_doracxx_cache_dir, get_dora_cache_path, get_arrow_cache_path
-    from config import load_config, DoracxxConfig, Toolchain, find_project_root
-    from dependencies import setup_dependencies
+    from cache import get_doracxx_cache_dir, get_dora_cache_path, get_arrow_cache_path, arrow_install_name, cache_lock
+    from config import load_config, DoracxxConfig, Toolchain, BuildSystem, CompilerCache, find_project_root, LOG_LEVELS, BenchConfig
+    from dependencies import setup_dependencies, dependencies_need_build
+    from incremental import (BuildState, STATE_FILE, plan_translation_units, compile_translation_units, flags_hash,
+                             remove_stale_objects, resolve_link_inputs, link_is_up_to_date, record_link)
+    from jobs import JobScheduler, default_job_count
+    from ninja_backend import find_ninja, generate_ninja, write_ninja_file, ninja_command
+    from object_cache import setup_compiler_cache
+    from pch import plan_pch, apply_pch, write_if_changed
+    from manifest import BuildManifest, MANIFEST_FILE, build_fingerprint
+    from toolchain import compiler_family, compiler_target_arch
+    from optimization import node_optimization_flags, merge_flags, pgo_dir, prepare_profile_data
+    from cpu import cpu_flags, arrow_simd_level, order_variants, variant_id, variant_name, render_launcher, LAUNCHER_SOURCE
+    from timings import TIMINGS, phase, timed, time_trace_flags, write_report
+    from git_mirror import checkout as git_checkout, remote_commit, head_commit
+    from artifacts import ArtifactStore
+    from prepare import PrepareGraph
+    from prepare_arrow import arrow_component_libraries
+    from size import LINK_MAP_FILE, link_map_flags, post_link_commands, print_size_report
+    from linker import select_linker, linker_flags, linker_binaries
 
 
 def find_dora_target_dir(dora_git: str | None = None, dora_rev: str | None = None):
@@ -48,13 +81,21 @@ def find_dora_target_dir(dora_git: str | None = None, dora_rev: str | None = Non
     return str(project_root / "target")
 
 
-def find_arrow_install_dir(arrow_git: str | None = None, arrow_rev: str | None = None, linkage: str = "static"):
+def find_arrow_install_dir(arrow_git: str | None = None, arrow_rev: str | None = None, linkage: str = "static",
+                           lto: str | None = None, simd_level: str | None = None, allocator: str = "system",
+                           components: list | None = None):
     """Find Arrow installation directory, checking cache first, then local."""
     # Check global cache first (version-specific with linkage)
-    cache_install = get_arrow_cache_path(arrow_git, arrow_rev, linkage) / "install"
+    install_name = arrow_install_name(lto, simd_level, allocator, components)
+    cache_install = get_arrow_cache_path(arrow_git, arrow_rev, linkage) / install_name
     if cache_install.exists():
         return str(cache_install)
     
+    # LTO, CPU-specific, allocator and component builds need a matching Arrow;
+    # the local fallbacks are regular builds
+    if install_name != "install":
+        return str(cache_install)
+    
     # Fallback: try the default latest cache if specific version not found
     if arrow_git or arrow_rev:
         default_cache_install = get_arrow_cache_path(linkage=linkage) / "install"
@@ -71,22 +112,28 @@ def find_arrow_install_dir(arrow_git: str | None = None, arrow_rev: str | None =
     return str(project_root / "third_party" / "arrow" / "install")
 
 
-def ensure_dora_prepared(dora_git: str | None = None, dora_rev: str | None = None, profile: str = "debug"):
-    """Ensure Dora is prepared and built. If not found, automatically prepare it."""
-    import sys
-    
-    # Check if Dora target directory exists with cxxbridge artifacts
-    dora_target_path = Path(find_dora_target_dir(dora_git, dora_rev))
-    
-    # Check for cxxbridge artifacts that indicate a successful Dora build
+def dora_is_built(dora_target_path: Path, profile: str) -> bool:
+    """True when the Dora target directory has the cxxbridge artifacts of a successful build"""
     cxxbridge_indicators = [
         dora_target_path / profile / "cxxbridge",
         dora_target_path / "cxxbridge"
     ]
+    return any(p.exists() and any(p.iterdir()) for p in cxxbridge_indicators if p.exists())
+
+
+@timed("dora")
+def ensure_dora_prepared(dora_git: str | None = None, dora_rev: str | None = None, profile: str = "debug",
+                         jobs: int | None = None):
+    """Ensure Dora is prepared and built. If not found, automatically prepare it.
+
+    jobs limits the parallel jobs of the cargo build (cargo's default otherwise).
+    """
+    import sys
     
-    has_cxxbridge = any(p.exists() and any(p.iterdir()) for p in cxxbridge_indicators if p.exists())
+    # Check if Dora target directory exists with cxxbridge artifacts
+    dora_target_path = Path(find_dora_target_dir(dora_git, dora_rev))
     
-    if not has_cxxbridge:
+    if not dora_is_built(dora_target_path, profile):
         print("[INFO] Dora not found or incomplete. Preparing Dora automatically...")
         
         # Import prepare_dora functionality
@@ -102,17 +149,22 @@ def ensure_dora_prepared(dora_git: str | None = None, dora_rev: str | None = Non
         vendor = get_dora_cache_path(dora_git, dora_rev)
         print(f"[CACHE] Preparing Dora in global cache: {vendor}")
         
-        # Clone or update Dora repository
-        dora_git_url = dora_git or "https://github.com/dora-rs/dora"
-        repo = git_clone_or_update(dora_git_url, vendor, dora_rev)
-        
-        # Build essential C++ API packages
-        print("[BUILD] Building essential C++ API packages...")
-        ok = build_workspace(repo, profile)
-        
-        if not ok:
-            print("[BUILD] Attempting targeted builds for C/C++ API crates...")
-            build_manifests(repo, profile)
+        with cache_lock(vendor):
+            # Another build may have prepared it while this one waited for the lock
+            if dora_is_built(vendor / "target", profile):
+                return str(vendor / "target")
+
+            # Clone or update Dora repository
+            dora_git_url = dora_git or "https://github.com/dora-rs/dora"
+            repo = git_clone_or_update(dora_git_url, vendor, dora_rev)
+            
+            # Build essential C++ API packages
+            print("[BUILD] Building essential C++ API packages...")
+            ok = build_workspace(repo, profile, jobs)
+            
+            if not ok:
+                print("[BUILD] Attempting targeted builds for C/C++ API crates...")
+                build_manifests(repo, profile, jobs)
         
         print("[OK] Dora preparation completed")
         
@@ -123,7 +175,20 @@ def ensure_dora_prepared(dora_git: str | None = None, dora_rev: str | None = Non
     return str(dora_target_path)
 
 
-def ensure_arrow_prepared(arrow_git: str | None = None, arrow_rev: str | None = None, profile: str = "debug", linkage: str = "static"):
+def arrow_is_installed(arrow_install_path: Path) -> bool:
+    """True when an Arrow install directory has the headers and libraries of a successful build"""
+    arrow_indicators = [
+        arrow_install_path / "include" / "arrow",
+        arrow_install_path / "lib"
+    ]
+    return all(p.exists() for p in arrow_indicators) and any((arrow_install_path / "lib").glob("*arrow*"))
+
+
+@timed("arrow")
+def ensure_arrow_prepared(arrow_git: str | None = None, arrow_rev: str | None = None, profile: str = "debug", linkage: str = "static",
+                          lto: str | None = None, cxx_compiler: str | None = None, simd_level: str | None = None,
+                          allocator: str = "system", jobs: int | None = None, artifacts=None,
+                          components: list | None = None):
     """Ensure Arrow is prepared and built. If not found, automatically prepare it.
     
     Args:
@@ -131,87 +196,87 @@ def ensure_arrow_prepared(arrow_git: str | None = None, arrow_rev: str | None =
         arrow_rev: Git revision/branch/tag to checkout
         profile: Build profile (debug/release)
         linkage: Linkage mode - "static" (default) or "shared"
+        lto: Build Arrow with link-time optimization ("thin" or "full") so it
+            is optimized together with the node
+        cxx_compiler: Compiler to build Arrow with (must match the node's for LTO)
+        simd_level: ARROW_SIMD_LEVEL to compile Arrow for (e.g. "AVX2", "NEON")
+        allocator: Allocator built into Arrow - "system", "jemalloc" or "mimalloc"
+        jobs: Parallel jobs of the Arrow build (defaults to the CPU count)
+        artifacts: ArtifactStore to restore a prebuilt Arrow from, and to archive a new build in
+        components: Arrow modules and codecs to build (None for the defaults)
     """
     import sys
     
     # Check if Arrow installation directory exists with required files
-    arrow_install_path = Path(find_arrow_install_dir(arrow_git, arrow_rev, linkage))
+    arrow_install_path = Path(find_arrow_install_dir(arrow_git, arrow_rev, linkage, lto, simd_level, allocator,
+                                                     components))
     
-    # Check for Arrow artifacts that indicate a successful build
-    arrow_indicators = [
-        arrow_install_path / "include" / "arrow",
-        arrow_install_path / "lib"
-    ]
-    
-    has_arrow = all(p.exists() for p in arrow_indicators)
-    
-    # Additional check for actual library files
-    if has_arrow:
-        lib_dir = arrow_install_path / "lib"
-        has_libs = any(lib_dir.glob("*arrow*"))
-        has_arrow = has_arrow and has_libs
-    
-    if not has_arrow:
+    if not arrow_is_installed(arrow_install_path):
         print(f"[INFO] Arrow not found or incomplete. Preparing Arrow automatically (linkage: {linkage})...")
         
         # Import prepare_arrow functionality
         try:
-            from .prepare_arrow import git_clone_or_update, build_arrow_cpp, verify_arrow_installation
+            from .prepare_arrow import (git_clone_or_update, build_arrow_cpp, verify_arrow_installation, arrow_artifact_name,
+                                        arrow_source_dir)
             from .cache import get_arrow_cache_path
         except ImportError:
             sys.path.insert(0, str(Path(__file__).parent))
-            from prepare_arrow import git_clone_or_update, build_arrow_cpp, verify_arrow_installation
+            from prepare_arrow import (git_clone_or_update, build_arrow_cpp, verify_arrow_installation, arrow_artifact_name,
+                                       arrow_source_dir)
             from cache import get_arrow_cache_path
         
         # Determine the repository path
         vendor = get_arrow_cache_path(arrow_git, arrow_rev, linkage)
-        install_dir = vendor / "install"
+        install_dir = vendor / arrow_install_name(lto, simd_level, allocator, components)
         print(f"[CACHE] Preparing Arrow in global cache: {vendor}")
         
-        # Clone or update Arrow repository
-        arrow_git_url = arrow_git or "https://github.com/apache/arrow.git"
-        repo = git_clone_or_update(arrow_git_url, vendor, arrow_rev)
-        
-        # Build Arrow C++ library
-        print(f"[BUILD] Building Arrow C++ library (linkage: {linkage})...")
-        try:
-            success = build_arrow_cpp(repo, profile, install_dir, linkage)
-            if success:
-                verify_arrow_installation(install_dir)
-                print("[OK] Arrow preparation completed")
-            else:
-                print("[ERROR] Arrow build failed")
-                raise RuntimeError("Arrow build failed")
-        except Exception as e:
-            print(f"[ERROR] Arrow preparation failed: {e}")
-            raise
+        # The checkout is shared by every install flavour of this revision
+        with cache_lock(vendor):
+            # Another build may have installed it while this one waited for the lock
+            if arrow_is_installed(install_dir):
+                return str(install_dir)
+
+            arrow_git_url = arrow_git or "https://github.com/apache/arrow.git"
+            settings = dict(profile=profile, linkage=linkage, lto=lto, cxx_compiler=cxx_compiler,
+                            simd_level=simd_level, allocator=allocator, components=components)
+
+            # A prebuilt Arrow of the same commit and settings saves the build
+            commit = remote_commit(arrow_git_url, arrow_rev) if artifacts and artifacts.enabled else None
+            if commit and artifacts.restore(arrow_artifact_name(commit, **settings), install_dir):
+                return str(install_dir)
+
+            # Clone or update Arrow repository
+            repo = git_clone_or_update(arrow_git_url, arrow_source_dir(vendor), arrow_rev)
+            
+            # Build Arrow C++ library
+            print(f"[BUILD] Building Arrow C++ library (linkage: {linkage})...")
+            try:
+                success = build_arrow_cpp(repo, profile, install_dir, linkage, lto=lto, cxx_compiler=cxx_compiler,
+                                          simd_level=simd_level, allocator=allocator, jobs=jobs,
+                                          components=components)
+                if success:
+                    verify_arrow_installation(install_dir)
+                    print("[OK] Arrow preparation completed")
+                    commit = head_commit(repo) or commit
+                    if artifacts and commit:
+                        artifacts.save(arrow_artifact_name(commit, **settings), install_dir)
+                else:
+                    print("[ERROR] Arrow build failed")
+                    raise RuntimeError("Arrow build failed")
+            except Exception as e:
+                print(f"[ERROR] Arrow preparation failed: {e}")
+                raise
         
         # Re-check the installation directory
-        new_install = find_arrow_install_dir(arrow_git, arrow_rev, linkage)
+        new_install = find_arrow_install_dir(arrow_git, arrow_rev, linkage, lto, simd_level, allocator, components)
         return new_install
     
     return str(arrow_install_path)
 
 
+@timed("git")
 def git_clone(url, dest, rev=None):
-    dest = Path(dest)
-    if dest.exists():
-        # try to fetch latest
-        try:
-            subprocess.check_call(["git", "-C", str(dest), "fetch", "--all"], stdout=subprocess.DEVNULL)
-            if rev:
-                subprocess.check_call(["git", "-C", str(dest), "checkout", rev])
-            else:
-                subprocess.check_call(["git", "-C", str(dest), "checkout", "main"]) 
-        except Exception:
-            pass
-        return dest
-    dest.parent.mkdir(parents=True, exist_ok=True)
-    cmd = ["git", "clone", url, str(dest)]
-    if rev:
-        cmd += ["--branch", rev]
-    subprocess.check_call(cmd)
-    return dest
+    return git_checkout(url, dest, rev)
 
 
 def run(cmd, cwd=None, env=None, capture_output=False, timeout=300, config=None):
@@ -327,6 +392,7 @@ def should_print_line(line, custom_patterns=None):
     return True
 
 
+@timed("dora")
 def build_package(pkg):
     try:
         run([os.environ.get("CARGO", "cargo"), "build", "--package", pkg])
@@ -336,6 +402,7 @@ def build_package(pkg):
         return False
 
 
+@timed("dora")
 def build_manifest(manifest_path, profile="debug"):
     cmd = [os.environ.get("CARGO", "cargo"), "build", "--manifest-path", str(manifest_path)]
     if profile == "release":
@@ -400,13 +467,50 @@ def find_cxxbridge_artifacts(dora_target: Path, profile: str):
     return include_dirs, generated_cc
 
 
-def find_arrow_artifacts(arrow_install: Path):
+def bridge_sources_to_compile(generated_cc: list, dora_target: Path, profile: str, kind: str) -> list:
+    """The generated .cc files whose crate has no Dora library to link instead
+
+    Compiling a source its crate's staticlib (e.g. libdora_node_api_cxx.a)
+    already holds would duplicate its symbols.
+    """
+    lib_dir = dora_target / profile
+    # Fallback to release if debug doesn't exist, or debug if release doesn't exist
+    if not lib_dir.exists():
+        if profile == "debug":
+            lib_dir = dora_target / "release"
+        elif profile == "release":
+            lib_dir = dora_target / "debug"
+
+    available_libs = set()
+    if lib_dir.exists():
+        for f in lib_dir.iterdir():
+            if f.is_file():
+                if kind == "msvc" and f.suffix.lower() == ".lib":
+                    available_libs.add(f.stem)
+                elif kind != "msvc" and f.suffix.lower() == ".a" and f.name.startswith("lib"):
+                    available_libs.add(f.stem[3:])  # remove "lib" prefix
+
+    sources = []
+    for p in generated_cc:
+        ppath = Path(p)
+        # crate name is parent of src (e.g., dora-node-api-cxx)
+        crate = ppath.parent.parent.name
+        if crate and (crate in available_libs or crate.replace('-', '_') in available_libs):
+            continue
+        sources.append(ppath)
+    return sources
+
+
+def find_arrow_artifacts(arrow_install: Path, components: list | None = None):
     """Return (include_dirs, lib_dirs, libraries, library_info) for Arrow.
 
     include_dirs: list of directories to pass as -I (/I for MSVC)
     lib_dirs: list of directories to pass as -L (/LIBPATH for MSVC)
     libraries: list of library names to link against
     library_info: dict with linkage info and shared library files
+
+    With components, only the libraries of those [arrow] components are
+    linked, in dependency order; otherwise every Arrow library found is.
     """
     include_dirs = []
     lib_dirs = []
@@ -431,32 +535,44 @@ def find_arrow_artifacts(arrow_install: Path):
         shared_libs = []
         shared_files = []
         
-        # Collect static libraries first (.a files on Unix, .lib files on Windows)
-        for lib_file in arrow_lib.glob("libarrow*.a"):
-            if lib_file.is_file():
-                lib_name = lib_file.name[3:].split('.', 1)[0]  # Remove 'lib' prefix and extension
-                static_libs.append(lib_name)
-        
-        # For Windows, look for .lib files (which can be static or import libraries)
-        for lib_file in arrow_lib.glob("arrow*.lib"):
-            if lib_file.is_file():
-                lib_name = lib_file.name.split('.', 1)[0]
-                static_libs.append(lib_name)
-        
-        # Collect shared libraries as fallback (.so files on Unix, .dll on Windows, .dylib on macOS)
-        for extension in ["*.so", "*.so.*", "*.dll", "*.dylib"]:
-            for lib_file in arrow_lib.glob(f"libarrow{extension}"):
+        for prefix in ("arrow", "parquet"):
+            # Collect static libraries first (.a files on Unix, .lib files on Windows)
+            for lib_file in arrow_lib.glob(f"lib{prefix}*.a"):
                 if lib_file.is_file():
                     lib_name = lib_file.name[3:].split('.', 1)[0]  # Remove 'lib' prefix and extension
-                    shared_libs.append(lib_name)
-                    shared_files.append(str(lib_file))
+                    static_libs.append(lib_name)
             
-            # Also check without 'lib' prefix (Windows style)
-            for lib_file in arrow_lib.glob(f"arrow{extension}"):
+            # For Windows, look for .lib files (which can be static or import libraries)
+            for lib_file in arrow_lib.glob(f"{prefix}*.lib"):
                 if lib_file.is_file():
                     lib_name = lib_file.name.split('.', 1)[0]
-                    shared_libs.append(lib_name)
-                    shared_files.append(str(lib_file))
+                    static_libs.append(lib_name)
+            
+            # Collect shared libraries as fallback (.so files on Unix, .dll on Windows, .dylib on macOS)
+            for extension in ["*.so", "*.so.*", "*.dll", "*.dylib"]:
+                for lib_file in arrow_lib.glob(f"lib{prefix}{extension}"):
+                    if lib_file.is_file():
+                        lib_name = lib_file.name[3:].split('.', 1)[0]  # Remove 'lib' prefix and extension
+                        shared_libs.append(lib_name)
+                        shared_files.append(str(lib_file))
+                
+                # Also check without 'lib' prefix (Windows style)
+                for lib_file in arrow_lib.glob(f"{prefix}{extension}"):
+                    if lib_file.is_file():
+                        lib_name = lib_file.name.split('.', 1)[0]
+                        shared_libs.append(lib_name)
+                        shared_files.append(str(lib_file))
+        
+        # Static linkers resolve left to right: dependents first, Arrow's
+        # bundled third-party code last
+        if components is not None:
+            order = arrow_component_libraries(components) + ["arrow_bundled_dependencies"]
+            static_libs = [lib for lib in order if lib in static_libs]
+            shared_files = [f for f, lib in zip(shared_files, shared_libs) if lib in order]
+            shared_libs = [lib for lib in order if lib in shared_libs]
+        else:
+            order = ["parquet", "arrow_dataset", "arrow_acero", "arrow", "arrow_bundled_dependencies"]
+            static_libs.sort(key=lambda lib: order.index(lib) if lib in order else order.index("arrow") - 0.5)
         
         # Use static libraries if available, otherwise fall back to shared
         if static_libs:
@@ -503,32 +619,249 @@ def copy_shared_libraries(shared_files: list, executable_path: Path):
         print(f"[SHARED] Copied {len(copied_files)} shared libraries: {copied_files}")
 
 
-def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, dora_target: str, extras: list, config: DoracxxConfig | None = None, dora_git: str | None = None, dora_rev: str | None = None):
-    # Extract Dora configuration from config if available
-    final_dora_git = dora_git
-    final_dora_rev = dora_rev
-    if config and config.node:
-        if config.node.dora_git:
-            final_dora_git = config.node.dora_git
-        if config.node.dora_rev:
-            final_dora_rev = config.node.dora_rev
-    
-    # Ensure Dora is prepared with the requested version
-    print("[INFO] Checking Dora preparation...")
-    try:
-        dora_target = ensure_dora_prepared(final_dora_git, final_dora_rev, profile)
-        print(f"[OK] Dora target ready: {dora_target}")
-    except Exception as e:
-        print(f"[ERROR] Failed to prepare Dora automatically: {e}")
-        print(f"Using fallback Dora target directory: {dora_target}")
-    
-    # On Windows, try to load MSVC environment (vcvarsall) so cl/link are visible
-    if os.name == "nt":
+def copy_if_changed(src: Path, dest: Path) -> bool:
+    """Copy src to dest only when the content differs.
+
+    Leaving identical files untouched keeps their mtime, so incremental builds
+    do not recompile every translation unit that includes them.
+    Returns True if the file was copied.
+    """
+    if dest.exists():
         try:
-            load_msvc_env()
-        except Exception:
-            # if it fails, we continue and rely on PATH / CXX
+            src_stat, dest_stat = src.stat(), dest.stat()
+            if dest_stat.st_size == src_stat.st_size and (
+                    # copied after src last changed: in sync without reading either
+                    dest_stat.st_mtime_ns >= src_stat.st_mtime_ns or dest.read_bytes() == src.read_bytes()):
+                return False
+        except OSError:
             pass
+    shutil.copyfile(src, dest)
+    return True
+
+
+HEADER_SUFFIXES = (".h", ".hh", ".hpp", ".hxx", ".inl")
+SYNCED_HEADERS_FILE = ".doracxx-headers.json"
+
+
+def sync_headers(headers: dict, dest_dir: Path, group: str) -> tuple:
+    """Make dest_dir hold the headers of group: {relative path: source}
+
+    Only changed headers are copied. Headers an earlier sync of the same
+    group put in dest_dir and that are no longer in headers are removed;
+    other files in dest_dir are left alone. The files each group synced are
+    recorded in dest_dir/.doracxx-headers.json. Returns (copied, removed).
+    """
+    record_path = dest_dir / SYNCED_HEADERS_FILE
+    try:
+        record = json.loads(record_path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        record = {}
+    copied, removed = [], []
+    for rel in sorted(set(record.get(group, [])) - set(headers)):
+        stale = dest_dir / rel
+        if stale.is_file():
+            stale.unlink()
+            removed.append(rel)
+            # drop directories the header leaves empty
+            for parent in stale.parents:
+                if parent == dest_dir or dest_dir not in parent.parents or any(parent.iterdir()):
+                    break
+                parent.rmdir()
+    for rel, src in sorted(headers.items()):
+        dest = dest_dir / rel
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        try:
+            if copy_if_changed(Path(src), dest):
+                copied.append(rel)
+        except OSError as e:
+            print(f"[WARN] Could not copy header {src}: {e}")
+    if record.get(group) != sorted(headers):
+        record[group] = sorted(headers)
+        write_if_changed(record_path, json.dumps(record, indent=2, sort_keys=True) + "\n")
+    return copied, removed
+
+
+def discover_node_sources(node_dir: Path, config: DoracxxConfig | None = None) -> list:
+    """Discover all C/C++ source files in the node directory (honouring sources/exclude_sources)"""
+    srcs = []
+    
+    # Check if sources are specified in config
+    if config and hasattr(config.build, 'sources') and config.build.sources:
+        # Use explicitly configured sources
+        for src_pattern in config.build.sources:
+            if "*" in src_pattern or "?" in src_pattern:
+                # Pattern matching
+                matched_files = list(node_dir.glob(src_pattern))
+                srcs.extend(matched_files)
+            else:
+                # Direct file path
+                src_path = node_dir / src_pattern
+                if src_path.exists():
+                    srcs.append(src_path)
+    else:
+        # Default behavior: discover all C/C++ files, except the sources doracxx
+        # generates under target/ (PCH stubs, CPU launcher) and the benchmarks
+        # that only `doracxx bench` builds
+        target_dir = find_project_root(node_dir) / "target"
+        bench_patterns = config.bench.sources if config else BenchConfig().sources
+        bench_srcs = {p for pattern in bench_patterns for p in node_dir.glob(pattern)}
+        for pattern in ["**/*.cc", "**/*.cpp", "**/*.c"]:
+            srcs.extend(p for p in node_dir.glob(pattern) if target_dir not in p.parents and p not in bench_srcs)
+    
+    # Apply exclude patterns if specified
+    if config and hasattr(config.build, 'exclude_sources') and config.build.exclude_sources:
+        import fnmatch
+        excluded_srcs = []
+        for src in srcs:
+            relative_path = str(src.relative_to(node_dir))
+            should_exclude = False
+            for exclude_pattern in config.build.exclude_sources:
+                if fnmatch.fnmatch(relative_path, exclude_pattern):
+                    should_exclude = True
+                    break
+            if should_exclude:
+                excluded_srcs.append(src)
+                print(f"[EXCLUDE] Excluding source file: {relative_path}")
+        
+        # Remove excluded files
+        for excluded in excluded_srcs:
+            srcs.remove(excluded)
+    
+    if not srcs:
+        raise RuntimeError("no C/C++ sources found in node dir (looked for .cc, .cpp, .c files)")
+    
+    return srcs
+
+
+@timed("headers")
+def sync_project_headers(node_dir: Path, target_include_dir: Path):
+    """Mirror the project's include/ headers into target/<profile>/include (see sync_headers)"""
+    project_include_src = node_dir / "include"
+    headers = {}
+    if project_include_src.exists():
+        for header in project_include_src.rglob("*"):
+            if header.suffix.lower() in HEADER_SUFFIXES and header.is_file():
+                headers[header.relative_to(project_include_src).as_posix()] = header
+    copied, removed = sync_headers(headers, target_include_dir, "project")
+    for rel in copied:
+        print(f"copied project header: {project_include_src / rel} -> {target_include_dir / rel}")
+    for rel in removed:
+        print(f"removed stale project header: {target_include_dir / rel}")
+
+
+# Support headers that need a newer C++ standard than the c++17 default
+SUPPORT_HEADER_MIN_STD = {"doracxx_async.h": 20}
+
+
+def cxx_standard_year(std: str | None) -> int:
+    """Year of a C++ standard setting ("c++20", "gnu++2a", "c++latest" ...), e.g. 2020"""
+    if not std:
+        return 2017
+    version = std.lower().rsplit("++", 1)[-1]
+    if version == "latest":
+        return 9999
+    drafts = {"0x": 2011, "1y": 2014, "1z": 2017, "2a": 2020, "2b": 2023, "2c": 2026}
+    if version in drafts:
+        return drafts[version]
+    if version.isdigit():
+        year = int(version)
+        return 1900 + year if year >= 90 else 2000 + year
+    return 2017
+
+
+@timed("headers")
+def install_support_headers(target_deps_dir: Path, std: str | None = None):
+    """Copy the headers doracxx ships for nodes (doracxx/support) to target/<profile>/deps
+    
+    Headers needing a newer standard than std (see SUPPORT_HEADER_MIN_STD)
+    are left out, and removed if an earlier build installed them.
+    """
+    support_dir = Path(__file__).resolve().parent / "support"
+    year = cxx_standard_year(std)
+    headers = {}
+    for header in support_dir.glob("*.h"):
+        if year < 2000 + SUPPORT_HEADER_MIN_STD.get(header.name, 17):
+            (target_deps_dir / header.name).unlink(missing_ok=True)
+            continue
+        headers[header.name] = header
+    copied, _ = sync_headers(headers, target_deps_dir, "support")
+    for name in copied:
+        print(f"copied support header: {name} -> {target_deps_dir / name}")
+
+
+def log_defines(kind: str, config: DoracxxConfig | None, profile: str) -> list:
+    """Preprocessor definitions configuring doracxx_log.h ([log] section)
+
+    Debug builds compile in debug messages and up, release builds info and up,
+    unless [log] level says otherwise.
+    """
+    log = config.log if config else None
+    level = (log.level if log else None) or ("info" if profile == "release" else "debug")
+    if level not in LOG_LEVELS:
+        print(f"[WARN] Unknown log level '{level}', using \"info\"")
+        level = "info"
+    defines = [f"DORACXX_LOG_LEVEL={LOG_LEVELS.index(level)}"]
+    if log:
+        defines += [f"DORACXX_LOG_RATE={max(log.rate_limit, 0)}", f"DORACXX_LOG_QUEUE_SIZE={max(log.queue_size, 2)}"]
+    prefix = "/D" if kind == "msvc" else "-D"
+    return [prefix + define for define in defines]
+
+
+def metrics_defines(kind: str, config: DoracxxConfig | None) -> list:
+    """Preprocessor definitions enabling doracxx_metrics.h ([metrics] section)
+
+    Nothing is defined unless metrics are enabled, which leaves the header's
+    instrumentation compiled out.
+    """
+    if not config or not config.metrics.enabled:
+        return []
+    prefix = "/D" if kind == "msvc" else "-D"
+    return [prefix + "DORACXX_METRICS=1", f"{prefix}DORACXX_METRICS_INTERVAL_MS={max(config.metrics.interval_ms, 1)}"]
+
+
+def uses_eigen(config: DoracxxConfig | None) -> bool:
+    """Whether one of the [dependencies] is Eigen (by name, URL or package name)"""
+    if not config:
+        return False
+    for name, dep in config.dependencies.items():
+        names = [name, getattr(dep, "url", None), getattr(dep, "name", None), getattr(dep, "pkg_config", None)]
+        if any(n and "eigen" in str(n).lower() for n in names):
+            return True
+    return False
+
+
+def eigen_defines(kind: str, config: DoracxxConfig | None, profile: str) -> list:
+    """Preprocessor definitions for nodes depending on Eigen
+
+    Release builds drop eigen_assert's index and size checks (EIGEN_NO_DEBUG),
+    which otherwise stay on because doracxx does not define NDEBUG. Eigen
+    picks its SIMD kernels from the -march / /arch of [build] target_cpu or
+    cpu_variants by itself.
+    """
+    if not uses_eigen(config) or profile != "release":
+        return []
+    prefix = "/D" if kind == "msvc" else "-D"
+    return [prefix + "EIGEN_NO_DEBUG"]
+
+
+@timed("resolve")
+def resolve_build(node_dir: Path, profile: str, dora_target: str | None, extras: list, config: DoracxxConfig | None,
+                  dora_git: str | None, dora_rev: str | None, project_root: Path, workspace_target_dir: Path,
+                  target_deps_dir: Path, target_include_dir: Path, final_out_path: Path,
+                  jobs: int | None = None) -> tuple:
+    """Resolve everything a node build needs besides its own sources.
+
+    Picks the compiler, prepares Dora, Arrow and the dependencies concurrently
+    (sharing jobs parallel build jobs), scans the cxxbridge outputs and
+    assembles the compile and link arguments.
+
+    Returns:
+        (resolved, watch): the JSON-serializable resolution stored in the build
+        manifest, and the files and directories it was derived from
+    """
+    # On Windows, try to load MSVC environment (vcvarsall) so cl/link are visible.
+    # The variables it sets are kept so a reused manifest can restore them.
+    msvc_env = msvc_environment()
 
     # Determine compiler preference from config
     preferred_toolchain = None
@@ -583,69 +916,6 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
         if not cc:
             raise RuntimeError("no C++ compiler found (tried CXX env, cl, clang-cl, clang++, g++); install one or set CXX")
 
-    # Discover all C/C++ source files in the node directory
-    srcs = []
-    
-    # Check if sources are specified in config
-    if config and hasattr(config.build, 'sources') and config.build.sources:
-        # Use explicitly configured sources
-        for src_pattern in config.build.sources:
-            if "*" in src_pattern or "?" in src_pattern:
-                # Pattern matching
-                matched_files = list(node_dir.glob(src_pattern))
-                srcs.extend(matched_files)
-            else:
-                # Direct file path
-                src_path = node_dir / src_pattern
-                if src_path.exists():
-                    srcs.append(src_path)
-    else:
-        # Default behavior: discover all C/C++ files
-        for pattern in ["**/*.cc", "**/*.cpp", "**/*.c"]:
-            srcs.extend(node_dir.glob(pattern))
-    
-    # Apply exclude patterns if specified
-    if config and hasattr(config.build, 'exclude_sources') and config.build.exclude_sources:
-        import fnmatch
-        excluded_srcs = []
-        for src in srcs:
-            relative_path = str(src.relative_to(node_dir))
-            should_exclude = False
-            for exclude_pattern in config.build.exclude_sources:
-                if fnmatch.fnmatch(relative_path, exclude_pattern):
-                    should_exclude = True
-                    break
-            if should_exclude:
-                excluded_srcs.append(src)
-                print(f"[EXCLUDE] Excluding source file: {relative_path}")
-        
-        # Remove excluded files
-        for excluded in excluded_srcs:
-            srcs.remove(excluded)
-    
-    if not srcs:
-        raise RuntimeError("no C/C++ sources found in node dir (looked for .cc, .cpp, .c files)")
-    
-    # Use target/<profile>/ for ALL build artifacts (like Rust projects)
-    # Use the project root directory, not the current working directory
-    project_root = find_project_root(node_dir)
-    workspace_target_dir = project_root / "target" / profile
-    workspace_target_dir.mkdir(parents=True, exist_ok=True)
-    
-    # Create subdirectories in target for organization
-    target_build_dir = workspace_target_dir / "build"
-    target_deps_dir = workspace_target_dir / "deps" 
-    target_include_dir = workspace_target_dir / "include"
-    target_build_dir.mkdir(exist_ok=True)
-    target_deps_dir.mkdir(exist_ok=True)
-    target_include_dir.mkdir(exist_ok=True)
-    
-    # Setup dependencies if config is provided
-    dep_manager = None
-    if config and config.dependencies:
-        print("[DEPS] Setting up dependencies...")
-        dep_manager = setup_dependencies(config, node_dir, workspace_target_dir)
-    
     # Check if Arrow is needed (either explicitly configured or from dependencies)
     arrow_git = None
     arrow_rev = None
@@ -653,10 +923,14 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
     
     # Check if Arrow is configured in arrow config
     arrow_linkage = "static"  # Default linkage mode
+    arrow_allocator = "system"
+    arrow_components = None
     if config and config.arrow and config.arrow.enabled:
         arrow_git = config.arrow.git
         arrow_rev = config.arrow.rev
         arrow_linkage = config.arrow.linkage
+        arrow_allocator = config.arrow.allocator
+        arrow_components = config.arrow.components
         arrow_needed = True
     
     # Check if Arrow is in dependencies
@@ -665,39 +939,69 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
             if 'arrow' in dep_name.lower():
                 arrow_needed = True
                 break
-    
-    # Prepare Arrow if needed
-    arrow_include_dirs = []
-    arrow_lib_dirs = []
-    arrow_libraries = []
-    arrow_library_info = {}
-    if arrow_needed:
+
+    # With LTO, Arrow is built with the node's compiler so its bitcode can be
+    # optimized together with the node at link time
+    arrow_lto = config.build.lto if config else None
+    # Arrow is built for the least capable targeted CPU and keeps its own
+    # runtime SIMD dispatch for the rest
+    arrow_cpus = []
+    if config:
+        arrow_cpus = config.build.cpu_variants or ([config.build.target_cpu] if config.build.target_cpu else [])
+    arrow_simd = arrow_simd_level(arrow_cpus)
+
+    def prepare_dora(jobs):
+        # Ensure Dora is prepared with the requested version
+        print("[INFO] Checking Dora preparation...")
+        try:
+            target = ensure_dora_prepared(dora_git, dora_rev, profile, jobs)
+            print(f"[OK] Dora target ready: {target}")
+        except Exception as e:
+            print(f"[ERROR] Failed to prepare Dora automatically: {e}")
+            target = dora_target or find_dora_target_dir(dora_git, dora_rev)
+            print(f"Using fallback Dora target directory: {target}")
+        return target
+
+    def prepare_dependencies(jobs):
+        print("[DEPS] Setting up dependencies...")
+        return setup_dependencies(config, node_dir, workspace_target_dir, jobs)
+
+    def prepare_arrow(jobs):
         try:
             print("[INFO] Checking Arrow preparation...")
-            arrow_install = ensure_arrow_prepared(arrow_git, arrow_rev, profile, arrow_linkage)
-            arrow_include_dirs, arrow_lib_dirs, arrow_libraries, arrow_library_info = find_arrow_artifacts(Path(arrow_install))
+            arrow_install = ensure_arrow_prepared(arrow_git, arrow_rev, profile, arrow_linkage, lto=arrow_lto,
+                                                  cxx_compiler=cc if arrow_lto and kind != "msvc" else None,
+                                                  simd_level=arrow_simd, allocator=arrow_allocator, jobs=jobs,
+                                                  artifacts=ArtifactStore.from_config(config.artifacts if config else None),
+                                                  components=arrow_components)
+            artifacts = find_arrow_artifacts(Path(arrow_install), arrow_components)
             print(f"[OK] Arrow ready: {arrow_install}")
-            print(f"Arrow include dirs: {arrow_include_dirs}")
-            print(f"Arrow lib dirs: {arrow_lib_dirs}")
-            print(f"Arrow libraries: {arrow_libraries}")
-            print(f"Arrow lib dirs: {arrow_lib_dirs}")
-            print(f"Arrow libraries: {arrow_libraries}")
+            print(f"Arrow include dirs: {artifacts[0]}")
+            print(f"Arrow lib dirs: {artifacts[1]}")
+            print(f"Arrow libraries: {artifacts[2]}")
+            return artifacts
         except Exception as e:
             print(f"[WARN] Arrow preparation failed: {e}")
             print("Continuing without Arrow...")
-    
-    # Clean target build directory to avoid conflicts with previous builds or parallel builds
-    for item in target_build_dir.iterdir():
-        if item.is_file() and (item.suffix in ['.obj', '.o', '.exe', '.pdb', '.ilk']):
-            try:
-                item.unlink()
-                print(f"cleaned: {item}")
-            except (OSError, PermissionError):
-                # file might be in use, continue anyway
-                pass
-    
-    # Final executable path
-    final_out_path = workspace_target_dir / (out_name + (".exe" if os.name == "nt" else ""))
+            return [], [], [], {}
+
+    # Dora, the dependencies and Arrow do not depend on each other: fetch and
+    # build them concurrently, splitting the job budget between those that
+    # still have to be built
+    prepare = PrepareGraph(jobs or (config.build.parallel_jobs if config else None))
+    prepare.add("dora", prepare_dora,
+                builds=not dora_is_built(Path(find_dora_target_dir(dora_git, dora_rev)), profile))
+    if config and config.dependencies:
+        prepare.add("dependencies", prepare_dependencies, builds=dependencies_need_build(config))
+    if arrow_needed:
+        arrow_install_path = Path(find_arrow_install_dir(arrow_git, arrow_rev, arrow_linkage, arrow_lto,
+                                                         arrow_simd, arrow_allocator, arrow_components))
+        prepare.add("arrow", prepare_arrow, builds=not arrow_is_installed(arrow_install_path))
+    prepared = prepare.run()
+
+    dora_target = prepared["dora"]
+    dep_manager = prepared.get("dependencies")
+    arrow_include_dirs, arrow_lib_dirs, arrow_libraries, arrow_library_info = prepared.get("arrow", ([], [], [], {}))
     
     # All artifacts go directly to target (no build_dir copy step)
     temp_out_path = final_out_path
@@ -754,97 +1058,41 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
     if deps_include not in include_dirs:
         include_dirs.insert(1, deps_include)
     
-    # Copy project headers to target/include if they exist
-    project_include_src = node_dir / "include"
-    if project_include_src.exists():
-        for header in project_include_src.glob("**/*.h"):
-            rel_path = header.relative_to(project_include_src)
-            dest = target_include_dir / rel_path
-            dest.parent.mkdir(parents=True, exist_ok=True)
-            try:
-                shutil.copyfile(header, dest)
-                print(f"copied project header: {header} -> {dest}")
-            except Exception:
-                pass
-    
     # Copy convenience headers to target/deps/ directory
     # These are generated/dependency headers from cxxbridge
-    try:
+    with phase("copy dependency headers", "headers"):
+        bridge_headers = {}
         # search for any lib.rs.h under the discovered cxxbridge root(s)
         for root in [Path(dora_target) / profile / "cxxbridge", Path(dora_target) / "cxxbridge"]:
-            if not root.exists():
+            if not root.is_dir():
                 continue
             for crate_dir in root.iterdir():
                 src_h = crate_dir / "src" / "lib.rs.h"
                 if src_h.exists():
                     # produce name like dora-operator-api.h by stripping -cxx or -c
-                    crate_name = crate_dir.name
-                    out_name = crate_name
-                    if out_name.endswith("-cxx"):
-                        out_name = out_name[: -len("-cxx")]
-                    if out_name.endswith("-c"):
-                        out_name = out_name[: -len("-c")]
-                    out_name = out_name + ".h"
-                    dest = target_deps_dir / out_name
-                    try:
-                        shutil.copyfile(src_h, dest)
-                        print(f"copied dependency header: {src_h} -> {dest}")
-                    except Exception:
-                        # ignore copy errors; we'll still have original include dirs
-                        pass
-    except Exception:
-        pass
-
-    # add generated .cc sources to compile list
-    # For both MSVC and GCC/Clang, if a matching Dora library exists for a crate, prefer linking that
-    # library instead of compiling the generated .cc to avoid duplicate symbols.
-    filtered = []
-    lib_dir = Path(dora_target) / profile
-    # Fallback to release if debug doesn't exist, or debug if release doesn't exist
-    if not lib_dir.exists():
-        if profile == "debug":
-            lib_dir = Path(dora_target) / "release"
-        elif profile == "release":
-            lib_dir = Path(dora_target) / "debug"
-    
-    # Check which libraries actually exist
-    available_libs = set()
-    if lib_dir.exists():
-        for f in lib_dir.iterdir():
-            if f.is_file():
-                if kind == "msvc" and f.suffix.lower() == ".lib":
-                    available_libs.add(f.stem)
-                elif not kind == "msvc" and f.suffix.lower() == ".a" and f.name.startswith("lib"):
-                    available_libs.add(f.stem[3:])  # remove "lib" prefix
-    
-    # Only compile .cc files if their corresponding library doesn't exist
-    for p in generated_cc:
-        ppath = Path(p)
-        # crate name is parent of src (e.g., dora-node-api-cxx)
-        crate = ppath.parent.parent.name if ppath.parent.parent.name else None
-        should_compile = True
-        
-        if crate:
-            lib_candidates = [crate, crate.replace('-', '_')]
-            for candidate in lib_candidates:
-                if candidate in available_libs:
-                    should_compile = False
-                    break
-        
-        if should_compile:
-            filtered.append(ppath)
-    
-    srcs += filtered
-    # Build command differs between MSVC (cl) and gcc/clang (g++, clang++)
+                    out_name = crate_dir.name.removesuffix("-cxx").removesuffix("-c")
+                    bridge_headers[out_name + ".h"] = src_h
+        # copy errors are reported but not fatal: the original include dirs stay on the path
+        copied, removed = sync_headers(bridge_headers, target_deps_dir, "cxxbridge")
+        for name in copied:
+            print(f"copied dependency header: {bridge_headers[name]} -> {target_deps_dir / name}")
+        for name in removed:
+            print(f"removed stale dependency header: {target_deps_dir / name}")
+
+    # The generated .cc sources of crates without a Dora library are compiled
+    # into the cached bridge library (see build_bridge_library) and linked
+    # ahead of the Dora libraries; a crate's staticlib already holds them
+    generated_sources = [str(p) for p in bridge_sources_to_compile(generated_cc, Path(dora_target), profile, kind)]
+    # Build flags differ between MSVC (cl) and gcc/clang (g++, clang++). Compile flags are
+    # shared by every translation unit; link arguments follow the objects in the final link.
     if kind == "msvc":
-        # cl compiles+links in one invocation. Use /std:c++17 and /EHsc for exceptions.
-        # Ensure runtime library matches Dora's build: always use /MD to match release libs
+        # /EHsc for exceptions. Ensure runtime library matches Dora's build: always use /MD to match release libs
         runtime_flag = "/MD"
-        cmd = [cc, "/nologo", "/EHsc", runtime_flag]
+        compile_flags = ["/nologo", "/EHsc", runtime_flag]
         
         # Add C++ standard from config
         std_flag = f"/std:{config.build.std}" if config else "/std:c++17"
-        cmd.append(std_flag)
+        compile_flags.append(std_flag)
         
         # Add custom compiler flags from config, converting GCC/Clang flags to MSVC equivalents
         if config:
@@ -867,10 +1115,17 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
                 elif flag == "-w":
                     msvc_flags.append("/w")  # Disable all warnings
                     has_warning_suppression = True
+                elif flag == "-O0":
+                    msvc_flags.append("/Od")  # Disable optimizations
+                elif flag in ("-O1", "-Os"):
+                    msvc_flags.append("/O1")  # Optimize for size
                 elif flag == "-O2":
                     msvc_flags.append("/O2")  # Optimization level 2
                 elif flag == "-O3":
                     msvc_flags.append("/Ox")  # Maximum optimization
+                elif flag.startswith(("-march=", "-mcpu=")):
+                    # Convert CPU targeting to /arch (or keep it for clang-cl)
+                    msvc_flags.extend(cpu_flags(kind, compiler_family(cc, kind), flag.split("=", 1)[1]))
                 elif flag.startswith("-D"):
                     msvc_flags.append(f"/D{flag[2:]}")  # Convert -DFOO to /DFOO
                 elif flag.startswith("/"):
@@ -896,32 +1151,27 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
                         msvc_flags.append("/wd4275")  # Disable base class export warnings
                         break
             
-            cmd.extend(msvc_flags)
+            compile_flags.extend(msvc_flags)
         
         # add include dirs for MSVC (Dora includes first)
         for inc in include_dirs:
-            cmd += ["/I", inc]
+            compile_flags += ["/I", inc]
         
         # Add Arrow include directories
         for inc in arrow_include_dirs:
-            cmd += ["/I", inc]
+            compile_flags += ["/I", inc]
         
         # Add dependency include directories
         if dep_manager:
             dep_include_flags, _, _ = dep_manager.get_compiler_flags()
             for flag in dep_include_flags:
-                cmd += ["/I", flag[2:]]  # Remove -I prefix for MSVC
+                compile_flags += ["/I", flag[2:]]  # Remove -I prefix for MSVC
         
         # Add custom include directories from config
         if config:
             for inc_dir in config.build.include_dirs:
                 abs_inc = node_dir / inc_dir if not Path(inc_dir).is_absolute() else Path(inc_dir)
-                cmd += ["/I", str(abs_inc)]
-        
-        # Set object file output directory to target/build
-        cmd.append(f"/Fo{target_build_dir}\\")
-        
-        cmd += [str(s) for s in srcs]
+                compile_flags += ["/I", str(abs_inc)]
         
         # Find any Dora library files under the Dora target dir to pass to linker
         lib_dir = Path(dora_target) / profile
@@ -965,70 +1215,65 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
                 libs.append(syslib)
         
         # /LINK and /OUT
-        cmd += ["/link", "/LIBPATH:" + str(lib_dir)]
+        link_lib_dirs = [str(lib_dir)]
         
         # Add Arrow library directories
-        for arrow_lib_dir in arrow_lib_dirs:
-            cmd += ["/LIBPATH:" + arrow_lib_dir]
+        link_lib_dirs.extend(arrow_lib_dirs)
         
         # Add dependency library directories
         if dep_manager:
-            for lib_dir_path in dep_manager.lib_dirs:
-                cmd += ["/LIBPATH:" + lib_dir_path]
+            link_lib_dirs.extend(dep_manager.lib_dirs)
         
         # Add custom library directories from config
         if config:
             for lib_dir_path in config.build.lib_dirs:
                 abs_lib = node_dir / lib_dir_path if not Path(lib_dir_path).is_absolute() else Path(lib_dir_path)
-                cmd += ["/LIBPATH:" + str(abs_lib)]
+                link_lib_dirs.append(str(abs_lib))
+        
+        link_args = ["/link"] + ["/LIBPATH:" + d for d in link_lib_dirs]
         
         # Add custom linker flags from config
         if config:
-            cmd.extend(config.build.ldflags)
+            link_args.extend(config.build.ldflags)
         
-        cmd += libs
-        cmd += ["/OUT:" + str(temp_out_path)]
-        
-        # Use configured timeout for build
-        timeout = config.build.build_timeout if config else 300
-        run(cmd, cwd=node_dir, timeout=timeout, config=config)
-        
-        # Copy shared libraries if using shared linkage
-        if arrow_library_info.get('linkage') == 'shared' and arrow_library_info.get('shared_files'):
-            copy_shared_libraries(arrow_library_info['shared_files'], final_out_path)
+        link_args += libs
+        link_args += ["/OUT:" + str(temp_out_path)]
+        link_libraries = libs
     else:
         # assume gcc/clang compatible
-        cmd = [cc]
-        cmd += [str(s) for s in srcs]
-        
         # Add C++ standard from config
         std_flag = f"-std={config.build.std}" if config else "-std=c++17"
-        cmd.append(std_flag)
+        compile_flags = [std_flag]
         
         # Add custom compiler flags from config
         if config:
-            cmd.extend(config.build.cxxflags)
+            compile_flags.extend(config.build.cxxflags)
         
         # include dirs (Dora includes first)
         for inc in include_dirs:
-            cmd += ["-I", inc]
+            compile_flags += ["-I", inc]
         
         # Add Arrow include directories
         for inc in arrow_include_dirs:
-            cmd += ["-I", inc]
+            compile_flags += ["-I", inc]
         
         # Add dependency include directories
         if dep_manager:
             dep_include_flags, _, _ = dep_manager.get_compiler_flags()
-            cmd.extend(dep_include_flags)
+            compile_flags.extend(dep_include_flags)
         
         # Add custom include directories from config
         if config:
             for inc_dir in config.build.include_dirs:
                 abs_inc = node_dir / inc_dir if not Path(inc_dir).is_absolute() else Path(inc_dir)
-                cmd += ["-I", str(abs_inc)]
+                compile_flags += ["-I", str(abs_inc)]
+        
+        if os.name != "nt":
+            compile_flags += ["-pthread"]
+        
+        # link flags (custom compiler flags are repeated so options like -fsanitize reach the linker)
+        link_args = list(config.build.cxxflags) if config else []
         
-        # link flags
         # search Dora libs in given dora_target/<profile> and dora_target/<profile>/deps
         # Fallback between debug and release profiles
         base_lib_dir = Path(dora_target) / profile
@@ -1039,11 +1284,13 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
                 base_lib_dir = Path(dora_target) / "debug"
         
         lib_dirs = [base_lib_dir, base_lib_dir / "deps"]
+        link_lib_dirs = []
         linked = []
         for ld in lib_dirs:
             if not ld.exists():
                 continue
-            cmd += ["-L", str(ld)]
+            link_args += ["-L", str(ld)]
+            link_lib_dirs.append(str(ld))
             for f in ld.iterdir():
                 if not f.is_file():
                     continue
@@ -1061,66 +1308,458 @@ def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, d
         # Add dependency library directories and libraries
         if dep_manager:
             _, dep_lib_dir_flags, dep_lib_flags = dep_manager.get_compiler_flags()
-            cmd.extend(dep_lib_dir_flags)
+            link_args.extend(dep_lib_dir_flags)
+            link_lib_dirs.extend(flag[2:] for flag in dep_lib_dir_flags)
         
         # Add Arrow library directories
         for arrow_lib_dir in arrow_lib_dirs:
-            cmd += ["-L", arrow_lib_dir]
+            link_args += ["-L", arrow_lib_dir]
+            link_lib_dirs.append(arrow_lib_dir)
         
         # Add custom library directories from config
         if config:
             for lib_dir_path in config.build.lib_dirs:
                 abs_lib = node_dir / lib_dir_path if not Path(lib_dir_path).is_absolute() else Path(lib_dir_path)
-                cmd += ["-L", str(abs_lib)]
+                link_args += ["-L", str(abs_lib)]
+                link_lib_dirs.append(str(abs_lib))
                 # Add rpath for custom library directories too
                 if os.name != "nt":  # Linux/macOS
-                    cmd += ["-Wl,-rpath," + str(abs_lib)]
+                    link_args += ["-Wl,-rpath," + str(abs_lib)]
         
         # add common flags
         if os.name == "nt":
-            cmd += ["-lws2_32"]
+            link_args += ["-lws2_32"]
         else:
-            cmd += ["-pthread"]
+            link_args += ["-pthread"]
+        
+        link_libraries = list(linked)
         
         # add -l for discovered libs
         for ln in linked:
-            cmd += ["-l", ln]
+            link_args += ["-l", ln]
         
         # Add dependency libraries
         if dep_manager:
             _, _, dep_lib_flags = dep_manager.get_compiler_flags()
-            cmd.extend(dep_lib_flags)
+            link_args.extend(dep_lib_flags)
+            link_libraries.extend(flag[2:] for flag in dep_lib_flags)
         
         # Add Arrow libraries
         for arrow_lib in arrow_libraries:
-            cmd += ["-l", arrow_lib]
+            link_args += ["-l", arrow_lib]
+        link_libraries.extend(arrow_libraries)
         
         # Add system dependencies for Arrow static linking
         if arrow_libraries and os.name != "nt":
             # Arrow needs these system libraries when statically linked
             arrow_system_deps = ["dl", "rt"]  # Dynamic loading and real-time extensions
             for sys_dep in arrow_system_deps:
-                cmd += ["-l", sys_dep]
+                link_args += ["-l", sys_dep]
         
         # Add custom libraries from config
         if config:
             for lib in config.build.libraries:
-                cmd += ["-l", lib]
+                link_args += ["-l", lib]
+            link_libraries.extend(config.build.libraries)
         
         # Add custom linker flags from config
         if config:
-            cmd.extend(config.build.ldflags)
-        
-        cmd += extras
-        cmd += ["-o", str(temp_out_path)]
-        
-        # Use configured timeout for build
-        timeout = config.build.build_timeout if config else 300
-        run(cmd, cwd=node_dir, timeout=timeout, config=config)
+            link_args.extend(config.build.ldflags)
+        
+        link_args += extras
+        link_args += ["-o", str(temp_out_path)]
+
+    # Optimization level, LTO and PGO flags ([build] optimization/lto/pgo). Profile
+    # data is kept per node under target/pgo/<node>.
+    family = compiler_family(cc, kind)
+    node_name = final_out_path.name.removesuffix(".exe")
+    opt = node_optimization_flags(kind, family, config, profile, pgo_dir(project_root, node_name), node_name)
+    # [build] linker: mold, lld or gold when available, threaded with the
+    # configured job count (not -j, which would relink on every change)
+    linker = select_linker(cc, kind, family, config.build.linker if config else None, opt.link)
+    if linker:
+        print(f"[LINK] Linking with {linker}")
+    opt = merge_flags(opt, linker_flags(kind, family, linker, default_job_count(config.build.parallel_jobs if config else None),
+                                        config.build.lto if config else None))
+    # The cxxbridge sources only need Dora's headers: without this project's
+    # include dirs, the log/metrics settings and the PGO flags (the profile is
+    # the node's), nodes share one bridge library
+    bridge_opt = node_optimization_flags(kind, family, config, profile, pgo_dir(project_root, node_name), node_name,
+                                         pgo=False)
+    bridge_flags = shared_bridge_flags(compile_flags + bridge_opt.compile, kind, project_root)
+    compile_flags += opt.compile
+    compile_flags += log_defines(kind, config, profile)
+    compile_flags += metrics_defines(kind, config)
+    compile_flags += eigen_defines(kind, config, profile)
+    if uses_eigen(config) and profile == "release" and not (config.build.target_cpu or config.build.cpu_variants):
+        print("[EIGEN] Eigen is vectorized for the compiler's default CPU only; set [build] target_cpu "
+              "or cpu_variants (e.g. [\"x86-64-v2\", \"x86-64-v3\"]) to use AVX kernels")
+    if kind == "msvc":
+        # driver options must precede /link, linker options follow it
+        link_args = opt.link + ["/link"] + opt.linker + link_args[1:]
+    else:
+        link_args = opt.link + link_args
+
+    # Files and directories the resolution was derived from; a change to any of
+    # them invalidates the manifest
+    watch = [shutil.which(cc) or cc]
+    for root in [Path(dora_target) / profile / "cxxbridge", Path(dora_target) / "cxxbridge"]:
+        if root.exists():
+            watch.append(root)
+            for crate_dir in root.iterdir():
+                watch += [crate_dir, crate_dir / "src", crate_dir / "src" / "lib.rs.h"]
+    watch += generated_cc
+    watch += link_lib_dirs
+    watch += arrow_include_dirs
+    if dep_manager:
+        watch += [str(d) for d in dep_manager.include_dirs]
+
+    resolved = {
+        "dora_target": str(dora_target),
+        "cc": cc,
+        "kind": kind,
+        "family": family,
+        "compile_flags": compile_flags,
+        "link_args": link_args,
+        "link_lib_dirs": [str(d) for d in link_lib_dirs],
+        "link_libraries": list(link_libraries),
+        "generated_sources": generated_sources,
+        "bridge_flags": bridge_flags,
+        "arrow_linkage": arrow_library_info.get("linkage"),
+        "arrow_shared_files": [str(f) for f in arrow_library_info.get("shared_files", [])],
+        "env": msvc_env,
+    }
+    return resolved, watch
+
+
+BRIDGE_DIR = "doracxx-bridge"  # Under the Dora target directory
+
+
+def bridge_archiver(cc: str, kind: str, family: str) -> list:
+    """Archiver command creating a static library; the library and the objects follow it"""
+    if kind == "msvc":
+        tool = (family == "clang-cl" and shutil.which("llvm-lib")) or "lib"
+        return [tool, "/NOLOGO"]
+    # the compiler's own archiver understands LTO objects
+    sibling = Path(cc).with_name({"gcc": "gcc-ar", "clang": "llvm-ar"}.get(family, "ar"))
+    if sibling.is_absolute() and sibling.exists():
+        return [str(sibling), "rcs"]
+    tool = shutil.which({"gcc": "gcc-ar", "clang": "llvm-ar"}.get(family, "ar")) or "ar"
+    return [tool, "rcs"]
+
+
+def shared_bridge_flags(compile_flags: list, kind: str, project_root: Path) -> list:
+    """compile_flags without the include dirs of the project (and relative ones)"""
+    root = project_root.resolve()
+    option = "/I" if kind == "msvc" else "-I"
+    flags = []
+    i = 0
+    while i < len(compile_flags):
+        flag = compile_flags[i]
+        path = None
+        if flag == option and i + 1 < len(compile_flags):
+            path, step = compile_flags[i + 1], 2
+        elif flag.startswith(option) and len(flag) > len(option):
+            path, step = flag[len(option):], 1
+        if path is None:
+            flags.append(flag)
+            i += 1
+            continue
+        resolved = Path(path).resolve() if Path(path).is_absolute() else None
+        if resolved is not None and resolved != root and root not in resolved.parents:
+            flags += compile_flags[i:i + step]
+        i += step
+    return flags
+
+
+def build_bridge_library(cc: str, kind: str, family: str, flags: list, sources: list, dora_target: Path,
+                         profile: str, scheduler: JobScheduler, launcher: list | None = None,
+                         object_cache=None) -> Path:
+    """Compile the cxxbridge-generated sources into a static library, once per Dora, profile and toolchain
+
+    The library lives in <dora target>/doracxx-bridge/<profile>-<key>, the
+    key hashing the compiler and flags, so every node built against the same
+    Dora links the same library and only the first build compiles it.
+    """
+    key = flags_hash(cc, kind, list(flags) + [str(src) for src in sources])[:16]
+    out_dir = Path(dora_target) / BRIDGE_DIR / f"{profile}-{key}"
+    out_dir.mkdir(parents=True, exist_ok=True)
+    library = out_dir / ("doracxx_bridge.lib" if kind == "msvc" else "libdoracxx_bridge.a")
+    units = plan_translation_units(sources, out_dir, out_dir / "obj", kind)
+    objects = [unit.obj for unit in units]
+    with cache_lock(out_dir):
+        state = BuildState.load(out_dir / STATE_FILE)
+        compiled = compile_translation_units(cc, kind, flags, units, state, scheduler, cwd=out_dir,
+                                             launcher=launcher, object_cache=object_cache)
+        lib_mtime = library.stat().st_mtime_ns if library.exists() else None
+        if compiled or lib_mtime is None or any(obj.stat().st_mtime_ns > lib_mtime for obj in objects):
+            tmp = library.with_name(library.name + ".tmp")
+            tmp.unlink(missing_ok=True)
+            archiver = bridge_archiver(cc, kind, family)
+            if kind == "msvc":
+                cmd = archiver + [f"/OUT:{tmp}"] + [str(obj) for obj in objects]
+            else:
+                cmd = archiver + [str(tmp)] + [str(obj) for obj in objects]
+            with phase("cxxbridge library", "link"):
+                result = subprocess.run(cmd, cwd=out_dir, capture_output=True, text=True)
+            if result.returncode != 0:
+                raise RuntimeError(f"creating {library.name} failed: {(result.stdout + result.stderr).strip()}")
+            os.replace(tmp, library)
+            print(f"[BRIDGE] Built {library} from {len(objects)} cxxbridge source(s)")
+    return library
+
+
+def retarget_link_args(link_args: list, out_path: Path, new_out_path: Path) -> list:
+    """Point the output argument of resolved link arguments at another executable"""
+    if new_out_path == out_path:
+        return list(link_args)
+    replaced = {str(out_path): str(new_out_path), "/OUT:" + str(out_path): "/OUT:" + str(new_out_path)}
+    return [replaced.get(arg, arg) for arg in link_args]
+
+
+def build_cpu_launcher(cc: str, kind: str, out_name: str, variants: list, out_path: Path, build_dir: Path,
+                       target_arch: str, scheduler: JobScheduler, node_dir: Path, timeout: int,
+                       config: DoracxxConfig | None = None):
+    """Build the launcher that runs the best CPU variant of a node"""
+    source = build_dir / LAUNCHER_SOURCE
+    write_if_changed(source, render_launcher(out_name, variants, kind, target_arch))
+    # the launcher must run on every CPU, so it is built without target flags
+    flags = ["/nologo", "/O2", "/EHsc"] if kind == "msvc" else ["-O2"]
+    units = plan_translation_units([source], build_dir, build_dir / "obj", kind)
+    state = BuildState.load(build_dir / STATE_FILE)
+    compile_translation_units(cc, kind, flags, units, state, scheduler, cwd=node_dir)
+
+    objects = [u.obj for u in units]
+    if kind == "msvc":
+        link_cmd = [cc, "/nologo"] + [str(o) for o in objects] + ["/link", "/OUT:" + str(out_path)]
+    else:
+        link_cmd = [cc] + [str(o) for o in objects] + ["-o", str(out_path)]
+    if link_is_up_to_date(out_path, objects, link_cmd, [], state):
+        print(f"[LINK] {out_path.name} is up to date")
+    else:
+        print(f"[LINK] Linking CPU launcher {out_path.name} ({', '.join(variants)})")
+        run(link_cmd, cwd=node_dir, timeout=timeout, config=config)
+        record_link(state, link_cmd)
+
+
+def compile_node(node_dir: Path, build_dir: Path, out_name: str, profile: str, dora_target: str, extras: list, config: DoracxxConfig | None = None, dora_git: str | None = None, dora_rev: str | None = None, jobs: int | None = None, refresh: bool = False, target_subdir: str | None = None):
+    """Build the node into target/<profile>/<out_name>.
+
+    target_subdir keeps the build manifest, objects and build state under
+    target/<profile>/<target_subdir> instead, so another executable built from
+    the same sources (`doracxx bench`) does not invalidate the node's.
+    """
+    # Extract Dora configuration from config if available
+    final_dora_git = dora_git
+    final_dora_rev = dora_rev
+    if config and config.node:
+        if config.node.dora_git:
+            final_dora_git = config.node.dora_git
+        if config.node.dora_rev:
+            final_dora_rev = config.node.dora_rev
+    
+    srcs = discover_node_sources(node_dir, config)
+    
+    # Use target/<profile>/ for ALL build artifacts (like Rust projects)
+    # Use the project root directory, not the current working directory
+    project_root = find_project_root(node_dir)
+    workspace_target_dir = project_root / "target" / profile
+    workspace_target_dir.mkdir(parents=True, exist_ok=True)
+    
+    # Create subdirectories in target for organization
+    state_dir = workspace_target_dir / target_subdir if target_subdir else workspace_target_dir
+    state_dir.mkdir(parents=True, exist_ok=True)
+    target_build_dir = state_dir / "build"
+    target_deps_dir = workspace_target_dir / "deps" 
+    target_include_dir = workspace_target_dir / "include"
+    target_build_dir.mkdir(exist_ok=True)
+    target_deps_dir.mkdir(exist_ok=True)
+    target_include_dir.mkdir(exist_ok=True)
+    
+    # Final executable path
+    final_out_path = workspace_target_dir / (out_name + (".exe" if os.name == "nt" else ""))
+    
+    sync_project_headers(node_dir, target_include_dir)
+    install_support_headers(target_deps_dir, config.build.std if config else None)
+    
+    # Reuse the resolved toolchain, flags and generated sources from the last build
+    # while its inputs are unchanged; otherwise resolve them again (this prepares
+    # Dora/Arrow, resolves dependencies and scans the cxxbridge outputs)
+    fingerprint = build_fingerprint(node_dir=str(node_dir), profile=profile, out_name=out_name,
+                                    dora_target=dora_target, dora_git=final_dora_git, dora_rev=final_dora_rev,
+                                    extras=extras, config=config, linkers=linker_binaries())
+    manifest = BuildManifest.load(state_dir / MANIFEST_FILE)
+    stale = "refresh requested" if refresh else manifest.stale_reason(fingerprint)
+    if stale is None:
+        print(f"[MANIFEST] Reusing resolved build configuration ({manifest.path})")
+        resolved = manifest.resolved
+        os.environ.update(resolved.get("env", {}))
+    else:
+        print(f"[MANIFEST] Resolving build configuration ({stale})")
+        resolved, watch = resolve_build(node_dir, profile, dora_target, extras, config, final_dora_git, final_dora_rev,
+                                        project_root, workspace_target_dir, target_deps_dir, target_include_dir,
+                                        final_out_path, jobs)
+        manifest.update(fingerprint, resolved, watch)
+    
+    cc = resolved["cc"]
+    kind = resolved["kind"]
+    compile_flags = resolved["compile_flags"]
+    link_args = resolved["link_args"]
+    link_lib_dirs = resolved["link_lib_dirs"]
+    link_libraries = resolved["link_libraries"]
+    # Generated cxxbridge sources are compiled once in the doracxx cache for every
+    # node using the same flags; manifests from before that compile them per node
+    bridge_flags = resolved.get("bridge_flags")
+    bridge_srcs = [Path(p) for p in resolved["generated_sources"]]
+    if bridge_flags is None:
+        srcs += bridge_srcs
+        bridge_srcs = []
+    
+    timeout = config.build.build_timeout if config else 300
+    family = resolved.get("family") or compiler_family(cc, kind)
+    link_prefix = [cc, "/nologo"] if kind == "msvc" else [cc]
+    link_inputs = resolve_link_inputs(link_lib_dirs, link_libraries, kind)
+
+    # Merge/collect the recorded PGO profile data; the stamp it maintains makes
+    # every unit and the link rebuild when new profile data is recorded
+    pgo = config.build.pgo if config else None
+    stamp = None
+    if pgo:
+        stamp = prepare_profile_data(pgo, family, cc, pgo_dir(project_root, out_name), out_name, final_out_path)
+        if stamp:
+            link_inputs.append(str(stamp))
+    max_jobs = jobs or (config.build.parallel_jobs if config else None)
+    cache_mode = config.build.compiler_cache if config else CompilerCache.AUTO
+    launcher, object_cache = setup_compiler_cache(cache_mode, base_dirs=[project_root, get_doracxx_cache_dir()])
+
+    ninja = None
+    if config and config.build.system == BuildSystem.NINJA:
+        ninja = find_ninja()
+        if not ninja:
+            print("[WARN] build system is 'ninja' but no ninja executable was found; using the native backend")
+        elif object_cache is not None:
+            print("[WARN] the built-in object cache is not used with the ninja backend; use ccache or sccache instead")
+    custom_patterns = config.build.warning_filter_patterns if config else None
+    # --timings: a clang -ftime-trace profile per compiled unit
+    trace_flags = time_trace_flags(family) if TIMINGS.enabled else []
+    # [build] size_opt reports the size per linked library from a link map;
+    # strip and split_debug run on each freshly linked executable
+    size_opt = config.build.size_opt if config else False
+    strip = config.build.strip if config else False
+    split_debug = config.build.split_debug if config else False
+    macos = sys.platform == "darwin"
+
+    def new_scheduler():
+        return JobScheduler(
+            max_jobs=max_jobs,
+            cwd=node_dir,
+            timeout=timeout,
+            line_filter=lambda line: should_print_line(line, custom_patterns),
+        )
+
+    def build_executable(out_path: Path, build_dir: Path, cpu_args: list):
+        """Compile the node's units under build_dir and link them into out_path"""
+        unit_flags = compile_flags + cpu_args
+        units = plan_translation_units(srcs, node_dir, build_dir / "obj", kind)
+        objects = [u.obj for u in units]
+
+        # Precompile the [build] pch headers once and force-include them in every C++ unit
+        pch_units = []
+        if config and config.build.pch:
+            pch = plan_pch(cc, kind, family, unit_flags, config.build.pch, build_dir / "pch")
+            apply_pch(pch, units, kind, family)
+            pch_units = [pch.unit]
+            objects += pch.link_objects
+        for unit in units:
+            if stamp:
+                unit.extra_inputs = unit.extra_inputs + [stamp]
+            # the profile is not part of the preprocessed source the object cache keys on
+            if pgo == "use":
+                unit.cacheable = False
+
+        if bridge_srcs:
+            # goes ahead of the Dora libraries in the link, which it calls into
+            objects.append(build_bridge_library(cc, kind, resolved["family"], bridge_flags + cpu_args, bridge_srcs,
+                                                Path(resolved["dora_target"]), profile, new_scheduler(),
+                                                launcher=launcher, object_cache=object_cache))
+
+        exe_link_prefix = link_prefix + (cpu_args if kind != "msvc" else [])
+        exe_link_args = retarget_link_args(link_args, final_out_path, out_path)
+        map_path = build_dir / LINK_MAP_FILE if size_opt else None
+        if map_path:
+            exe_link_args = exe_link_args + link_map_flags(kind, map_path, macos)
+        post_link = post_link_commands(kind, out_path, strip, split_debug, macos)
+
+        def finish_link():
+            for cmd in post_link:
+                run(cmd, cwd=node_dir, timeout=timeout, config=config)
+            if size_opt:
+                print_size_report(out_path, map_path, str(build_dir / "obj"))
+
+        if ninja:
+            # Let ninja drive compile and link from <build_dir>/build.ninja;
+            # the file is only rewritten when the resolved commands change
+            content = generate_ninja(cc, kind, unit_flags, pch_units + units, exe_link_prefix, exe_link_args,
+                                     out_path, link_inputs, cwd=node_dir, launcher=launcher,
+                                     objects=objects)
+            write_ninja_file(build_dir, content)
+            linked_before = out_path.stat().st_mtime_ns if out_path.exists() else None
+            with phase(f"ninja {out_path.name}", "compile"):
+                run(ninja_command(ninja, build_dir, max_jobs), cwd=node_dir,
+                    timeout=timeout * (len(units) + 1), config=config)
+            if out_path.exists() and out_path.stat().st_mtime_ns != linked_before:
+                finish_link()
+            return
+
+        # Compile each translation unit to its own object under <build_dir>/obj,
+        # skipping units whose source, headers and flags are unchanged since the last build
+        state = BuildState.load(build_dir / STATE_FILE)
+        remove_stale_objects(state, pch_units + units)
+        scheduler = new_scheduler()
+        if pch_units:
+            compile_translation_units(cc, kind, unit_flags, pch_units, state, scheduler, cwd=node_dir,
+                                      launcher=launcher)
+        with phase(f"compile {out_path.name}", "build"):
+            compile_translation_units(cc, kind, unit_flags, units, state, scheduler, cwd=node_dir,
+                                      launcher=launcher, object_cache=object_cache, trace_flags=trace_flags)
+
+        # Link once every object is up to date; the post-link steps are part of
+        # how the executable was made
+        link_cmd = exe_link_prefix + [str(o) for o in objects] + exe_link_args
+        link_key = link_cmd + [arg for cmd in post_link for arg in cmd]
+        if link_is_up_to_date(out_path, objects, link_key, link_inputs, state):
+            print(f"[LINK] {out_path.name} is up to date")
+        else:
+            print(f"[LINK] Linking {out_path.name}")
+            with phase(f"link {out_path.name}", "link"):
+                run(link_cmd, cwd=node_dir, timeout=timeout, config=config)
+                finish_link()
+            record_link(state, link_key)
+
+    cpu_variants = list(config.build.cpu_variants) if config else []
+    if cpu_variants:
+        # One executable per CPU level in target/<profile>/<node>-<variant>, each
+        # built under build/cpu/<variant>, and a launcher under the node's name
+        target_arch = compiler_target_arch(cc, kind)
+        variants = order_variants(cpu_variants, target_arch)
+        if not variants:
+            raise RuntimeError("cpu_variants: no variant matches the compiler's target architecture")
+        exe_suffix = ".exe" if os.name == "nt" else ""
+        for variant in variants:
+            print(f"[CPU] Building variant {variant}")
+            build_executable(workspace_target_dir / (variant_name(out_name, variant) + exe_suffix),
+                             target_build_dir / "cpu" / variant_id(variant),
+                             cpu_flags(kind, family, variant))
+        build_cpu_launcher(cc, kind, out_name, variants, final_out_path, target_build_dir / "launcher",
+                           target_arch=target_arch, scheduler=new_scheduler(),
+                           node_dir=node_dir, timeout=timeout, config=config)
+    else:
+        target_cpu = config.build.target_cpu if config else None
+        build_executable(final_out_path, target_build_dir, cpu_flags(kind, family, target_cpu))
     
     # Copy shared libraries if using shared linkage
-    if arrow_library_info.get('linkage') == 'shared' and arrow_library_info.get('shared_files'):
-        copy_shared_libraries(arrow_library_info['shared_files'], final_out_path)
+    if resolved.get("arrow_linkage") == "shared" and resolved.get("arrow_shared_files"):
+        copy_shared_libraries([Path(f) for f in resolved["arrow_shared_files"]], final_out_path)
     
     # Check if executable was created successfully
     if final_out_path.exists():
@@ -1197,6 +1836,7 @@ def ensure_clang_installed(install: bool = False):
         if not dest_zip.exists():
             print(f"Downloading LLVM from {default_url} to {dest_zip}...")
             try:
+                import urllib.request
                 with urllib.request.urlopen(default_url) as resp, open(dest_zip, "wb") as out:
                     shutil.copyfileobj(resp, out)
             except Exception as e:
@@ -1221,6 +1861,8 @@ def ensure_clang_installed(install: bool = False):
         extract_dir = target_root / zip_name.replace('.zip', '').replace('.tar.xz', '')
         if not extract_dir.exists():
             print(f"Extracting {dest_zip} to {extract_dir}...")
+            import tarfile
+            import zipfile
             if zip_name.endswith('.zip'):
                 with zipfile.ZipFile(dest_zip, 'r') as z:
                     z.extractall(extract_dir)
@@ -1307,7 +1949,7 @@ def copy_shared_libraries_to_executable_dir(executable_path: Path, lib_dirs: Lis
     return copied_libs
 
 
-def main():
+def build_arg_parser() -> argparse.ArgumentParser:
     parser = argparse.ArgumentParser()
     parser.add_argument("--node-dir", default=None, help="directory containing the node (defaults to current directory if it contains doracxx.toml)")
     parser.add_argument("--profile", default=None, help="build profile: debug or release (overrides config)")
@@ -1321,9 +1963,16 @@ def main():
     parser.add_argument("--config", default=None, help="path to doracxx.toml configuration file")
     parser.add_argument("--no-config", action="store_true", help="disable automatic config loading")
     parser.add_argument("--no-auto-prepare", action="store_true", help="disable automatic Dora preparation")
-    args = parser.parse_args()
+    parser.add_argument("--refresh", action="store_true", help="re-resolve Dora, Arrow, dependencies and flags instead of reusing the build manifest")
+    parser.add_argument("-j", "--jobs", type=int, default=None, help="number of parallel compile jobs (overrides config parallel_jobs, defaults to CPU count)")
+    parser.add_argument("--timings", action="store_true", help="record how long each phase and translation unit takes; writes target/<profile>/doracxx-timings.json (Chrome trace) and .html")
+    parser.add_argument("--dataflow", default=None, help="build every doracxx node of a Dora dataflow.yml in one process")
+    parser.add_argument("--workspace", nargs="?", const="doracxx.toml", default=None, help="build the [workspace] members of a doracxx.toml (defaults to ./doracxx.toml)")
+    return parser
+
 
-    # Auto-detect node directory if not specified
+def find_node_dir(args) -> Path:
+    """--node-dir, or the current directory / project root when it has a doracxx.toml"""
     if args.node_dir is None:
         # Check if current directory contains doracxx.toml
         current_dir = Path.cwd()
@@ -1347,7 +1996,14 @@ def main():
                 sys.exit(1)
     else:
         node_dir = Path(args.node_dir).resolve()
+    return node_dir
+
+
+def build_node(args, node_dir: Path) -> Path:
+    """Build the node in node_dir with the command-line args; returns the executable
 
+    Raises when the build fails. args.profile is set to the profile used.
+    """
     build_dir = node_dir / "build"
     build_dir.mkdir(parents=True, exist_ok=True)
 
@@ -1386,6 +2042,7 @@ def main():
         dora_rev = args.dora_rev
         out_name = args.out or "node"
         install_clang = args.install_clang
+    args.profile = profile
 
     print(f"[BUILD] Building node: {out_name}")
     print(f"[NODE] Node directory: {node_dir}")
@@ -1407,15 +2064,9 @@ def main():
     dora_target = args.dora_target or os.environ.get("DORA_TARGET_DIR")
     if not dora_target:
         if not args.no_auto_prepare:
-            # Automatically ensure Dora is prepared with the right version
-            try:
-                dora_target = ensure_dora_prepared(dora_git, dora_rev, profile)
-                print(f"Using Dora target directory: {dora_target}")
-            except Exception as e:
-                print(f"[ERROR] Failed to prepare Dora automatically: {e}")
-                # Fallback to manual target detection
-                dora_target = find_dora_target_dir(dora_git, dora_rev)
-                print(f"Using fallback Dora target directory: {dora_target}")
+            # compile_node prepares Dora with the right version, unless the build
+            # manifest from the previous build is still valid
+            dora_target = None
         else:
             # Manual mode - just find existing target
             dora_target = find_dora_target_dir(dora_git, dora_rev)
@@ -1466,11 +2117,13 @@ def main():
         ensure_clang_installed(install=True)
 
     try:
-        out = compile_node(node_dir, build_dir, out_name, profile, dora_target, 
-                          extras=["-l", "dora_node_api_cxx"], config=config, 
-                          dora_git=dora_git, dora_rev=dora_rev)
+        with phase("compile_node", "build", node=out_name):
+            out = compile_node(node_dir, build_dir, out_name, profile, dora_target, 
+                              extras=["-l", "dora_node_api_cxx"], config=config, 
+                              dora_git=dora_git, dora_rev=dora_rev, jobs=args.jobs,
+                              refresh=args.refresh)
         print("built:", out)
-        sys.exit(0)  # Explicit successful exit
+        return out
     except Exception as e:
         print(f"compilation failed: {e}")
         # Check if the executable was actually created despite the error in target location
@@ -1480,10 +2133,52 @@ def main():
         if expected_exe_target.exists():
             print(f"However, executable was successfully created in target: {expected_exe_target}")
             print("built:", expected_exe_target)
-            sys.exit(0)  # Explicit successful exit even if there was an exception
-        else:
-            print(f"Executable not found in target: {expected_exe_target}")
-            sys.exit(1)
+            return expected_exe_target
+        print(f"Executable not found in target: {expected_exe_target}")
+        raise
+
+
+def main():
+    args = build_arg_parser().parse_args()
+    if args.timings:
+        TIMINGS.enable()
+
+    if args.dataflow or args.workspace:
+        try:
+            from .workspace import build_workspace_command
+        except ImportError:
+            from workspace import build_workspace_command
+        sys.exit(build_workspace_command(args))
+
+    node_dir = find_node_dir(args)
+    try:
+        build_node(args, node_dir)
+        sys.exit(0)  # Explicit successful exit
+    except Exception:
+        sys.exit(1)
+    finally:
+        if args.timings:
+            write_report(find_project_root(node_dir) / "target" / (args.profile or "debug"))
+
+_msvc_env_lock = threading.Lock()
+_msvc_env: dict | None = None
+
+
+def msvc_environment() -> dict:
+    """Variables vcvarsall adds on Windows, loaded once per process (empty elsewhere)"""
+    global _msvc_env
+    with _msvc_env_lock:
+        if _msvc_env is None:
+            env_before = dict(os.environ)
+            if os.name == "nt":
+                try:
+                    load_msvc_env()
+                except Exception:
+                    # if it fails, we continue and rely on PATH / CXX
+                    pass
+            _msvc_env = {k: v for k, v in os.environ.items() if env_before.get(k) != v}
+        return dict(_msvc_env)
+
 
 def load_msvc_env():
     """Locate vcvarsall.bat using vswhere or common install paths, run it and import the environment.
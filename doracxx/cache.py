@@ -1,9 +1,17 @@
 #!/usr/bin/env python3
 """Cache management utilities for doracxx."""
 
+from contextlib import contextmanager
 from pathlib import Path
+import os
 import subprocess
 import shutil
+import time
+
+try:
+    from .config import resolve_arrow_components
+except ImportError:
+    from config import resolve_arrow_components
 
 
 def get_doracxx_cache_dir():
@@ -14,6 +22,71 @@ def get_doracxx_cache_dir():
     return cache_dir
 
 
+def get_object_cache_dir():
+    """Get the built-in compiler object cache directory (~/.doracxx/objects)."""
+    return get_doracxx_cache_dir() / "objects"
+
+
+def _try_lock(handle) -> bool:
+    try:
+        if os.name == "nt":
+            import msvcrt
+            handle.seek(0)
+            msvcrt.locking(handle.fileno(), msvcrt.LK_NBLCK, 1)
+        else:
+            import fcntl
+            fcntl.flock(handle.fileno(), fcntl.LOCK_EX | fcntl.LOCK_NB)
+        return True
+    except OSError:
+        return False
+
+
+def _unlock(handle):
+    if os.name == "nt":
+        import msvcrt
+        handle.seek(0)
+        msvcrt.locking(handle.fileno(), msvcrt.LK_UNLCK, 1)
+    else:
+        import fcntl
+        fcntl.flock(handle.fileno(), fcntl.LOCK_UN)
+
+
+@contextmanager
+def cache_lock(entry: Path):
+    """Hold an exclusive lock on a cache entry while preparing it.
+
+    The lock is <entry>.lock next to the entry, so concurrent doracxx builds
+    (several nodes of one dataflow, say) take turns cloning and building the
+    same Dora, Arrow or dependency revision instead of corrupting it. Threads
+    of one build exclude each other too. Whoever waited should check whether
+    the entry was completed meanwhile.
+    """
+    lock_path = entry.with_name(entry.name + ".lock")
+    lock_path.parent.mkdir(parents=True, exist_ok=True)
+    with open(lock_path, "a+b") as handle:
+        if not _try_lock(handle):
+            print(f"[LOCK] Waiting for another build preparing {entry}...")
+            while not _try_lock(handle):
+                time.sleep(0.2)
+        try:
+            yield
+        finally:
+            _unlock(handle)
+
+
+def object_cache_stats(root: Path | None = None):
+    """Return (object count, total size in bytes) of the built-in object cache."""
+    root = root or get_object_cache_dir()
+    count = 0
+    size = 0
+    if root.exists():
+        for path in root.rglob('*'):
+            if path.is_file() and not path.name.endswith('.tmp'):
+                count += 1
+                size += path.stat().st_size
+    return count, size
+
+
 def get_latest_git_tag(url: str) -> str | None:
     """Get the latest git tag from a remote repository."""
     try:
@@ -94,6 +167,13 @@ def cache_info():
                     print(f"  {item.name}  (size unknown)")
     else:
         print("Cache directory does not exist yet.")
+        return
+
+    count, size = object_cache_stats()
+    print(f"\nBuilt-in object cache: {count} object{'s' if count != 1 else ''} ({size / (1024 * 1024):.1f} MB)")
+    for launcher in ("ccache", "sccache"):
+        if shutil.which(launcher):
+            print(f"  {launcher} available: {shutil.which(launcher)} (run '{launcher} -s' for statistics)")
 
 
 def cache_clean():
@@ -147,6 +227,28 @@ def get_arrow_cache_path(url: str | None = None, rev: str | None = None, linkage
             return cache_dir / f"{repo_name}-main-{linkage}"
 
 
+def arrow_install_name(lto: str | None = None, simd_level: str | None = None,
+                       allocator: str | None = None, components: list | None = None) -> str:
+    """Name of the install directory inside an Arrow cache entry.
+
+    LTO builds contain compiler-specific bitcode, CPU-specific builds only run
+    on matching CPUs, and allocator and component choices change the libraries
+    to link, so each is installed next to the regular build instead of
+    replacing it.
+    """
+    name = "install"
+    if lto:
+        name += "-lto"
+    if simd_level:
+        name += f"-simd-{simd_level.lower()}"
+    if allocator and allocator != "system":
+        name += f"-{allocator}"
+    if components is not None and resolve_arrow_components(components) != resolve_arrow_components():
+        import hashlib
+        name += "-" + hashlib.md5(",".join(resolve_arrow_components(components)).encode()).hexdigest()[:8]
+    return name
+
+
 def sanitize_for_filesystem(name: str) -> str:
     """Sanitize a string to be safe for use as a filesystem path component."""
     import re
@@ -231,3 +333,32 @@ def cache_clean_arrow():
             print("No Arrow cache directories found.")
     else:
         print("Cache directory does not exist.")
+
+
+def cache_clean_objects():
+    """Clean only the built-in compiler object cache"""
+    objects_dir = get_object_cache_dir()
+    if objects_dir.exists():
+        count, size = object_cache_stats(objects_dir)
+        try:
+            shutil.rmtree(objects_dir)
+            print(f"Removed {count} cached object{'s' if count != 1 else ''} ({size / (1024 * 1024):.1f} MB): {objects_dir}")
+        except Exception as e:
+            print(f"Error clearing object cache: {e}")
+    else:
+        print("No object cache found.")
+
+
+def cache_clean_artifacts():
+    """Clean only the local prebuilt artifact archives (see artifacts.py)"""
+    artifacts_dir = get_doracxx_cache_dir() / "artifacts"
+    if artifacts_dir.exists():
+        archives = list(artifacts_dir.glob("*.tar.gz"))
+        size = sum(archive.stat().st_size for archive in archives)
+        try:
+            shutil.rmtree(artifacts_dir)
+            print(f"Removed {len(archives)} artifact archive{'s' if len(archives) != 1 else ''} ({size / (1024 * 1024):.1f} MB): {artifacts_dir}")
+        except Exception as e:
+            print(f"Error clearing artifact archives: {e}")
+    else:
+        print("No artifact archives found.")
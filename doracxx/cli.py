@@ -15,7 +15,7 @@ import subprocess
 import sys
 import shutil
 from pathlib import Path
-from .cache import get_doracxx_cache_dir, cache_info, cache_clean, cache_clean_dora, cache_clean_arrow
+from .cache import get_doracxx_cache_dir, cache_info, cache_clean, cache_clean_dora, cache_clean_arrow, cache_clean_objects, cache_clean_artifacts
 
 
 def _run_script(name: str, args=None):
@@ -53,6 +53,14 @@ def _run_script(name: str, args=None):
             prepare_arrow.main()
         finally:
             sys.argv = original_argv
+    elif name == "bench.py":
+        from . import bench
+        original_argv = sys.argv
+        try:
+            sys.argv = [name] + args
+            bench.main()
+        finally:
+            sys.argv = original_argv
     else:
         # Fallback to subprocess for unknown scripts
         package_root = Path(__file__).resolve().parent
@@ -73,6 +81,15 @@ def build_node():
     _run_script("build-cxx-node.py", args)
 
 
+def bench_node():
+    """Build and run a node's micro-benchmarks"""
+    args = list(sys.argv[1:])
+    if args and not args[0].startswith('-'):
+        node_dir = args.pop(0)
+        args = ["--node-dir", node_dir] + args
+    _run_script("bench.py", args)
+
+
 def prepare_dora():
     """Prepare Dora environment and dependencies"""
     _run_script("prepare-dora.py", list(sys.argv[1:]))
@@ -95,6 +112,10 @@ def main():
         # Remove 'build' from args and call build_node
         sys.argv = [sys.argv[0]] + sys.argv[2:]
         build_node()
+    elif subcommand == "bench":
+        # Remove 'bench' from args and call bench_node
+        sys.argv = [sys.argv[0]] + sys.argv[2:]
+        bench_node()
     elif subcommand in ["prepare", "prep", "p"]:
         # Handle prepare command with subtype
         if len(sys.argv) >= 3 and sys.argv[2] in ["arrow", "a"]:
@@ -105,6 +126,10 @@ def main():
             # Remove 'prepare' from args and call prepare_dora (default)
             sys.argv = [sys.argv[0]] + sys.argv[2:]
             prepare_dora()
+    elif subcommand == "new" and (len(sys.argv) > 2 and not sys.argv[2].startswith("-")
+                                  or any(arg in sys.argv for arg in ["-t", "--template", "-n", "--name", "-h", "--help"])):
+        # Create a node project from a template
+        new_node()
     elif subcommand in ["init", "new"]:
         # Create a new doracxx.toml configuration
         init_config()
@@ -117,23 +142,31 @@ def main():
                 cache_clean_dora()
             elif sys.argv[2] == "--arrow":
                 cache_clean_arrow()
+            elif sys.argv[2] == "--objects":
+                cache_clean_objects()
+            elif sys.argv[2] == "--artifacts":
+                cache_clean_artifacts()
             else:
                 print(f"Unknown clean option: {sys.argv[2]}")
                 print("Clean options:")
                 print("  --cache      Clear entire cache")
                 print("  --dora       Clear only Dora from cache")
                 print("  --arrow      Clear only Arrow from cache")
-                print("\nUsage: doracxx clean [--cache|--dora]")
+                print("  --objects    Clear only the compiled object cache")
+                print("  --artifacts  Clear only the prebuilt artifact archives")
+                print("\nUsage: doracxx clean [--cache|--dora|--arrow|--objects|--artifacts]")
         else:
             print("Clean options:")
             print("  --cache      Clear entire cache")
             print("  --dora       Clear only Dora from cache")
             print("  --arrow      Clear only Arrow from cache")
-            print("\nUsage: doracxx clean [--cache|--dora|--arrow]")
+            print("  --objects    Clear only the compiled object cache")
+            print("  --artifacts  Clear only the prebuilt artifact archives")
+            print("\nUsage: doracxx clean [--cache|--dora|--arrow|--objects|--artifacts]")
     elif subcommand == "cache":
         # Handle cache subcommands (legacy support)
         if len(sys.argv) < 3:
-            print("Cache subcommands: info, clean, clean-dora")
+            print("Cache subcommands: info, clean, clean-dora, clean-arrow, clean-objects")
             return
             
         cache_subcommand = sys.argv[2]
@@ -145,9 +178,11 @@ def main():
             cache_clean_dora()
         elif cache_subcommand == "clean-arrow":
             cache_clean_arrow()
+        elif cache_subcommand == "clean-objects":
+            cache_clean_objects()
         else:
             print(f"Unknown cache subcommand: {cache_subcommand}")
-            print("Available: info, clean, clean-dora, clean-arrow")
+            print("Available: info, clean, clean-dora, clean-arrow, clean-objects")
     elif subcommand in ["help", "-h", "--help"]:
         print_help()
     else:
@@ -228,6 +263,86 @@ Examples:
         print(f"[ERROR] Error creating configuration file: {e}")
 
 
+def new_node():
+    """Create a new node project from a template"""
+    try:
+        from .templates import create_node, TEMPLATES
+    except ImportError:
+        sys.path.insert(0, str(Path(__file__).parent))
+        from templates import create_node, TEMPLATES
+    
+    args = sys.argv[2:]
+    directory = None
+    template = "basic"
+    name = None
+    force = False
+    
+    i = 0
+    while i < len(args):
+        if args[i] in ["-t", "--template", "-n", "--name"]:
+            if i + 1 >= len(args):
+                print(f"Error: {args[i]} requires a value")
+                return
+            if args[i] in ["-t", "--template"]:
+                template = args[i + 1]
+            else:
+                name = args[i + 1]
+            i += 2
+        elif args[i] in ["-f", "--force"]:
+            force = True
+            i += 1
+        elif args[i] in ["-h", "--help"]:
+            templates = "\n".join(f"  {key:<14} {spec.description}" for key, spec in TEMPLATES.items())
+            print(f"""
+doracxx new - Create a new node project from a template
+
+Usage: doracxx new [DIR] [options]
+
+Without DIR or options, 'doracxx new' only creates doracxx.toml (see 'doracxx init').
+
+Options:
+  -t, --template NAME  Template to use (default: basic)
+  -n, --name NAME      Node name (default: name of DIR)
+  -f, --force          Overwrite existing files
+  -h, --help           Show this help message
+
+Templates:
+{templates}
+
+Examples:
+  doracxx new my-node                         # Event loop skeleton in ./my-node
+  doracxx new my-node --template worker-pool  # Inputs processed on worker threads
+  doracxx new my-node --template async        # C++20 coroutine node
+  doracxx new --template worker-pool          # In the current directory
+""")
+            return
+        elif directory is None and not args[i].startswith("-"):
+            directory = args[i]
+            i += 1
+        else:
+            print(f"Unknown option: {args[i]}")
+            print("Use 'doracxx new --help' for usage information")
+            return
+    
+    target = Path(directory) if directory else Path.cwd()
+    try:
+        written = create_node(target, template, name, force)
+    except FileExistsError as e:
+        print(f"Files already exist: {e}")
+        print("Use --force to overwrite them")
+        return
+    except ValueError as e:
+        print(f"[ERROR] {e}")
+        sys.exit(1)
+    
+    print(f"[OK] Created {template} node in {target}")
+    for path in written:
+        print(f"  {path}")
+    print("\n[INFO] Next steps:")
+    print(f"1. Build the node with: doracxx build {target}")
+    print("2. Add it to your dataflow.yml")
+
+
 def print_help():
     """Print help information for doracxx command"""
     help_text = """
@@ -236,25 +351,34 @@ doracxx - A cross-platform C++ build system for Dora dataflow nodes
 Usage: doracxx <command> [options]
 
 Commands:
-  init, new      Create a new doracxx.toml configuration file
+  init           Create a new doracxx.toml configuration file
+  new [DIR]      Create a node project from a template (--template basic|worker-pool|async)
   build, b       Build a C++ Dora node
+  bench          Build and run the node's micro-benchmarks ([bench], doracxx_bench.h)
   prepare, p     Prepare Dora environment and dependencies
     arrow, a     Prepare Apache Arrow instead of Dora
   clean          Clean cache
     --cache      Clear entire cache
     --dora       Clear only Dora from cache
     --arrow      Clear only Arrow from cache
+    --objects    Clear only the compiled object cache
+    --artifacts  Clear only the prebuilt artifact archives
   cache          Manage global cache (~/.doracxx) [legacy]
     info         Show cache information
     clean        Clear entire cache
     clean-dora   Clear only Dora from cache
     clean-arrow  Clear only Arrow from cache
+    clean-objects  Clear only the compiled object cache
   help           Show this help message
 
 Examples:
   doracxx init                                   # Create new doracxx.toml
+  doracxx new my-node --template worker-pool     # New multi-threaded node
   doracxx build --node-dir nodes/my-node        # Build with CLI args
   doracxx build --node-dir .                    # Build using doracxx.toml
+  doracxx build --dataflow dataflow.yml         # Build every C++ node of a dataflow
+  doracxx bench . --save-baseline               # Benchmark, record the baseline
+  doracxx bench .                               # Benchmark, fail on regressions
   doracxx prepare --profile release             # Prepare Dora
   doracxx prepare arrow --profile release       # Prepare Arrow
   doracxx cache info
@@ -269,8 +393,10 @@ Configuration:
 
 For detailed options for each command, use:
   doracxx build --help
+  doracxx bench --help
   doracxx prepare --help
   doracxx init --help
+  doracxx new --help
 
 Note: doracxx now uses a global cache (~/.doracxx) to share dependencies
 between projects. Use --use-local flag with prepare to use project-local mode.
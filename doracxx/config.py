@@ -40,6 +40,15 @@ class BuildSystem(Enum):
     NINJA = "ninja"
 
 
+class CompilerCache(Enum):
+    """Compiler cache used for node translation units"""
+    AUTO = "auto"  # ccache or sccache when installed, otherwise none
+    CCACHE = "ccache"
+    SCCACHE = "sccache"
+    BUILTIN = "builtin"  # doracxx content-addressed object store in ~/.doracxx/objects
+    NONE = "none"
+
+
 class DependencyType(Enum):
     """Types of dependencies"""
     GIT = "git"
@@ -106,6 +115,26 @@ class NodeConfig:
     version: str = "0.1.0"
 
 
+# Arrow modules and compression codecs [arrow] components can select, and the
+# components each one needs
+ARROW_COMPONENTS = ("compute", "csv", "json", "filesystem", "ipc", "acero", "dataset", "parquet",
+                    "lz4", "zstd", "snappy", "zlib", "brotli", "bz2")
+ARROW_COMPONENT_REQUIRES = {"acero": ["compute"], "dataset": ["acero", "filesystem"], "parquet": ["ipc"]}
+DEFAULT_ARROW_COMPONENTS = ["compute", "csv", "json", "filesystem", "ipc"]
+
+
+def resolve_arrow_components(components: Optional[List[str]] = None) -> List[str]:
+    """Sorted components including the ones they need (the defaults for None); unknown names are dropped"""
+    resolved = set()
+    pending = list(DEFAULT_ARROW_COMPONENTS if components is None else components)
+    while pending:
+        component = pending.pop()
+        if component in ARROW_COMPONENTS and component not in resolved:
+            resolved.add(component)
+            pending.extend(ARROW_COMPONENT_REQUIRES.get(component, []))
+    return sorted(resolved)
+
+
 @dataclass
 class ArrowConfig:
     """Arrow configuration section"""
@@ -113,6 +142,48 @@ class ArrowConfig:
     rev: Optional[str] = None
     enabled: bool = True
     linkage: str = "static"  # "static" or "shared"
+    allocator: str = "system"  # Allocators built into Arrow: "system", "jemalloc" or "mimalloc"
+    components: List[str] = field(default_factory=lambda: list(DEFAULT_ARROW_COMPONENTS))  # Modules and codecs built and linked
+LOG_LEVELS = ("trace", "debug", "info", "warn", "error", "off")
+
+
+@dataclass
+class LogConfig:
+    """Log configuration section, compiled into nodes using doracxx_log.h"""
+    level: Optional[str] = None  # Lowest level compiled in; debug builds default to "debug", release to "info"
+    rate_limit: int = 0  # Most messages per second from one call site, 0 for no limit
+    queue_size: int = 4096  # Messages buffered before new ones are dropped
+
+
+@dataclass
+class MetricsConfig:
+    """Metrics configuration section, compiled into nodes using doracxx_metrics.h"""
+    enabled: bool = False  # Record latencies and counters; when off, the instrumentation compiles away
+    interval_ms: int = 1000  # How often Metrics::maybe_export() exports
+
+
+@dataclass
+class BenchConfig:
+    """Bench configuration section, used by `doracxx bench` (see doracxx_bench.h)"""
+    sources: List[str] = field(default_factory=lambda: ["bench/*.cc"])  # DORACXX_BENCHMARK sources, left out of the node
+    exclude_sources: List[str] = field(default_factory=list)  # Node sources left out of the bench executable
+    events: int = 10000  # Timed inputs per benchmark
+    warmup: int = 1000  # Untimed inputs before them
+    sizes: List[int] = field(default_factory=lambda: [4096])  # Synthetic input sizes in bytes, used in turn
+    rate: float = 0  # Inputs per second, 0 for back to back
+    replay: Optional[str] = None  # Recording (doracxx::bench::Recorder) to replay instead of synthetic inputs
+    baseline: Optional[str] = None  # Results to compare against, e.g. "bench/baseline.json"
+    max_regression: float = 10.0  # Percent slower (throughput, p50, p99) or more allocations that fails the comparison
+
+
+@dataclass
+class ArtifactsConfig:
+    """Artifacts configuration section: prebuilt Arrow and dependency installs"""
+    enabled: bool = True  # Archive finished installs in ~/.doracxx/artifacts and restore them instead of rebuilding
+    remote: Optional[str] = None  # Shared store: "https://...", "s3://bucket/prefix", "file:///..." or a directory
+    push: bool = False  # Upload archives built here to the remote
+
+
 @dataclass
 class BuildConfig:
     """Build configuration section"""
@@ -120,7 +191,7 @@ class BuildConfig:
     system: BuildSystem = BuildSystem.NATIVE
     profile: str = "debug"
     std: str = "c++17"
-    optimization: Optional[str] = None
+    optimization: Optional[str] = None  # "0"-"3", "s", "z" or "fast"; release defaults to "2"
     debug_info: bool = True
     warnings_as_errors: bool = False
     
@@ -151,6 +222,16 @@ class BuildConfig:
     # Advanced options
     parallel_jobs: Optional[int] = None
     install_clang: bool = False
+    compiler_cache: CompilerCache = CompilerCache.AUTO
+    pch: List[str] = field(default_factory=list)  # Headers to precompile and force-include
+    lto: Optional[str] = None  # Link-time optimization: "thin" or "full"
+    pgo: Optional[str] = None  # Profile-guided optimization phase: "generate" or "use"
+    target_cpu: Optional[str] = None  # CPU to specialize for, e.g. "x86-64-v3", "armv8.2-a", "native"
+    cpu_variants: List[str] = field(default_factory=list)  # CPU levels to build, selected at startup
+    size_opt: bool = False  # Drop unreferenced sections at link time and report the size per library
+    strip: bool = False  # Strip the symbol table from the linked executable
+    split_debug: bool = False  # Move debug info to <exe>.debug (.dSYM on macOS)
+    linker: str = "auto"  # "auto" (fastest available), "mold", "lld", "gold" or "system"
 
 
 @dataclass
@@ -159,6 +240,10 @@ class DoracxxConfig:
     node: NodeConfig
     build: BuildConfig = field(default_factory=BuildConfig)
     arrow: Optional[ArrowConfig] = None
+    log: LogConfig = field(default_factory=LogConfig)
+    metrics: MetricsConfig = field(default_factory=MetricsConfig)
+    bench: BenchConfig = field(default_factory=BenchConfig)
+    artifacts: ArtifactsConfig = field(default_factory=ArtifactsConfig)
     dependencies: Dict[str, Union[GitDependency, VcpkgDependency, SystemDependency, LocalDependency]] = field(default_factory=dict)
 
 
@@ -273,7 +358,17 @@ def load_config(config_path: Optional[Union[str, Path]] = None) -> DoracxxConfig
         cmake_options=build_data.get("cmake_options", {}),
         cmake_build_type=build_data.get("cmake_build_type"),
         parallel_jobs=build_data.get("parallel_jobs"),
-        install_clang=build_data.get("install_clang", False)
+        install_clang=build_data.get("install_clang", False),
+        compiler_cache=CompilerCache(build_data.get("compiler_cache", "auto")),
+        pch=build_data.get("pch", []),
+        lto=build_data.get("lto"),
+        pgo=build_data.get("pgo"),
+        target_cpu=build_data.get("target_cpu"),
+        cpu_variants=build_data.get("cpu_variants", []),
+        size_opt=build_data.get("size_opt", False),
+        strip=build_data.get("strip", False),
+        split_debug=build_data.get("split_debug", False),
+        linker=build_data.get("linker", "auto")
     )
     
     # Parse arrow section
@@ -284,9 +379,48 @@ def load_config(config_path: Optional[Union[str, Path]] = None) -> DoracxxConfig
             git=arrow_data.get("git"),
             rev=arrow_data.get("rev"),
             enabled=arrow_data.get("enabled", True),
-            linkage=arrow_data.get("linkage", "static")
+            linkage=arrow_data.get("linkage", "static"),
+            allocator=arrow_data.get("allocator", "system"),
+            components=arrow_data.get("components", list(DEFAULT_ARROW_COMPONENTS))
         )
     
+    # Parse log section
+    log_data = data.get("log", {})
+    log = LogConfig(
+        level=log_data.get("level"),
+        rate_limit=log_data.get("rate_limit", 0),
+        queue_size=log_data.get("queue_size", 4096)
+    )
+    
+    # Parse metrics section
+    metrics_data = data.get("metrics", {})
+    metrics = MetricsConfig(
+        enabled=metrics_data.get("enabled", False),
+        interval_ms=metrics_data.get("interval_ms", 1000)
+    )
+    
+    # Parse bench section
+    bench_data = data.get("bench", {})
+    bench = BenchConfig(
+        sources=bench_data.get("sources", ["bench/*.cc"]),
+        exclude_sources=bench_data.get("exclude_sources", []),
+        events=bench_data.get("events", 10000),
+        warmup=bench_data.get("warmup", 1000),
+        sizes=bench_data.get("sizes", [4096]),
+        rate=bench_data.get("rate", 0),
+        replay=bench_data.get("replay"),
+        baseline=bench_data.get("baseline"),
+        max_regression=bench_data.get("max_regression", 10.0)
+    )
+    
+    # Parse artifacts section
+    artifacts_data = data.get("artifacts", {})
+    artifacts = ArtifactsConfig(
+        enabled=artifacts_data.get("enabled", True),
+        remote=artifacts_data.get("remote"),
+        push=artifacts_data.get("push", False)
+    )
+    
     # Parse dependencies section
     deps_data = data.get("dependencies", {})
     dependencies = {}
@@ -297,31 +431,54 @@ def load_config(config_path: Optional[Union[str, Path]] = None) -> DoracxxConfig
         node=node,
         build=build,
         arrow=arrow,
+        log=log,
+        metrics=metrics,
+        bench=bench,
+        artifacts=artifacts,
         dependencies=dependencies
     )
 
 
-def create_example_config(path: Optional[Union[str, Path]] = None) -> Path:
-    """Create an example doracxx.toml configuration file"""
+def create_example_config(path: Optional[Union[str, Path]] = None, node_name: Optional[str] = None,
+                          description: str = "Minimal Dora C++ node configuration",
+                          build_extra: str = "", std: str = "c++17") -> Path:
+    """Create an example doracxx.toml configuration file
+    
+    Args:
+        path: Output file (default: ./doracxx.toml)
+        node_name: Node name (default: name of the current directory)
+        description: Node description
+        build_extra: Additional lines for the [build] section
+        std: C++ standard of the node
+    """
     if path is None:
         path = Path.cwd() / "doracxx.toml"
     else:
         path = Path(path)
     
-    node_name = Path.cwd().name
+    if node_name is None:
+        node_name = Path.cwd().name
     example_config = f'''# doracxx.toml - Minimal configuration for Dora C++ node
 
 [node]
 name = "{node_name}"
 type = "node"
-description = "Minimal Dora C++ node configuration"
+description = "{description}"
 version = "0.1.0"
 
 [build]
 toolchain = "auto"
 system = "native"
 profile = "debug"
-std = "c++17"
+std = "{std}"
+{build_extra}# lto = "thin"       # Link-time optimization: "thin" or "full"
+# pgo = "generate"   # Profile-guided optimization: "generate", then "use"
+# target_cpu = "x86-64-v3"                            # Specialize for one CPU
+# cpu_variants = ["x86-64", "x86-64-v3", "x86-64-v4"]  # Or build several, picked at startup
+# linker = "mold"    # Default "auto": mold, lld or gold when installed; "system" for the default
+# size_opt = true    # Drop unused code at link time and print the size per library
+# strip = true       # Strip symbols after linking
+# split_debug = true # Keep debug info in <node>.debug next to the executable
 
 # Optional: Enable Apache Arrow support
 # [arrow]
@@ -329,6 +486,32 @@ std = "c++17"
 # git = "https://github.com/apache/arrow.git"
 # rev = "apache-arrow-15.0.0"
 # linkage = "static"  # "static" (default) or "shared"
+# allocator = "mimalloc"  # "system" (default), "jemalloc" or "mimalloc"
+# components = ["compute"]  # Default: compute, csv, json, filesystem, ipc; also acero, dataset, parquet, lz4, zstd, ...
+
+# Optional: doracxx_log.h settings
+# [log]
+# level = "info"      # Lowest level compiled in (default: "debug", "info" in release)
+# rate_limit = 100    # Messages per second per call site, 0 for no limit
+# queue_size = 4096   # Messages buffered before new ones are dropped
+
+# Optional: doracxx_metrics.h latency histograms and counters
+# [metrics]
+# enabled = true      # Off by default: the instrumentation compiles away
+# interval_ms = 1000  # Export period of Metrics::maybe_export()
+
+# Optional: `doracxx bench` micro-benchmarks (doracxx_bench.h)
+# [bench]
+# sources = ["bench/*.cc"]            # DORACXX_BENCHMARK sources
+# sizes = [1024, 65536]               # Synthetic input sizes in bytes
+# rate = 0                            # Inputs per second, 0 for back to back
+# baseline = "bench/baseline.json"    # Fail on regressions against these results
+# max_regression = 10.0               # Percent
+
+# Optional: share prebuilt Arrow and dependency installs between machines
+# [artifacts]
+# remote = "s3://my-bucket/doracxx"   # Or "https://...", "file:///..." or a directory
+# push = true                         # Upload what this machine builds (e.g. on CI)
 '''
     
     with open(path, "w", encoding="utf-8") as f:
@@ -355,6 +538,60 @@ def validate_config(config: DoracxxConfig) -> List[str]:
     if config.build.parallel_jobs is not None and config.build.parallel_jobs < 1:
         warnings.append("parallel_jobs must be >= 1")
     
+    if config.build.lto is not None and config.build.lto not in ["thin", "full"]:
+        warnings.append(f"Unknown lto mode: {config.build.lto} (expected \"thin\" or \"full\")")
+    
+    if config.build.linker not in ["auto", "mold", "lld", "gold", "system"]:
+        warnings.append(f"Unknown linker: {config.build.linker} (expected auto, mold, lld, gold or system)")
+    
+    if config.build.pgo is not None and config.build.pgo not in ["generate", "use"]:
+        warnings.append(f"Unknown pgo mode: {config.build.pgo} (expected \"generate\" or \"use\")")
+    
+    if config.arrow and config.arrow.allocator not in ["system", "jemalloc", "mimalloc"]:
+        warnings.append(f"Unknown Arrow allocator: {config.arrow.allocator}")
+    
+    if config.arrow:
+        unknown = [c for c in config.arrow.components if c not in ARROW_COMPONENTS]
+        if unknown:
+            warnings.append(f"Unknown Arrow components: {', '.join(unknown)} (expected some of {', '.join(ARROW_COMPONENTS)})")
+    
+    if config.log.level is not None and config.log.level not in LOG_LEVELS:
+        warnings.append(f"Unknown log level: {config.log.level} (expected one of {', '.join(LOG_LEVELS)})")
+    
+    if config.log.rate_limit < 0:
+        warnings.append("log rate_limit must be >= 0")
+    
+    if config.log.queue_size < 2:
+        warnings.append("log queue_size must be >= 2")
+    
+    if config.metrics.interval_ms < 1:
+        warnings.append("metrics interval_ms must be >= 1")
+    
+    if config.bench.events < 1:
+        warnings.append("bench events must be >= 1")
+    
+    if config.bench.warmup < 0:
+        warnings.append("bench warmup must be >= 0")
+    
+    if not config.bench.sizes or any(size < 0 for size in config.bench.sizes):
+        warnings.append("bench sizes must be a non-empty list of sizes >= 0")
+    
+    if config.bench.rate < 0:
+        warnings.append("bench rate must be >= 0")
+    
+    if config.bench.max_regression < 0:
+        warnings.append("bench max_regression must be >= 0")
+    
+    if config.artifacts.remote and "://" in config.artifacts.remote \
+            and not config.artifacts.remote.startswith(("http://", "https://", "s3://", "file://")):
+        warnings.append(f"Unknown artifacts remote: {config.artifacts.remote} (expected http(s)://, s3://, file:// or a directory)")
+    
+    if config.artifacts.push and not config.artifacts.remote:
+        warnings.append("artifacts push needs a remote")
+    
+    if config.build.target_cpu and config.build.cpu_variants:
+        warnings.append("target_cpu is ignored when cpu_variants is set")
+    
     # Validate dependencies
     for dep_name, dep in config.dependencies.items():
         if isinstance(dep, GitDependency):
@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""
+CPU targeting for doracxx node builds
+
+[build] target_cpu specializes a node (and its Arrow build) for one CPU,
+for example "x86-64-v3" for AVX2 servers or "armv8.2-a+dotprod" for Jetson
+Orin boards. [build] cpu_variants instead builds one executable per listed
+CPU level, target/<profile>/<node>-<variant>, plus a small launcher under
+the node's own name that checks the running CPU (CPUID on x86, HWCAP on
+Linux/aarch64) and executes the best variant it supports.
+"""
+
+import re
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional
+
+# Env variable that makes the launcher run a given variant, bypassing detection
+VARIANT_ENV = "DORACXX_CPU_VARIANT"
+LAUNCHER_SOURCE = "doracxx_cpu_launcher.cc"
+
+
+@dataclass
+class CpuLevel:
+    """A CPU level that can be selected at runtime by the launcher"""
+    name: str
+    arch: str  # "x86_64" or "aarch64"
+    # x86: features as named in _X86_CPUID (GCC's -m option names)
+    x86_features: List[str] = field(default_factory=list)
+    # x86: XCR0 state bits the OS must enable (AVX: 0x6, AVX-512: 0xe6)
+    xsave_mask: int = 0
+    # aarch64: HWCAP_* / HWCAP2_* bits from <asm/hwcap.h>
+    hwcaps: List[str] = field(default_factory=list)
+    hwcaps2: List[str] = field(default_factory=list)
+    arrow_simd: str = "NONE"  # ARROW_SIMD_LEVEL for this level
+    msvc_arch: Optional[str] = None  # /arch: value for cl
+
+
+# The x86-64 psABI micro-architecture levels; XSAVE support is the xsave_mask check
+_V2 = ["cx16", "sahf", "popcnt", "sse3", "sse4.1", "sse4.2", "ssse3"]
+_V3 = _V2 + ["avx", "avx2", "bmi", "bmi2", "f16c", "fma", "lzcnt", "movbe"]
+_V4 = _V3 + ["avx512f", "avx512bw", "avx512cd", "avx512dq", "avx512vl"]
+_ARMV82 = ["HWCAP_ATOMICS", "HWCAP_FPHP", "HWCAP_ASIMDHP"]
+
+# Runtime-selectable levels, from the most portable to the most specialized
+CPU_LEVELS: List[CpuLevel] = [
+    CpuLevel("x86-64", "x86_64"),
+    CpuLevel("x86-64-v2", "x86_64", _V2, arrow_simd="SSE4_2"),
+    CpuLevel("x86-64-v3", "x86_64", _V3, xsave_mask=0x6, arrow_simd="AVX2", msvc_arch="AVX2"),
+    CpuLevel("x86-64-v4", "x86_64", _V4, xsave_mask=0xe6, arrow_simd="AVX512", msvc_arch="AVX512"),
+    CpuLevel("armv8-a", "aarch64", arrow_simd="NEON", msvc_arch="armv8.0"),
+    CpuLevel("armv8.2-a", "aarch64", hwcaps=_ARMV82, arrow_simd="NEON", msvc_arch="armv8.2"),
+    CpuLevel("armv8.2-a+dotprod", "aarch64", hwcaps=_ARMV82 + ["HWCAP_ASIMDDP"], arrow_simd="NEON",
+             msvc_arch="armv8.2"),
+    CpuLevel("armv9-a", "aarch64", hwcaps=_ARMV82 + ["HWCAP_ASIMDDP", "HWCAP_SVE"], hwcaps2=["HWCAP2_SVE2"],
+             arrow_simd="NEON", msvc_arch="armv9.0"),
+]
+_LEVELS: Dict[str, CpuLevel] = {level.name: level for level in CPU_LEVELS}
+
+# cpuid (leaf, register index in __cpuidex output, bit) for the x86 features above.
+# The launcher reads CPUID itself with every compiler: __builtin_cpu_supports
+# does not know lzcnt, movbe, f16c or cx16 in every GCC and clang release.
+_X86_CPUID = {
+    "sse3": (1, 2, 0), "ssse3": (1, 2, 9), "fma": (1, 2, 12), "cx16": (1, 2, 13),
+    "sse4.1": (1, 2, 19), "sse4.2": (1, 2, 20), "movbe": (1, 2, 22), "popcnt": (1, 2, 23),
+    "avx": (1, 2, 28), "f16c": (1, 2, 29),
+    "bmi": (7, 1, 3), "avx2": (7, 1, 5), "bmi2": (7, 1, 8),
+    "avx512f": (7, 1, 16), "avx512dq": (7, 1, 17), "avx512cd": (7, 1, 28),
+    "avx512bw": (7, 1, 30), "avx512vl": (7, 1, 31),
+    "sahf": (0x80000001, 2, 0), "lzcnt": (0x80000001, 2, 5),
+}
+
+
+def cpu_level(name: str) -> Optional[CpuLevel]:
+    return _LEVELS.get(name)
+
+
+def cpu_flags(kind: str, family: str, cpu: Optional[str]) -> List[str]:
+    """Compile (and link) flags targeting a CPU"""
+    if not cpu:
+        return []
+    if kind == "msvc":
+        if family == "clang-cl":
+            return [f"/clang:{flag}" for flag in cpu_flags("gcc", "clang", cpu)]
+        level = cpu_level(cpu)
+        if level is None or level.msvc_arch is None:
+            # cl has no switch for it (native, x86-64-v2, named CPUs): use its default
+            print(f"[WARN] MSVC has no /arch equivalent for target CPU '{cpu}'; using the compiler default")
+            return []
+        return [f"/arch:{level.msvc_arch}"]
+    # gcc/clang take ARM core names through -mcpu and everything else through -march
+    if cpu.startswith(("cortex-", "neoverse-", "apple-", "carmel")):
+        return [f"-mcpu={cpu}"]
+    return [f"-march={cpu}"]
+
+
+def arrow_simd_level(cpus: List[str]) -> Optional[str]:
+    """ARROW_SIMD_LEVEL matching the least capable of the given CPUs.
+
+    Arrow keeps its own runtime dispatch (ARROW_RUNTIME_SIMD_LEVEL=MAX), so a
+    single Arrow build serves every variant. Returns None when Arrow's default
+    should be kept (no CPU set, "native" or a named CPU).
+    """
+    levels = [cpu_level(c) for c in cpus]
+    if not levels or any(level is None for level in levels):
+        return None
+    return min(levels, key=CPU_LEVELS.index).arrow_simd
+
+
+def variant_id(variant: str) -> str:
+    """Variant name usable in file names ("armv8.2-a+dotprod" -> "armv8.2-a_dotprod")"""
+    return re.sub(r"[^A-Za-z0-9._-]", "_", variant)
+
+
+def variant_name(out_name: str, variant: str) -> str:
+    """File name (without .exe) of a variant executable"""
+    return f"{out_name}-{variant_id(variant)}"
+
+
+def order_variants(variants: List[str], target_arch: str) -> List[str]:
+    """Validate cpu_variants for the compiler's architecture, most portable first"""
+    result = []
+    for name in variants:
+        level = cpu_level(name)
+        if level is None:
+            known = ", ".join(level.name for level in CPU_LEVELS)
+            raise RuntimeError(f"cpu_variants: '{name}' cannot be detected at runtime (supported: {known})")
+        if level.arch != target_arch:
+            print(f"[WARN] Skipping CPU variant '{name}': the compiler targets {target_arch}")
+            continue
+        if name not in result:
+            result.append(name)
+    return sorted(result, key=lambda n: CPU_LEVELS.index(_LEVELS[n]))
+
+
+def _x86_condition(level: CpuLevel) -> str:
+    checks = [f"cpu_has(0x{leaf:x}, {reg}, {bit})" for leaf, reg, bit in
+              (_X86_CPUID[f] for f in level.x86_features)]
+    if level.xsave_mask:
+        checks.append(f"os_saves(0x{level.xsave_mask:x})")
+    return " && ".join(checks) or "true"
+
+
+def _aarch64_condition(level: CpuLevel) -> str:
+    checks = [f"(hwcap & {cap})" for cap in level.hwcaps]
+    checks += [f"(hwcap2 & {cap})" for cap in level.hwcaps2]
+    return " && ".join(checks) or "true"
+
+
+def render_launcher(out_name: str, variants: List[str], kind: str, target_arch: str) -> str:
+    """C++ source of the launcher that runs the best supported variant"""
+    names = [variant_name(out_name, v) for v in variants]
+    selects = []
+    for index, variant in reversed(list(enumerate(variants))):
+        level = _LEVELS[variant]
+        if index == 0:
+            break
+        if target_arch == "x86_64":
+            condition = _x86_condition(level)
+        else:
+            condition = _aarch64_condition(level)
+        selects.append(f"  if ({condition}) return {index};  // {variant}")
+    select_body = "\n".join(selects)
+    table = ",\n".join(f'    {{"{v}", "{n}"}}' for v, n in zip(variants, names))
+
+    if target_arch == "x86_64":
+        detect_setup = ""
+    else:
+        detect_setup = ("#if defined(__linux__)\n"
+                        "  const unsigned long hwcap = getauxval(AT_HWCAP);\n"
+                        "  const unsigned long hwcap2 = getauxval(AT_HWCAP2);\n"
+                        "  (void)hwcap2;\n"
+                        "#else\n"
+                        "  // HWCAP detection is Linux only; elsewhere the portable variant runs\n"
+                        "  return 0;\n"
+                        "#endif\n")
+        select_body = "#if defined(__linux__)\n" + select_body + "\n#endif"
+
+    return _LAUNCHER_TEMPLATE.format(
+        variant_count=len(variants), table=table, detect_setup=detect_setup, select_body=select_body,
+        variable=VARIANT_ENV,
+    )
+
+
+_LAUNCHER_TEMPLATE = r'''// Generated by doracxx from [build] cpu_variants - do not edit
+//
+// Runs the most specialized build of this node that the current CPU supports.
+// Set {variable}=<variant> to force a variant.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <climits>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+#if defined(__linux__) && defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace {{
+
+struct Variant {{
+  const char* cpu;
+  const char* executable;
+}};
+
+const Variant kVariants[{variant_count}] = {{
+{table}
+}};
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+void cpuid(unsigned leaf, unsigned regs[4]) {{
+#if defined(__GNUC__)
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#else
+  int values[4];
+  __cpuidex(values, static_cast<int>(leaf), 0);
+  for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(values[i]);
+#endif
+}}
+
+bool cpu_has(unsigned leaf, int reg, int bit) {{
+  // regs[0] of the first leaf of a range is the highest leaf in it
+  unsigned regs[4];
+  cpuid(leaf & 0x80000000u, regs);
+  if (regs[0] < leaf) return false;
+  cpuid(leaf, regs);
+  return (regs[reg] >> bit) & 1;
+}}
+
+bool os_saves(unsigned long long mask) {{
+  // OSXSAVE must be set before XCR0 can be read
+  if (!cpu_has(1, 2, 27)) return false;
+#if defined(__GNUC__)
+  unsigned eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#else
+  unsigned long long xcr0 = _xgetbv(0);
+#endif
+  return (xcr0 & mask) == mask;
+}}
+#endif
+
+int select_variant() {{
+{detect_setup}{select_body}
+  return 0;
+}}
+
+std::string executable_dir(const char* argv0) {{
+  std::string path;
+#if defined(_WIN32)
+  char buffer[MAX_PATH];
+  DWORD length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+  if (length > 0 && length < MAX_PATH) path.assign(buffer, length);
+#elif defined(__APPLE__)
+  char buffer[PATH_MAX];
+  uint32_t size = sizeof(buffer);
+  if (_NSGetExecutablePath(buffer, &size) == 0) path = buffer;
+#else
+  char buffer[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+  if (length > 0) path.assign(buffer, static_cast<size_t>(length));
+#endif
+  if (path.empty() && argv0) path = argv0;
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}}
+
+}}  // namespace
+
+int main(int argc, char** argv) {{
+  (void)argc;
+  int index = select_variant();
+  if (const char* forced = std::getenv("{variable}")) {{
+    for (int i = 0; i < {variant_count}; ++i) {{
+      if (std::strcmp(kVariants[i].cpu, forced) == 0) index = i;
+    }}
+  }}
+
+  std::string path = executable_dir(argv[0]) + kVariants[index].executable;
+#if defined(_WIN32)
+  path += ".exe";
+  // keep the original command line (and its quoting) for the variant
+  STARTUPINFOA startup;
+  PROCESS_INFORMATION process;
+  std::memset(&startup, 0, sizeof(startup));
+  startup.cb = sizeof(startup);
+  std::string command_line = GetCommandLineA();
+  if (!CreateProcessA(path.c_str(), &command_line[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr,
+                      &startup, &process)) {{
+    std::fprintf(stderr, "doracxx launcher: cannot start %s (error %lu)\n", path.c_str(), GetLastError());
+    return 127;
+  }}
+  WaitForSingleObject(process.hProcess, INFINITE);
+  DWORD code = 1;
+  GetExitCodeProcess(process.hProcess, &code);
+  CloseHandle(process.hThread);
+  CloseHandle(process.hProcess);
+  return static_cast<int>(code);
+#else
+  execv(path.c_str(), argv);
+  std::perror(path.c_str());
+  return 127;
+#endif
+}}
+'''
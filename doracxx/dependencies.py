@@ -6,13 +6,13 @@ This module handles resolution, downloading, and building of dependencies
 defined in doracxx.toml configuration files.
 """
 
+import functools
 import os
 import shutil
 import subprocess
 import tempfile
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
-import urllib.request
 import zipfile
 import tarfile
 
@@ -20,7 +20,12 @@ from .config import (
     DoracxxConfig, GitDependency, VcpkgDependency, 
     SystemDependency, LocalDependency, BuildSystem
 )
-from .cache import get_doracxx_cache_dir
+from .cache import get_doracxx_cache_dir, cache_lock
+from .optimization import cmake_lto_options
+from .timings import timed
+from .git_mirror import checkout, head_commit
+from .artifacts import ArtifactStore, artifact_name, cmake_compiler_identity
+from .prepare import PrepareGraph
 
 
 class DependencyManager:
@@ -38,6 +43,7 @@ class DependencyManager:
             
         self.cache_dir = get_doracxx_cache_dir() / "dependencies"
         self.cache_dir.mkdir(parents=True, exist_ok=True)
+        self.artifacts = ArtifactStore.from_config(config.artifacts)
         
         # Initialize dependency cache and build information
         self.resolved_deps: Dict[str, Dict[str, Path]] = {}  # Store both source and install paths
@@ -45,81 +51,112 @@ class DependencyManager:
         self.lib_dirs: List[str] = []
         self.libraries: List[str] = []
     
-    def resolve_all_dependencies(self) -> Dict[str, Dict[str, Path]]:
-        """Resolve all dependencies and return mapping of name to {source, install} paths"""
+    def resolve_all_dependencies(self, jobs: Optional[int] = None) -> Dict[str, Dict[str, Path]]:
+        """Resolve all dependencies and return mapping of name to {source, install} paths
+
+        Dependencies are resolved concurrently; those with a build system share
+        jobs (BuildConfig.parallel_jobs, else the CPU count) between their builds.
+        """
         print("[INFO] Resolving dependencies...")
-        
+
+        graph = PrepareGraph(jobs or self.config.build.parallel_jobs)
         for dep_name, dep_config in self.config.dependencies.items():
-            print(f"[DEPS] Processing dependency: {dep_name}")
-            
-            try:
-                if isinstance(dep_config, GitDependency):
-                    source_dir, install_path = self._resolve_git_dependency(dep_name, dep_config)
-                elif isinstance(dep_config, VcpkgDependency):
-                    source_dir, install_path = self._resolve_vcpkg_dependency(dep_name, dep_config)
-                elif isinstance(dep_config, SystemDependency):
-                    source_dir, install_path = self._resolve_system_dependency(dep_name, dep_config)
-                elif isinstance(dep_config, LocalDependency):
-                    source_dir, install_path = self._resolve_local_dependency(dep_name, dep_config)
-                else:
-                    raise ValueError(f"Unknown dependency type for {dep_name}")
-                
-                self.resolved_deps[dep_name] = {
-                    'source': source_dir,
-                    'install': install_path
-                }
-                print(f"[OK] Resolved {dep_name}: {install_path}")
-                
-            except Exception as e:
-                print(f"[ERROR] Failed to resolve {dep_name}: {e}")
-                raise
+            graph.add(dep_name, functools.partial(self._resolve_dependency, dep_name, dep_config),
+                      builds=bool(getattr(dep_config, "build_system", None)))
+        resolved = graph.run()
+
+        # Keep the configured order, which is the include and link order
+        for dep_name in self.config.dependencies:
+            source_dir, install_path = resolved[dep_name]
+            self.resolved_deps[dep_name] = {
+                'source': source_dir,
+                'install': install_path
+            }
         
         # Collect all include dirs, lib dirs, and libraries
         self._collect_dependency_info()
         
         return self.resolved_deps
+
+    def _resolve_dependency(self, dep_name: str, dep_config, jobs: int) -> Tuple[Path, Path]:
+        """Resolve one dependency with jobs available to its build"""
+        print(f"[DEPS] Processing dependency: {dep_name}")
+        
+        try:
+            if isinstance(dep_config, GitDependency):
+                source_dir, install_path = self._resolve_git_dependency(dep_name, dep_config, jobs)
+            elif isinstance(dep_config, VcpkgDependency):
+                source_dir, install_path = self._resolve_vcpkg_dependency(dep_name, dep_config)
+            elif isinstance(dep_config, SystemDependency):
+                source_dir, install_path = self._resolve_system_dependency(dep_name, dep_config)
+            elif isinstance(dep_config, LocalDependency):
+                source_dir, install_path = self._resolve_local_dependency(dep_name, dep_config, jobs)
+            else:
+                raise ValueError(f"Unknown dependency type for {dep_name}")
+            
+            print(f"[OK] Resolved {dep_name}: {install_path}")
+            return source_dir, install_path
+            
+        except Exception as e:
+            print(f"[ERROR] Failed to resolve {dep_name}: {e}")
+            raise
     
-    def _resolve_git_dependency(self, name: str, dep: GitDependency) -> Tuple[Path, Path]:
+    def _resolve_git_dependency(self, name: str, dep: GitDependency, jobs: Optional[int] = None) -> Tuple[Path, Path]:
         """Resolve a git-based dependency, returns (source_dir, install_dir)"""
         # Create cache key based on URL and revision
         cache_key = self._create_cache_key(dep.url, dep.rev or dep.branch or dep.tag or "main")
         cache_path = self.cache_dir / "git" / cache_key
         
-        # Clone or update repository
-        if not cache_path.exists():
-            print(f"  [GIT] Cloning {dep.url}...")
-            self._git_clone(dep.url, cache_path, dep.rev or dep.branch or dep.tag)
-        else:
-            print(f"  [CACHE] Using cached repository: {cache_path}")
-        
-        # Determine source directory (handle subdir)
-        source_dir = cache_path / dep.subdir if dep.subdir else cache_path
-        
-        # Create install directory
-        install_dir = cache_path / "install"
-        try:
-            install_dir.mkdir(parents=True, exist_ok=True)
-        except Exception as e:
-            print(f"  [WARN] Failed to create install directory: {e}")
-            # Use alternative path if default fails
-            install_dir = cache_path / "inst"
-            install_dir.mkdir(parents=True, exist_ok=True)
-        
-        # Build if necessary
-        if not list(install_dir.iterdir()):
-            if dep.build_system:
-                try:
-                    self._build_dependency(source_dir, install_dir, dep.build_system, dep.cmake_options)
-                except Exception as e:
-                    print(f"  [WARN] Build failed: {e}")
-                    print(f"  [FALLBACK] Treating as header-only library...")
-                    # Fallback to header-only for libraries like Eigen
-                    self._setup_header_only_lib(source_dir, install_dir, dep.include_dirs or ["Eigen"])
+        # Concurrent builds of the same revision take turns
+        with cache_lock(cache_path):
+            # Clone or update repository
+            if not cache_path.exists():
+                print(f"  [GIT] Cloning {dep.url}...")
+                self._git_clone(dep.url, cache_path, dep.rev or dep.branch or dep.tag)
             else:
-                # Header-only library, just create symlinks to include directories
-                self._setup_header_only_lib(source_dir, install_dir, dep.include_dirs)
-        
-        return source_dir, install_dir
+                print(f"  [CACHE] Using cached repository: {cache_path}")
+
+            # Determine source directory (handle subdir)
+            source_dir = cache_path / dep.subdir if dep.subdir else cache_path
+
+            # Create install directory (LTO builds are installed separately)
+            install_dir = cache_path / ("install-lto" if self.config.build.lto else "install")
+            try:
+                install_dir.mkdir(parents=True, exist_ok=True)
+            except Exception as e:
+                print(f"  [WARN] Failed to create install directory: {e}")
+                # Use alternative path if default fails
+                install_dir = cache_path / "inst"
+                install_dir.mkdir(parents=True, exist_ok=True)
+
+            # Build if necessary, unless a prebuilt install of the same commit and settings exists
+            if not list(install_dir.iterdir()):
+                if dep.build_system:
+                    artifact = self._artifact_name(cache_path, dep)
+                    try:
+                        if not (artifact and self.artifacts.restore(artifact, install_dir)):
+                            self._build_dependency(source_dir, install_dir, dep.build_system, dep.cmake_options, jobs)
+                            if artifact:
+                                self.artifacts.save(artifact, install_dir)
+                    except Exception as e:
+                        print(f"  [WARN] Build failed: {e}")
+                        print(f"  [FALLBACK] Treating as header-only library...")
+                        # Fallback to header-only for libraries like Eigen
+                        self._setup_header_only_lib(source_dir, install_dir, dep.include_dirs or ["Eigen"])
+                else:
+                    # Header-only library, just create symlinks to include directories
+                    self._setup_header_only_lib(source_dir, install_dir, dep.include_dirs)
+
+            return source_dir, install_dir
+    
+    def _artifact_name(self, checkout: Path, dep: GitDependency) -> Optional[str]:
+        """Name of the prebuilt archive of a git dependency's build, None without a known commit"""
+        commit = head_commit(checkout) if self.artifacts.enabled else None
+        if not commit:
+            return None
+        return artifact_name("dependency", commit=commit, subdir=dep.subdir, build_system=dep.build_system.value,
+                             options=dep.cmake_options, profile=self.config.build.profile,
+                             lto=self.config.build.lto, compiler=cmake_compiler_identity())
     
     def _resolve_vcpkg_dependency(self, name: str, dep: VcpkgDependency) -> Tuple[Path, Path]:
         """Resolve a vcpkg-based dependency, returns (source_dir, install_dir)"""
@@ -185,7 +222,7 @@ class DependencyManager:
             missing = set(dep.libraries) - set(found_libs)
             raise RuntimeError(f"System dependency {name}: missing libraries {missing}")
     
-    def _resolve_local_dependency(self, name: str, dep: LocalDependency) -> Tuple[Path, Path]:
+    def _resolve_local_dependency(self, name: str, dep: LocalDependency, jobs: Optional[int] = None) -> Tuple[Path, Path]:
         """Resolve a local dependency, returns (source_dir, install_dir)"""
         source_path = Path(dep.path).resolve()
         if not source_path.exists():
@@ -193,36 +230,43 @@ class DependencyManager:
         
         # Create installation directory in cache
         cache_key = f"local_{source_path.name}_{abs(hash(str(source_path)))}"
+        if self.config.build.lto:
+            cache_key += "_lto"
         install_dir = self.cache_dir / "local" / cache_key
         
         # Build if necessary
-        if not install_dir.exists() or not list(install_dir.iterdir()):
-            if dep.build_system:
-                self._build_dependency(source_path, install_dir, dep.build_system, dep.cmake_options)
-            else:
-                # Header-only library
-                install_dir.mkdir(parents=True, exist_ok=True)
-                self._setup_header_only_lib(source_path, install_dir, dep.include_dirs)
+        with cache_lock(install_dir):
+            if not install_dir.exists() or not list(install_dir.iterdir()):
+                if dep.build_system:
+                    self._build_dependency(source_path, install_dir, dep.build_system, dep.cmake_options, jobs)
+                else:
+                    # Header-only library
+                    install_dir.mkdir(parents=True, exist_ok=True)
+                    self._setup_header_only_lib(source_path, install_dir, dep.include_dirs)
         
         return source_path, install_dir
     
     def _build_dependency(self, source_dir: Path, install_dir: Path, 
-                         build_system: BuildSystem, cmake_options: Dict[str, str]):
-        """Build a dependency using the specified build system"""
+                         build_system: BuildSystem, cmake_options: Dict[str, str], jobs: Optional[int] = None):
+        """Build a dependency using the specified build system, with up to jobs parallel jobs"""
         print(f"  [BUILD] Building with {build_system.value}...")
+        jobs = jobs or self.config.build.parallel_jobs
         
         if build_system == BuildSystem.CMAKE:
-            self._build_with_cmake(source_dir, install_dir, cmake_options)
+            self._build_with_cmake(source_dir, install_dir, cmake_options, jobs)
         elif build_system == BuildSystem.MAKE:
-            self._build_with_make(source_dir, install_dir)
+            self._build_with_make(source_dir, install_dir, jobs)
         elif build_system == BuildSystem.NINJA:
-            self._build_with_ninja(source_dir, install_dir)
+            self._build_with_ninja(source_dir, install_dir, jobs)
         else:
             raise ValueError(f"Unsupported build system: {build_system}")
     
-    def _build_with_cmake(self, source_dir: Path, install_dir: Path, options: Dict[str, str]):
+    @timed("deps")
+    def _build_with_cmake(self, source_dir: Path, install_dir: Path, options: Dict[str, str],
+                          jobs: Optional[int] = None):
         """Build using CMake"""
-        build_dir = source_dir / "build"
+        lto = self.config.build.lto
+        build_dir = source_dir / ("build-lto" if lto else "build")
         build_dir.mkdir(exist_ok=True)
         
         # Configure
@@ -232,6 +276,9 @@ class DependencyManager:
             f"-DCMAKE_BUILD_TYPE={self.config.build.profile.title()}",
         ]
         
+        # Link-time optimization across the dependency/node boundary
+        cmake_args.extend(cmake_lto_options(lto))
+        
         # Add custom options
         for key, value in options.items():
             cmake_args.append(f"-D{key}={value}")
@@ -243,8 +290,8 @@ class DependencyManager:
         
         # Build
         build_args = ["cmake", "--build", ".", "--config", self.config.build.profile.title()]
-        if self.config.build.parallel_jobs:
-            build_args.extend(["--parallel", str(self.config.build.parallel_jobs)])
+        if jobs:
+            build_args.extend(["--parallel", str(jobs)])
         
         print(f"    [CMAKE] Build: {' '.join(build_args)}")
         subprocess.run(build_args, cwd=build_dir, check=True)
@@ -254,24 +301,27 @@ class DependencyManager:
         print(f"    [CMAKE] Install: {' '.join(install_args)}")
         subprocess.run(install_args, cwd=build_dir, check=True)
     
-    def _build_with_make(self, source_dir: Path, install_dir: Path):
+    @timed("deps")
+    def _build_with_make(self, source_dir: Path, install_dir: Path, jobs: Optional[int] = None):
         """Build using Make"""
         make_args = ["make"]
-        if self.config.build.parallel_jobs:
-            make_args.extend(["-j", str(self.config.build.parallel_jobs)])
+        if jobs:
+            make_args.extend(["-j", str(jobs)])
         
         subprocess.run(make_args, cwd=source_dir, check=True)
         subprocess.run(["make", "install", f"PREFIX={install_dir}"], cwd=source_dir, check=True)
     
-    def _build_with_ninja(self, source_dir: Path, install_dir: Path):
+    @timed("deps")
+    def _build_with_ninja(self, source_dir: Path, install_dir: Path, jobs: Optional[int] = None):
         """Build using Ninja"""
         ninja_args = ["ninja"]
-        if self.config.build.parallel_jobs:
-            ninja_args.extend(["-j", str(self.config.build.parallel_jobs)])
+        if jobs:
+            ninja_args.extend(["-j", str(jobs)])
         
         subprocess.run(ninja_args, cwd=source_dir, check=True)
         subprocess.run(["ninja", "install"], cwd=source_dir, check=True)
     
+    @timed("headers")
     def _setup_header_only_lib(self, source_dir: Path, install_dir: Path, include_dirs: List[str]):
         """Setup a header-only library by copying include directories"""
         install_include = install_dir / "include"
@@ -379,12 +429,10 @@ class DependencyManager:
                 self.lib_dirs.extend(dep_config.lib_dirs)
                 self.libraries.extend(dep_config.libraries)
     
+    @timed("git")
     def _git_clone(self, url: str, dest: Path, ref: Optional[str] = None):
-        """Clone a git repository"""
-        cmd = ["git", "clone", url, str(dest)]
-        if ref:
-            cmd.extend(["--branch", ref])
-        subprocess.run(cmd, check=True)
+        """Check a git repository out from its shared mirror"""
+        checkout(url, dest, ref)
     
     def _create_cache_key(self, url: str, ref: str) -> str:
         """Create a cache key for a dependency"""
@@ -487,10 +535,17 @@ class DependencyManager:
         return include_flags, lib_dir_flags, lib_flags
 
 
-def setup_dependencies(config: DoracxxConfig, node_dir: Path, target_dir: Optional[Path] = None) -> DependencyManager:
-    """Setup and resolve all dependencies for a node"""
+def dependencies_need_build(config: DoracxxConfig) -> bool:
+    """True when some dependency has a build system, and so may run a parallel build"""
+    return any(getattr(dep, "build_system", None) for dep in config.dependencies.values())
+
+
+@timed("deps")
+def setup_dependencies(config: DoracxxConfig, node_dir: Path, target_dir: Optional[Path] = None,
+                       jobs: Optional[int] = None) -> DependencyManager:
+    """Setup and resolve all dependencies for a node, with up to jobs parallel build jobs"""
     dep_manager = DependencyManager(config, node_dir, target_dir)
-    dep_manager.resolve_all_dependencies()
+    dep_manager.resolve_all_dependencies(jobs)
     return dep_manager
 
 
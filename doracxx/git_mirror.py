@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Git checkouts for Dora, Arrow and git dependencies
+
+Every repository is fetched once into a bare mirror under
+~/.doracxx/mirrors, and each revision a build needs is checked out from it
+as a git worktree. Worktrees share the mirror's objects, so several Dora or
+Arrow revisions in the cache cost one copy of the history rather than one
+each.
+
+Only the configured revision is fetched, with --depth 1. When the server
+cannot serve that (an abbreviated commit hash, for instance), the branches
+and tags are fetched with --filter=blob:none instead: all commits, but only
+the file contents of what is checked out. An up-to-date checkout of a full
+commit hash does not touch the network at all.
+"""
+
+import hashlib
+import os
+import re
+import shutil
+import subprocess
+from pathlib import Path
+from typing import List, Optional
+
+try:
+    from .cache import get_doracxx_cache_dir, cache_lock
+except ImportError:
+    from cache import get_doracxx_cache_dir, cache_lock
+
+MIRRORS_DIR = "mirrors"
+
+# Refs the fetched revisions are kept under, so they survive git gc
+_REF_PREFIX = "refs/doracxx/"
+
+
+def _git(args: List[str], cwd: Optional[Path] = None, quiet: bool = False) -> str:
+    result = subprocess.run(["git", *args], cwd=cwd, check=True, text=True,
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL if quiet else None)
+    return result.stdout.strip()
+
+
+def is_commit_hash(rev: Optional[str]) -> bool:
+    """True for a full 40 (SHA-1) or 64 (SHA-256) digit commit hash"""
+    return bool(rev) and re.fullmatch(r"[0-9a-f]{40}|[0-9a-f]{64}", rev) is not None
+
+
+def mirror_path(url: str, root: Optional[Path] = None) -> Path:
+    """Bare mirror of url: <root>/<repo name>-<url hash>.git, root defaulting to ~/.doracxx/mirrors"""
+    root = root or get_doracxx_cache_dir() / MIRRORS_DIR
+    name = url.rstrip("/").split("/")[-1]
+    if name.endswith(".git"):
+        name = name[:-4]
+    safe_name = "".join(c for c in name if c.isalnum() or c in "-_")[:16] or "repo"
+    return root / f"{safe_name}-{hashlib.md5(url.encode()).hexdigest()[:8]}.git"
+
+
+def ensure_mirror(url: str, root: Optional[Path] = None) -> Path:
+    """Create the bare mirror of url if needed; no objects are fetched yet"""
+    path = mirror_path(url, root)
+    if (path / "HEAD").exists():
+        return path
+    path.parent.mkdir(parents=True, exist_ok=True)
+    tmp = path.with_name(f"{path.name}.tmp{os.getpid()}")
+    shutil.rmtree(tmp, ignore_errors=True)
+    _git(["init", "--quiet", "--bare", str(tmp)])
+    _git(["remote", "add", "origin", url], cwd=tmp)
+    try:
+        os.replace(tmp, path)
+    except OSError:
+        # another build created it first
+        shutil.rmtree(tmp, ignore_errors=True)
+    return path
+
+
+def fetch_revision(mirror: Path, rev: Optional[str]) -> str:
+    """Fetch rev (a branch, tag or commit; the remote HEAD if None) into mirror and return its commit hash"""
+    source = rev or "HEAD"
+    ref = _REF_PREFIX + re.sub(r"[^A-Za-z0-9._-]", "_", source)
+    try:
+        _git(["fetch", "--quiet", "--depth", "1", "--no-tags", "origin", f"+{source}:{ref}"], cwd=mirror,
+             quiet=True)
+        return _git(["rev-parse", f"{ref}^{{commit}}"], cwd=mirror)
+    except subprocess.CalledProcessError:
+        print(f"[GIT] Shallow fetch of {source} failed, fetching branches and tags without file contents")
+    _git(["fetch", "--quiet", "--filter=blob:none", "--tags", "origin",
+          "+refs/heads/*:refs/heads/*"], cwd=mirror)
+    commit = _git(["rev-parse", f"{source if rev else 'FETCH_HEAD'}^{{commit}}"], cwd=mirror)
+    _git(["update-ref", ref, commit], cwd=mirror)
+    return commit
+
+
+def remote_commit(url: str, rev: Optional[str]) -> Optional[str]:
+    """Commit hash rev (the remote HEAD if None) currently names on the remote, None if unknown"""
+    if is_commit_hash(rev):
+        return rev
+    try:
+        output = _git(["ls-remote", url, rev or "HEAD"], quiet=True)
+    except (subprocess.CalledProcessError, OSError):
+        return None
+    commits = {}
+    for line in output.splitlines():
+        commit, _, ref = line.partition("\t")
+        commits[ref] = commit
+    # annotated tags are listed a second time, peeled to their commit
+    for ref, commit in commits.items():
+        if ref.endswith("^{}"):
+            return commit
+    return next(iter(commits.values()), None)
+
+
+def head_commit(dest: Path) -> Optional[str]:
+    """Commit checked out at dest, None if it is not a git checkout"""
+    try:
+        return _git(["rev-parse", "HEAD"], cwd=dest, quiet=True)
+    except (subprocess.CalledProcessError, OSError):
+        return None
+
+
+def checkout(url: str, dest: Path, rev: Optional[str] = None, mirrors: Optional[Path] = None) -> Path:
+    """Check rev of url out at dest, as a worktree of the shared mirror.
+
+    An existing checkout is moved to rev; failing that it is kept as is with
+    a warning, like an offline build would want. A checkout made by an older
+    doracxx (a full clone) is updated in place. A non-empty dest that is not
+    a checkout raises RuntimeError rather than being overwritten.
+    """
+    dest = Path(dest)
+    if dest.exists() and any(dest.iterdir()):
+        if not (dest / ".git").exists() or head_commit(dest) is None:
+            raise RuntimeError(f"{dest} is not empty and not a git checkout; remove it to check {url} out there")
+        if is_commit_hash(rev) and head_commit(dest) == rev:
+            return dest
+        try:
+            if (dest / ".git").is_dir():
+                _git(["fetch", "--quiet", "origin", rev or "HEAD"], cwd=dest)
+                commit = "FETCH_HEAD"
+            else:
+                mirror = ensure_mirror(url, mirrors)
+                with cache_lock(mirror):
+                    commit = fetch_revision(mirror, rev)
+            _git(["checkout", "--quiet", "--detach", commit], cwd=dest)
+        except (subprocess.CalledProcessError, OSError):
+            print(f"[WARN] git update of {dest} failed, continuing with the existing checkout")
+        return dest
+
+    dest.parent.mkdir(parents=True, exist_ok=True)
+    try:
+        mirror = ensure_mirror(url, mirrors)
+        # concurrent fetches would race on the mirror's shallow file and refs
+        with cache_lock(mirror):
+            commit = fetch_revision(mirror, rev)
+            # worktrees whose directory was deleted (doracxx clean) would block the path
+            _git(["worktree", "prune"], cwd=mirror)
+            print(f"[GIT] Checking out {url} {rev or 'HEAD'} ({commit[:12]}) at {dest}")
+            _git(["worktree", "add", "--quiet", "--detach", str(dest.resolve()), commit], cwd=mirror)
+    except (subprocess.CalledProcessError, OSError) as e:
+        print(f"[WARN] Shared git mirror unavailable ({e}), cloning {url} directly")
+        shutil.rmtree(dest, ignore_errors=True)
+        cmd = ["git", "clone", url, str(dest)]
+        if rev and not is_commit_hash(rev):
+            cmd += ["--depth", "1", "--branch", rev]
+        subprocess.check_call(cmd)
+        if is_commit_hash(rev):
+            subprocess.check_call(["git", "-C", str(dest), "checkout", "--quiet", "--detach", rev])
+    return dest
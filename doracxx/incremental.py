@@ -0,0 +1,405 @@
+#!/usr/bin/env python3
+"""
+Incremental per-translation-unit compilation for doracxx node builds
+
+Every source file (node sources and cxxbridge-generated .cc files) is compiled
+to its own object under target/<profile>/build/obj. A state file records, per
+object, the hash of the compile flags and the headers reported by the compiler
+(-MMD depfiles for gcc/clang, /sourceDependencies JSON for MSVC), so that
+translation units whose inputs did not change are skipped on the next build.
+"""
+
+import hashlib
+import json
+import os
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+try:
+    from .jobs import Job, JobScheduler
+except ImportError:
+    from jobs import Job, JobScheduler
+
+STATE_VERSION = 1
+STATE_FILE = "doracxx-objects.json"
+
+
+@dataclass
+class TranslationUnit:
+    """A single source file and the artifacts produced when compiling it.
+
+    extra_flags are appended to the shared compile flags for this unit only
+    (e.g. precompiled header use), and extra_inputs are files that force a
+    rebuild when they are newer than the object (e.g. the precompiled header).
+    Units that are not cacheable never go through the built-in object cache.
+    A unit with its own command (e.g. a precompiled header) is built with it
+    instead of the regular compile command.
+    """
+    source: Path
+    obj: Path
+    depfile: Path
+    extra_flags: List[str] = field(default_factory=list)
+    extra_inputs: List[Path] = field(default_factory=list)
+    cacheable: bool = True
+    command: Optional[List[str]] = None
+
+
+def object_suffix(kind: str) -> str:
+    """Object file extension for the given compiler kind"""
+    return ".obj" if kind == "msvc" else ".o"
+
+
+def object_path(source: Path, node_dir: Path, obj_dir: Path, kind: str) -> Path:
+    """Map a source file to its object path under obj_dir.
+
+    Sources inside the node directory mirror their relative path; sources
+    outside of it (cxxbridge-generated files) are grouped by a short hash of
+    their parent directory so that several lib.rs.cc files never collide.
+    """
+    source = Path(source)
+    try:
+        rel = source.resolve().relative_to(node_dir.resolve())
+    except ValueError:
+        parent_key = hashlib.sha1(str(source.resolve().parent).encode()).hexdigest()[:8]
+        crate = source.parent.parent.name if source.parent.name == "src" else source.parent.name
+        rel = Path("_ext") / f"{crate}-{parent_key}" / source.name
+    return obj_dir / rel.parent / (rel.name + object_suffix(kind))
+
+
+def plan_translation_units(srcs: List[Path], node_dir: Path, obj_dir: Path, kind: str) -> List[TranslationUnit]:
+    """Create the list of translation units to compile for the given sources"""
+    units = []
+    for src in srcs:
+        obj = object_path(Path(src), node_dir, obj_dir, kind)
+        depfile = obj.with_name(obj.name + (".json" if kind == "msvc" else ".d"))
+        units.append(TranslationUnit(source=Path(src), obj=obj, depfile=depfile))
+    return units
+
+
+def uses_clang_cl(cc: str) -> bool:
+    """Check whether an MSVC-style compiler is actually clang-cl"""
+    return "clang-cl" in Path(cc).name.lower()
+
+
+def compile_command(cc: str, kind: str, flags: List[str], unit: TranslationUnit) -> List[str]:
+    """Build the command that compiles a single translation unit"""
+    if unit.command:
+        return list(unit.command)
+    flags = flags + unit.extra_flags
+    if kind == "msvc":
+        cmd = [cc] + flags + ["/c", str(unit.source), f"/Fo{unit.obj}"]
+        if uses_clang_cl(cc):
+            cmd += ["/clang:-MMD", f"/clang:-MF{unit.depfile}"]
+        else:
+            cmd += ["/sourceDependencies", str(unit.depfile)]
+        return cmd
+    return [cc] + flags + ["-c", str(unit.source), "-o", str(unit.obj), "-MMD", "-MF", str(unit.depfile)]
+
+
+def flags_hash(cc: str, kind: str, flags: List[str]) -> str:
+    """Hash the compiler identity and flags that affect every object"""
+    h = hashlib.sha256()
+    h.update(kind.encode())
+    h.update(b"\0")
+    h.update(str(cc).encode())
+    try:
+        st = Path(cc).stat()
+        h.update(f"{st.st_size}:{st.st_mtime_ns}".encode())
+    except OSError:
+        pass
+    for flag in flags:
+        h.update(b"\0")
+        h.update(flag.encode())
+    return h.hexdigest()
+
+
+def parse_depfile(text: str) -> List[str]:
+    """Parse a Makefile-style depfile produced by -MMD / -MF.
+
+    Returns the prerequisites of the first rule (the object), handling line
+    continuations and backslash-escaped spaces.
+    """
+    text = text.replace("\\\r\n", " ").replace("\\\n", " ")
+    # only the first rule matters: "obj: src hdr1 hdr2 ..."
+    first_rule = text.split("\n\n", 1)[0]
+    colon = first_rule.find(": ")
+    if colon == -1:
+        colon = first_rule.find(":\n")
+    if colon == -1:
+        return []
+    body = first_rule[colon + 1:]
+
+    deps = []
+    current = []
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c == "\\" and i + 1 < len(body) and body[i + 1] in " #":
+            current.append(body[i + 1])
+            i += 2
+            continue
+        if c == "$" and i + 1 < len(body) and body[i + 1] == "$":
+            current.append("$")
+            i += 2
+            continue
+        if c.isspace():
+            if current:
+                deps.append("".join(current))
+                current = []
+        else:
+            current.append(c)
+        i += 1
+    if current:
+        deps.append("".join(current))
+    return deps
+
+
+def parse_source_dependencies(text: str) -> List[str]:
+    """Parse the JSON written by MSVC's /sourceDependencies option"""
+    data = json.loads(text)
+    info = data.get("Data", {})
+    deps = []
+    if info.get("Source"):
+        deps.append(info["Source"])
+    deps.extend(info.get("Includes", []))
+    return deps
+
+
+def read_dependencies(unit: TranslationUnit, kind: str, cc: str, cwd: Optional[Path] = None) -> Optional[List[str]]:
+    """Read the dependencies reported by the compiler for a translation unit.
+
+    Relative paths are resolved against the directory the compiler ran in.
+    Returns None when the compiler did not produce a dependency file, in which
+    case the unit is always rebuilt.
+    """
+    if not unit.depfile.exists():
+        return None
+    try:
+        text = unit.depfile.read_text(encoding="utf-8", errors="replace")
+        if kind == "msvc" and not uses_clang_cl(cc):
+            deps = parse_source_dependencies(text)
+        else:
+            deps = parse_depfile(text)
+        base = Path(cwd) if cwd else Path.cwd()
+        return [str(base / d) if not Path(d).is_absolute() else d for d in deps]
+    except (OSError, ValueError) as e:
+        print(f"[WARN] Could not read dependency file {unit.depfile}: {e}")
+        return None
+
+
+class BuildState:
+    """Persistent record of compiled objects and the inputs they were built from"""
+
+    def __init__(self, path: Path):
+        self.path = path
+        self.objects: Dict[str, Dict] = {}
+        self.link: Dict = {}
+
+    @classmethod
+    def load(cls, path: Path) -> "BuildState":
+        state = cls(path)
+        if path.exists():
+            try:
+                data = json.loads(path.read_text(encoding="utf-8"))
+                if data.get("version") == STATE_VERSION:
+                    state.objects = data.get("objects", {})
+                    state.link = data.get("link", {})
+            except (OSError, ValueError):
+                # corrupt state only costs a full rebuild
+                pass
+        return state
+
+    def save(self):
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        data = {"version": STATE_VERSION, "objects": self.objects, "link": self.link}
+        tmp = self.path.with_name(self.path.name + ".tmp")
+        tmp.write_text(json.dumps(data, indent=1), encoding="utf-8")
+        os.replace(tmp, self.path)
+
+    def record(self, unit: TranslationUnit, fhash: str, deps: Optional[List[str]]):
+        self.objects[str(unit.obj)] = {
+            "source": str(unit.source),
+            "flags": fhash,
+            "deps": deps,
+        }
+
+    def forget(self, obj: Path):
+        self.objects.pop(str(obj), None)
+
+
+def _mtime(path) -> Optional[int]:
+    try:
+        return os.stat(path).st_mtime_ns
+    except OSError:
+        return None
+
+
+def rebuild_reason(unit: TranslationUnit, fhash: str, state: BuildState) -> Optional[str]:
+    """Return why a translation unit must be rebuilt, or None if it is up to date"""
+    obj_mtime = _mtime(unit.obj)
+    if obj_mtime is None:
+        return "no object"
+    entry = state.objects.get(str(unit.obj))
+    if not entry or entry.get("source") != str(unit.source):
+        return "not built by doracxx"
+    if entry.get("flags") != fhash:
+        return "flags changed"
+    deps = entry.get("deps")
+    if deps is None:
+        return "dependencies unknown"
+    src_mtime = _mtime(unit.source)
+    if src_mtime is None or src_mtime > obj_mtime:
+        return "source changed"
+    for dep in deps:
+        dep_mtime = _mtime(dep)
+        if dep_mtime is None:
+            return f"missing dependency {dep}"
+        if dep_mtime > obj_mtime:
+            return f"{Path(dep).name} changed"
+    for extra in unit.extra_inputs:
+        extra_mtime = _mtime(extra)
+        if extra_mtime is None or extra_mtime > obj_mtime:
+            return f"{Path(extra).name} changed"
+    return None
+
+
+def compile_translation_units(cc: str, kind: str, flags: List[str], units: List[TranslationUnit],
+                              state: BuildState, scheduler: JobScheduler,
+                              cwd: Optional[Path] = None, launcher: Optional[List[str]] = None,
+                              object_cache=None, trace_flags: Optional[List[str]] = None) -> int:
+    """Compile every out-of-date translation unit.
+
+    Args:
+        cc: Compiler executable
+        kind: "msvc" or "gcc" (gcc/clang compatible)
+        flags: Compile flags shared by every translation unit
+        units: Translation units to bring up to date
+        state: Build state, updated in place and saved after each object
+        scheduler: Job scheduler running the compiles concurrently
+        cwd: Directory the compiler runs in (used to resolve relative dependencies)
+        launcher: Compiler launcher prefix (ccache/sccache), if any
+        object_cache: Built-in ObjectCache consulted before compiling each unit, if any
+        trace_flags: Flags writing a clang -ftime-trace profile next to each object
+            (--timings); they do not change the object, so they are left out of
+            the flags hash and up-to-date units are not rebuilt for them
+
+    Returns:
+        Number of translation units that were compiled
+    """
+    base_hash = flags_hash(cc, kind, flags)
+    jobs = []
+    up_to_date = 0
+
+    for unit in units:
+        if unit.command:
+            fhash = flags_hash(cc, kind, unit.command)
+        elif unit.extra_flags:
+            fhash = flags_hash(cc, kind, flags + unit.extra_flags)
+        else:
+            fhash = base_hash
+        reason = rebuild_reason(unit, fhash, state)
+        if reason is None:
+            up_to_date += 1
+            continue
+
+        print(f"[COMPILE] {unit.source.name} ({reason})")
+        unit.obj.parent.mkdir(parents=True, exist_ok=True)
+        if unit.depfile.exists():
+            unit.depfile.unlink()
+        # drop the entry first so an interrupted compile is never considered fresh
+        state.forget(unit.obj)
+
+        cache_key = {}
+
+        def precheck(unit=unit, cache_key=cache_key):
+            key = object_cache.compute_key(cc, kind, flags + unit.extra_flags, unit, cwd=cwd,
+                                           timeout=scheduler.timeout)
+            if key is None:
+                return False
+            cache_key["key"] = key
+            if object_cache.fetch(key, kind, unit):
+                print(f"[CACHE] {unit.source.name} restored from object cache")
+                return True
+            return False
+
+        def on_success(unit=unit, cache_key=cache_key, fhash=fhash):
+            if object_cache is not None and cache_key.get("key"):
+                object_cache.store(cache_key["key"], kind, unit)
+            state.record(unit, fhash, read_dependencies(unit, kind, cc, cwd))
+            state.save()
+
+        cmd = (launcher or []) + compile_command(cc, kind, flags, unit)
+        trace_file = None
+        if trace_flags and not unit.command:
+            cmd += trace_flags
+            trace_file = unit.obj.with_suffix(".json")
+        jobs.append(Job(label=unit.source.name, cmd=cmd, on_success=on_success, cwd=cwd,
+                        precheck=precheck if object_cache is not None and unit.cacheable else None,
+                        category="compile", trace_file=trace_file))
+
+    if jobs:
+        print(f"[COMPILE] Compiling {len(jobs)} translation unit(s) with up to {scheduler.max_jobs} job(s)")
+    # the cache may be shared by several batches (one per CPU variant)
+    hits_before = object_cache.hits if object_cache is not None else 0
+    misses_before = object_cache.misses if object_cache is not None else 0
+    try:
+        scheduler.run(jobs)
+    finally:
+        state.save()
+
+    if object_cache is not None and jobs:
+        print(f"[CACHE] Object cache: {object_cache.hits - hits_before} hit(s), "
+              f"{object_cache.misses - misses_before} miss(es)")
+    print(f"[COMPILE] {len(jobs)} compiled, {up_to_date} up to date")
+    return len(jobs)
+
+
+def remove_stale_objects(state: BuildState, units: List[TranslationUnit]):
+    """Delete objects from previous builds whose sources are no longer part of the node"""
+    current = {str(u.obj) for u in units}
+    for obj in [o for o in state.objects if o not in current]:
+        for path in (Path(obj), Path(obj + ".d"), Path(obj + ".json")):
+            try:
+                path.unlink()
+            except OSError:
+                pass
+        state.forget(Path(obj))
+        print(f"[CLEAN] Removed stale object: {obj}")
+
+
+def resolve_link_inputs(lib_dirs: List[str], libraries: List[str], kind: str) -> List[str]:
+    """Resolve library names to the files the linker will read, where they can be found"""
+    found = []
+    for name in libraries:
+        if kind == "msvc":
+            candidates = [name if name.lower().endswith(".lib") else name + ".lib"]
+        else:
+            candidates = [f"lib{name}.a", f"lib{name}.so", f"lib{name}.dylib"]
+        for lib_dir in lib_dirs:
+            hit = next((Path(lib_dir) / c for c in candidates if (Path(lib_dir) / c).exists()), None)
+            if hit:
+                found.append(str(hit))
+                break
+    return found
+
+
+def link_is_up_to_date(out_path: Path, objects: List[Path], link_cmd: List[str],
+                       link_inputs: List[str], state: BuildState) -> bool:
+    """Check whether the executable is newer than all objects and libraries and was linked the same way"""
+    out_mtime = _mtime(out_path)
+    if out_mtime is None:
+        return False
+    if state.link.get("command") != hashlib.sha256("\0".join(link_cmd).encode()).hexdigest():
+        return False
+    for path in list(objects) + list(link_inputs):
+        mtime = _mtime(path)
+        if mtime is None or mtime > out_mtime:
+            return False
+    return True
+
+
+def record_link(state: BuildState, link_cmd: List[str]):
+    """Remember the command used for the last successful link"""
+    state.link["command"] = hashlib.sha256("\0".join(link_cmd).encode()).hexdigest()
+    state.save()
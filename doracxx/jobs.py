@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+"""
+Parallel job scheduling for doracxx builds
+
+Runs independent commands (typically one compiler invocation per translation
+unit) concurrently. Each job's output is captured and printed in one block
+when the job finishes so that lines from concurrent compilers never
+interleave, and the first failure stops the whole batch.
+
+Schedulers are independent, so several node builds of a workspace can each
+run their own. share_job_slots bounds the commands all of them run at once,
+so the builds together still use no more than the job budget.
+"""
+
+import os
+import subprocess
+import threading
+import time
+from contextlib import nullcontext
+from concurrent.futures import ThreadPoolExecutor, wait, FIRST_EXCEPTION
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Callable, List, Optional
+
+try:
+    from .timings import TIMINGS
+except ImportError:
+    from timings import TIMINGS
+
+
+def default_job_count(parallel_jobs: Optional[int] = None) -> int:
+    """Resolve the number of concurrent jobs (BuildConfig.parallel_jobs, else os.cpu_count())"""
+    if parallel_jobs and parallel_jobs > 0:
+        return parallel_jobs
+    return os.cpu_count() or 1
+
+
+_job_slots: Optional[threading.BoundedSemaphore] = None
+
+
+def share_job_slots(count: Optional[int]):
+    """Bound the commands every scheduler of this process runs at once (None lifts the bound)"""
+    global _job_slots
+    _job_slots = threading.BoundedSemaphore(count) if count else None
+
+
+def _job_slot():
+    slots = _job_slots
+    return slots if slots is not None else nullcontext()
+
+
+@dataclass
+class Job:
+    """A command to run, with an optional callback invoked after it succeeds.
+
+    precheck runs in the worker thread before the command, holding the same
+    job slot (see share_job_slots); when it returns
+    True the job's outputs are already in place (e.g. restored from a cache),
+    the command is skipped and the job counts as succeeded. category and
+    trace_file only matter to --timings: the phase the job is recorded as,
+    and a clang -ftime-trace profile the command writes.
+    """
+    label: str
+    cmd: List[str]
+    on_success: Optional[Callable[[], None]] = None
+    cwd: Optional[Path] = None
+    precheck: Optional[Callable[[], bool]] = None
+    category: str = "job"
+    trace_file: Optional[Path] = None
+
+
+@dataclass
+class JobResult:
+    job: Job
+    returncode: int
+    output: List[str] = field(default_factory=list)
+    duration: float = 0.0
+
+
+class JobScheduler:
+    """Run jobs concurrently with streamed-per-job output and fail-fast semantics"""
+
+    def __init__(self, max_jobs: Optional[int] = None, cwd: Optional[Path] = None,
+                 timeout: int = 300, line_filter: Optional[Callable[[str], bool]] = None,
+                 env: Optional[dict] = None):
+        self.max_jobs = default_job_count(max_jobs)
+        self.cwd = cwd
+        self.timeout = timeout
+        self.line_filter = line_filter
+        self.env = env
+        self._print_lock = threading.Lock()
+        self._state_lock = threading.Lock()
+        self._running: List[subprocess.Popen] = []
+        self._failed = threading.Event()
+        self._first_error: Optional[BaseException] = None
+
+    def _emit(self, result: JobResult):
+        """Print a finished job's command and filtered output as one block"""
+        with self._print_lock:
+            print("$ ", " ".join(result.job.cmd))
+            for line in result.output:
+                if line and (self.line_filter is None or self.line_filter(line)):
+                    print(line)
+
+    def _run_one(self, job: Job) -> JobResult:
+        if self._failed.is_set():
+            return JobResult(job, returncode=-1)
+
+        start = time.monotonic()
+        trace_start = TIMINGS.now()
+        # the precheck preprocesses the unit, so it takes a slot like the command
+        with _job_slot():
+            if job.precheck:
+                try:
+                    skipped = job.precheck()
+                except Exception as e:
+                    self._fail(e)
+                    raise
+                if skipped:
+                    if job.on_success:
+                        with self._state_lock:
+                            job.on_success()
+                    TIMINGS.record(job.label, job.category, trace_start, TIMINGS.now(), {"note": "restored from cache"})
+                    return JobResult(job, returncode=0, duration=time.monotonic() - start)
+                if self._failed.is_set():
+                    return JobResult(job, returncode=-1)
+
+            try:
+                process = subprocess.Popen(
+                    job.cmd,
+                    cwd=job.cwd or self.cwd,
+                    env=self.env,
+                    stdout=subprocess.PIPE,
+                    stderr=subprocess.STDOUT,
+                    text=True,
+                    errors="replace",
+                )
+            except OSError as e:
+                self._fail(e)
+                raise
+            with self._state_lock:
+                self._running.append(process)
+                # another job may have failed between the check above and Popen
+                if self._failed.is_set():
+                    process.kill()
+            try:
+                output, _ = process.communicate(timeout=self.timeout)
+            except subprocess.TimeoutExpired:
+                process.kill()
+                output, _ = process.communicate()
+                result = JobResult(job, returncode=-1, output=(output or "").splitlines())
+                result.output.append(f"error: timed out after {self.timeout}s")
+                self._emit(result)
+                self._fail(subprocess.TimeoutExpired(job.cmd, self.timeout))
+                raise self._first_error
+            finally:
+                with self._state_lock:
+                    self._running.remove(process)
+
+        result = JobResult(job, process.returncode, (output or "").splitlines(), time.monotonic() - start)
+        # a job killed because another one failed is not worth reporting
+        if result.returncode != 0 and self._failed.is_set():
+            return result
+        self._emit(result)
+
+        if result.returncode != 0:
+            self._fail(subprocess.CalledProcessError(result.returncode, job.cmd))
+            raise self._first_error
+
+        if TIMINGS.enabled:
+            TIMINGS.record(job.label, job.category, trace_start, TIMINGS.now())
+            if job.trace_file and job.trace_file.exists():
+                TIMINGS.add_clang_trace(job.trace_file, trace_start, TIMINGS.lane())
+        if job.on_success:
+            with self._state_lock:
+                job.on_success()
+        return result
+
+    def _fail(self, error: BaseException):
+        """Record the first failure and stop every other running job"""
+        with self._state_lock:
+            if self._first_error is None:
+                self._first_error = error
+        self._failed.set()
+        self._kill_running()
+
+    def _kill_running(self):
+        with self._state_lock:
+            for process in self._running:
+                try:
+                    process.kill()
+                except OSError:
+                    pass
+
+    def run(self, jobs: List[Job]) -> List[JobResult]:
+        """Run all jobs, raising the first failure after cancelling the rest"""
+        if not jobs:
+            return []
+
+        self._failed.clear()
+        self._first_error = None
+        workers = min(self.max_jobs, len(jobs))
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            futures = [pool.submit(self._run_one, job) for job in jobs]
+            done, pending = wait(futures, return_when=FIRST_EXCEPTION)
+            for future in pending:
+                future.cancel()
+            wait(pending)
+
+        if self._first_error is not None:
+            raise self._first_error
+        for future in futures:
+            if not future.cancelled() and future.exception() is not None:
+                raise future.exception()
+        return [f.result() for f in futures if not f.cancelled()]
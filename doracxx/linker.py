@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Linker selection for doracxx node builds
+
+With static Arrow and Dora libraries, GNU ld often takes longer than the
+whole compile, and it links again after every edit. [build] linker picks
+the linker the compiler driver runs:
+
+    auto     the fastest one that works: mold, then lld, then gold on
+             Linux; lld-link for clang-cl; the system linker otherwise
+    mold     -fuse-ld=mold
+    lld      -fuse-ld=lld (ld.lld, ld64.lld or lld-link)
+    gold     -fuse-ld=gold
+    system   whatever the compiler uses by default
+
+On Linux, auto tries each candidate on a small program first, with the
+build's LTO flags and the linker's thread options, because the GCC plugin does not load into lld and not
+every mold build has the LLVM plugin. The chosen linker gets the build's
+job count as its thread count. The flags are part of the link command, so
+the native and ninja backends both use them and switching linkers relinks.
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+try:
+    from .optimization import OptimizationFlags
+except ImportError:
+    from optimization import OptimizationFlags
+
+LINKERS = ("auto", "mold", "lld", "gold", "system")
+
+# ld binaries behind each -fuse-ld choice, and the order auto tries them in
+_LINKER_BINARIES = {"mold": ["mold", "ld.mold"], "lld": ["ld.lld", "lld"], "gold": ["ld.gold"]}
+_AUTO_ORDER = ("mold", "lld", "gold")
+
+_probe_lock = threading.Lock()
+_probes: Dict[Tuple[str, str, Tuple[str, ...]], bool] = {}
+
+
+def linker_available(linker: str, kind: str = "gcc") -> bool:
+    """Whether the linker's binary is installed"""
+    if kind == "msvc":
+        return linker == "lld" and shutil.which("lld-link") is not None
+    return any(shutil.which(binary) for binary in _LINKER_BINARIES.get(linker, []))
+
+
+def linker_binaries() -> Dict[str, Optional[str]]:
+    """Resolved path of every linker binary the selection can pick, by name
+
+    Symlinks are followed, so switching what ld or ld.lld points to shows.
+    """
+    names = ["ld", "lld-link"] + [binary for binaries in _LINKER_BINARIES.values() for binary in binaries]
+    found = {}
+    for name in names:
+        path = shutil.which(name)
+        found[name] = os.path.realpath(path) if path else None
+    return found
+
+
+def probe_linker(cc: str, linker: str, extra_flags: Optional[List[str]] = None) -> bool:
+    """Whether cc links a trivial program with -fuse-ld=<linker> and extra_flags (cached)"""
+    key = (cc, linker, tuple(extra_flags or []))
+    with _probe_lock:
+        if key in _probes:
+            return _probes[key]
+    with tempfile.TemporaryDirectory(prefix="doracxx-ld-") as tmp:
+        src = Path(tmp) / "probe.cc"
+        src.write_text("int main() { return 0; }\n")
+        cmd = [cc, f"-fuse-ld={linker}"] + list(extra_flags or []) + [str(src), "-o", str(Path(tmp) / "probe")]
+        try:
+            ok = subprocess.run(cmd, capture_output=True, timeout=60).returncode == 0
+        except (OSError, subprocess.SubprocessError):
+            ok = False
+    with _probe_lock:
+        _probes[key] = ok
+    return ok
+
+
+def select_linker(cc: str, kind: str, family: str, requested: Optional[str] = None,
+                  link_flags: Optional[List[str]] = None) -> Optional[str]:
+    """The [build] linker to use ("mold", "lld", "gold") or None for the compiler's default
+
+    link_flags are the build's other driver link flags (LTO, PGO), which
+    auto tries the candidates with.
+    """
+    requested = requested or "auto"
+    if requested not in LINKERS:
+        print(f"[WARN] Unknown linker '{requested}' (expected one of: {', '.join(LINKERS)}); using the default")
+        return None
+    if requested == "system":
+        return None
+
+    if kind == "msvc":
+        # cl.exe always runs link.exe; clang-cl can drive lld-link
+        if family == "clang-cl" and requested in ("auto", "lld") and linker_available("lld", kind):
+            return "lld"
+        if requested != "auto":
+            print(f"[WARN] linker = \"{requested}\" is not available for {family}; using link.exe")
+        return None
+
+    if requested != "auto":
+        if not linker_available(requested):
+            print(f"[WARN] linker = \"{requested}\" is not installed; using the compiler's default linker")
+            return None
+        return requested
+
+    # ld64 is already fast and the only complete Mach-O linker; MinGW only pairs reliably with lld
+    if sys.platform == "darwin":
+        return None
+    candidates = ("lld",) if os.name == "nt" else _AUTO_ORDER
+    for linker in candidates:
+        # with its thread options too: not every gold is built with threads
+        threads = linker_flags(kind, family, linker, 1).link[1:]
+        if linker_available(linker) and probe_linker(cc, linker, list(link_flags or []) + threads):
+            return linker
+    return None
+
+
+def linker_flags(kind: str, family: str, linker: Optional[str], jobs: int, lto: Optional[str] = None) -> OptimizationFlags:
+    """Flags selecting the linker and letting it use jobs threads"""
+    flags = OptimizationFlags()
+    if kind == "msvc":
+        if linker == "lld":
+            flags.link.append("-fuse-ld=lld")
+            flags.linker.append(f"/threads:{jobs}")
+        elif family == "msvc" and lto:
+            # whole-program code generation is link.exe's parallel part
+            flags.linker.append(f"/CGTHREADS:{min(jobs, 8)}")
+        return flags
+    if not linker:
+        return flags
+    flags.link.append(f"-fuse-ld={linker}")
+    if linker == "lld":
+        flags.link.append(f"-Wl,--threads={jobs}")
+    elif linker == "mold":
+        flags.link.append(f"-Wl,--thread-count={jobs}")
+    elif linker == "gold":
+        flags.link += ["-Wl,--threads", f"-Wl,--thread-count={jobs}"]
+    return flags
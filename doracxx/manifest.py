@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+Persisted build manifest for warm doracxx builds
+
+Resolving a node build (preparing Dora and Arrow, locating the compiler,
+scanning the cxxbridge tree, resolving dependencies and assembling flags)
+costs seconds even when nothing changed, and with no Dora revision set it
+also queries the remote for the latest tag. The result of that resolution is
+stored in target/<profile>/doracxx-manifest.json together with:
+
+- a fingerprint of everything that feeds the resolution (configuration,
+  command-line overrides, relevant environment variables, the installed
+  linkers, doracxx itself)
+- the modification times of the files and directories it found (compiler,
+  cxxbridge outputs, Dora/Arrow/dependency library and include directories)
+
+While both match, the next build reuses the stored result and goes straight
+to compiling.
+"""
+
+import dataclasses
+import hashlib
+import json
+import os
+from enum import Enum
+from pathlib import Path
+from typing import Dict, List, Optional
+
+MANIFEST_VERSION = 1
+MANIFEST_FILE = "doracxx-manifest.json"
+
+# Environment variables that influence toolchain and Dora resolution
+FINGERPRINT_ENV = ["CXX", "CXX_COMPILER", "DORA_TARGET_DIR", "PATH", "VCPKG_ROOT", "CARGO"]
+
+
+def _json_default(value):
+    if isinstance(value, Enum):
+        return value.value
+    if isinstance(value, Path):
+        return str(value)
+    return str(value)
+
+
+def config_digest(config) -> Optional[str]:
+    """Stable digest of a loaded DoracxxConfig"""
+    if config is None:
+        return None
+    data = json.dumps(dataclasses.asdict(config), default=_json_default, sort_keys=True)
+    return hashlib.sha256(data.encode()).hexdigest()
+
+
+def build_fingerprint(**inputs) -> str:
+    """Fingerprint the inputs of build resolution.
+
+    Keyword arguments are the build parameters (node dir, profile, config,
+    overrides...); the DoracxxConfig given as ``config`` is digested and the
+    relevant environment variables and doracxx sources are added.
+    """
+    data = {k: v for k, v in inputs.items() if k != "config"}
+    data["config"] = config_digest(inputs.get("config"))
+    data["env"] = {name: os.environ.get(name) for name in FINGERPRINT_ENV}
+    data["manifest_version"] = MANIFEST_VERSION
+    # resolution logic changes with doracxx itself
+    data["doracxx"] = package_digest()
+    text = json.dumps(data, default=_json_default, sort_keys=True)
+    return hashlib.sha256(text.encode()).hexdigest()
+
+
+def package_digest() -> str:
+    """Digest of every doracxx module; any of them can change how a build resolves"""
+    digest = hashlib.sha256()
+    package_dir = Path(__file__).resolve().parent
+    for path in sorted(package_dir.glob("*.py")):
+        digest.update(path.name.encode() + b"\0")
+        try:
+            digest.update(path.read_bytes())
+        except OSError:
+            pass
+    return digest.hexdigest()
+
+
+def _stat(path) -> Optional[List[int]]:
+    try:
+        st = os.stat(path)
+        return [st.st_mtime_ns, st.st_size]
+    except OSError:
+        return None
+
+
+class BuildManifest:
+    """Resolved build configuration and the inputs it was derived from"""
+
+    def __init__(self, path: Path):
+        self.path = path
+        self.fingerprint: Optional[str] = None
+        self.resolved: Dict = {}
+        self.watched: Dict[str, Optional[List[int]]] = {}
+
+    @classmethod
+    def load(cls, path: Path) -> "BuildManifest":
+        manifest = cls(path)
+        try:
+            data = json.loads(path.read_text(encoding="utf-8"))
+            if data.get("version") == MANIFEST_VERSION:
+                manifest.fingerprint = data.get("fingerprint")
+                manifest.resolved = data.get("resolved", {})
+                manifest.watched = data.get("watched", {})
+        except (OSError, ValueError):
+            # missing or corrupt manifest only costs a full resolution
+            pass
+        return manifest
+
+    def stale_reason(self, fingerprint: str) -> Optional[str]:
+        """Return why the manifest cannot be reused, or None if it is fresh"""
+        if not self.resolved:
+            return "no manifest"
+        if self.fingerprint != fingerprint:
+            return "configuration changed"
+        for path, recorded in self.watched.items():
+            if _stat(path) != recorded:
+                return f"{path} changed"
+        return None
+
+    def update(self, fingerprint: str, resolved: Dict, watch: List):
+        """Record a fresh resolution and the files it depends on, then save"""
+        self.fingerprint = fingerprint
+        self.resolved = resolved
+        self.watched = {}
+        for path in watch:
+            if path:
+                self.watched[str(path)] = _stat(path)
+        self.save()
+
+    def save(self):
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        data = {"version": MANIFEST_VERSION, "fingerprint": self.fingerprint,
+                "resolved": self.resolved, "watched": self.watched}
+        tmp = self.path.with_name(self.path.name + ".tmp")
+        tmp.write_text(json.dumps(data, indent=1, default=_json_default), encoding="utf-8")
+        os.replace(tmp, self.path)
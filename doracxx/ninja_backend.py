@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Ninja backend for doracxx node builds
+
+When [build] system = "ninja", compile_node writes the resolved compile and
+link commands to target/<profile>/build/build.ninja and lets ninja drive the
+build. Ninja then takes care of header dependency tracking (depfiles or
+/showIncludes), parallelism and no-op detection, and the generated graph is
+reused by later `doracxx build` calls as long as the configuration is unchanged.
+"""
+
+import os
+import shlex
+import shutil
+import subprocess
+from pathlib import Path
+from typing import List, Optional
+
+try:
+    from .incremental import TranslationUnit
+except ImportError:
+    from incremental import TranslationUnit
+
+NINJA_FILE = "build.ninja"
+
+
+def find_ninja() -> Optional[str]:
+    """Locate the ninja executable (NINJA env, then PATH)"""
+    env_ninja = os.environ.get("NINJA")
+    if env_ninja and shutil.which(env_ninja):
+        return shutil.which(env_ninja)
+    return shutil.which("ninja") or shutil.which("ninja-build")
+
+
+def escape_path(path) -> str:
+    """Escape a path for use in a ninja build statement"""
+    return str(path).replace("$", "$$").replace(" ", "$ ").replace(":", "$:")
+
+
+def escape_value(value: str) -> str:
+    """Escape a variable value (only '$' is special there)"""
+    return value.replace("$", "$$")
+
+
+def shell_join(args: List[str]) -> str:
+    """Quote a command line the way ninja's process spawner expects it"""
+    if os.name == "nt":
+        return subprocess.list2cmdline(args)
+    return " ".join(shlex.quote(a) for a in args)
+
+
+def generate_ninja(cc: str, kind: str, compile_flags: List[str], units: List[TranslationUnit],
+                   link_prefix: List[str], link_args: List[str], out_path: Path,
+                   link_inputs: List[str], cwd: Path, launcher: Optional[List[str]] = None,
+                   objects: Optional[List[Path]] = None) -> str:
+    """Render the build.ninja content for a node.
+
+    Args:
+        cc: Compiler executable
+        kind: "msvc" or "gcc" (gcc/clang compatible)
+        compile_flags: Flags shared by every translation unit
+        units: Translation units (source -> object), including ones with their own command
+               such as a precompiled header
+        link_prefix: Command placed before the objects in the link (compiler and driver flags)
+        link_args: Linker arguments placed after the objects
+        out_path: Final executable
+        link_inputs: Library files the link reads, tracked as implicit dependencies
+        cwd: Directory commands run in (sources and flags may be relative to it)
+        launcher: Compiler launcher prefix (ccache/sccache) for compile commands
+        objects: Objects to link (defaults to the objects of the regular units)
+    """
+    lines = [
+        "# Generated by doracxx - do not edit, changes are overwritten on the next build",
+        "ninja_required_version = 1.3",
+        "",
+        f"cxx = {escape_value(shell_join((launcher or []) + [cc]))}",
+        f"cxxflags = {escape_value(shell_join(compile_flags))}",
+        f"link_prefix = {escape_value(shell_join(link_prefix))}",
+        f"link_args = {escape_value(shell_join(link_args))}",
+        "",
+    ]
+
+    cd = "cd /d" if os.name == "nt" else "cd"
+    cd_prefix = f"{cd} {escape_value(shell_join([str(cwd)]))} && "
+    if os.name == "nt":
+        # cmd.exe is needed for 'cd && ...'
+        cd_prefix = "cmd /c " + cd_prefix
+
+    if kind == "msvc":
+        lines += [
+            "msvc_deps_prefix = Note: including file:",
+            "rule cxx",
+            f"  command = {cd_prefix}$cxx /showIncludes $cxxflags /c $in /Fo$out",
+            "  deps = msvc",
+            "  description = CXX $in",
+            "",
+        ]
+    else:
+        lines += [
+            "rule cxx",
+            f"  command = {cd_prefix}$cxx $cxxflags -MMD -MF $out.d -c $in -o $out",
+            "  depfile = $out.d",
+            "  deps = gcc",
+            "  description = CXX $in",
+            "",
+        ]
+
+    lines += [
+        "rule custom",
+        f"  command = {cd_prefix}$cmd",
+        "  description = GEN $out",
+        "",
+        "rule link",
+        f"  command = {cd_prefix}$link_prefix $in $link_args",
+        "  description = LINK $out",
+        "",
+    ]
+
+    for unit in units:
+        implicit_inputs = ""
+        if unit.extra_inputs:
+            implicit_inputs = " | " + " ".join(escape_path(p) for p in unit.extra_inputs)
+        if unit.command:
+            lines.append(f"build {escape_path(unit.obj)}: custom {escape_path(unit.source)}{implicit_inputs}")
+            lines.append(f"  cmd = {escape_value(shell_join(unit.command))}")
+            if unit.depfile.suffix == ".d":
+                lines += [f"  depfile = {escape_value(str(unit.depfile))}", "  deps = gcc"]
+            continue
+        lines.append(f"build {escape_path(unit.obj)}: cxx {escape_path(unit.source)}{implicit_inputs}")
+        if unit.extra_flags:
+            lines.append(f"  cxxflags = $cxxflags {escape_value(shell_join(unit.extra_flags))}")
+    lines.append("")
+
+    if objects is None:
+        objects = [u.obj for u in units if not u.command]
+    objects = " ".join(escape_path(o) for o in objects)
+    implicit = " ".join(escape_path(p) for p in link_inputs)
+    link_line = f"build {escape_path(out_path)}: link {objects}"
+    if implicit:
+        link_line += f" | {implicit}"
+    lines += [link_line, "", f"default {escape_path(out_path)}", ""]
+    return "\n".join(lines)
+
+
+def write_ninja_file(build_dir: Path, content: str) -> Path:
+    """Write build.ninja only when its content changed so ninja keeps its graph and log"""
+    ninja_file = build_dir / NINJA_FILE
+    if ninja_file.exists():
+        try:
+            if ninja_file.read_text(encoding="utf-8") == content:
+                return ninja_file
+        except OSError:
+            pass
+    build_dir.mkdir(parents=True, exist_ok=True)
+    ninja_file.write_text(content, encoding="utf-8")
+    print(f"[NINJA] Wrote {ninja_file}")
+    return ninja_file
+
+
+def ninja_command(ninja: str, build_dir: Path, jobs: Optional[int] = None) -> List[str]:
+    """Command that runs ninja on the generated file"""
+    cmd = [ninja, "-C", str(build_dir), "-f", NINJA_FILE]
+    if jobs:
+        cmd += ["-j", str(jobs)]
+    return cmd
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+Compiler cache support for doracxx node builds
+
+Translation units can be compiled through an external compiler cache
+(ccache or sccache, used as a compiler launcher) or through the built-in
+content-addressed object store under ~/.doracxx/objects. The built-in store
+keys every object by the preprocessed source, the compile flags and the
+compiler version, so an object compiled in one checkout (or on another
+machine sharing the directory) is reused by any other build that would
+produce the same object.
+"""
+
+import hashlib
+import json
+import os
+import re
+import shutil
+import subprocess
+import threading
+from pathlib import Path
+from typing import List, Optional, Tuple
+
+try:
+    from .cache import get_object_cache_dir
+    from .config import CompilerCache
+    from .incremental import TranslationUnit, uses_clang_cl
+    from .toolchain import compiler_version
+except ImportError:
+    from cache import get_object_cache_dir
+    from config import CompilerCache
+    from incremental import TranslationUnit, uses_clang_cl
+    from toolchain import compiler_version
+
+# Bump when the key derivation changes so old entries are never matched
+KEY_VERSION = 1
+
+
+def find_launcher(mode: CompilerCache) -> Optional[str]:
+    """Locate the external compiler cache for the configured mode"""
+    if mode == CompilerCache.AUTO:
+        return shutil.which("sccache") or shutil.which("ccache")
+    if mode in (CompilerCache.CCACHE, CompilerCache.SCCACHE):
+        launcher = shutil.which(mode.value)
+        if not launcher:
+            print(f"[WARN] compiler_cache = \"{mode.value}\" but {mode.value} was not found in PATH; compiling without a cache")
+        return launcher
+    return None
+
+
+def key_flags(flags: List[str]) -> List[str]:
+    """Drop include directory flags; their effect is captured by the preprocessed source"""
+    result = []
+    skip_next = False
+    for flag in flags:
+        if skip_next:
+            skip_next = False
+            continue
+        if flag in ("-I", "/I", "-isystem", "-iquote", "/external:I"):
+            skip_next = True
+            continue
+        if flag.startswith(("-I", "/I", "-isystem", "-iquote", "/external:I")):
+            continue
+        result.append(flag)
+    return result
+
+
+class ObjectCache:
+    """Content-addressed store of compiled objects"""
+
+    def __init__(self, root: Optional[Path] = None, base_dirs: Optional[List[Path]] = None):
+        self.root = Path(root) if root else get_object_cache_dir()
+        # Directory prefixes stripped from preprocessed output so that
+        # different checkouts of the same node produce the same key
+        self.base_dirs = sorted((str(Path(d).resolve()) for d in base_dirs or []), key=len, reverse=True)
+        # a base only matches up to a path separator: /home/a/node must not
+        # turn /home/a/node-utils into -utils
+        self._base_pattern = (re.compile("|".join(re.escape(base) for base in self.base_dirs) + r"(?=[/\\])")
+                              if self.base_dirs else None)
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.Lock()
+
+    def _entry(self, key: str, kind: str) -> Path:
+        return self.root / key[:2] / (key + (".obj" if kind == "msvc" else ".o"))
+
+    def preprocess_command(self, cc: str, kind: str, flags: List[str], unit: TranslationUnit) -> List[str]:
+        """Command printing the preprocessed source while writing the unit's dependency file"""
+        if kind == "msvc":
+            if uses_clang_cl(cc):
+                return [cc] + flags + ["/E", str(unit.source), "/clang:-MMD", f"/clang:-MF{unit.depfile}"]
+            return [cc] + flags + ["/E", "/showIncludes", str(unit.source)]
+        return [cc] + flags + ["-E", str(unit.source), "-MMD", "-MF", str(unit.depfile)]
+
+    def compute_key(self, cc: str, kind: str, flags: List[str], unit: TranslationUnit,
+                    cwd: Optional[Path] = None, timeout: int = 300) -> Optional[str]:
+        """Preprocess a translation unit and derive its cache key.
+
+        Also leaves the unit's dependency file in place (for MSVC it is written
+        in /sourceDependencies format) so a cache hit can be recorded in the
+        build state like a real compile. Returns None if preprocessing failed,
+        in which case the unit is simply compiled.
+        """
+        cmd = self.preprocess_command(cc, kind, flags, unit)
+        try:
+            result = subprocess.run(cmd, cwd=cwd, capture_output=True, timeout=timeout)
+        except (OSError, subprocess.SubprocessError):
+            return None
+        if result.returncode != 0:
+            return None
+
+        text = result.stdout.decode("utf-8", errors="replace")
+        if kind == "msvc" and not uses_clang_cl(cc):
+            self._write_source_dependencies(unit, result.stderr.decode("utf-8", errors="replace"))
+        text = self._strip_base_dirs(text)
+
+        h = hashlib.sha256()
+        for part in (str(KEY_VERSION), kind, compiler_version(cc, kind), unit.source.suffix):
+            h.update(part.encode())
+            h.update(b"\0")
+        for flag in key_flags(flags):
+            h.update(self._strip_base_dirs(flag).encode())
+            h.update(b"\0")
+        h.update(text.encode("utf-8", errors="replace"))
+        return h.hexdigest()
+
+    def _strip_base_dirs(self, text: str) -> str:
+        return self._base_pattern.sub("", text) if self._base_pattern else text
+
+    @staticmethod
+    def _write_source_dependencies(unit: TranslationUnit, show_includes: str):
+        """Turn /showIncludes output into the JSON that /sourceDependencies would write"""
+        includes = []
+        for line in show_includes.splitlines():
+            if line.startswith("Note: including file:"):
+                includes.append(line.split(":", 2)[2].strip())
+        data = {"Version": "1.1", "Data": {"Source": str(unit.source), "Includes": includes}}
+        unit.depfile.parent.mkdir(parents=True, exist_ok=True)
+        unit.depfile.write_text(json.dumps(data), encoding="utf-8")
+
+    def fetch(self, key: str, kind: str, unit: TranslationUnit) -> bool:
+        """Copy a cached object to the unit's object path; returns True on a hit"""
+        entry = self._entry(key, kind)
+        if not entry.exists():
+            with self._lock:
+                self.misses += 1
+            return False
+        unit.obj.parent.mkdir(parents=True, exist_ok=True)
+        tmp = unit.obj.with_name(unit.obj.name + ".tmp")
+        try:
+            # plain copy: the object must look newer than its sources to the incremental check
+            shutil.copyfile(entry, tmp)
+            os.replace(tmp, unit.obj)
+            os.utime(entry)  # keep recently used entries fresh for pruning
+        except OSError:
+            with self._lock:
+                self.misses += 1
+            return False
+        with self._lock:
+            self.hits += 1
+        return True
+
+    def store(self, key: str, kind: str, unit: TranslationUnit):
+        """Add a freshly compiled object to the store"""
+        entry = self._entry(key, kind)
+        if entry.exists():
+            return
+        try:
+            entry.parent.mkdir(parents=True, exist_ok=True)
+            tmp = entry.with_name(f"{entry.name}.{os.getpid()}.{threading.get_ident()}.tmp")
+            shutil.copyfile(unit.obj, tmp)
+            os.replace(tmp, entry)
+        except OSError as e:
+            print(f"[WARN] Could not store {unit.obj.name} in the object cache: {e}")
+
+
+def setup_compiler_cache(mode: CompilerCache, base_dirs: Optional[List[Path]] = None) -> Tuple[List[str], Optional[ObjectCache]]:
+    """Resolve the configured compiler cache.
+
+    Returns the launcher prefix for compile commands (empty when none is used)
+    and the built-in object cache, if selected.
+    """
+    if mode == CompilerCache.NONE:
+        return [], None
+    if mode == CompilerCache.BUILTIN:
+        cache = ObjectCache(base_dirs=base_dirs)
+        print(f"[CACHE] Using built-in object cache: {cache.root}")
+        return [], cache
+    launcher = find_launcher(mode)
+    if launcher:
+        print(f"[CACHE] Using compiler launcher: {launcher}")
+        return [launcher], None
+    return [], None
+
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+"""
+Optimization settings for doracxx node builds
+
+Maps the [build] optimization, lto, pgo and size_opt settings to compiler
+and linker flags for gcc, clang and MSVC (cl and clang-cl), and manages the
+profile data of PGO builds, which is kept per node under target/pgo/<node>.
+
+PGO workflow:
+  1. build with pgo = "generate" and run the node on a representative dataflow
+  2. build with pgo = "use"; objects are recompiled whenever new profile data
+     is recorded
+"""
+
+import os
+import shutil
+import subprocess
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import List, Optional
+
+LTO_MODES = ("thin", "full")
+PGO_MODES = ("generate", "use")
+PROFILE_STAMP = ".doracxx-profile-stamp"
+
+
+@dataclass
+class OptimizationFlags:
+    """Flags contributed by the optimization settings"""
+    compile: List[str] = field(default_factory=list)
+    # driver options placed before the objects (/link for MSVC) in the link
+    link: List[str] = field(default_factory=list)
+    # MSVC linker options placed after /link
+    linker: List[str] = field(default_factory=list)
+
+
+def pgo_dir(project_root: Path, node_name: str) -> Path:
+    """Directory holding the profile data of a node"""
+    return project_root / "target" / "pgo" / node_name
+
+
+def msvc_pgd_path(profile_dir: Path, node_name: str) -> Path:
+    return profile_dir / f"{node_name}.pgd"
+
+
+def clang_profdata_path(profile_dir: Path) -> Path:
+    return profile_dir / "default.profdata"
+
+
+def has_explicit_optimization(flags: List[str]) -> bool:
+    """Check whether the user already passes an optimization level"""
+    return any(f.startswith(("-O", "/O")) for f in flags)
+
+
+def optimization_level_flags(kind: str, level: Optional[str], profile: str, cxxflags: List[str]) -> List[str]:
+    """Flags for [build] optimization ("0", "1", "2", "3", "s", "z", "fast").
+
+    Release builds default to level 2 unless the cxxflags already set one.
+    """
+    if level is None:
+        if profile != "release" or has_explicit_optimization(cxxflags):
+            return []
+        level = "2"
+    level = str(level)
+    if kind == "msvc":
+        msvc = {"0": "/Od", "1": "/O1", "2": "/O2", "3": "/O2", "s": "/O1", "z": "/O1", "fast": "/O2"}
+        if level not in msvc:
+            print(f"[WARN] Unknown optimization level for MSVC: {level}")
+            return []
+        flags = [msvc[level]]
+        if level == "3":
+            flags.append("/Ob3")
+        if level == "fast":
+            flags.append("/fp:fast")
+        return flags
+    if level not in ("0", "1", "2", "3", "s", "z", "fast", "g"):
+        print(f"[WARN] Unknown optimization level: {level}")
+        return []
+    return [f"-O{level}"]
+
+
+def lto_flags(kind: str, family: str, lto: Optional[str]) -> OptimizationFlags:
+    """Flags enabling link-time optimization"""
+    flags = OptimizationFlags()
+    if not lto:
+        return flags
+    if lto not in LTO_MODES:
+        print(f"[WARN] Unknown lto mode '{lto}' (expected one of: {', '.join(LTO_MODES)}); LTO disabled")
+        return flags
+
+    if family == "msvc":
+        # cl has a single whole-program mode
+        flags.compile.append("/GL")
+        flags.linker.append("/LTCG")
+    elif family == "clang-cl":
+        lto_flag = "-flto=thin" if lto == "thin" else "-flto"
+        flags.compile.append(lto_flag)
+        # link.exe cannot read LLVM bitcode
+        flags.link += [lto_flag, "-fuse-ld=lld"]
+    elif family == "clang":
+        lto_flag = "-flto=thin" if lto == "thin" else "-flto"
+        flags.compile.append(lto_flag)
+        flags.link.append(lto_flag)
+        # the system ld on Linux usually lacks the LLVM plugin; [build] linker
+        # = "auto" only picks a linker that links bitcode
+    else:
+        if lto == "thin":
+            print("[INFO] gcc has no ThinLTO; using parallel full LTO (-flto=auto)")
+        flags.compile.append("-flto=auto")
+        flags.link.append("-flto=auto")
+    return flags
+
+
+def pgo_flags(kind: str, family: str, pgo: Optional[str], profile_dir: Path, node_name: str) -> OptimizationFlags:
+    """Flags for the profile-guided optimization phase"""
+    flags = OptimizationFlags()
+    if not pgo:
+        return flags
+    if pgo not in PGO_MODES:
+        print(f"[WARN] Unknown pgo mode '{pgo}' (expected one of: {', '.join(PGO_MODES)}); PGO disabled")
+        return flags
+
+    if family == "msvc":
+        # MSVC PGO works on whole-program code generation
+        pgd = msvc_pgd_path(profile_dir, node_name)
+        flags.compile.append("/GL")
+        option = "/GENPROFILE" if pgo == "generate" else "/USEPROFILE"
+        flags.linker += ["/LTCG", f"{option}:PGD={pgd}"]
+    elif family in ("clang", "clang-cl"):
+        prefix = "/clang:" if family == "clang-cl" else ""
+        if pgo == "generate":
+            opt = f"{prefix}-fprofile-generate={profile_dir}"
+        else:
+            opt = f"{prefix}-fprofile-use={clang_profdata_path(profile_dir)}"
+        flags.compile.append(opt)
+        flags.link.append(opt)
+    else:
+        if pgo == "generate":
+            opts = [f"-fprofile-generate={profile_dir}"]
+        else:
+            # objects that were not exercised during training have no profile
+            opts = [f"-fprofile-use={profile_dir}", "-fprofile-partial-training", "-Wno-missing-profile"]
+        flags.compile += opts
+        flags.link += opts
+    return flags
+
+
+def size_flags(kind: str, size_opt: bool) -> OptimizationFlags:
+    """Flags letting the linker drop unreferenced functions and data"""
+    flags = OptimizationFlags()
+    if not size_opt:
+        return flags
+    if kind == "msvc":
+        # one COMDAT per function and global; drop unreferenced ones, fold identical ones
+        flags.compile += ["/Gy", "/Gw"]
+        flags.linker += ["/OPT:REF", "/OPT:ICF"]
+        return flags
+    flags.compile += ["-ffunction-sections", "-fdata-sections"]
+    flags.link.append("-Wl,-dead_strip" if _is_macos() else "-Wl,--gc-sections")
+    return flags
+
+
+def merge_flags(*parts: OptimizationFlags) -> OptimizationFlags:
+    merged = OptimizationFlags()
+    for part in parts:
+        for flag in part.compile:
+            if flag not in merged.compile:
+                merged.compile.append(flag)
+        for flag in part.link:
+            if flag not in merged.link:
+                merged.link.append(flag)
+        for flag in part.linker:
+            if flag not in merged.linker:
+                merged.linker.append(flag)
+    return merged
+
+
+def node_optimization_flags(kind: str, family: str, config, profile: str, profile_dir: Path,
+                            node_name: str, pgo: bool = True) -> OptimizationFlags:
+    """Combine the [build] optimization, lto, pgo and size_opt settings of a node build
+
+    pgo=False leaves out the PGO flags, for code no profile of this node covers.
+    """
+    build = config.build if config else None
+    level = optimization_level_flags(kind, build.optimization if build else None, profile,
+                                     build.cxxflags if build else [])
+    return merge_flags(OptimizationFlags(compile=level),
+                       lto_flags(kind, family, build.lto if build else None),
+                       pgo_flags(kind, family, build.pgo if build and pgo else None, profile_dir, node_name),
+                       size_flags(kind, build.size_opt if build else False))
+
+
+def _is_macos() -> bool:
+    return os.uname().sysname == "Darwin" if hasattr(os, "uname") else False
+
+
+def find_llvm_profdata(cc: str) -> Optional[str]:
+    """Locate llvm-profdata, preferring the one shipped next to the compiler"""
+    cc_path = shutil.which(cc) or cc
+    exe = "llvm-profdata.exe" if os.name == "nt" else "llvm-profdata"
+    sibling = Path(cc_path).resolve().parent / exe
+    if sibling.exists():
+        return str(sibling)
+    return shutil.which("llvm-profdata")
+
+
+def _newest_mtime(directory: Path, suffixes) -> Optional[int]:
+    newest = None
+    if directory.exists():
+        for path in directory.rglob("*"):
+            if path.is_file() and path.name.endswith(suffixes):
+                mtime = path.stat().st_mtime_ns
+                newest = mtime if newest is None else max(newest, mtime)
+    return newest
+
+
+def prepare_profile_data(pgo: Optional[str], family: str, cc: str, profile_dir: Path,
+                         node_name: str, executable: Path) -> Optional[Path]:
+    """Bring the node's profile data up to date before a PGO build.
+
+    For "generate" this creates the profile directory. For "use" it merges
+    clang .profraw files into default.profdata and collects MSVC .pgc files
+    written next to the executable. Returns a stamp file that is touched
+    whenever new profile data is found; objects and the link list it as an
+    input so they are rebuilt with the new profile.
+    """
+    if pgo not in PGO_MODES:
+        return None
+    profile_dir.mkdir(parents=True, exist_ok=True)
+    stamp = profile_dir / PROFILE_STAMP
+    if pgo == "generate":
+        return None
+
+    if family in ("clang", "clang-cl"):
+        profdata = clang_profdata_path(profile_dir)
+        raw = sorted(profile_dir.glob("*.profraw"))
+        raw_mtime = max((p.stat().st_mtime_ns for p in raw), default=None)
+        if raw and (not profdata.exists() or raw_mtime > profdata.stat().st_mtime_ns):
+            tool = find_llvm_profdata(cc)
+            if not tool:
+                raise RuntimeError("pgo = \"use\" needs llvm-profdata to merge the recorded .profraw files")
+            print(f"[PGO] Merging {len(raw)} raw profile(s) into {profdata}")
+            subprocess.run([tool, "merge", "-o", str(profdata)] + [str(p) for p in raw], check=True)
+        if not profdata.exists():
+            raise RuntimeError(f"no profile data in {profile_dir}; build with pgo = \"generate\" and run the node first")
+        newest = profdata.stat().st_mtime_ns
+    elif family == "msvc":
+        # instrumented executables write <exe>!N.pgc next to themselves
+        for pgc in executable.parent.glob(f"{executable.stem}!*.pgc"):
+            shutil.move(str(pgc), str(profile_dir / pgc.name.replace(executable.stem, node_name, 1)))
+        if not msvc_pgd_path(profile_dir, node_name).exists():
+            raise RuntimeError(f"no profile data in {profile_dir}; build with pgo = \"generate\" and run the node first")
+        newest = _newest_mtime(profile_dir, (".pgd", ".pgc"))
+    else:
+        newest = _newest_mtime(profile_dir, (".gcda",))
+        if newest is None:
+            print(f"[WARN] no .gcda profile data in {profile_dir}; build with pgo = \"generate\" and run the node first")
+
+    if newest is not None and (not stamp.exists() or stamp.stat().st_mtime_ns < newest):
+        print(f"[PGO] New profile data in {profile_dir}")
+        stamp.touch()
+    return stamp if stamp.exists() else None
+
+
+def cmake_lto_options(lto: Optional[str]) -> List[str]:
+    """CMake definitions propagating LTO to Arrow and CMake dependencies"""
+    if lto not in LTO_MODES:
+        return []
+    return ["-DCMAKE_INTERPROCEDURAL_OPTIMIZATION=ON", "-DCMAKE_POLICY_DEFAULT_CMP0069=NEW"]
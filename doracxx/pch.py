@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Precompiled header support for doracxx node builds
+
+The headers listed in [build] pch (typically dora-node-api.h and the Arrow
+umbrella headers) are gathered into a generated target/<profile>/build/pch/
+doracxx_pch.h, which is precompiled once and force-included in every C++
+translation unit. The precompiled header is tracked like any other
+translation unit, so it is only rebuilt when one of the headers it pulls in
+or the compile flags change, and every unit using it is rebuilt after that.
+"""
+
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import List
+
+try:
+    from .incremental import TranslationUnit
+except ImportError:
+    from incremental import TranslationUnit
+
+PCH_HEADER = "doracxx_pch.h"
+
+
+@dataclass
+class PrecompiledHeader:
+    """A planned precompiled header and the flags that make units use it"""
+    header: Path
+    unit: TranslationUnit
+    use_flags: List[str]
+    link_objects: List[Path] = field(default_factory=list)
+
+
+def render_pch_header(headers: List[str]) -> str:
+    """Content of the generated header that includes every configured header"""
+    lines = ["// Generated by doracxx from [build] pch - do not edit", "#pragma once"]
+    for header in headers:
+        header = header.strip()
+        if header.startswith(("<", '"')):
+            lines.append(f"#include {header}")
+        else:
+            lines.append(f'#include "{header}"')
+    return "\n".join(lines) + "\n"
+
+
+def write_if_changed(path: Path, content: str) -> bool:
+    """Write a generated file only when its content changed, preserving its mtime otherwise"""
+    try:
+        if path.read_text(encoding="utf-8") == content:
+            return False
+    except OSError:
+        pass
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_text(content, encoding="utf-8")
+    return True
+
+
+def plan_pch(cc: str, kind: str, family: str, flags: List[str], headers: List[str], pch_dir: Path) -> PrecompiledHeader:
+    """Generate the PCH header and describe how to build and use it.
+
+    Args:
+        cc: Compiler executable
+        kind: "msvc" or "gcc" (gcc/clang compatible)
+        family: Compiler family from toolchain.compiler_family
+        flags: Compile flags shared by every translation unit
+        headers: Headers from [build] pch
+        pch_dir: Directory for the generated header and PCH artifacts
+    """
+    header = pch_dir / PCH_HEADER
+    if write_if_changed(header, render_pch_header(headers)):
+        print(f"[PCH] Wrote {header}")
+
+    if kind == "msvc":
+        # cl (and clang-cl) build the PCH from a stub source with /Yc; the
+        # resulting object carries the PCH's symbols and must be linked
+        stub = pch_dir / "doracxx_pch.cc"
+        write_if_changed(stub, f'#include "{PCH_HEADER}"\n')
+        pch_file = pch_dir / "doracxx_pch.pch"
+        obj = pch_dir / "doracxx_pch.cc.obj"
+        pch_flags = ["/I", str(pch_dir), f"/Fp{pch_file}", f"/FI{PCH_HEADER}"]
+        command = [cc] + flags + pch_flags + [f"/Yc{PCH_HEADER}", "/c", str(stub), f"/Fo{obj}"]
+        if family == "clang-cl":
+            depfile = obj.with_name(obj.name + ".d")
+            command += ["/clang:-MMD", f"/clang:-MF{depfile}"]
+        else:
+            depfile = obj.with_name(obj.name + ".json")
+            command += ["/sourceDependencies", str(depfile)]
+        unit = TranslationUnit(source=stub, obj=obj, depfile=depfile, cacheable=False, command=command,
+                               extra_inputs=[header])
+        return PrecompiledHeader(header=header, unit=unit, use_flags=pch_flags + [f"/Yu{PCH_HEADER}"],
+                                 link_objects=[obj])
+
+    if family == "clang":
+        output = pch_dir / (PCH_HEADER + ".pch")
+        use_flags = ["-include-pch", str(output)]
+    else:
+        # gcc picks up doracxx_pch.h.gch next to the force-included header
+        output = pch_dir / (PCH_HEADER + ".gch")
+        use_flags = ["-include", str(header), "-Winvalid-pch"]
+    depfile = output.with_name(output.name + ".d")
+    command = [cc] + flags + ["-x", "c++-header", str(header), "-o", str(output), "-MMD", "-MF", str(depfile)]
+    unit = TranslationUnit(source=header, obj=output, depfile=depfile, cacheable=False, command=command)
+    return PrecompiledHeader(header=header, unit=unit, use_flags=use_flags)
+
+
+def apply_pch(pch: PrecompiledHeader, units: List[TranslationUnit], kind: str, family: str):
+    """Make the C++ translation units use the precompiled header"""
+    for unit in units:
+        # cl compiles .c files as C, which cannot use a C++ PCH
+        if kind == "msvc" and unit.source.suffix.lower() == ".c":
+            continue
+        unit.extra_flags = unit.extra_flags + pch.use_flags
+        unit.extra_inputs = unit.extra_inputs + [pch.unit.obj]
+        # clang and MSVC do not re-expand a PCH when preprocessing, so the
+        # object cache key would not see the headers it contains
+        if family != "gcc":
+            unit.cacheable = False
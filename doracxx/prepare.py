@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Concurrent preparation of what a node build needs
+
+Dora, Arrow and the [dependencies] of a node are fetched and built by
+independent tasks: on a cold machine the Arrow CMake build no longer waits
+for the Dora cargo build. A PrepareGraph starts each task as soon as the
+tasks it comes after have finished, and shares one job budget between the
+tasks that run a parallel build, so running them together does not
+oversubscribe the machine. The first failure is raised once the tasks
+already running have returned; tasks not started yet are skipped.
+"""
+
+import threading
+from concurrent.futures import ThreadPoolExecutor, wait, FIRST_COMPLETED
+from dataclasses import dataclass, field
+from typing import Any, Callable, Dict, List, Optional
+
+try:
+    from .jobs import default_job_count
+except ImportError:
+    from jobs import default_job_count
+
+
+@dataclass
+class PrepareTask:
+    """A preparation step; run receives the number of parallel jobs it may use.
+
+    builds marks a task that runs a parallel build (cargo, CMake, make) and
+    therefore gets a share of the job budget. Tasks with nothing to
+    build, such as an already prepared Dora, should not set it.
+    """
+    name: str
+    run: Callable[[int], Any]
+    after: List[str] = field(default_factory=list)
+    builds: bool = False
+
+
+class PrepareGraph:
+    """Run preparation tasks concurrently in dependency order"""
+
+    def __init__(self, jobs: Optional[int] = None):
+        self.jobs = default_job_count(jobs)
+        self.tasks: Dict[str, PrepareTask] = {}
+
+    def add(self, name: str, run: Callable[[int], Any], after: Optional[List[str]] = None,
+            builds: bool = False) -> PrepareTask:
+        if name in self.tasks:
+            raise ValueError(f"duplicate prepare task: {name}")
+        task = PrepareTask(name, run, list(after or []), builds)
+        self.tasks[name] = task
+        return task
+
+    def job_share(self) -> int:
+        """Jobs for each building task: the budget split evenly, at least one each"""
+        builders = sum(1 for task in self.tasks.values() if task.builds)
+        return max(1, self.jobs // max(1, builders))
+
+    def _check(self):
+        for task in self.tasks.values():
+            for dep in task.after:
+                if dep not in self.tasks:
+                    raise ValueError(f"prepare task {task.name} comes after unknown task {dep}")
+        # depth-first search for a cycle
+        state: Dict[str, int] = {}
+
+        def visit(name: str, path: List[str]):
+            if state.get(name) == 2:
+                return
+            if state.get(name) == 1:
+                raise ValueError(f"prepare tasks form a cycle: {' -> '.join(path + [name])}")
+            state[name] = 1
+            for dep in self.tasks[name].after:
+                visit(dep, path + [name])
+            state[name] = 2
+
+        for name in self.tasks:
+            visit(name, [])
+
+    def run(self) -> Dict[str, Any]:
+        """Run every task and return their results by name"""
+        self._check()
+        if not self.tasks:
+            return {}
+        share = self.job_share()
+        results: Dict[str, Any] = {}
+        remaining = dict(self.tasks)
+        error: Optional[BaseException] = None
+        lock = threading.Lock()
+
+        def run_task(task: PrepareTask):
+            value = task.run(share if task.builds else 1)
+            with lock:
+                results[task.name] = value
+
+        with ThreadPoolExecutor(max_workers=len(self.tasks)) as pool:
+            running = {}
+            while True:
+                if error is None:
+                    for name, task in list(remaining.items()):
+                        if all(dep in results for dep in task.after):
+                            running[pool.submit(run_task, task)] = name
+                            del remaining[name]
+                if not running:
+                    break
+                done, _ = wait(running, return_when=FIRST_COMPLETED)
+                for future in done:
+                    del running[future]
+                    if future.exception() is not None and error is None:
+                        error = future.exception()
+
+        if error is not None:
+            raise error
+        return results
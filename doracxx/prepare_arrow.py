@@ -19,35 +19,58 @@ import shutil
 
 # Import cache functions with proper path handling for different execution contexts
 try:
-    from .cache import get_doracxx_cache_dir, get_arrow_cache_path
+    from .cache import get_doracxx_cache_dir, get_arrow_cache_path, arrow_install_name, cache_lock
+    from .optimization import cmake_lto_options
+    from .timings import timed
+    from .artifacts import artifact_name, cmake_compiler_identity
+    from .git_mirror import checkout
+    from .config import resolve_arrow_components
 except ImportError:
     # When run directly, import from the same directory
     import sys
     sys.path.insert(0, str(Path(__file__).parent))
-    from cache import get_doracxx_cache_dir, get_arrow_cache_path
+    from cache import get_doracxx_cache_dir, get_arrow_cache_path, arrow_install_name, cache_lock
+    from optimization import cmake_lto_options
+    from timings import timed
+    from artifacts import artifact_name, cmake_compiler_identity
+    from git_mirror import checkout
+    from config import resolve_arrow_components
 
+# CMake option enabling each Arrow component
+ARROW_COMPONENT_OPTIONS = {
+    "compute": "ARROW_COMPUTE", "csv": "ARROW_CSV", "json": "ARROW_JSON", "filesystem": "ARROW_FILESYSTEM",
+    "ipc": "ARROW_IPC", "acero": "ARROW_ACERO", "dataset": "ARROW_DATASET", "parquet": "ARROW_PARQUET",
+    "lz4": "ARROW_WITH_LZ4", "zstd": "ARROW_WITH_ZSTD", "snappy": "ARROW_WITH_SNAPPY",
+    "zlib": "ARROW_WITH_ZLIB", "brotli": "ARROW_WITH_BROTLI", "bz2": "ARROW_WITH_BZ2",
+}
 
+
+def arrow_component_libraries(components: list | None = None) -> list:
+    """Arrow libraries a node links for these components, dependents first"""
+    components = resolve_arrow_components(components)
+    libraries = []
+    for component, library in (("parquet", "parquet"), ("dataset", "arrow_dataset"), ("acero", "arrow_acero")):
+        if component in components:
+            libraries.append(library)
+    return libraries + ["arrow"]
+
+
+def arrow_source_dir(vendor: Path) -> Path:
+    """The Arrow checkout of a cache entry
+
+    It lives next to the install trees, not around them: restoring a
+    prebuilt install fills the entry before anything is cloned.
+    """
+    return vendor / "src"
+
+
+@timed("git")
 def git_clone_or_update(url: str, dest: Path, rev: str | None):
     """Clone or update Apache Arrow repository"""
     dest = dest.resolve()
     if dest.exists():
         print(f"Arrow already present at {dest}, fetching updates")
-        try:
-            subprocess.check_call(["git", "-C", str(dest), "fetch", "--all"], stdout=subprocess.DEVNULL)
-            if rev:
-                subprocess.check_call(["git", "-C", str(dest), "checkout", rev])
-            else:
-                subprocess.check_call(["git", "-C", str(dest), "checkout", "main"]) 
-        except subprocess.CalledProcessError:
-            print("warning: git update failed, continuing with existing checkout")
-        return dest
-
-    dest.parent.mkdir(parents=True, exist_ok=True)
-    cmd = ["git", "clone", url, str(dest)]
-    if rev:
-        cmd += ["--branch", rev]
-    subprocess.check_call(cmd)
-    return dest
+    return checkout(url, dest, rev)
 
 
 def run(cmd, cwd=None, env=None, check=True):
@@ -78,65 +101,40 @@ def detect_cmake_generator():
         return "Unix Makefiles"
 
 
-def build_arrow_cpp(repo: Path, profile: str, install_dir: Path, linkage: str = "static"):
-    """Build Arrow C++ library with minimal configuration optimized for doracxx
-    
-    Args:
-        repo: Arrow repository path
-        profile: Build profile (debug/release)
-        install_dir: Installation directory
-        linkage: Linkage mode - "static" (default) or "shared"
-    """
-    cpp_dir = repo / "cpp"
-    if not cpp_dir.exists():
-        raise RuntimeError(f"Arrow C++ directory not found: {cpp_dir}")
-    
-    build_dir = cpp_dir / "build"
-    build_dir.mkdir(exist_ok=True)
-    
-    # Determine build type
+def arrow_cmake_options(profile: str, linkage: str = "static", lto: str | None = None,
+                        cxx_compiler: str | None = None, simd_level: str | None = None,
+                        allocator: str = "system", components: list | None = None) -> list:
+    """The CMake options doracxx builds Arrow with, which also identify a prebuilt Arrow"""
+    if allocator == "jemalloc" and os.name == "nt":
+        allocator = "mimalloc"
     build_type = "Release" if profile == "release" else "Debug"
     
-    # Detect CMake generator
-    generator = detect_cmake_generator()
-    
-    print(f"Building Arrow C++ library ({build_type}, {linkage} linkage)...")
-    
     # Configure linkage settings
     shared_enabled = "ON" if linkage == "shared" else "OFF"
     static_enabled = "ON" if linkage == "static" else "OFF"
     
+    # Only the selected [arrow] components are built; everything else stays off
+    selected = resolve_arrow_components(components)
+    
     # Configure CMake with minimal Arrow features for faster builds
     cmake_args = [
-        "cmake",
         f"-DCMAKE_BUILD_TYPE={build_type}",
-        f"-DCMAKE_INSTALL_PREFIX={install_dir}",
         
         # Core Arrow features - enable minimal set
         f"-DARROW_BUILD_SHARED={shared_enabled}",  # Configurable shared libs
         f"-DARROW_BUILD_STATIC={static_enabled}",  # Configurable static libs
-        "-DARROW_COMPUTE=ON",        # Core compute functionality
-        "-DARROW_CSV=ON",           # CSV support
-        "-DARROW_FILESYSTEM=ON",    # Filesystem operations
-        "-DARROW_JSON=ON",          # JSON support
+    ] + [f"-D{option}={'ON' if component in selected else 'OFF'}"
+         for component, option in ARROW_COMPONENT_OPTIONS.items()] + [
         
         # Disable heavy features to speed up build
-        "-DARROW_DATASET=OFF",
         "-DARROW_FLIGHT=OFF",
         "-DARROW_GANDIVA=OFF",
         "-DARROW_HDFS=OFF",
-        "-DARROW_JEMALLOC=OFF",
-        "-DARROW_MIMALLOC=OFF",
-        "-DARROW_PARQUET=OFF",      # Disable Parquet for faster builds
+        f"-DARROW_JEMALLOC={'ON' if allocator == 'jemalloc' else 'OFF'}",
+        f"-DARROW_MIMALLOC={'ON' if allocator == 'mimalloc' else 'OFF'}",
         "-DARROW_PLASMA=OFF",
         "-DARROW_PYTHON=OFF",
         "-DARROW_S3=OFF",
-        "-DARROW_WITH_BROTLI=OFF",
-        "-DARROW_WITH_BZ2=OFF",
-        "-DARROW_WITH_LZ4=OFF",
-        "-DARROW_WITH_SNAPPY=OFF",
-        "-DARROW_WITH_ZLIB=OFF",
-        "-DARROW_WITH_ZSTD=OFF",
         
         # Testing and benchmarks - disable for faster builds
         "-DARROW_BUILD_TESTS=OFF",
@@ -149,6 +147,72 @@ def build_arrow_cpp(repo: Path, profile: str, install_dir: Path, linkage: str =
         "-DARROW_VERBOSE_THIRDPARTY_BUILD=OFF",
     ]
     
+    # Link-time optimization across the Arrow/node boundary
+    cmake_args.extend(cmake_lto_options(lto))
+    if cxx_compiler:
+        cmake_args.append(f"-DCMAKE_CXX_COMPILER={cxx_compiler}")
+    
+    # CPU targeting: compile for the baseline level, dispatch newer SIMD at runtime
+    if simd_level:
+        cmake_args.extend([f"-DARROW_SIMD_LEVEL={simd_level}", "-DARROW_RUNTIME_SIMD_LEVEL=MAX"])
+    return cmake_args
+
+
+def arrow_artifact_name(commit: str, profile: str, linkage: str = "static", lto: str | None = None,
+                        cxx_compiler: str | None = None, simd_level: str | None = None,
+                        allocator: str = "system", components: list | None = None) -> str:
+    """Name of the prebuilt archive of an Arrow commit built with these settings"""
+    # The compiler is identified by its version, not its path, so machines can share builds
+    return artifact_name("arrow", commit=commit, compiler=cmake_compiler_identity(cxx_compiler),
+                         options=arrow_cmake_options(profile, linkage, lto, None, simd_level, allocator,
+                                                     components))
+
+
+@timed("arrow")
+def build_arrow_cpp(repo: Path, profile: str, install_dir: Path, linkage: str = "static",
+                    lto: str | None = None, cxx_compiler: str | None = None, simd_level: str | None = None,
+                    allocator: str = "system", jobs: int | None = None, components: list | None = None):
+    """Build Arrow C++ library with minimal configuration optimized for doracxx
+    
+    Args:
+        repo: Arrow repository path
+        profile: Build profile (debug/release)
+        install_dir: Installation directory
+        linkage: Linkage mode - "static" (default) or "shared"
+        lto: Enable interprocedural optimization ("thin" or "full")
+        cxx_compiler: C++ compiler to build with (LTO objects are compiler specific)
+        simd_level: ARROW_SIMD_LEVEL baseline (e.g. "AVX2"); kernels for newer
+            instruction sets are still selected at runtime
+        allocator: "system" (default), "jemalloc" or "mimalloc"; the chosen
+            allocator becomes Arrow's default memory pool
+        jobs: Parallel build jobs (defaults to the CPU count)
+        components: Arrow modules and codecs to build (see ARROW_COMPONENT_OPTIONS);
+            None builds the defaults
+    """
+    cpp_dir = repo / "cpp"
+    if not cpp_dir.exists():
+        raise RuntimeError(f"Arrow C++ directory not found: {cpp_dir}")
+    
+    if allocator == "jemalloc" and os.name == "nt":
+        print("[WARN] Arrow does not support jemalloc on Windows; building with mimalloc instead")
+        allocator = "mimalloc"
+    
+    # LTO and CPU-specific builds use their own build tree so they never reuse regular objects
+    build_dir = cpp_dir / arrow_install_name(lto, simd_level, allocator, components).replace("install", "build", 1)
+    build_dir.mkdir(exist_ok=True)
+    
+    # Determine build type
+    build_type = "Release" if profile == "release" else "Debug"
+    
+    # Detect CMake generator
+    generator = detect_cmake_generator()
+    
+    print(f"Building Arrow C++ library ({build_type}, {linkage} linkage{', LTO' if lto else ''}, "
+          f"components: {', '.join(resolve_arrow_components(components))})...")
+    
+    cmake_args = ["cmake", f"-DCMAKE_INSTALL_PREFIX={install_dir}"]
+    cmake_args += arrow_cmake_options(profile, linkage, lto, cxx_compiler, simd_level, allocator, components)
+    
     # Add generator if detected
     if generator:
         cmake_args.extend(["-G", generator])
@@ -162,7 +226,7 @@ def build_arrow_cpp(repo: Path, profile: str, install_dir: Path, linkage: str =
     build_args = ["cmake", "--build", ".", "--config", build_type]
     
     # Add parallel jobs if available
-    parallel_jobs = os.cpu_count()
+    parallel_jobs = jobs or os.cpu_count()
     if parallel_jobs and parallel_jobs > 1:
         if generator == "Ninja":
             build_args.extend(["-j", str(parallel_jobs)])
@@ -223,6 +287,16 @@ def main():
     p.add_argument("--profile", choices=("debug", "release"), default="debug")
     p.add_argument("--linkage", choices=("static", "shared"), default="static",
                    help="Arrow linkage mode: static (default) or shared")
+    p.add_argument("--lto", choices=("thin", "full"), default=None,
+                   help="Build with link-time optimization (installed separately from regular builds)")
+    p.add_argument("--cxx", default=None,
+                   help="C++ compiler to build Arrow with (use the node's compiler with --lto)")
+    p.add_argument("--simd-level", choices=("NONE", "SSE4_2", "AVX2", "AVX512", "NEON"), default=None,
+                   help="Baseline ARROW_SIMD_LEVEL (installed separately from regular builds)")
+    p.add_argument("--allocator", choices=("system", "jemalloc", "mimalloc"), default="system",
+                   help="Allocator built into Arrow and used as its default memory pool")
+    p.add_argument("--components", default=None,
+                   help="Comma-separated Arrow components to build, e.g. compute,ipc,parquet,zstd")
     p.add_argument("--force-rebuild", action="store_true",
                    help="Force rebuild even if Arrow is already installed")
     p.add_argument("--use-local", action="store_true",
@@ -230,6 +304,7 @@ def main():
     p.add_argument("--create-symlink", action="store_true",
                    help="Create symlink from third_party/arrow to global cache for backward compatibility")
     args = p.parse_args()
+    components = args.components.split(",") if args.components else None
 
     if args.use_local:
         # Legacy mode: use third_party/arrow in current project
@@ -239,7 +314,7 @@ def main():
     else:
         # New mode: use global cache with version-specific directories
         vendor = get_arrow_cache_path(args.arrow_git, args.arrow_rev, args.linkage)
-        install_dir = vendor / "install"
+        install_dir = vendor / arrow_install_name(args.lto, args.simd_level, args.allocator, components)
         print("Prepare Arrow in (global cache):", vendor)
         
         # Optionally create symlink from third_party/arrow to cache for backward compatibility
@@ -270,25 +345,30 @@ def main():
             print(f"Arrow installation verification failed: {e}")
             print("Rebuilding Arrow...")
 
-    # Clone or update Arrow repository
-    repo = git_clone_or_update(args.arrow_git, vendor, args.arrow_rev)
-    
-    # Build Arrow C++ library
-    try:
-        success = build_arrow_cpp(repo, args.profile, install_dir, args.linkage)
-        if success:
-            verify_arrow_installation(install_dir)
-            print(f"\nArrow preparation completed successfully! (linkage: {args.linkage})")
-            print(f"Installation directory: {install_dir}")
-            print(f"Include directory: {install_dir / 'include'}")
-            print(f"Library directory: {install_dir / 'lib'}")
-        else:
-            print("Arrow build failed!")
+    # Concurrent builds of the same revision take turns
+    with cache_lock(vendor):
+        # Clone or update Arrow repository
+        source = vendor if args.use_local else arrow_source_dir(vendor)
+        repo = git_clone_or_update(args.arrow_git, source, args.arrow_rev)
+
+        # Build Arrow C++ library
+        try:
+            success = build_arrow_cpp(repo, args.profile, install_dir, args.linkage, lto=args.lto, cxx_compiler=args.cxx,
+                                      simd_level=args.simd_level, allocator=args.allocator,
+                                      components=components)
+            if success:
+                verify_arrow_installation(install_dir)
+                print(f"\nArrow preparation completed successfully! (linkage: {args.linkage})")
+                print(f"Installation directory: {install_dir}")
+                print(f"Include directory: {install_dir / 'include'}")
+                print(f"Library directory: {install_dir / 'lib'}")
+            else:
+                print("Arrow build failed!")
+                return 1
+
+        except Exception as e:
+            print(f"Error building Arrow: {e}")
             return 1
-            
-    except Exception as e:
-        print(f"Error building Arrow: {e}")
-        return 1
 
     return 0
 
@@ -19,34 +19,24 @@ import os
 
 # Import cache functions with proper path handling for different execution contexts
 try:
-    from .cache import get_doracxx_cache_dir, get_dora_cache_path
+    from .cache import get_doracxx_cache_dir, get_dora_cache_path, cache_lock
+    from .timings import timed
+    from .git_mirror import checkout
 except ImportError:
     # When run directly, import from the same directory
     import sys
     sys.path.insert(0, str(Path(__file__).parent))
-    from cache import get_doracxx_cache_dir, get_dora_cache_path
+    from cache import get_doracxx_cache_dir, get_dora_cache_path, cache_lock
+    from timings import timed
+    from git_mirror import checkout
 
 
+@timed("git")
 def git_clone_or_update(url: str, dest: Path, rev: str | None):
     dest = dest.resolve()
     if dest.exists():
         print(f"Dora already present at {dest}, fetching updates")
-        try:
-            subprocess.check_call(["git", "-C", str(dest), "fetch", "--all"], stdout=subprocess.DEVNULL)
-            if rev:
-                subprocess.check_call(["git", "-C", str(dest), "checkout", rev])
-            else:
-                subprocess.check_call(["git", "-C", str(dest), "checkout", "main"]) 
-        except subprocess.CalledProcessError:
-            print("warning: git update failed, continuing with existing checkout")
-        return dest
-
-    dest.parent.mkdir(parents=True, exist_ok=True)
-    cmd = ["git", "clone", url, str(dest)]
-    if rev:
-        cmd += ["--branch", rev]
-    subprocess.check_call(cmd)
-    return dest
+    return checkout(url, dest, rev)
 
 
 def run(cmd, cwd=None, env=None, check=True):
@@ -54,8 +44,23 @@ def run(cmd, cwd=None, env=None, check=True):
     return subprocess.run(cmd, cwd=cwd, env=env, check=check)
 
 
-def build_workspace(repo: Path, profile: str):
-    """Build only the C++ APIs needed for nodes instead of the full workspace."""
+def cargo_build_command(profile: str, jobs: int | None = None) -> list:
+    cmd = [os.environ.get("CARGO", "cargo"), "build"]
+    if profile == "release":
+        cmd.append("--release")
+    if jobs:
+        cmd += ["--jobs", str(jobs)]
+    return cmd
+
+
+@timed("dora")
+def build_workspace(repo: Path, profile: str, jobs: int | None = None):
+    """Build only the C++ APIs needed for nodes instead of the full workspace.
+
+    All packages are built by one cargo invocation so their shared crates are
+    compiled once and in parallel; if that fails, each package is built on
+    its own to keep whatever does build.
+    """
     # Only build the specific C++ API packages we need
     essential_packages = [
         "dora-node-api-cxx", 
@@ -65,12 +70,19 @@ def build_workspace(repo: Path, profile: str):
     ]
     
     print("Building only essential C++ API packages instead of full workspace...")
+    cmd = cargo_build_command(profile, jobs)
+    for package in essential_packages:
+        cmd += ["--package", package]
+    try:
+        run(cmd, cwd=repo)
+        print(f"[OK] Successfully built packages: {', '.join(essential_packages)}")
+        return True
+    except subprocess.CalledProcessError:
+        print("[WARN] Warning: building the packages together failed, building them one by one")
+
     success_count = 0
-    
     for package in essential_packages:
-        cmd = [os.environ.get("CARGO", "cargo"), "build", "--package", package]
-        if profile == "release":
-            cmd.append("--release")
+        cmd = cargo_build_command(profile, jobs) + ["--package", package]
         try:
             run(cmd, cwd=repo)
             print(f"[OK] Successfully built package: {package}")
@@ -86,7 +98,8 @@ def build_workspace(repo: Path, profile: str):
         return False
 
 
-def build_manifests(repo: Path, profile: str):
+@timed("dora")
+def build_manifests(repo: Path, profile: str, jobs: int | None = None):
     manifests = [
         repo / "apis" / "c++" / "node" / "Cargo.toml",
         repo / "apis" / "c++" / "operator" / "Cargo.toml",
@@ -95,9 +108,7 @@ def build_manifests(repo: Path, profile: str):
     ]
     for m in manifests:
         if m.exists():
-            cmd = [os.environ.get("CARGO", "cargo"), "build", "--manifest-path", str(m)]
-            if profile == "release":
-                cmd.append("--release")
+            cmd = cargo_build_command(profile, jobs) + ["--manifest-path", str(m)]
             try:
                 run(cmd, cwd=repo)
             except subprocess.CalledProcessError:
@@ -144,27 +155,27 @@ def main():
                 except (subprocess.CalledProcessError, OSError) as e:
                     print(f"Warning: could not create symlink ({e})")
 
-    repo = git_clone_or_update(args.dora_git, vendor, args.dora_rev)
+    # Concurrent builds of the same revision take turns
+    with cache_lock(vendor):
+        repo = git_clone_or_update(args.dora_git, vendor, args.dora_rev)
 
-    if args.full_workspace:
-        print("Building full workspace as requested...")
-        # Original workspace build
-        cmd = [os.environ.get("CARGO", "cargo"), "build", "--workspace"]
-        if args.profile == "release":
-            cmd.append("--release")
-        try:
-            run(cmd, cwd=repo)
-            ok = True
-        except subprocess.CalledProcessError:
-            print("warning: workspace build failed (some system deps may be missing)")
-            ok = False
-    else:
-        # Optimized build - only essential C++ APIs
-        ok = build_workspace(repo, args.profile)
-    
-    if not ok:
-        print("Attempting targeted builds for C/C++ API crates...")
-        build_manifests(repo, args.profile)
+        if args.full_workspace:
+            print("Building full workspace as requested...")
+            # Original workspace build
+            cmd = cargo_build_command(args.profile) + ["--workspace"]
+            try:
+                run(cmd, cwd=repo)
+                ok = True
+            except subprocess.CalledProcessError:
+                print("warning: workspace build failed (some system deps may be missing)")
+                ok = False
+        else:
+            # Optimized build - only essential C++ APIs
+            ok = build_workspace(repo, args.profile)
+
+        if not ok:
+            print("Attempting targeted builds for C/C++ API crates...")
+            build_manifests(repo, args.profile)
 
     target_dir = repo / "target"
     print()
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+Binary size settings for doracxx node builds
+
+[build] size_opt compiles every function and object into its own section
+and lets the linker drop the unreferenced ones (-Wl,--gc-sections,
+-Wl,-dead_strip on macOS, /OPT:REF /OPT:ICF with MSVC). The link then also
+writes a map file, and the size each linked library contributes is printed
+after the link. [build] strip and split_debug run after the link, so they
+keep working when the link itself is up to date:
+
+    split_debug   debug info moves to <exe>.debug (with a .gnu_debuglink
+                  back to it) or <exe>.dSYM on macOS; MSVC keeps it in the
+                  .pdb already
+    strip         the executable loses its symbol table; with split_debug
+                  the symbols stay available in the debug file
+"""
+
+import re
+import shutil
+from pathlib import Path
+from typing import Dict, List, Optional
+
+LINK_MAP_FILE = "link.map"
+
+# Input sections that take no space in the loaded executable
+_UNALLOCATED = (".debug", ".comment", ".note.GNU-stack", ".gnu.warning", ".gnu_debuglink", ".stab")
+
+# Sections the linker creates, listed under the first input file
+_LINKER_SECTIONS = (".interp", ".note.gnu", ".gnu.hash", ".hash", ".dynsym", ".dynstr", ".gnu.version",
+                    ".rela", ".rel.", ".dynamic", ".got", ".plt", ".eh_frame_hdr")
+
+# GNU ld: " .text.foo  0x0000000000401000  0x1c  /path/libarrow.a(memory_pool.cc.o)";
+# long section names put the address and size on the next line
+_GNU_INPUT = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+_GNU_SECTION_ONLY = re.compile(r"^ (\S+)$")
+# lld: "  2011e0  2011e0  26  16  /path/libarrow.a(memory_pool.cc.o):(.text.foo)" (hex sizes);
+# mold writes the same columns without the LMA
+_LLD_INPUT = re.compile(r"^\s*[0-9a-fA-F]+\s+(?:[0-9a-fA-F]+\s+)?([0-9a-fA-F]+)\s+\d+\s+(.+):\((\S+)\)$")
+# ld64: "[  3] /path/libarrow.a(memory_pool.o)" and "0x100003F80	0x00000010	[  3] _foo"
+_LD64_FILE = re.compile(r"^\[\s*(\d+)\]\s+(.+)$")
+_LD64_SYMBOL = re.compile(r"^0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+\[\s*(\d+)\]\s")
+
+
+def link_map_flags(kind: str, map_path: Path, macos: bool = False) -> List[str]:
+    """Link options writing a map file, appended after the libraries"""
+    if kind == "msvc":
+        return [f"/MAP:{map_path}"]
+    if macos:
+        return [f"-Wl,-map,{map_path}"]
+    return [f"-Wl,-Map={map_path}"]
+
+
+def _find_tool(*names: str) -> Optional[str]:
+    for name in names:
+        path = shutil.which(name)
+        if path:
+            return path
+    return None
+
+
+def post_link_commands(kind: str, out_path: Path, strip: bool, split_debug: bool,
+                       macos: bool = False) -> List[List[str]]:
+    """Commands stripping or splitting the debug info of a freshly linked executable"""
+    if kind == "msvc" or not (strip or split_debug):
+        # link.exe writes debug info to the .pdb and no symbols into the executable
+        return []
+    exe = str(out_path)
+    if macos:
+        commands = []
+        if split_debug:
+            dsymutil = _find_tool("dsymutil")
+            if not dsymutil:
+                print("[WARN] split_debug needs dsymutil; debug info is kept in the executable")
+            else:
+                commands.append([dsymutil, exe, "-o", exe + ".dSYM"])
+        strip_tool = _find_tool("strip")
+        if strip_tool:
+            # -S drops debug info only; plain strip removes the symbol table as well
+            commands.append([strip_tool, exe] if strip else [strip_tool, "-S", exe])
+        return commands
+
+    objcopy = _find_tool("objcopy", "llvm-objcopy")
+    if not objcopy:
+        print("[WARN] strip and split_debug need objcopy (binutils or llvm-objcopy); the executable is left as linked")
+        return []
+    strip_mode = "--strip-all" if strip else "--strip-debug"
+    if not split_debug:
+        return [[objcopy, strip_mode, exe]]
+    debug_file = exe + ".debug"
+    return [[objcopy, "--only-keep-debug", exe, debug_file],
+            [objcopy, strip_mode, f"--add-gnu-debuglink={debug_file}", exe]]
+
+
+def _library_of(input_file: str, own_objects: Optional[str]) -> str:
+    """Report label of an input file: the archive it came from, or the object itself"""
+    input_file = input_file.strip()
+    if input_file.endswith(")") and "(" in input_file:
+        return Path(input_file[:input_file.index("(")]).name
+    if own_objects and input_file.startswith(own_objects):
+        return "<node objects>"
+    return Path(input_file).name
+
+
+def parse_link_map(text: str, own_objects: Optional[str] = None) -> Dict[str, int]:
+    """Bytes each library and object contributes to the executable, from a GNU ld, gold, lld, mold or ld64 map
+
+    MSVC map files do not list sizes per object; they give an empty result.
+    """
+    sizes: Dict[str, int] = {}
+
+    def add(input_file: str, size: int, section: str = ""):
+        if size:
+            label = "<linker generated>" if section.startswith(_LINKER_SECTIONS) else _library_of(input_file, own_objects)
+            sizes[label] = sizes.get(label, 0) + size
+
+    lines = text.splitlines()
+    if any(line.lstrip().startswith("VMA ") and "Symbol" in line for line in lines[:5]):
+        for line in lines:
+            match = _LLD_INPUT.match(line)
+            if match and not match.group(3).startswith(_UNALLOCATED):
+                add(match.group(2), int(match.group(1), 16), match.group(3))
+        return sizes
+
+    if any(line.startswith("# Object files:") for line in lines):
+        files: Dict[str, str] = {}
+        in_symbols = False
+        for line in lines:
+            if line.startswith("# Symbols:"):
+                in_symbols = True
+            elif line.startswith("# ") and in_symbols and not line.startswith("# Address"):
+                in_symbols = False
+            match = _LD64_FILE.match(line)
+            if match and not in_symbols:
+                files[match.group(1)] = match.group(2)
+                continue
+            match = _LD64_SYMBOL.match(line) if in_symbols else None
+            if match and match.group(2) in files:
+                add(files[match.group(2)], int(match.group(1), 16))
+        return sizes
+
+    # GNU ld and gold: input sections follow "Linker script and memory map"
+    # ("Memory map" for gold); the sections listed before it were discarded
+    in_map = False
+    pending = None
+    for line in lines:
+        if line.startswith("Linker script and memory map") or line.rstrip() == "Memory map":
+            in_map = True
+            continue
+        if not in_map:
+            continue
+        match = _GNU_INPUT.match(line)
+        if match:
+            section = match.group(1) or pending
+            pending = None
+            if section and section not in ("*fill*",) and not section.startswith(_UNALLOCATED) \
+                    and not match.group(4).startswith("load address"):
+                add(match.group(4), int(match.group(3), 16), section)
+            continue
+        match = _GNU_SECTION_ONLY.match(line)
+        pending = match.group(1) if match else None
+    return sizes
+
+
+def _bytes(value: int) -> str:
+    if value >= 1024 * 1024:
+        return f"{value / (1024 * 1024):.1f} MB"
+    if value >= 1024:
+        return f"{value / 1024:.1f} KB"
+    return f"{value} B"
+
+
+def print_size_report(out_path: Path, map_path: Optional[Path] = None, own_objects: Optional[str] = None,
+                      top: int = 15):
+    """Print the executable's size and what each linked library contributes to it"""
+    if not out_path.exists():
+        return
+    print(f"[SIZE] {out_path.name}: {_bytes(out_path.stat().st_size)}")
+    for extra in (Path(str(out_path) + ".debug"), Path(str(out_path) + ".dSYM")):
+        if extra.is_file():
+            print(f"[SIZE]   debug info in {extra.name}: {_bytes(extra.stat().st_size)}")
+    if not map_path or not map_path.exists():
+        return
+    sizes = parse_link_map(map_path.read_text(encoding="utf-8", errors="replace"), own_objects)
+    if not sizes:
+        print(f"[SIZE]   no per-library sizes in {map_path.name}")
+        return
+    total = sum(sizes.values())
+    ranked = sorted(sizes.items(), key=lambda item: -item[1])
+    width = max(len(name) for name, _ in ranked[:top])
+    for name, size in ranked[:top]:
+        print(f"[SIZE]   {name:<{width}} {_bytes(size):>10} {size * 100 / total:5.1f}%")
+    rest = ranked[top:]
+    if rest:
+        rest_size = sum(size for _, size in rest)
+        print(f"[SIZE]   {f'{len(rest)} more':<{width}} {_bytes(rest_size):>10} {rest_size * 100 / total:5.1f}%")
@@ -0,0 +1,128 @@
+// doracxx_arrow_bridge.h - Arrow C Data Interface bridge for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// Dora carries Arrow arrays between nodes; these helpers import inputs and
+// export outputs through the Arrow C Data Interface (ArrowArray/ArrowSchema),
+// so typed arrays and multi-column record batches travel without being
+// flattened to bytes. Buffers are shared, never copied: an imported array
+// keeps the Dora input alive until it is released, and an exported array
+// keeps the node's buffers alive until Dora is done with them.
+//
+// Include it after dora-node-api.h. The Dora glue needs a Dora version whose
+// C++ API provides event_as_arrow_input and send_arrow_output; the
+// import/export helpers only need Arrow.
+//
+//   auto batch = doracxx::arrow_bridge::input_record_batch(std::move(event));
+//   ...
+//   auto status = doracxx::arrow_bridge::send_record_batch(dora_node.send_output, "out", *result);
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/c/abi.h>
+#include <arrow/c/bridge.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace doracxx {
+namespace arrow_bridge {
+
+// --- Arrow C Data Interface ---------------------------------------------------
+
+/// Import an exported array; moves out of (and releases) the C structs.
+inline arrow::Result<std::shared_ptr<arrow::Array>> import_array(ArrowArray* array, ArrowSchema* schema) {
+    return arrow::ImportArray(array, schema);
+}
+
+/// Import an exported struct array as a record batch.
+inline arrow::Result<std::shared_ptr<arrow::RecordBatch>> import_record_batch(ArrowArray* array,
+                                                                              ArrowSchema* schema) {
+    return arrow::ImportRecordBatch(array, schema);
+}
+
+/// Export an array and its type; the consumer must call the release callbacks.
+inline arrow::Status export_array(const arrow::Array& array, ArrowArray* out_array, ArrowSchema* out_schema) {
+    ARROW_RETURN_NOT_OK(arrow::ExportType(*array.type(), out_schema));
+    arrow::Status status = arrow::ExportArray(array, out_array);
+    if (!status.ok()) {
+        out_schema->release(out_schema);
+    }
+    return status;
+}
+
+/// Export a record batch as a struct array with one child per column.
+inline arrow::Status export_record_batch(const arrow::RecordBatch& batch, ArrowArray* out_array,
+                                         ArrowSchema* out_schema) {
+    ARROW_RETURN_NOT_OK(arrow::ExportSchema(*batch.schema(), out_schema));
+    arrow::Status status = arrow::ExportRecordBatch(batch, out_array);
+    if (!status.ok()) {
+        out_schema->release(out_schema);
+    }
+    return status;
+}
+
+// --- Dora glue ------------------------------------------------------------------
+//
+// Templates so that this header also compiles against Dora versions without
+// the Arrow entry points, as long as these helpers are not used.
+
+namespace detail {
+
+template <typename Result>
+arrow::Status to_status(const Result& result, const char* what) {
+    std::string error(result.error);
+    if (error.empty()) {
+        return arrow::Status::OK();
+    }
+    return arrow::Status::IOError(what, ": ", error);
+}
+
+}  // namespace detail
+
+/// Take the Arrow array of an input event without copying its buffers.
+template <typename Event>
+arrow::Result<std::shared_ptr<arrow::Array>> input_array(Event&& event) {
+    ArrowArray c_array{};
+    ArrowSchema c_schema{};
+    auto result = event_as_arrow_input(std::forward<Event>(event), reinterpret_cast<uint8_t*>(&c_array),
+                                       reinterpret_cast<uint8_t*>(&c_schema));
+    ARROW_RETURN_NOT_OK(detail::to_status(result, "event_as_arrow_input"));
+    return import_array(&c_array, &c_schema);
+}
+
+/// Take a multi-column input (a struct array) as a record batch.
+template <typename Event>
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> input_record_batch(Event&& event) {
+    ARROW_ASSIGN_OR_RAISE(auto array, input_array(std::forward<Event>(event)));
+    if (array->type_id() != arrow::Type::STRUCT) {
+        return arrow::Status::TypeError("input is a ", array->type()->ToString(), ", not a struct array");
+    }
+    return arrow::RecordBatch::FromStructArray(array);
+}
+
+/// Send an Arrow array as an output; Dora takes ownership of the exported structs.
+///
+/// Extra arguments (for example metadata on Dora versions that take it) are
+/// forwarded to send_arrow_output.
+template <typename Sender, typename... Extra>
+arrow::Status send_array(Sender& sender, const std::string& id, const arrow::Array& array, Extra&&... extra) {
+    ArrowArray c_array{};
+    ArrowSchema c_schema{};
+    ARROW_RETURN_NOT_OK(export_array(array, &c_array, &c_schema));
+    auto result = send_arrow_output(sender, id, reinterpret_cast<uint8_t*>(&c_array),
+                                    reinterpret_cast<uint8_t*>(&c_schema), std::forward<Extra>(extra)...);
+    return detail::to_status(result, "send_arrow_output");
+}
+
+/// Send a record batch as a struct array output.
+template <typename Sender, typename... Extra>
+arrow::Status send_record_batch(Sender& sender, const std::string& id, const arrow::RecordBatch& batch,
+                                Extra&&... extra) {
+    ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::StructArray> array, batch.ToStructArray());
+    return send_array(sender, id, *array, std::forward<Extra>(extra)...);
+}
+
+}  // namespace arrow_bridge
+}  // namespace doracxx
@@ -0,0 +1,302 @@
+// doracxx_arrow_memory.h - per-processor Arrow memory pools for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// Arrow allocates through arrow::default_memory_pool() unless told otherwise;
+// a node handling events at a high rate is better off with its own pool that
+// it passes to builders, AllocateBuffer and its ExecContext:
+//
+//   default   the process-wide default pool, with per-processor statistics
+//   system    malloc/free, with per-processor statistics
+//   jemalloc  Arrow's jemalloc pool (Arrow built with [arrow] allocator = "jemalloc")
+//   mimalloc  Arrow's mimalloc pool (Arrow built with [arrow] allocator = "mimalloc")
+//   arena     a frame-scoped bump allocator that recycles its blocks whenever
+//             every buffer allocated from it has been released, typically at
+//             the end of each event
+//
+//   auto pool = doracxx::arrow_memory::make_memory_pool("arena").ValueOrDie();
+//   arrow::compute::ExecContext ctx(pool.get());
+//   ...
+//   std::cout << doracxx::arrow_memory::pool_stats(pool.get()).ToString() << std::endl;
+#pragma once
+
+#include <arrow/memory_pool.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace doracxx {
+namespace arrow_memory {
+
+/// Allocation counters of a memory pool, for sizing it.
+struct PoolStats {
+    int64_t bytes_allocated = 0;        // currently live
+    int64_t max_memory = 0;             // peak of bytes_allocated
+    int64_t total_bytes_allocated = 0;  // cumulative
+    int64_t num_allocations = 0;        // cumulative
+
+    std::string ToString() const {
+        return "bytes_allocated=" + std::to_string(bytes_allocated) + " max_memory=" + std::to_string(max_memory) +
+               " total_bytes_allocated=" + std::to_string(total_bytes_allocated) +
+               " num_allocations=" + std::to_string(num_allocations);
+    }
+};
+
+inline PoolStats pool_stats(const arrow::MemoryPool* pool) {
+    PoolStats stats;
+    stats.bytes_allocated = pool->bytes_allocated();
+    stats.max_memory = pool->max_memory();
+    stats.total_bytes_allocated = pool->total_bytes_allocated();
+    stats.num_allocations = pool->num_allocations();
+    return stats;
+}
+
+/// Bump allocator over blocks taken from an upstream pool.
+///
+/// Allocations are carved out of the current block and never freed one by
+/// one; once the last live allocation is freed the arena rewinds and keeps a
+/// single block (the largest) for the next frame. Allocations larger than
+/// the block size get a block of their own.
+class ArenaMemoryPool : public arrow::MemoryPool {
+public:
+    static constexpr int64_t kDefaultBlockSize = 1 << 20;
+
+    explicit ArenaMemoryPool(int64_t block_size = kDefaultBlockSize,
+                             arrow::MemoryPool* upstream = arrow::system_memory_pool())
+        : block_size_(block_size), upstream_(upstream) {}
+
+    ~ArenaMemoryPool() override {
+        for (const Block& block : blocks_) {
+            upstream_->Free(block.data, block.size, kBlockAlignment);
+        }
+    }
+
+    ArenaMemoryPool(const ArenaMemoryPool&) = delete;
+    ArenaMemoryPool& operator=(const ArenaMemoryPool&) = delete;
+
+    using arrow::MemoryPool::Allocate;
+    using arrow::MemoryPool::Free;
+    using arrow::MemoryPool::Reallocate;
+
+    arrow::Status Allocate(int64_t size, int64_t alignment, uint8_t** out) override {
+        if (size < 0) {
+            return arrow::Status::Invalid("negative allocation size");
+        }
+        if (size == 0) {
+            *out = zero_size_area();
+            return arrow::Status::OK();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        ARROW_RETURN_NOT_OK(bump(size, alignment, out));
+        ++live_allocations_;
+        record_allocation(size);
+        return arrow::Status::OK();
+    }
+
+    arrow::Status Reallocate(int64_t old_size, int64_t new_size, int64_t alignment, uint8_t** ptr) override {
+        if (new_size < 0) {
+            return arrow::Status::Invalid("negative allocation size");
+        }
+        if (old_size == 0 || *ptr == zero_size_area()) {
+            return Allocate(new_size, alignment, ptr);
+        }
+        if (new_size == 0) {
+            Free(*ptr, old_size, alignment);
+            *ptr = zero_size_area();
+            return arrow::Status::OK();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // the most recent allocation can grow or shrink in place
+        if (!blocks_.empty() && *ptr == last_allocation_) {
+            Block& current = blocks_[current_block_];
+            const int64_t start = *ptr - current.data;
+            if (start + new_size <= current.size) {
+                offset_ = start + new_size;
+                record_resize(old_size, new_size);
+                return arrow::Status::OK();
+            }
+        }
+        uint8_t* moved = nullptr;
+        ARROW_RETURN_NOT_OK(bump(new_size, alignment, &moved));
+        std::memcpy(moved, *ptr, static_cast<size_t>(std::min(old_size, new_size)));
+        *ptr = moved;
+        record_resize(old_size, new_size);
+        return arrow::Status::OK();
+    }
+
+    void Free(uint8_t* buffer, int64_t size, int64_t /*alignment*/) override {
+        if (size == 0 || buffer == zero_size_area()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes_allocated_ -= size;
+        if (--live_allocations_ == 0) {
+            rewind();
+        }
+    }
+
+    void ReleaseUnused() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (live_allocations_ == 0) {
+            for (const Block& block : blocks_) {
+                upstream_->Free(block.data, block.size, kBlockAlignment);
+            }
+            blocks_.clear();
+            current_block_ = 0;
+            offset_ = 0;
+            last_allocation_ = nullptr;
+        }
+    }
+
+    int64_t bytes_allocated() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_allocated_;
+    }
+    int64_t max_memory() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_memory_;
+    }
+    int64_t total_bytes_allocated() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_bytes_allocated_;
+    }
+    int64_t num_allocations() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_allocations_;
+    }
+    std::string backend_name() const override { return "arena(" + upstream_->backend_name() + ")"; }
+
+    /// Bytes held from the upstream pool, live or not.
+    int64_t reserved_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t reserved = 0;
+        for (const Block& block : blocks_) {
+            reserved += block.size;
+        }
+        return reserved;
+    }
+
+private:
+    // every block is aligned for any alignment Arrow asks for
+    static constexpr int64_t kBlockAlignment = 64;
+
+    struct Block {
+        uint8_t* data;
+        int64_t size;
+    };
+
+    static uint8_t* zero_size_area() {
+        alignas(kBlockAlignment) static uint8_t area[kBlockAlignment];
+        return area;
+    }
+
+    static int64_t align_up(int64_t value, int64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    arrow::Status bump(int64_t size, int64_t alignment, uint8_t** out) {
+        if (alignment <= 0 || alignment > kBlockAlignment || (alignment & (alignment - 1)) != 0) {
+            return arrow::Status::Invalid("unsupported alignment ", alignment);
+        }
+        if (!blocks_.empty()) {
+            const int64_t start = align_up(offset_, alignment);
+            if (start + size <= blocks_[current_block_].size) {
+                return carve(start, size, out);
+            }
+        }
+        Block block{nullptr, std::max(block_size_, align_up(size, kBlockAlignment))};
+        ARROW_RETURN_NOT_OK(upstream_->Allocate(block.size, kBlockAlignment, &block.data));
+        blocks_.push_back(block);
+        current_block_ = blocks_.size() - 1;
+        return carve(0, size, out);
+    }
+
+    arrow::Status carve(int64_t start, int64_t size, uint8_t** out) {
+        *out = blocks_[current_block_].data + start;
+        offset_ = start + size;
+        last_allocation_ = *out;
+        return arrow::Status::OK();
+    }
+
+    void rewind() {
+        // keep the largest block so that a steady frame size stops allocating
+        if (blocks_.size() > 1) {
+            auto largest = std::max_element(blocks_.begin(), blocks_.end(),
+                                            [](const Block& a, const Block& b) { return a.size < b.size; });
+            std::swap(*largest, blocks_.front());
+            for (size_t i = 1; i < blocks_.size(); ++i) {
+                upstream_->Free(blocks_[i].data, blocks_[i].size, kBlockAlignment);
+            }
+            blocks_.resize(1);
+        }
+        current_block_ = 0;
+        offset_ = 0;
+        last_allocation_ = nullptr;
+    }
+
+    void record_allocation(int64_t size) {
+        bytes_allocated_ += size;
+        max_memory_ = std::max(max_memory_, bytes_allocated_);
+        total_bytes_allocated_ += size;
+        ++num_allocations_;
+    }
+
+    void record_resize(int64_t old_size, int64_t new_size) {
+        bytes_allocated_ += new_size - old_size;
+        max_memory_ = std::max(max_memory_, bytes_allocated_);
+        if (new_size > old_size) {
+            total_bytes_allocated_ += new_size - old_size;
+        }
+        ++num_allocations_;
+    }
+
+    const int64_t block_size_;
+    arrow::MemoryPool* const upstream_;
+    mutable std::mutex mutex_;
+    std::vector<Block> blocks_;
+    size_t current_block_ = 0;
+    int64_t offset_ = 0;
+    uint8_t* last_allocation_ = nullptr;
+    int64_t live_allocations_ = 0;
+    int64_t bytes_allocated_ = 0;
+    int64_t max_memory_ = 0;
+    int64_t total_bytes_allocated_ = 0;
+    int64_t num_allocations_ = 0;
+};
+
+/// Create a pool owned by one processor: "default", "system", "jemalloc",
+/// "mimalloc" or "arena".
+///
+/// The process-wide pools are wrapped in an arrow::ProxyMemoryPool so that
+/// statistics only count this processor's allocations. Asking for jemalloc
+/// or mimalloc when Arrow was built without it returns an error status.
+inline arrow::Result<std::unique_ptr<arrow::MemoryPool>> make_memory_pool(const std::string& kind,
+                                                                         int64_t arena_block_size = ArenaMemoryPool::kDefaultBlockSize) {
+    if (kind == "arena") {
+        return std::unique_ptr<arrow::MemoryPool>(new ArenaMemoryPool(arena_block_size));
+    }
+    arrow::MemoryPool* base = nullptr;
+    if (kind.empty() || kind == "default") {
+        base = arrow::default_memory_pool();
+    } else if (kind == "system") {
+        base = arrow::system_memory_pool();
+    } else if (kind == "jemalloc") {
+        ARROW_RETURN_NOT_OK(arrow::jemalloc_memory_pool(&base));
+    } else if (kind == "mimalloc") {
+        ARROW_RETURN_NOT_OK(arrow::mimalloc_memory_pool(&base));
+    } else {
+        return arrow::Status::Invalid("unknown memory pool '", kind,
+                                      "' (expected default, system, jemalloc, mimalloc or arena)");
+    }
+    return std::unique_ptr<arrow::MemoryPool>(new arrow::ProxyMemoryPool(base));
+}
+
+}  // namespace arrow_memory
+}  // namespace doracxx
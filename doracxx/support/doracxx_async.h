@@ -0,0 +1,505 @@
+// doracxx_async.h - C++20 coroutine runtime for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps when the node is built with
+// std = "c++20" or later. A NodeRuntime runs coroutines on the node's main
+// thread; while one task waits for an event, a timer or blocking work moved
+// to another thread, the others keep running and the event stream is still
+// read:
+//
+//   doracxx::async::Task<> handle_inputs(doracxx::async::NodeRuntime& rt, DoraNode& node) {
+//       while (auto event = co_await rt.next_event()) {
+//           if (event_type(*event) != DoraEventType::Input) continue;
+//           auto input = event_as_input(std::move(*event));
+//           auto reply = co_await rt.run_in_thread([&] { return call_service(input); });
+//           co_await rt.send([&] { return send_output(node.send_output, "reply", slice(reply)); });
+//       }
+//   }
+//
+//   doracxx::async::Task<> heartbeat(doracxx::async::NodeRuntime& rt) {
+//       for (;;) { co_await rt.sleep_for(std::chrono::seconds(1)); ... }
+//   }
+//
+//   auto node = init_dora_node();
+//   doracxx::async::NodeRuntime rt(*node.events);
+//   rt.spawn(heartbeat(rt));
+//   rt.run(handle_inputs(rt, node));
+//
+// Include it after dora-node-api.h. Events are read on a background thread,
+// which stops after the AllInputsClosed event; the runtime's destructor waits
+// for it, so destroy the runtime only once the stream has ended. Everything
+// else - tasks, timers and sends - runs on the thread calling run().
+#pragma once
+
+#if (defined(_MSVC_LANG) && _MSVC_LANG < 202002L) || (!defined(_MSVC_LANG) && __cplusplus < 202002L)
+#error "doracxx_async.h needs C++20: set std = \"c++20\" (or later) in doracxx.toml"
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace doracxx {
+namespace async {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            // resume whoever awaited the task; detached tasks just stop
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+    T take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+}  // namespace detail
+
+/// Lazily started coroutine; co_await it from another task, or hand it to
+/// NodeRuntime::run or spawn.
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend struct detail::Promise<T>;
+    friend class NodeRuntime;
+
+    explicit Task(Handle handle) : handle_(handle) {}
+
+    Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+}  // namespace detail
+
+/// Single-threaded scheduler for the coroutines of one Dora node.
+class NodeRuntime {
+public:
+    using Event = rust::Box<DoraEvent>;
+    using Clock = std::chrono::steady_clock;
+
+    explicit NodeRuntime(Events& events) : events_(events) {
+        reader_ = std::thread([this] { read_events(); });
+    }
+
+    ~NodeRuntime() {
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return offloaded_ == 0; });
+    }
+
+    NodeRuntime(const NodeRuntime&) = delete;
+    NodeRuntime& operator=(const NodeRuntime&) = delete;
+
+    /// Run task, and the tasks spawned meanwhile, until task finishes.
+    /// Rethrows an exception escaping task or any spawned task.
+    void run(Task<> task) {
+        Task<>::Handle main = task.handle_;
+        schedule(main);
+        while (!main.done()) {
+            collect();
+            if (ready_.empty()) {
+                wait();
+                continue;
+            }
+            std::deque<std::coroutine_handle<>> ready;
+            ready.swap(ready_);
+            for (std::coroutine_handle<> handle : ready) {
+                handle.resume();
+            }
+            reap_spawned();
+        }
+        main.promise().take();
+    }
+
+    /// Start a task that runs alongside the others; it is destroyed once done.
+    void spawn(Task<> task) {
+        schedule(task.handle_);
+        spawned_.push_back(std::move(task));
+    }
+
+    /// Wait for the next Dora event; empty once the stream has ended.
+    ///
+    /// Concurrent waiters receive events in the order they started waiting.
+    auto next_event() {
+        struct Awaiter {
+            NodeRuntime& runtime;
+            std::optional<Event> event;
+            bool await_ready() {
+                if (runtime.event_waiters_.empty() && !runtime.events_ready_.empty()) {
+                    event.emplace(std::move(runtime.events_ready_.front()));
+                    runtime.events_ready_.pop_front();
+                    return true;
+                }
+                return runtime.events_ready_.empty() && runtime.stream_ended_;
+            }
+            void await_suspend(std::coroutine_handle<> handle) {
+                runtime.event_waiters_.push_back(EventWaiter{handle, &event});
+            }
+            std::optional<Event> await_resume() { return std::move(event); }
+        };
+        return Awaiter{*this, std::nullopt};
+    }
+
+    /// Resume after a delay, letting other tasks run meanwhile.
+    auto sleep_until(Clock::time_point deadline) {
+        struct Awaiter {
+            NodeRuntime& runtime;
+            Clock::time_point deadline;
+            bool await_ready() const { return deadline <= Clock::now(); }
+            void await_suspend(std::coroutine_handle<> handle) {
+                runtime.timers_.push(Timer{deadline, runtime.timer_sequence_++, handle});
+            }
+            void await_resume() const {}
+        };
+        return Awaiter{*this, deadline};
+    }
+
+    template <typename Rep, typename Period>
+    auto sleep_for(std::chrono::duration<Rep, Period> delay) {
+        return sleep_until(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay));
+    }
+
+    /// Resume once every spawned task has finished.
+    ///
+    /// Await it from the task passed to run(), not from a spawned task,
+    /// which would wait for itself.
+    auto drain() {
+        struct Awaiter {
+            NodeRuntime& runtime;
+            bool await_ready() const { return runtime.spawned_done(); }
+            void await_suspend(std::coroutine_handle<> handle) { runtime.drain_waiters_.push_back(handle); }
+            void await_resume() const {}
+        };
+        return Awaiter{*this};
+    }
+
+    /// Let the other ready tasks run before resuming.
+    auto yield() {
+        struct Awaiter {
+            NodeRuntime& runtime;
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { runtime.schedule(handle); }
+            void await_resume() const {}
+        };
+        return Awaiter{*this};
+    }
+
+    /// Send an output, then let the other ready tasks run.
+    ///
+    /// send is a callable performing the actual send, e.g.
+    /// [&] { return send_output(node.send_output, "out", data); }; its result
+    /// is returned. Dora's send does not block on the receivers, so it runs
+    /// right away on the runtime thread, which is the only thread allowed to
+    /// use the output sender.
+    template <typename Send>
+    auto send(Send send) {
+        using Result = std::invoke_result_t<Send&>;
+        struct Awaiter {
+            NodeRuntime& runtime;
+            Send send;
+            std::optional<Result> result;
+            bool await_ready() {
+                result.emplace(send());
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) { runtime.schedule(handle); }
+            Result await_resume() { return std::move(*result); }
+        };
+        return Awaiter{*this, std::move(send), std::nullopt};
+    }
+
+    /// Run a blocking callable on its own thread and resume with its result.
+    ///
+    /// Meant for calls that wait (a GPU queue, a network request): a thread
+    /// is started per call, so CPU-bound work belongs in a worker pool.
+    /// Exceptions thrown by work are rethrown in the awaiting task.
+    ///
+    /// args are moved into the awaiter and passed to work on the thread, so
+    /// the data a call needs is handed over without a capturing lambda:
+    /// co_await rt.run_in_thread(encode, std::move(frame)).
+    template <typename Work, typename... Args>
+    auto run_in_thread(Work&& work, Args&&... args) {
+        using Callable = std::decay_t<Work>;
+        using Arguments = std::tuple<std::decay_t<Args>...>;
+        using Result = std::invoke_result_t<Callable&, std::decay_t<Args>...>;
+        using Stored = std::conditional_t<std::is_void_v<Result>, bool, Result>;
+        struct Awaiter {
+            NodeRuntime& runtime;
+            Callable work;
+            Arguments args;
+            std::optional<Stored> result;
+            std::exception_ptr error;
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                {
+                    std::lock_guard<std::mutex> lock(runtime.mutex_);
+                    ++runtime.offloaded_;
+                }
+                std::thread([this, handle] {
+                    try {
+                        if constexpr (std::is_void_v<Result>) {
+                            std::apply(work, std::move(args));
+                            result.emplace(true);
+                        } else {
+                            result.emplace(std::apply(work, std::move(args)));
+                        }
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    runtime.post_from_thread(handle);
+                }).detach();
+            }
+            Result await_resume() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                if constexpr (!std::is_void_v<Result>) {
+                    return std::move(*result);
+                }
+            }
+        };
+        return Awaiter{*this, std::forward<Work>(work), Arguments(std::forward<Args>(args)...), std::nullopt, nullptr};
+    }
+
+private:
+    struct EventWaiter {
+        std::coroutine_handle<> handle;
+        std::optional<Event>* slot;
+    };
+
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t sequence;  // keeps timers with equal deadlines in order
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    void schedule(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+    void post_from_thread(std::coroutine_handle<> handle) {
+        // notify under the lock: once offloaded_ drops to zero the destructor may run
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_.push_back(handle);
+        --offloaded_;
+        wake_.notify_all();
+    }
+
+    void read_events() {
+        for (;;) {
+            Event event = events_.next();
+            const bool last = event_type(event) == DoraEventType::AllInputsClosed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                incoming_.push_back(std::move(event));
+                incoming_ended_ = last;
+            }
+            wake_.notify_all();
+            if (last) {
+                return;
+            }
+        }
+    }
+
+    /// Move work from other threads and due timers to the ready queue.
+    void collect() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (std::coroutine_handle<> handle : posted_) {
+                ready_.push_back(handle);
+            }
+            posted_.clear();
+            for (Event& event : incoming_) {
+                events_ready_.push_back(std::move(event));
+            }
+            incoming_.clear();
+            stream_ended_ = incoming_ended_;
+        }
+
+        while (!event_waiters_.empty() && !events_ready_.empty()) {
+            EventWaiter waiter = event_waiters_.front();
+            event_waiters_.pop_front();
+            waiter.slot->emplace(std::move(events_ready_.front()));
+            events_ready_.pop_front();
+            ready_.push_back(waiter.handle);
+        }
+        if (stream_ended_ && events_ready_.empty()) {
+            // nothing more will come: wake every waiter with an empty event
+            for (const EventWaiter& waiter : event_waiters_) {
+                ready_.push_back(waiter.handle);
+            }
+            event_waiters_.clear();
+        }
+
+        const Clock::time_point now = Clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            ready_.push_back(timers_.top().handle);
+            timers_.pop();
+        }
+    }
+
+    /// Sleep until another thread posts work or the next timer is due.
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto woken = [this] {
+            return !posted_.empty() || !incoming_.empty() || incoming_ended_ != stream_ended_;
+        };
+        if (timers_.empty()) {
+            wake_.wait(lock, woken);
+        } else {
+            wake_.wait_until(lock, timers_.top().deadline, woken);
+        }
+    }
+
+    bool spawned_done() const {
+        for (const Task<>& task : spawned_) {
+            if (!task.done()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void reap_spawned() {
+        for (auto it = spawned_.begin(); it != spawned_.end();) {
+            if (it->done()) {
+                Task<> finished = std::move(*it);
+                it = spawned_.erase(it);
+                finished.handle_.promise().take();
+            } else {
+                ++it;
+            }
+        }
+        if (spawned_.empty() && !drain_waiters_.empty()) {
+            ready_.insert(ready_.end(), drain_waiters_.begin(), drain_waiters_.end());
+            drain_waiters_.clear();
+        }
+    }
+
+    Events& events_;
+    std::thread reader_;
+
+    // Shared with the reader and offload threads
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::coroutine_handle<>> posted_;
+    std::vector<Event> incoming_;
+    bool incoming_ended_ = false;
+    int offloaded_ = 0;
+
+    // Runtime thread only
+    std::deque<std::coroutine_handle<>> ready_;
+    std::deque<Event> events_ready_;
+    std::deque<EventWaiter> event_waiters_;
+    bool stream_ended_ = false;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t timer_sequence_ = 0;
+    std::vector<Task<>> spawned_;
+    std::vector<std::coroutine_handle<>> drain_waiters_;
+};
+
+}  // namespace async
+}  // namespace doracxx
@@ -0,0 +1,676 @@
+// doracxx_bench.h - micro-benchmark harness for the processing code of Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// `doracxx bench` builds the node's sources, minus the file defining main(),
+// with the [bench] sources into target/<profile>/<node>-bench and runs every
+// benchmark on the same inputs, without a daemon or a dataflow:
+//
+//   #include "doracxx_bench.h"
+//   #include "my_processor.h"
+//
+//   DORACXX_BENCHMARK(process) {
+//       MyProcessor processor;  // setup, not measured
+//       run.each_input([&](const doracxx::bench::Input& input) {
+//           doracxx::bench::do_not_optimize(processor.process(input.data));
+//       });
+//   }
+//
+// The inputs are synthetic (random bytes of each of the --sizes in turn, at
+// --rate inputs per second or back to back) or replayed from a file written
+// by a Recorder in a running node. each_input() passes --warmup inputs
+// untimed, then --events timed ones, and reports:
+//   - throughput, in events and bytes per second
+//   - p50/p99/p999/max latency; when inputs are paced, the latency of an
+//     input counts from when it was due, so time spent waiting behind a slow
+//     input counts as it would in a dataflow
+//   - heap allocations and bytes per event, counted by replacing the global
+//     operator new in the generated main. Memory taken from Arrow pools or
+//     straight from malloc is not seen; use the pool statistics of
+//     doracxx_arrow_memory.h for those.
+//
+// Results are printed as a table and written as JSON with --json, which
+// `doracxx bench` compares against a saved baseline.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace doracxx {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/// One input, as a node would get it from event_as_input.
+struct Input {
+    std::string id;
+    std::vector<uint8_t> data;
+    uint64_t time_ns = 0;  // Arrival time after the first input (recordings only)
+};
+
+/// Harness settings, from the command line of the bench executable.
+struct Options {
+    std::string filter;                   // Only run benchmarks whose name contains this
+    size_t events = 10000;                // Timed inputs per benchmark
+    size_t warmup = 1000;                 // Untimed inputs before them
+    std::vector<size_t> sizes{4096};      // Synthetic input sizes in bytes, used in turn
+    size_t distinct = 64;                 // Synthetic inputs generated, then cycled
+    double rate = 0;                      // Inputs per second, 0 for back to back
+    std::string replay;                   // Recording to replay instead of synthetic inputs
+    bool realtime = false;                // Replay at the recorded pace
+    uint64_t seed = 1;                    // Seed of the synthetic data
+    std::string json;                     // File to write the results to
+};
+
+/// Measurements of one benchmark.
+struct Result {
+    std::string name;
+    size_t events = 0;
+    double seconds = 0;
+    uint64_t bytes = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+    double mean_ns = 0;
+    double allocations_per_event = 0;
+    double allocated_bytes_per_event = 0;
+
+    double events_per_second() const { return seconds > 0 ? static_cast<double>(events) / seconds : 0; }
+    double bytes_per_second() const { return seconds > 0 ? static_cast<double>(bytes) / seconds : 0; }
+};
+
+namespace detail {
+
+struct AllocationCounters {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+// Constant-initialized, so operator new can use it before any constructor runs
+inline AllocationCounters allocations;
+
+inline void* counted_alloc(std::size_t size, std::size_t alignment) noexcept {
+    allocations.count.fetch_add(1, std::memory_order_relaxed);
+    allocations.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+inline void counted_free(void* ptr, std::size_t alignment) noexcept {
+#if defined(_WIN32)
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(ptr);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(ptr);
+}
+
+inline void* counted_new(std::size_t size, std::size_t alignment) {
+    void* ptr = counted_alloc(size, alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+inline const void* volatile sink = nullptr;
+#endif
+
+}  // namespace detail
+
+/// Keep the compiler from optimizing away a value or the code computing it.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    detail::sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+namespace detail {
+
+constexpr char kRecordingMagic[8] = {'D', 'X', 'B', 'E', 'N', 'C', 'H', '1'};
+
+template <typename T>
+void write_pod(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_pod(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+}  // namespace detail
+
+/// Writes the inputs a running node receives to a file that the bench
+/// executable replays with --replay. Records are the arrival time, the id
+/// and the data, in host byte order. Thread-safe.
+///
+///   doracxx::bench::Recorder recorder("inputs.bin");
+///   ...
+///   auto input = event_as_input(std::move(event));
+///   recorder.record(std::string(input.id), input.data);
+class Recorder {
+public:
+    explicit Recorder(const std::string& path) : out_(path, std::ios::binary | std::ios::trunc) {
+        if (!out_) {
+            throw std::runtime_error("cannot open recording " + path);
+        }
+        out_.write(detail::kRecordingMagic, sizeof(detail::kRecordingMagic));
+    }
+
+    void record(std::string_view id, const uint8_t* data, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        if (!started_) {
+            start_ = now;
+            started_ = true;
+        }
+        detail::write_pod(out_, static_cast<uint64_t>(
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count()));
+        detail::write_pod(out_, static_cast<uint32_t>(id.size()));
+        detail::write_pod(out_, static_cast<uint64_t>(size));
+        out_.write(id.data(), static_cast<std::streamsize>(id.size()));
+        out_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    /// Any contiguous byte container: rust::Slice<const uint8_t>, std::vector<uint8_t>...
+    template <typename Bytes>
+    void record(std::string_view id, const Bytes& bytes) {
+        record(id, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out_.flush();
+    }
+
+private:
+    std::mutex mutex_;
+    std::ofstream out_;
+    Clock::time_point start_;
+    bool started_ = false;
+};
+
+/// Read a file written by Recorder; throws std::runtime_error if it is not one.
+inline std::vector<Input> load_recording(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open recording " + path);
+    }
+    char magic[sizeof(detail::kRecordingMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, detail::kRecordingMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error(path + " is not a doracxx recording");
+    }
+    std::vector<Input> inputs;
+    uint64_t time_ns = 0;
+    while (detail::read_pod(in, time_ns)) {
+        uint32_t id_size = 0;
+        uint64_t data_size = 0;
+        Input input;
+        input.time_ns = time_ns;
+        if (detail::read_pod(in, id_size) && detail::read_pod(in, data_size)) {
+            input.id.resize(id_size);
+            input.data.resize(static_cast<size_t>(data_size));
+            in.read(input.id.data(), id_size);
+            in.read(reinterpret_cast<char*>(input.data.data()), static_cast<std::streamsize>(data_size));
+        }
+        if (!in) {
+            throw std::runtime_error(path + " is truncated after " + std::to_string(inputs.size()) + " input(s)");
+        }
+        inputs.push_back(std::move(input));
+    }
+    if (inputs.empty()) {
+        throw std::runtime_error(path + " holds no inputs");
+    }
+    return inputs;
+}
+
+/// `distinct` inputs of random bytes, with each of the sizes in turn.
+inline std::vector<Input> synthetic_inputs(const std::vector<size_t>& sizes, size_t distinct, uint64_t seed,
+                                           const std::string& id = "input") {
+    std::vector<Input> inputs;
+    if (sizes.empty()) {
+        return inputs;
+    }
+    std::mt19937_64 random(seed);
+    const size_t count = std::max(distinct, sizes.size());
+    inputs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        Input input;
+        input.id = id;
+        input.data.resize(sizes[i % sizes.size()]);
+        for (size_t offset = 0; offset < input.data.size(); offset += sizeof(uint64_t)) {
+            const uint64_t word = random();
+            std::memcpy(input.data.data() + offset, &word, std::min(sizeof(word), input.data.size() - offset));
+        }
+        inputs.push_back(std::move(input));
+    }
+    return inputs;
+}
+
+/// One benchmark run, handed to the DORACXX_BENCHMARK body as `run`.
+class Run {
+public:
+    Run(std::string name, std::vector<Input> inputs, const Options& options)
+        : options_(options), inputs_(std::move(inputs)) {
+        result_.name = std::move(name);
+    }
+
+    const std::string& name() const { return result_.name; }
+    const Options& options() const { return options_; }
+
+    /// This benchmark's copy of the inputs; setup may rewrite them before each_input().
+    std::vector<Input>& inputs() { return inputs_; }
+
+    /// Call fn(const Input&) on the warmup inputs, then on the timed ones.
+    template <typename Fn>
+    void each_input(Fn&& fn) {
+        if (measured_) {
+            throw std::logic_error("each_input() called twice in benchmark " + name());
+        }
+        if (inputs_.empty()) {
+            throw std::runtime_error("benchmark " + name() + " has no inputs");
+        }
+        for (size_t i = 0; i < options_.warmup; ++i) {
+            fn(static_cast<const Input&>(inputs_[i % inputs_.size()]));
+        }
+
+        std::vector<uint64_t> latencies;
+        latencies.reserve(options_.events);
+        const bool paced = options_.rate > 0 || (options_.realtime && !options_.replay.empty());
+        const uint64_t period = replay_period();
+        uint64_t bytes = 0;
+
+        const uint64_t allocations = detail::allocations.count.load(std::memory_order_relaxed);
+        const uint64_t allocated = detail::allocations.bytes.load(std::memory_order_relaxed);
+        const auto start = Clock::now();
+        for (size_t i = 0; i < options_.events; ++i) {
+            const Input& input = inputs_[i % inputs_.size()];
+            auto begin = Clock::now();
+            if (paced) {
+                const auto due = start + std::chrono::nanoseconds(due_ns(i, period));
+                wait_until(due);
+                begin = due;
+            }
+            fn(input);
+            latencies.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count()));
+            bytes += input.data.size();
+        }
+        const auto end = Clock::now();
+
+        result_.events = options_.events;
+        result_.seconds = std::chrono::duration<double>(end - start).count();
+        result_.bytes = bytes;
+        if (options_.events > 0) {
+            const double events = static_cast<double>(options_.events);
+            result_.allocations_per_event =
+                static_cast<double>(detail::allocations.count.load(std::memory_order_relaxed) - allocations) / events;
+            result_.allocated_bytes_per_event =
+                static_cast<double>(detail::allocations.bytes.load(std::memory_order_relaxed) - allocated) / events;
+            summarize(latencies);
+        }
+        measured_ = true;
+    }
+
+    bool measured() const { return measured_; }
+    const Result& result() const { return result_; }
+
+private:
+    // Time between the start of two passes over a recording at its own pace
+    uint64_t replay_period() const {
+        if (inputs_.size() < 2) {
+            return inputs_.empty() ? 0 : 1000000;
+        }
+        const uint64_t span = inputs_.back().time_ns - inputs_.front().time_ns;
+        return span + span / (inputs_.size() - 1);
+    }
+
+    uint64_t due_ns(size_t i, uint64_t period) const {
+        if (options_.rate > 0) {
+            return static_cast<uint64_t>(static_cast<double>(i) * 1e9 / options_.rate);
+        }
+        return (i / inputs_.size()) * period + inputs_[i % inputs_.size()].time_ns - inputs_.front().time_ns;
+    }
+
+    static void wait_until(Clock::time_point due) {
+        // sleep_until alone oversleeps by tens of microseconds; sleep most of
+        // the way and spin the rest
+        const auto margin = std::chrono::microseconds(100);
+        if (due - Clock::now() > 2 * margin) {
+            std::this_thread::sleep_until(due - margin);
+        }
+        while (Clock::now() < due) {
+        }
+    }
+
+    void summarize(std::vector<uint64_t>& latencies) {
+        std::sort(latencies.begin(), latencies.end());
+        const auto at = [&](double q) {
+            const size_t rank = static_cast<size_t>(q * static_cast<double>(latencies.size()));
+            return latencies[std::min(rank, latencies.size() - 1)];
+        };
+        result_.p50_ns = at(0.5);
+        result_.p99_ns = at(0.99);
+        result_.p999_ns = at(0.999);
+        result_.max_ns = latencies.back();
+        double total = 0;
+        for (uint64_t latency : latencies) {
+            total += static_cast<double>(latency);
+        }
+        result_.mean_ns = total / static_cast<double>(latencies.size());
+    }
+
+    const Options& options_;
+    std::vector<Input> inputs_;
+    Result result_;
+    bool measured_ = false;
+};
+
+using Function = void (*)(Run&);
+
+struct Benchmark {
+    const char* name;
+    Function function;
+};
+
+inline std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+struct Registration {
+    Registration(const char* name, Function function) { registry().push_back({name, function}); }
+};
+
+/// Define a benchmark; its body gets `doracxx::bench::Run& run` and must call
+/// run.each_input() once.
+#define DORACXX_BENCHMARK(name)                                                                 \
+    static void doracxx_benchmark_##name(::doracxx::bench::Run& run);                           \
+    static const ::doracxx::bench::Registration doracxx_benchmark_registration_##name(#name,    \
+                                                                                   doracxx_benchmark_##name); \
+    static void doracxx_benchmark_##name(::doracxx::bench::Run& run)
+
+namespace detail {
+
+inline bool parse_size(const char* text, size_t& value) {
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+inline bool parse_sizes(const char* text, std::vector<size_t>& sizes) {
+    sizes.clear();
+    std::string list(text);
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        const size_t end = std::min(list.find(',', begin), list.size());
+        size_t size = 0;
+        if (!parse_size(list.substr(begin, end - begin).c_str(), size)) {
+            return false;
+        }
+        sizes.push_back(size);
+        begin = end + 1;
+    }
+    return !sizes.empty();
+}
+
+inline void print_usage(const char* program) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --filter TEXT     only run benchmarks whose name contains TEXT\n"
+        "  --events N        timed inputs per benchmark (default 10000)\n"
+        "  --warmup N        untimed inputs before them (default 1000)\n"
+        "  --sizes A,B,...   synthetic input sizes in bytes (default 4096)\n"
+        "  --distinct N      synthetic inputs generated, then cycled (default 64)\n"
+        "  --rate R          inputs per second, 0 for back to back (default 0)\n"
+        "  --replay FILE     replay a recording instead of synthetic inputs\n"
+        "  --realtime        replay at the recorded pace\n"
+        "  --seed N          seed of the synthetic data (default 1)\n"
+        "  --json FILE       write the results to FILE\n"
+        "  --list            list the benchmarks\n",
+        program);
+}
+
+// Returns 0 to run, 1 to exit successfully (--help, --list), 2 on error
+inline int parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (arg == "--list") {
+            for (const auto& benchmark : registry()) {
+                std::printf("%s\n", benchmark.name);
+            }
+            return 1;
+        }
+        if (arg == "--realtime") {
+            options.realtime = true;
+            continue;
+        }
+        static const char* const kValueOptions[] = {"--filter", "--replay", "--json", "--events", "--warmup",
+                                                    "--distinct", "--sizes", "--seed", "--rate"};
+        if (std::find(std::begin(kValueOptions), std::end(kValueOptions), arg) == std::end(kValueOptions)) {
+            std::fprintf(stderr, "unknown option %s (see --help)\n", arg.c_str());
+            return 2;
+        }
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "%s requires a value (see --help)\n", arg.c_str());
+            return 2;
+        }
+        const char* value = argv[++i];
+        bool ok = true;
+        if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--replay") {
+            options.replay = value;
+        } else if (arg == "--json") {
+            options.json = value;
+        } else if (arg == "--events") {
+            ok = parse_size(value, options.events);
+        } else if (arg == "--warmup") {
+            ok = parse_size(value, options.warmup);
+        } else if (arg == "--distinct") {
+            ok = parse_size(value, options.distinct);
+        } else if (arg == "--sizes") {
+            ok = parse_sizes(value, options.sizes);
+        } else if (arg == "--seed") {
+            size_t seed = 0;
+            ok = parse_size(value, seed);
+            options.seed = seed;
+        } else {
+            char* end = nullptr;
+            options.rate = std::strtod(value, &end);
+            ok = end != value && *end == '\0' && options.rate >= 0;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "invalid value for %s: %s\n", arg.c_str(), value);
+            return 2;
+        }
+    }
+    return 0;
+}
+
+inline bool write_json(const std::string& path, const Options& options, const std::vector<Result>& results) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "{\n  \"inputs\": \"%s\",\n  \"rate\": %g,\n  \"benchmarks\": [",
+                 options.replay.empty() ? "synthetic" : "replay", options.rate);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(file,
+                     "%s\n    {\"name\": \"%s\", \"events\": %zu, \"seconds\": %.9g, "
+                     "\"events_per_second\": %.9g, \"bytes_per_second\": %.9g, "
+                     "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, "
+                     "\"mean_ns\": %.9g, \"allocations_per_event\": %.9g, \"allocated_bytes_per_event\": %.9g}",
+                     i ? "," : "", r.name.c_str(), r.events, r.seconds, r.events_per_second(),
+                     r.bytes_per_second(), static_cast<unsigned long long>(r.p50_ns),
+                     static_cast<unsigned long long>(r.p99_ns), static_cast<unsigned long long>(r.p999_ns),
+                     static_cast<unsigned long long>(r.max_ns), r.mean_ns, r.allocations_per_event,
+                     r.allocated_bytes_per_event);
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+}  // namespace detail
+
+/// Entry point of the bench executable: run the registered benchmarks.
+inline int run_benchmarks(int argc, char** argv) {
+    Options options;
+    const int parsed = detail::parse_options(argc, argv, options);
+    if (parsed != 0) {
+        return parsed == 1 ? 0 : 2;
+    }
+
+    std::vector<Input> inputs;
+    try {
+        inputs = options.replay.empty() ? synthetic_inputs(options.sizes, options.distinct, options.seed)
+                                        : load_recording(options.replay);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "[ERROR] %s\n", e.what());
+        return 2;
+    }
+
+    std::vector<Result> results;
+    int status = 0;
+    std::printf("%-28s %10s %12s %10s %10s %10s %10s %10s %10s\n", "benchmark", "events", "events/s", "MB/s",
+                "p50 us", "p99 us", "p999 us", "allocs/ev", "bytes/ev");
+    for (const auto& benchmark : registry()) {
+        if (!options.filter.empty() && std::string_view(benchmark.name).find(options.filter) == std::string_view::npos) {
+            continue;
+        }
+        Run run(benchmark.name, inputs, options);
+        try {
+            benchmark.function(run);
+            if (!run.measured()) {
+                throw std::logic_error("the benchmark did not call run.each_input()");
+            }
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "[ERROR] %s: %s\n", benchmark.name, e.what());
+            status = 1;
+            continue;
+        }
+        const Result& r = run.result();
+        std::printf("%-28s %10zu %12.0f %10.1f %10.2f %10.2f %10.2f %10.2f %10.0f\n", r.name.c_str(), r.events,
+                    r.events_per_second(), r.bytes_per_second() / 1e6, static_cast<double>(r.p50_ns) / 1e3,
+                    static_cast<double>(r.p99_ns) / 1e3, static_cast<double>(r.p999_ns) / 1e3,
+                    r.allocations_per_event, r.allocated_bytes_per_event);
+        results.push_back(r);
+    }
+    if (results.empty() && status == 0) {
+        std::fprintf(stderr, "[ERROR] no benchmark%s%s\n", options.filter.empty() ? "" : " matches ",
+                     options.filter.c_str());
+        status = 2;
+    }
+    if (!options.json.empty() && !detail::write_json(options.json, options, results)) {
+        std::fprintf(stderr, "[ERROR] cannot write %s\n", options.json.c_str());
+        status = 2;
+    }
+    return status;
+}
+
+}  // namespace bench
+}  // namespace doracxx
+
+// Defined once, in the main unit doracxx generates for the bench executable:
+// the global allocation functions count into detail::allocations.
+#ifdef DORACXX_BENCH_MAIN
+
+void* operator new(std::size_t size) { return doracxx::bench::detail::counted_new(size, 0); }
+void* operator new[](std::size_t size) { return doracxx::bench::detail::counted_new(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return doracxx::bench::detail::counted_new(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return doracxx::bench::detail::counted_new(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return doracxx::bench::detail::counted_alloc(size, 0);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return doracxx::bench::detail::counted_alloc(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return doracxx::bench::detail::counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return doracxx::bench::detail::counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { doracxx::bench::detail::counted_free(ptr, 0); }
+void operator delete[](void* ptr) noexcept { doracxx::bench::detail::counted_free(ptr, 0); }
+void operator delete(void* ptr, std::size_t) noexcept { doracxx::bench::detail::counted_free(ptr, 0); }
+void operator delete[](void* ptr, std::size_t) noexcept { doracxx::bench::detail::counted_free(ptr, 0); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { doracxx::bench::detail::counted_free(ptr, 0); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { doracxx::bench::detail::counted_free(ptr, 0); }
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+    doracxx::bench::detail::counted_free(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+    doracxx::bench::detail::counted_free(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    doracxx::bench::detail::counted_free(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    doracxx::bench::detail::counted_free(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    doracxx::bench::detail::counted_free(ptr, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    doracxx::bench::detail::counted_free(ptr, static_cast<std::size_t>(alignment));
+}
+
+int main(int argc, char** argv) { return doracxx::bench::run_benchmarks(argc, argv); }
+
+#endif
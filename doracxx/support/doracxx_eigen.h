@@ -0,0 +1,274 @@
+// doracxx_eigen.h - Eigen views over Dora inputs and outputs
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// Copying an input into an Eigen::MatrixXd before working on it costs an
+// allocation and a pass over the data per event. These helpers map the
+// bytes of an input as an Eigen matrix instead, and write results straight
+// into an output buffer (doracxx_output_buffer.h), so matrix-heavy nodes run
+// Eigen's vectorized kernels on the data where it is.
+//
+// Tensors travel with a 64-byte TensorHeader in front of the elements,
+// holding the element type, the storage order and the shape, so the
+// receiving node can check what it got. Higher-dimensional tensors are
+// viewed as dims[0] rows by the product of the other dims.
+//
+//   auto input = event_as_input(std::move(event));
+//   auto points = doracxx::eigen::view_tensor<double, Eigen::RowMajor>(input.data);
+//   if (!points.ok()) { std::cerr << points.error << std::endl; continue; }
+//
+//   auto frame = pool.acquire(doracxx::eigen::tensor_bytes<double>(points.rows() * 3));
+//   auto out = doracxx::eigen::write_tensor<double, Eigen::RowMajor>(frame, points.rows(), 3);
+//   out.noalias() = points.matrix * transform.transpose();
+//   frame.send(dora_node.send_output, "points");
+//
+// Views borrow the input's bytes: the input must outlive them. view_matrix
+// maps raw payloads without a header when the shape is known otherwise.
+// Input views are unaligned Maps, which Eigen still vectorizes with
+// unaligned loads; output maps are fully aligned. Elements are in the
+// machine's byte order.
+#pragma once
+
+#include <Eigen/Core>
+
+#include "doracxx_output_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace doracxx {
+namespace eigen {
+
+enum class DType : uint8_t { U8 = 1, I8, U16, I16, U32, I32, U64, I64, F32, F64 };
+
+/// Element type code of Scalar.
+template <typename Scalar>
+constexpr DType dtype_of() {
+    static_assert(std::is_arithmetic<Scalar>::value && sizeof(Scalar) <= 8, "unsupported tensor element type");
+    if (std::is_floating_point<Scalar>::value) {
+        return sizeof(Scalar) == 4 ? DType::F32 : DType::F64;
+    }
+    constexpr bool is_signed = std::is_signed<Scalar>::value;
+    switch (sizeof(Scalar)) {
+        case 1: return is_signed ? DType::I8 : DType::U8;
+        case 2: return is_signed ? DType::I16 : DType::U16;
+        case 4: return is_signed ? DType::I32 : DType::U32;
+        default: return is_signed ? DType::I64 : DType::U64;
+    }
+}
+
+inline const char* dtype_name(DType dtype) {
+    static const char* const names[] = {"?",   "u8",  "i8",  "u16", "i16", "u32",
+                                        "i32", "u64", "i64", "f32", "f64"};
+    const auto index = static_cast<size_t>(dtype);
+    return index < sizeof(names) / sizeof(names[0]) ? names[index] : "?";
+}
+
+constexpr size_t kMaxDims = 4;
+
+/// What precedes the elements of a tensor payload.
+struct TensorHeader {
+    char magic[4] = {'D', 'X', 'T', '1'};
+    uint8_t dtype = 0;
+    uint8_t row_major = 1;
+    uint8_t ndim = 0;
+    uint8_t reserved = 0;
+    uint64_t dims[kMaxDims] = {0, 0, 0, 0};
+    uint8_t padding[24] = {};
+
+    bool valid() const { return std::memcmp(magic, "DXT1", 4) == 0 && ndim >= 1 && ndim <= kMaxDims; }
+
+    uint64_t count() const {
+        uint64_t n = 1;
+        for (uint8_t i = 0; i < ndim; ++i) {
+            n *= dims[i];
+        }
+        return n;
+    }
+
+    /// Whether count() is at most max_count; unlike count() it cannot overflow.
+    bool count_at_most(uint64_t max_count) const { return product_at_most(0, max_count); }
+
+    uint64_t rows() const { return ndim ? dims[0] : 0; }
+
+    /// The trailing dims flattened, so a 0xN tensor still has N columns.
+    uint64_t cols() const {
+        uint64_t n = 1;
+        for (uint8_t i = 1; i < ndim; ++i) {
+            n *= dims[i];
+        }
+        return n;
+    }
+
+    /// Whether cols() is at most max_cols; unlike cols() it cannot overflow.
+    bool cols_at_most(uint64_t max_cols) const { return product_at_most(1, max_cols); }
+
+private:
+    bool product_at_most(uint8_t first, uint64_t max_product) const {
+        for (uint8_t i = first; i < ndim; ++i) {
+            if (dims[i] == 0) {
+                return true;
+            }
+        }
+        uint64_t n = 1;
+        for (uint8_t i = first; i < ndim; ++i) {
+            if (n > max_product / dims[i]) {
+                return false;
+            }
+            n *= dims[i];
+        }
+        return true;
+    }
+};
+
+static_assert(sizeof(TensorHeader) == 64, "TensorHeader keeps the elements 64-byte aligned");
+
+template <typename Scalar, int Options = Eigen::RowMajor>
+using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Options>;
+
+template <typename Scalar, int Options = Eigen::RowMajor>
+using ConstMatrixMap = Eigen::Map<const Matrix<Scalar, Options>>;
+
+template <typename Scalar, int Options = Eigen::RowMajor>
+using MatrixMap = Eigen::Map<Matrix<Scalar, Options>, Eigen::AlignedMax>;
+
+/// A read-only matrix view of an input, or the reason there is none.
+template <typename Scalar, int Options = Eigen::RowMajor>
+struct InputView {
+    ConstMatrixMap<Scalar, Options> matrix{nullptr, 0, 0};
+    TensorHeader header;
+    std::string error;
+    // the elements start on an EIGEN_MAX_ALIGN_BYTES boundary
+    bool aligned = false;
+
+    bool ok() const { return error.empty(); }
+    Eigen::Index rows() const { return matrix.rows(); }
+    Eigen::Index cols() const { return matrix.cols(); }
+};
+
+namespace detail {
+
+template <typename Scalar, int Options>
+InputView<Scalar, Options> make_view(const uint8_t* elements, Eigen::Index rows, Eigen::Index cols) {
+    InputView<Scalar, Options> view;
+    new (&view.matrix) ConstMatrixMap<Scalar, Options>(reinterpret_cast<const Scalar*>(elements), rows, cols);
+    view.aligned = reinterpret_cast<uintptr_t>(elements) % EIGEN_MAX_ALIGN_BYTES == 0;
+    return view;
+}
+
+template <typename Scalar, int Options>
+InputView<Scalar, Options> fail(std::string error) {
+    InputView<Scalar, Options> view;
+    view.error = std::move(error);
+    return view;
+}
+
+}  // namespace detail
+
+/// View size bytes as a rows x cols matrix, without a TensorHeader.
+template <typename Scalar, int Options = Eigen::RowMajor>
+InputView<Scalar, Options> view_matrix(const uint8_t* data, size_t size, Eigen::Index rows, Eigen::Index cols) {
+    const auto max_count = static_cast<uint64_t>(size / sizeof(Scalar));
+    const bool fits = rows >= 0 && cols >= 0 &&
+                      (cols == 0 || static_cast<uint64_t>(rows) <= max_count / static_cast<uint64_t>(cols));
+    if (!fits || size != static_cast<size_t>(rows) * static_cast<size_t>(cols) * sizeof(Scalar)) {
+        return detail::fail<Scalar, Options>("payload of " + std::to_string(size) + " bytes is not a " +
+                                             std::to_string(rows) + "x" + std::to_string(cols) + " " +
+                                             dtype_name(dtype_of<Scalar>()) + " matrix");
+    }
+    auto view = detail::make_view<Scalar, Options>(data, rows, cols);
+    view.header.dtype = static_cast<uint8_t>(dtype_of<Scalar>());
+    view.header.row_major = (Options & Eigen::RowMajor) ? 1 : 0;
+    view.header.ndim = 2;
+    view.header.dims[0] = static_cast<uint64_t>(rows);
+    view.header.dims[1] = static_cast<uint64_t>(cols);
+    return view;
+}
+
+/// View a payload starting with a TensorHeader; checks its type, order and size.
+template <typename Scalar, int Options = Eigen::RowMajor>
+InputView<Scalar, Options> view_tensor(const uint8_t* data, size_t size) {
+    TensorHeader header;
+    if (size < sizeof(header)) {
+        return detail::fail<Scalar, Options>("payload of " + std::to_string(size) + " bytes has no tensor header");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (!header.valid()) {
+        return detail::fail<Scalar, Options>("payload does not start with a doracxx tensor header");
+    }
+    if (header.dtype != static_cast<uint8_t>(dtype_of<Scalar>())) {
+        return detail::fail<Scalar, Options>(std::string("tensor holds ") + dtype_name(DType(header.dtype)) +
+                                             " elements, not " + dtype_name(dtype_of<Scalar>()));
+    }
+    const bool row_major = (Options & Eigen::RowMajor) != 0;
+    if ((header.row_major != 0) != row_major && header.rows() > 1 && header.cols() > 1) {
+        return detail::fail<Scalar, Options>(std::string("tensor is ") + (header.row_major ? "row" : "column") +
+                                             "-major; view it with that storage order");
+    }
+    // dims come from the sender: check the element count against the body
+    // before multiplying it out, and the rows and columns against Eigen::Index
+    // (an empty tensor bounds neither)
+    const size_t body = size - sizeof(header);
+    if (!header.count_at_most(body / sizeof(Scalar)) || body != header.count() * sizeof(Scalar)) {
+        return detail::fail<Scalar, Options>("tensor payload of " + std::to_string(body) +
+                                             " bytes does not match its shape");
+    }
+    const auto max_index = static_cast<uint64_t>(std::numeric_limits<Eigen::Index>::max());
+    if (header.rows() > max_index || !header.cols_at_most(max_index)) {
+        return detail::fail<Scalar, Options>("tensor has more rows or columns than Eigen::Index can hold");
+    }
+    auto view = detail::make_view<Scalar, Options>(data + sizeof(header), static_cast<Eigen::Index>(header.rows()),
+                                                   static_cast<Eigen::Index>(header.cols()));
+    view.header = header;
+    return view;
+}
+
+/// view_matrix / view_tensor over anything with data() and size(), e.g. input.data.
+template <typename Scalar, int Options = Eigen::RowMajor, typename Bytes>
+InputView<Scalar, Options> view_matrix(const Bytes& bytes, Eigen::Index rows, Eigen::Index cols) {
+    return view_matrix<Scalar, Options>(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), rows, cols);
+}
+
+template <typename Scalar, int Options = Eigen::RowMajor, typename Bytes>
+InputView<Scalar, Options> view_tensor(const Bytes& bytes) {
+    return view_tensor<Scalar, Options>(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+}
+
+/// Bytes of a tensor payload with count elements of Scalar.
+template <typename Scalar>
+constexpr size_t tensor_bytes(size_t count) {
+    return sizeof(TensorHeader) + count * sizeof(Scalar);
+}
+
+/// Size buffer for a rows x cols tensor, write its header and map its elements.
+///
+/// ndim is 2, or 1 for a column vector (cols == 1). The map stays valid
+/// until the buffer is resized, sent or reset.
+template <typename Scalar, int Options = Eigen::RowMajor>
+MatrixMap<Scalar, Options> write_tensor(output::OutputBuffer& buffer, Eigen::Index rows, Eigen::Index cols) {
+    TensorHeader header;
+    header.dtype = static_cast<uint8_t>(dtype_of<Scalar>());
+    header.row_major = (Options & Eigen::RowMajor) ? 1 : 0;
+    header.ndim = cols == 1 ? 1 : 2;
+    header.dims[0] = static_cast<uint64_t>(rows);
+    header.dims[1] = cols == 1 ? 0 : static_cast<uint64_t>(cols);
+    buffer.resize(tensor_bytes<Scalar>(static_cast<size_t>(rows) * static_cast<size_t>(cols)));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    return MatrixMap<Scalar, Options>(reinterpret_cast<Scalar*>(buffer.data() + sizeof(header)), rows, cols);
+}
+
+/// Write a matrix expression as a tensor into buffer (one pass, no temporary).
+template <typename Derived>
+void write_tensor(output::OutputBuffer& buffer, const Eigen::MatrixBase<Derived>& value) {
+    using Scalar = typename Derived::Scalar;
+    constexpr int Options = Derived::IsRowMajor ? Eigen::RowMajor : Eigen::ColMajor;
+    write_tensor<Scalar, Options>(buffer, value.rows(), value.cols()).noalias() = value;
+}
+
+}  // namespace eigen
+}  // namespace doracxx
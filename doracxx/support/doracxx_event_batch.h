@@ -0,0 +1,163 @@
+// doracxx_event_batch.h - batched event draining for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// Calling events->next() and handling one event at a time makes every event
+// pay for its own processing setup, logging and send_output. EventBatcher
+// reads events on a background thread, at most one batch ahead by default,
+// and hands them out in batches: each batch holds every event already
+// queued, and waits for more up to a latency budget counted from the arrival
+// of its first event, so no event is delayed by more than the budget.
+//
+// Include it after dora-node-api.h.
+//
+//   doracxx::events::BatchOptions options;
+//   options.max_batch = 64;
+//   options.latency_budget = std::chrono::microseconds(500);
+//   doracxx::events::EventBatcher batcher(*dora_node.events, options);
+//   for (auto batch = batcher.next_batch(); !batch.empty(); batch = batcher.next_batch()) {
+//       for (auto& event : batch) { ... }
+//   }
+//
+// The reader thread stops after the AllInputsClosed event, which Dora also
+// reports when the event stream ends. The batcher must not be destroyed
+// before that event was read: its destructor waits for the reader.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace doracxx {
+namespace events {
+
+struct BatchOptions {
+    // Most events handed out per batch
+    size_t max_batch = 64;
+    // Longest a batch waits for more events after its first one arrived;
+    // zero only drains what is already queued
+    std::chrono::microseconds latency_budget{500};
+    // Most events taken from Dora before the node asks for them; 0 means
+    // max_batch. Events taken no longer count against Dora's per-input
+    // queue_size, so a larger read-ahead keeps stale events Dora would have
+    // dropped under load.
+    size_t read_ahead = 0;
+};
+
+/// Batches the events of a Dora event stream (*dora_node.events).
+template <typename Events>
+class EventBatcher {
+public:
+    using Event = decltype(std::declval<Events&>().next());
+    using Clock = std::chrono::steady_clock;
+
+    explicit EventBatcher(Events& events, BatchOptions options = {}) : events_(events), options_(options) {
+        if (options_.max_batch == 0) {
+            options_.max_batch = 1;
+        }
+        if (options_.read_ahead == 0) {
+            options_.read_ahead = options_.max_batch;
+        }
+        reader_ = std::thread([this] { read_events(); });
+    }
+
+    ~EventBatcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // let a reader waiting for room finish the stream
+            options_.read_ahead = static_cast<size_t>(-1);
+        }
+        not_full_.notify_one();
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+    }
+
+    EventBatcher(const EventBatcher&) = delete;
+    EventBatcher& operator=(const EventBatcher&) = delete;
+
+    /// Wait for the next batch; empty once the stream has ended.
+    ///
+    /// The AllInputsClosed event, when present, is the last event of its batch.
+    std::vector<Event> next_batch() {
+        std::vector<Event> batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return !queue_.empty() || finished_; });
+        if (queue_.empty()) {
+            return batch;
+        }
+
+        const Clock::time_point deadline = queue_.front().arrival + options_.latency_budget;
+        batch.reserve(options_.max_batch);
+        while (batch.size() < options_.max_batch) {
+            if (queue_.empty()) {
+                if (finished_) {
+                    break;
+                }
+                ready_.wait_until(lock, deadline, [this] { return !queue_.empty() || finished_; });
+                if (queue_.empty()) {
+                    break;
+                }
+            }
+            const bool last = queue_.front().last;
+            batch.push_back(std::move(queue_.front().event));
+            queue_.pop_front();
+            if (last) {
+                break;
+            }
+        }
+        lock.unlock();
+        not_full_.notify_one();
+        return batch;
+    }
+
+    /// True once the last event has been handed out.
+    bool finished() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return finished_ && queue_.empty();
+    }
+
+private:
+    struct Queued {
+        Event event;
+        Clock::time_point arrival;
+        bool last;
+    };
+
+    void read_events() {
+        for (;;) {
+            {
+                // wait for room before taking the event: until then it stays in Dora's queue
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_full_.wait(lock, [this] { return queue_.size() < options_.read_ahead; });
+            }
+            Event event = events_.next();
+            const bool last = event_type(event) == DoraEventType::AllInputsClosed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.push_back(Queued{std::move(event), Clock::now(), last});
+                finished_ = last;
+            }
+            ready_.notify_one();
+            if (last) {
+                return;
+            }
+        }
+    }
+
+    Events& events_;
+    BatchOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable not_full_;
+    std::deque<Queued> queue_;
+    bool finished_ = false;
+    std::thread reader_;
+};
+
+}  // namespace events
+}  // namespace doracxx
@@ -0,0 +1,422 @@
+// doracxx_log.h - asynchronous logging for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// std::cout << ... << std::endl on the event loop writes and flushes stdout
+// on every line. The DORACXX_LOG_* macros instead format the message on the
+// calling thread into a fixed-size record, push it onto a lock-free ring and
+// return; a background thread writes the records out, flushing once per
+// round rather than once per line.
+//
+//   DORACXX_LOG_INFO("Processing ", inputs.size(), " input(s)");
+//   DORACXX_LOG_DEBUG("Summing array with ", values->length(), " elements");
+//   DORACXX_LOG_ERROR("Failed to send output: ", status.ToString());
+//
+// The build defines these from the [log] section of doracxx.toml:
+//   DORACXX_LOG_LEVEL       lowest level compiled in (0 trace, 1 debug, 2 info,
+//                           3 warn, 4 error, 5 off); calls below it compile to
+//                           nothing, their arguments are not evaluated
+//   DORACXX_LOG_RATE        most messages per second from one call site, 0 for
+//                           no limit; the next message that gets through says
+//                           how many were suppressed
+//   DORACXX_LOG_QUEUE_SIZE  records the ring holds; when it is full, messages
+//                           are dropped and counted instead of blocking
+//
+// Warnings and errors go to stderr, the rest to stdout, each line prefixed
+// with its level. Messages longer than DORACXX_LOG_MESSAGE_SIZE bytes are
+// truncated. doracxx::log::flush() waits until everything logged so far is
+// written; whatever is pending at exit is written too, so do not log from
+// destructors of static objects.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#ifndef DORACXX_LOG_LEVEL
+#ifdef NDEBUG
+#define DORACXX_LOG_LEVEL 2
+#else
+#define DORACXX_LOG_LEVEL 1
+#endif
+#endif
+
+#ifndef DORACXX_LOG_RATE
+#define DORACXX_LOG_RATE 0
+#endif
+
+#ifndef DORACXX_LOG_QUEUE_SIZE
+#define DORACXX_LOG_QUEUE_SIZE 4096
+#endif
+
+#ifndef DORACXX_LOG_MESSAGE_SIZE
+#define DORACXX_LOG_MESSAGE_SIZE 256
+#endif
+
+namespace doracxx {
+namespace log {
+
+enum class Level : int { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+/// Whether messages of a level are compiled in; guards work done only to log.
+constexpr bool enabled(Level level) {
+    return static_cast<int>(level) >= DORACXX_LOG_LEVEL && level != Level::Off;
+}
+
+inline const char* level_name(Level level) {
+    switch (level) {
+        case Level::Trace: return "TRACE";
+        case Level::Debug: return "DEBUG";
+        case Level::Info: return "INFO";
+        case Level::Warn: return "WARN";
+        case Level::Error: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+namespace detail {
+
+struct Record {
+    Level level;
+    uint32_t length;
+    char text[DORACXX_LOG_MESSAGE_SIZE];
+};
+
+/// Appends arguments to a record; common types are formatted without allocating.
+class Formatter {
+public:
+    explicit Formatter(Record& record) : record_(record) {}
+
+    void append(const char* data, size_t size) {
+        const size_t room = sizeof(record_.text) - record_.length;
+        const size_t count = size < room ? size : room;
+        std::memcpy(record_.text + record_.length, data, count);
+        record_.length += static_cast<uint32_t>(count);
+    }
+
+    template <typename T>
+    void add(const T& value) {
+        using Value = std::decay_t<T>;
+        if constexpr (std::is_array_v<T>) {
+            append(value, std::strlen(value));
+        } else if constexpr (std::is_same_v<Value, const char*> || std::is_same_v<Value, char*>) {
+            const char* text = value ? value : "(null)";
+            append(text, std::strlen(text));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            const std::string_view text = value;
+            append(text.data(), text.size());
+        } else if constexpr (std::is_same_v<Value, char>) {
+            append(&value, 1);
+        } else if constexpr (std::is_same_v<Value, bool>) {
+            value ? append("true", 4) : append("false", 5);
+        } else if constexpr (std::is_integral_v<Value>) {
+            char buffer[24];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            append(buffer, static_cast<size_t>(result.ptr - buffer));
+        } else if constexpr (std::is_floating_point_v<Value>) {
+            char buffer[32];
+            const int size = std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+            append(buffer, size > 0 ? static_cast<size_t>(size) : 0);
+        } else if constexpr (std::is_enum_v<Value>) {
+            add(static_cast<std::underlying_type_t<Value>>(value));
+        } else {
+            // anything else printable with operator<<, at the cost of a stream
+            std::ostringstream stream;
+            stream << value;
+            const std::string text = stream.str();
+            append(text.data(), text.size());
+        }
+    }
+
+private:
+    Record& record_;
+};
+
+/// Bounded lock-free ring with many producers and one consumer.
+class RecordRing {
+public:
+    explicit RecordRing(size_t capacity) : mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+                                           cells_(new Cell[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Copy a record in; false when the ring is full.
+    bool try_push(const Record& record) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.record.level = record.level;
+                    cell.record.length = record.length;
+                    std::memcpy(cell.record.text, record.text, record.length);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Oldest record, or nullptr if it is not written yet. Consumer only.
+    const Record* front() const {
+        const Cell& cell = cells_[dequeue_pos_ & mask_];
+        return cell.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1 ? &cell.record : nullptr;
+    }
+
+    /// Release the record returned by front(). Consumer only.
+    void pop() {
+        cells_[dequeue_pos_ & mask_].sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+    }
+
+    /// Records claimed by producers so far.
+    size_t pushed() const { return enqueue_pos_.load(std::memory_order_acquire); }
+    /// Records consumed so far. Consumer only.
+    size_t popped() const { return dequeue_pos_; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0;
+};
+
+/// Owns the ring and the thread writing it out.
+class Logger {
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+
+    void push(const Record& record) {
+        if (!ring_.try_push(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void flush() {
+        const size_t target = ring_.pushed();
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++flush_requests_;
+        wake_.notify_one();
+        flushed_.wait(lock, [&] { return written_ >= target; });
+    }
+
+private:
+    // Longest a record waits in the ring before the writer picks it up
+    static constexpr std::chrono::milliseconds kDrainInterval{2};
+
+    Logger() : ring_(DORACXX_LOG_QUEUE_SIZE), writer_([this] { write_records(); }) {}
+
+    void write_records() {
+        std::string out;
+        std::string err;
+        for (;;) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait_for(lock, kDrainInterval, [this] { return stop_ || flush_requests_ > 0; });
+                stopping = stop_;
+                flush_requests_ = 0;
+            }
+
+            // Everything claimed so far; a producer may still be copying
+            // into its cell, which takes no longer than a memcpy
+            const size_t target = ring_.pushed();
+            while (ring_.popped() < target) {
+                if (drain_into(out, err, target) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            if (const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+                err += "[WARN] " + std::to_string(dropped) + " log message(s) dropped, the log queue is full\n";
+            }
+            if (!out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                std::fflush(stdout);
+                out.clear();
+            }
+            if (!err.empty()) {
+                std::fwrite(err.data(), 1, err.size(), stderr);
+                std::fflush(stderr);
+                err.clear();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                written_ = ring_.popped();
+            }
+            flushed_.notify_all();
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    size_t drain_into(std::string& out, std::string& err, size_t target) {
+        size_t count = 0;
+        while (ring_.popped() < target) {
+            const Record* record = ring_.front();
+            if (!record) {
+                break;
+            }
+            std::string& stream = record->level >= Level::Warn ? err : out;
+            stream += '[';
+            stream += level_name(record->level);
+            stream += "] ";
+            stream.append(record->text, record->length);
+            stream += '\n';
+            ring_.pop();
+            ++count;
+        }
+        return count;
+    }
+
+    RecordRing ring_;
+    std::atomic<uint64_t> dropped_{0};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    bool stop_ = false;
+    uint64_t flush_requests_ = 0;
+    size_t written_ = 0;
+    std::thread writer_;
+};
+
+/// Per call site limit of DORACXX_LOG_RATE messages per second.
+class RateLimit {
+public:
+    /// Whether a message may be logged; sets suppressed to the number of
+    /// messages held back since the last one that got through.
+    bool allow(uint64_t& suppressed) {
+#if DORACXX_LOG_RATE == 0
+        (void)suppressed;
+        return true;
+#else
+        const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t window = window_.load(std::memory_order_relaxed);
+        if (now != window && window_.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+            count_.store(0, std::memory_order_relaxed);
+            suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        }
+        if (count_.fetch_add(1, std::memory_order_relaxed) < static_cast<uint64_t>(DORACXX_LOG_RATE)) {
+            return true;
+        }
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+#endif
+    }
+
+private:
+    std::atomic<int64_t> window_{-1};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+template <typename... Args>
+void log_at(Level level, RateLimit& limit, const Args&... args) {
+    uint64_t suppressed = 0;
+    if (!limit.allow(suppressed)) {
+        return;
+    }
+    Record record;
+    record.level = level;
+    record.length = 0;
+    Formatter formatter(record);
+    (formatter.add(args), ...);
+    if (suppressed > 0) {
+        formatter.add(" (");
+        formatter.add(suppressed);
+        formatter.add(" similar message(s) suppressed)");
+    }
+    Logger::instance().push(record);
+}
+
+}  // namespace detail
+
+/// Wait until every message logged so far has been written.
+inline void flush() {
+    detail::Logger::instance().flush();
+}
+
+}  // namespace log
+}  // namespace doracxx
+
+#define DORACXX_LOG_AT(level, ...)                                                    \
+    do {                                                                              \
+        static ::doracxx::log::detail::RateLimit doracxx_log_rate_limit_;             \
+        ::doracxx::log::detail::log_at((level), doracxx_log_rate_limit_, __VA_ARGS__); \
+    } while (0)
+
+#if DORACXX_LOG_LEVEL <= 0
+#define DORACXX_LOG_TRACE(...) DORACXX_LOG_AT(::doracxx::log::Level::Trace, __VA_ARGS__)
+#else
+#define DORACXX_LOG_TRACE(...) ((void)0)
+#endif
+
+#if DORACXX_LOG_LEVEL <= 1
+#define DORACXX_LOG_DEBUG(...) DORACXX_LOG_AT(::doracxx::log::Level::Debug, __VA_ARGS__)
+#else
+#define DORACXX_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if DORACXX_LOG_LEVEL <= 2
+#define DORACXX_LOG_INFO(...) DORACXX_LOG_AT(::doracxx::log::Level::Info, __VA_ARGS__)
+#else
+#define DORACXX_LOG_INFO(...) ((void)0)
+#endif
+
+#if DORACXX_LOG_LEVEL <= 3
+#define DORACXX_LOG_WARN(...) DORACXX_LOG_AT(::doracxx::log::Level::Warn, __VA_ARGS__)
+#else
+#define DORACXX_LOG_WARN(...) ((void)0)
+#endif
+
+#if DORACXX_LOG_LEVEL <= 4
+#define DORACXX_LOG_ERROR(...) DORACXX_LOG_AT(::doracxx::log::Level::Error, __VA_ARGS__)
+#else
+#define DORACXX_LOG_ERROR(...) ((void)0)
+#endif
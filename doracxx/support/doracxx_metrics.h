@@ -0,0 +1,444 @@
+// doracxx_metrics.h - latency histograms and throughput counters for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// A Metrics object wraps the three steps of a node's event loop - waiting in
+// events->next(), processing an input and sending an output - and records
+// how long each took, per input and output id, together with message and
+// byte counts:
+//
+//   doracxx::metrics::Metrics metrics("my-node");
+//   for (;;) {
+//       auto event = metrics.next(*dora_node.events);
+//       ...
+//       auto input = event_as_input(std::move(event));
+//       {
+//           auto timer = metrics.process(std::string(input.id), input.data.size());
+//           ...  // processing, timed until the end of the scope
+//       }
+//       metrics.send("output", data.size(), [&] { return send_output(dora_node.send_output, "output", data); });
+//       metrics.maybe_export([&](const std::string& text) { ... send text as a "metrics" output ... });
+//   }
+//
+// Latencies go into log-linear histograms (HDR style: 32 sub-buckets per
+// power of two, so quantiles are within about 3% of the recorded value)
+// made of atomic counters; recording is a few relaxed atomic adds and can
+// happen from any thread. For code that calls next() itself, such as
+// EventBatcher, `auto&& events = metrics.events(*dora_node.events);` is an
+// event source whose next() is timed.
+//
+// The build defines, from the [metrics] section of doracxx.toml:
+//   DORACXX_METRICS              1 to record; otherwise every call compiles
+//                                to the plain call it wraps and nothing is kept
+//   DORACXX_METRICS_INTERVAL_MS  how often maybe_export() exports
+//
+// maybe_export() renders the Prometheus text exposition format, writes it to
+// the file named by the DORACXX_METRICS_FILE environment variable (for a
+// node_exporter textfile collector) and hands it to an optional sink, e.g.
+// to send it as a Dora output. Every series carries a node label, so the
+// latencies of all nodes of a dataflow can be put side by side.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifndef DORACXX_METRICS
+#define DORACXX_METRICS 0
+#endif
+
+#ifndef DORACXX_METRICS_INTERVAL_MS
+#define DORACXX_METRICS_INTERVAL_MS 1000
+#endif
+
+namespace doracxx {
+namespace metrics {
+
+using Clock = std::chrono::steady_clock;
+
+inline int highest_bit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+/// Lock-free log-linear histogram of non-negative values (nanoseconds here).
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+    static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(uint64_t value) {
+        buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /// Upper bound of the bucket holding the value at quantile q (0 to 1).
+    uint64_t quantile(double q) const {
+        const uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(bucket_upper(i), max());
+            }
+        }
+        return max();
+    }
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const int shift = highest_bit(value) - kSubBucketBits;
+        return static_cast<size_t>((shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets));
+    }
+
+    static uint64_t bucket_upper(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        const int shift = static_cast<int>(index / kSubBuckets) - 1;
+        const uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+        return lower + ((uint64_t{1} << shift) - 1);
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/// Counters and latencies of one input or output id.
+struct Series {
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> bytes{0};
+    Histogram latency;  // processing time of inputs, send time of outputs
+
+    void record(uint64_t nanoseconds, size_t size) {
+        messages.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        latency.record(nanoseconds);
+    }
+};
+
+inline uint64_t nanoseconds_since(Clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+#if DORACXX_METRICS
+
+/// Records a series' latency when it goes out of scope.
+class Timer {
+public:
+    Timer(Series& series, size_t bytes) : series_(&series), bytes_(bytes), start_(Clock::now()) {}
+    Timer(Timer&& other) noexcept : series_(std::exchange(other.series_, nullptr)), bytes_(other.bytes_),
+                                    start_(other.start_) {}
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    Timer& operator=(Timer&&) = delete;
+    ~Timer() { stop(); }
+
+    /// Record now instead of at the end of the scope.
+    void stop() {
+        if (series_) {
+            series_->record(nanoseconds_since(start_), bytes_);
+            series_ = nullptr;
+        }
+    }
+
+private:
+    Series* series_;
+    size_t bytes_;
+    Clock::time_point start_;
+};
+
+class Metrics {
+public:
+    explicit Metrics(std::string node,
+                     std::chrono::milliseconds interval = std::chrono::milliseconds(DORACXX_METRICS_INTERVAL_MS))
+        : node_(std::move(node)), interval_(interval), next_export_(Clock::now() + interval) {
+        if (const char* file = std::getenv("DORACXX_METRICS_FILE")) {
+            file_ = file;
+        }
+    }
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /// events.next(), timing how long it blocked.
+    template <typename Events>
+    auto next(Events& events) {
+        const Clock::time_point start = Clock::now();
+        auto event = events.next();
+        next_wait_.record(nanoseconds_since(start));
+        events_.fetch_add(1, std::memory_order_relaxed);
+        return event;
+    }
+
+    /// Event source whose next() is timed, for code that reads events itself.
+    template <typename Events>
+    class EventSource {
+    public:
+        EventSource(Metrics& metrics, Events& events) : metrics_(metrics), events_(events) {}
+        auto next() { return metrics_.next(events_); }
+
+    private:
+        Metrics& metrics_;
+        Events& events_;
+    };
+
+    template <typename Events>
+    EventSource<Events> events(Events& events) {
+        return EventSource<Events>(*this, events);
+    }
+
+    /// Time the processing of an input until the returned timer is destroyed.
+    Timer process(std::string_view input, size_t bytes = 0) { return Timer(this->input(input), bytes); }
+
+    /// Call send() (e.g. a send_output call) and record it under an output id.
+    template <typename Send>
+    decltype(auto) send(std::string_view output, size_t bytes, Send&& send) {
+        Timer timer(this->output(output), bytes);
+        return std::forward<Send>(send)();
+    }
+
+    template <typename Send>
+    decltype(auto) send(std::string_view output, Send&& send) {
+        return this->send(output, 0, std::forward<Send>(send));
+    }
+
+    /// The series of an id; keep the reference to skip the lookup on hot paths.
+    Series& input(std::string_view id) { return series(inputs_, id); }
+    Series& output(std::string_view id) { return series(outputs_, id); }
+
+    const Histogram& next_wait() const { return next_wait_; }
+    uint64_t events_read() const { return events_.load(std::memory_order_relaxed); }
+
+    /// Everything recorded so far, in the Prometheus text exposition format.
+    std::string to_prometheus() const {
+        std::string text;
+        const std::string node = "node=\"" + escape(node_) + "\"";
+
+        header(text, "doracxx_events_total", "counter", "Events read from the Dora event stream");
+        sample(text, "doracxx_events_total", node, static_cast<double>(events_read()));
+        header(text, "doracxx_next_wait_seconds", "summary", "Time blocked waiting for the next event");
+        summary(text, "doracxx_next_wait_seconds", node, next_wait_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        render_series(text, inputs_, node, "input", "Inputs processed", "Input bytes processed",
+                      "doracxx_process_seconds", "Time spent processing an input");
+        render_series(text, outputs_, node, "output", "Outputs sent", "Output bytes sent",
+                      "doracxx_send_seconds", "Time spent sending an output");
+        return text;
+    }
+
+    /// Write text to path, replacing the file atomically.
+    static bool write_file(const std::string& path, const std::string& text) {
+        const std::string temporary = path + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        if (std::fclose(file) != 0 || !written) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());  // rename does not replace files on Windows
+#endif
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    /// Once per interval: write DORACXX_METRICS_FILE, if set, and pass the
+    /// Prometheus text to sink. Call it from one thread, e.g. the event loop.
+    /// @return Whether it exported
+    template <typename Sink>
+    bool maybe_export(Sink&& sink) {
+        const Clock::time_point now = Clock::now();
+        if (now < next_export_) {
+            return false;
+        }
+        next_export_ = now + interval_;
+        const std::string text = to_prometheus();
+        if (!file_.empty()) {
+            write_file(file_, text);
+        }
+        sink(text);
+        return true;
+    }
+
+    bool maybe_export() {
+        return maybe_export([](const std::string&) {});
+    }
+
+private:
+    using SeriesMap = std::map<std::string, std::unique_ptr<Series>, std::less<>>;
+
+    Series& series(SeriesMap& map, std::string_view id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = map.find(id);
+        if (it == map.end()) {
+            it = map.emplace(std::string(id), std::make_unique<Series>()).first;
+        }
+        return *it->second;
+    }
+
+    static std::string escape(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+                escaped += c;
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    static void header(std::string& text, const char* name, const char* type, const char* help) {
+        text += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+    }
+
+    static void sample(std::string& text, const std::string& name, const std::string& labels, double value) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.9g", value);
+        text += name + "{" + labels + "} " + number + "\n";
+    }
+
+    static void summary(std::string& text, const std::string& name, const std::string& labels,
+                        const Histogram& histogram) {
+        static constexpr const char* kQuantiles[] = {"0.5", "0.9", "0.99", "0.999", "1"};
+        for (const char* q : kQuantiles) {
+            sample(text, name, labels + ",quantile=\"" + q + "\"", histogram.quantile(std::atof(q)) * 1e-9);
+        }
+        sample(text, name + "_sum", labels, static_cast<double>(histogram.sum()) * 1e-9);
+        sample(text, name + "_count", labels, static_cast<double>(histogram.count()));
+    }
+
+    static void render_series(std::string& text, const SeriesMap& map, const std::string& node, const char* kind,
+                              const char* messages_help, const char* bytes_help, const char* latency_name,
+                              const char* latency_help) {
+        if (map.empty()) {
+            return;
+        }
+        const std::string messages_name = std::string("doracxx_") + kind + "_messages_total";
+        const std::string bytes_name = std::string("doracxx_") + kind + "_bytes_total";
+        header(text, messages_name.c_str(), "counter", messages_help);
+        for (const auto& [id, series] : map) {
+            sample(text, messages_name, node + "," + kind + "=\"" + escape(id) + "\"",
+                   static_cast<double>(series->messages.load(std::memory_order_relaxed)));
+        }
+        header(text, bytes_name.c_str(), "counter", bytes_help);
+        for (const auto& [id, series] : map) {
+            sample(text, bytes_name, node + "," + kind + "=\"" + escape(id) + "\"",
+                   static_cast<double>(series->bytes.load(std::memory_order_relaxed)));
+        }
+        header(text, latency_name, "summary", latency_help);
+        for (const auto& [id, series] : map) {
+            summary(text, latency_name, node + "," + kind + "=\"" + escape(id) + "\"", series->latency);
+        }
+    }
+
+    std::string node_;
+    std::chrono::milliseconds interval_;
+    Clock::time_point next_export_;
+    std::string file_;
+
+    std::atomic<uint64_t> events_{0};
+    Histogram next_wait_;
+
+    mutable std::mutex mutex_;
+    SeriesMap inputs_;
+    SeriesMap outputs_;
+};
+
+#else  // !DORACXX_METRICS
+
+// Metrics disabled: the same interface, reduced to the calls it wraps
+
+class Timer {
+public:
+    ~Timer() {}  // user-provided, so timers held only for their scope are not unused variables
+    void stop() {}
+};
+
+class Metrics {
+public:
+    explicit Metrics(std::string, std::chrono::milliseconds = std::chrono::milliseconds(DORACXX_METRICS_INTERVAL_MS)) {}
+
+    template <typename Events>
+    auto next(Events& events) {
+        return events.next();
+    }
+
+    template <typename Events>
+    Events& events(Events& events) {
+        return events;
+    }
+
+    Timer process(std::string_view, size_t = 0) { return {}; }
+
+    template <typename Send>
+    decltype(auto) send(std::string_view, size_t, Send&& send) {
+        return std::forward<Send>(send)();
+    }
+
+    template <typename Send>
+    decltype(auto) send(std::string_view, Send&& send) {
+        return std::forward<Send>(send)();
+    }
+
+    std::string to_prometheus() const { return {}; }
+
+    template <typename Sink>
+    bool maybe_export(Sink&&) {
+        return false;
+    }
+
+    bool maybe_export() { return false; }
+};
+
+#endif  // DORACXX_METRICS
+
+}  // namespace metrics
+}  // namespace doracxx
@@ -0,0 +1,281 @@
+// doracxx_output_buffer.h - recycled output buffers for Dora C++ nodes
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// Building each output in a fresh std::vector<uint8_t> allocates (and for
+// multi-megabyte camera or lidar frames, page-faults) a new buffer every
+// frame, and the frame is often copied once more into that vector. An
+// OutputBuffer is taken from a BufferPool instead: the node writes the frame
+// straight into it, sends it, and the buffer goes back to the pool, so a node
+// sending frames of a steady size stops allocating after the first ones.
+//
+//   doracxx::output::BufferPool pool;
+//   ...
+//   auto frame = pool.acquire(width * height * 3);
+//   capture_into(frame.data(), frame.size());                 // fill in place
+//   auto result = frame.send(dora_node.send_output, "image");  // back to the pool
+//
+// Buffers are 64-byte aligned, so they can back an Eigen::Map or an
+// arrow::MutableBuffer directly. send() hands the bytes to send_output as a
+// rust::Slice; Dora copies them into its own message (shared memory for large
+// ones) before it returns, which is the one copy left. send() needs
+// dora-node-api.h to be included first; the pool itself does not.
+//
+// A pool is thread-safe. It must outlive the buffers taken from it.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace doracxx {
+namespace output {
+
+struct PoolOptions {
+    // Free buffers kept for reuse; more are released to the system
+    size_t max_cached = 8;
+    // Total bytes of the free buffers kept for reuse
+    size_t max_cached_bytes = size_t(256) << 20;
+    // Buffer capacities are rounded up to a multiple of this
+    size_t granularity = 4096;
+};
+
+class BufferPool;
+
+/// A writable output buffer leased from a BufferPool; returns to it when destroyed.
+class OutputBuffer {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    OutputBuffer() = default;
+    ~OutputBuffer() { reset(); }
+
+    OutputBuffer(OutputBuffer&& other) noexcept
+        : pool_(other.pool_), data_(other.data_), size_(other.size_), capacity_(other.capacity_) {
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+        other.size_ = other.capacity_ = 0;
+    }
+
+    OutputBuffer& operator=(OutputBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            std::swap(pool_, other.pool_);
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+        }
+        return *this;
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    uint8_t* data() { return data_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    uint8_t* begin() { return data_; }
+    uint8_t* end() { return data_ + size_; }
+
+    /// The buffer as an array of T (T must fit the 64-byte alignment).
+    template <typename T>
+    T* as() {
+        static_assert(alignof(T) <= kAlignment, "type is over-aligned for an output buffer");
+        return reinterpret_cast<T*>(data_);
+    }
+
+    /// Number of whole T that fit in size().
+    template <typename T>
+    size_t count() const {
+        return size_ / sizeof(T);
+    }
+
+    /// Change the size; growing past capacity() moves the contents into a larger pooled buffer.
+    void resize(size_t size);
+
+    /// Append bytes at the end, growing like resize().
+    void append(const void* bytes, size_t count) {
+        const size_t offset = size_;
+        resize(size_ + count);
+        if (count) {
+            std::memcpy(data_ + offset, bytes, count);
+        }
+    }
+
+    void clear() { size_ = 0; }
+
+    /// Hand the buffer back to its pool now; a later resize() takes a new one.
+    void reset();
+
+#ifdef CXXBRIDGE1_RUST_SLICE
+    /// The filled bytes as the slice send_output takes.
+    rust::Slice<const uint8_t> slice() const { return rust::Slice<const uint8_t>(data_, size_); }
+
+    /// send_output(sender, id, slice()), then return the buffer to its pool.
+    ///
+    /// Extra arguments (for example metadata on Dora versions that take it)
+    /// are forwarded to send_output.
+    template <typename Sender, typename... Extra>
+    auto send(Sender& sender, const std::string& id, Extra&&... extra) {
+        auto result = send_output(sender, id, slice(), std::forward<Extra>(extra)...);
+        reset();
+        return result;
+    }
+#endif
+
+private:
+    friend class BufferPool;
+
+    OutputBuffer(BufferPool* pool, uint8_t* data, size_t size, size_t capacity)
+        : pool_(pool), data_(data), size_(size), capacity_(capacity) {}
+
+    BufferPool* pool_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+/// Recycles output buffers between frames.
+///
+/// acquire() reuses the smallest free buffer that fits, as long as it is at
+/// most four times larger than needed, so small outputs do not tie up the
+/// buffers of large ones.
+class BufferPool {
+public:
+    explicit BufferPool(PoolOptions options = {}) : options_(options) {
+        if (options_.granularity == 0) {
+            options_.granularity = 1;
+        }
+    }
+
+    ~BufferPool() { trim(); }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /// A buffer of size bytes; its contents are unspecified.
+    OutputBuffer acquire(size_t size) {
+        const size_t wanted = round_up(size);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t best = free_.size();
+            for (size_t i = 0; i < free_.size(); ++i) {
+                const size_t capacity = free_[i].capacity;
+                if (capacity >= wanted && capacity / 4 <= wanted &&
+                    (best == free_.size() || capacity < free_[best].capacity)) {
+                    best = i;
+                }
+            }
+            if (best != free_.size()) {
+                Block block = free_[best];
+                free_[best] = free_.back();
+                free_.pop_back();
+                cached_bytes_ -= block.capacity;
+                ++reuses_;
+                return OutputBuffer(this, block.data, size, block.capacity);
+            }
+            ++allocations_;
+        }
+        auto* data = static_cast<uint8_t*>(::operator new(wanted, std::align_val_t(OutputBuffer::kAlignment)));
+        return OutputBuffer(this, data, size, wanted);
+    }
+
+    /// Buffers allocated so far; constant once the node's sends reach a steady state.
+    size_t allocations() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocations_;
+    }
+
+    /// acquire() calls served from a recycled buffer.
+    size_t reuses() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reuses_;
+    }
+
+    /// Free buffers held for reuse.
+    size_t cached() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+    /// Release every free buffer to the system.
+    void trim() {
+        std::vector<Block> blocks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            blocks.swap(free_);
+            cached_bytes_ = 0;
+        }
+        for (const Block& block : blocks) {
+            deallocate(block.data);
+        }
+    }
+
+private:
+    friend class OutputBuffer;
+
+    struct Block {
+        uint8_t* data;
+        size_t capacity;
+    };
+
+    size_t round_up(size_t size) const {
+        const size_t granularity = options_.granularity;
+        return size == 0 ? granularity : (size + granularity - 1) / granularity * granularity;
+    }
+
+    static void deallocate(uint8_t* data) { ::operator delete(data, std::align_val_t(OutputBuffer::kAlignment)); }
+
+    void release(uint8_t* data, size_t capacity) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.size() < options_.max_cached && cached_bytes_ + capacity <= options_.max_cached_bytes) {
+                free_.push_back(Block{data, capacity});
+                cached_bytes_ += capacity;
+                return;
+            }
+        }
+        deallocate(data);
+    }
+
+    PoolOptions options_;
+    mutable std::mutex mutex_;
+    std::vector<Block> free_;
+    size_t cached_bytes_ = 0;
+    size_t allocations_ = 0;
+    size_t reuses_ = 0;
+};
+
+inline void OutputBuffer::reset() {
+    if (data_) {
+        pool_->release(data_, capacity_);
+    }
+    data_ = nullptr;
+    size_ = capacity_ = 0;
+}
+
+inline void OutputBuffer::resize(size_t size) {
+    if (size > capacity_) {
+        if (!pool_) {
+            // a default-constructed buffer has no pool to take memory from
+            throw std::bad_alloc();
+        }
+        // grow geometrically so that repeated appends stay amortized
+        OutputBuffer larger = pool_->acquire(size < capacity_ * 2 ? capacity_ * 2 : size);
+        if (size_) {
+            std::memcpy(larger.data_, data_, size_);
+        }
+        larger.size_ = size_;
+        *this = std::move(larger);
+    }
+    size_ = size;
+}
+
+}  // namespace output
+}  // namespace doracxx
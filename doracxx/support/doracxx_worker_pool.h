@@ -0,0 +1,307 @@
+// doracxx_worker_pool.h - worker threads behind a Dora event loop
+//
+// Shipped by doracxx into target/<profile>/deps next to dora-node-api.h.
+// The Dora event loop stays on one thread, the sending thread: it submits
+// each input to a WorkerPool, whose threads run the processing function in
+// parallel, and gets the outputs back in submission order through poll().
+//
+// Inputs travel over a bounded lock-free ring (Vyukov MPMC queue) and each
+// output is written to the slot of its sequence number, so the handoff in
+// either direction takes no lock. Idle workers spin briefly, then sleep
+// until the next submit. At most `capacity` inputs are in flight; submit()
+// delivers finished outputs while it waits for room.
+//
+//   doracxx::workers::WorkerPool<Input, Output> pool([](Input& in) { return process(in); });
+//   pool.submit(std::move(input), [&](Output& out) { send(out); });  // per event
+//   pool.poll([&](Output& out) { send(out); });                      // when idle
+//   pool.drain([&](Output& out) { send(out); });                     // at the end
+//
+// An exception thrown by the processing function is rethrown on the sending
+// thread when its output would have been delivered.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace doracxx {
+namespace workers {
+
+// Avoids false sharing between the producer and consumer side counters
+constexpr size_t kCacheLineSize = 64;
+
+inline size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/// Bounded lock-free multi-producer multi-consumer ring.
+///
+/// Capacity is rounded up to a power of two. try_push and try_pop never
+/// block; they fail when the ring is full or empty.
+template <typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity)
+        : mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    bool try_push(T&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value.emplace(std::move(value));
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::optional<T> try_pop() {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    std::optional<T> value(std::move(cell.value));
+                    cell.value.reset();
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return value;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;  // empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Approximate: may be stale as soon as it returns.
+    bool empty() const {
+        return dequeue_pos_.load(std::memory_order_acquire) >= enqueue_pos_.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        std::optional<T> value;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos_{0};
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos_{0};
+};
+
+/// Runs a function over inputs on worker threads, returning outputs in order.
+///
+/// submit(), poll(), drain() and in_flight() must all be called from the
+/// same thread, normally the one running the Dora event loop.
+template <typename Input, typename Output>
+class WorkerPool {
+public:
+    using Function = std::function<Output(Input&)>;
+
+    /**
+     * @param function Processing function, called concurrently on worker threads
+     * @param threads Number of workers; 0 uses every hardware thread but one,
+     *        which is left to the sending thread
+     * @param capacity Most inputs in flight, rounded up to a power of two
+     */
+    explicit WorkerPool(Function function, size_t threads = 0, size_t capacity = 256)
+        : function_(std::move(function)), jobs_(capacity), slots_(new Slot[jobs_.capacity()]) {
+        if (threads == 0) {
+            const unsigned hardware = std::thread::hardware_concurrency();
+            threads = hardware > 1 ? hardware - 1 : 1;
+        }
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    /// Stops the workers; outputs not yet delivered are discarded.
+    ~WorkerPool() {
+        stop_.store(true, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+        }
+        idle_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t threads() const { return workers_.size(); }
+    size_t capacity() const { return jobs_.capacity(); }
+    size_t in_flight() const { return static_cast<size_t>(next_submit_ - next_deliver_); }
+
+    /// Queue an input; while the pool is full, deliver outputs in order to sink.
+    template <typename Sink>
+    void submit(Input input, Sink&& sink) {
+        for (unsigned spin = 0; in_flight() >= capacity(); ++spin) {
+            if (poll(sink) == 0) {
+                backoff(spin);
+            }
+        }
+        Job job{next_submit_++, std::move(input)};
+        // cannot fail: the ring holds capacity() jobs and fewer are in flight
+        jobs_.try_push(std::move(job));
+        wake_worker();
+    }
+
+    /// Deliver every output that is ready, in order, without blocking.
+    /// @return Number of outputs delivered
+    template <typename Sink>
+    size_t poll(Sink&& sink) {
+        size_t delivered = 0;
+        while (next_deliver_ != next_submit_) {
+            Slot& slot = slots_[next_deliver_ & (capacity() - 1)];
+            if (!slot.ready.load(std::memory_order_acquire)) {
+                break;
+            }
+            std::optional<Output> output = std::move(slot.output);
+            std::exception_ptr error = slot.error;
+            slot.output.reset();
+            slot.error = nullptr;
+            slot.ready.store(false, std::memory_order_relaxed);
+            ++next_deliver_;
+            ++delivered;
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            sink(*output);
+        }
+        return delivered;
+    }
+
+    /// Wait for every submitted input and deliver the outputs in order.
+    template <typename Sink>
+    void drain(Sink&& sink) {
+        for (unsigned spin = 0; next_deliver_ != next_submit_; ++spin) {
+            if (poll(sink) == 0) {
+                backoff(spin);
+            } else {
+                spin = 0;
+            }
+        }
+    }
+
+private:
+    // Spins before a worker goes to sleep or the sender starts yielding
+    static constexpr unsigned kSpinCount = 2000;
+
+    struct Job {
+        uint64_t sequence;
+        Input input;
+    };
+
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<bool> ready{false};
+        std::optional<Output> output;
+        std::exception_ptr error;
+    };
+
+    static void backoff(unsigned spin) {
+        if (spin < kSpinCount) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void wake_worker() {
+        // pairs with the fence in next_job: either the worker sees the job
+        // or this thread sees the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_.notify_one();
+        }
+    }
+
+    std::optional<Job> next_job() {
+        for (unsigned spin = 0;; ++spin) {
+            if (std::optional<Job> job = jobs_.try_pop()) {
+                return job;
+            }
+            if (stop_.load(std::memory_order_acquire)) {
+                return std::nullopt;
+            }
+            if (spin < kSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            sleepers_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            idle_.wait(lock, [this] { return stop_.load(std::memory_order_acquire) || !jobs_.empty(); });
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            spin = 0;
+        }
+    }
+
+    void work() {
+        while (std::optional<Job> job = next_job()) {
+            Slot& slot = slots_[job->sequence & (capacity() - 1)];
+            try {
+                slot.output.emplace(function_(job->input));
+            } catch (...) {
+                slot.error = std::current_exception();
+            }
+            slot.ready.store(true, std::memory_order_release);
+        }
+    }
+
+    Function function_;
+    MpmcRing<Job> jobs_;
+    std::unique_ptr<Slot[]> slots_;
+    std::vector<std::thread> workers_;
+
+    // Sending thread only
+    uint64_t next_submit_ = 0;
+    uint64_t next_deliver_ = 0;
+
+    std::atomic<bool> stop_{false};
+    std::atomic<int> sleepers_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+};
+
+}  // namespace workers
+}  // namespace doracxx
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""
+Node templates for `doracxx new`
+
+Each template is a small, buildable node project: a doracxx.toml plus the
+sources under src/ and include/. The headers the templates rely on (such as
+doracxx_worker_pool.h) are shipped by doracxx into target/<profile>/deps at
+build time, so the generated projects only contain the node's own code.
+"""
+
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+try:
+    from .config import create_example_config
+except ImportError:
+    from config import create_example_config
+
+
+@dataclass
+class NodeTemplate:
+    description: str
+    files: Dict[str, str] = field(default_factory=dict)
+    # Lines added to the [build] section of the generated doracxx.toml
+    build_extra: str = ""
+    std: str = "c++17"
+
+
+_BASIC_NODE = r'''#include "dora-node-api.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main() {
+    auto dora_node = init_dora_node();
+
+    for (;;) {
+        auto event = dora_node.events->next();
+        auto ty = event_type(event);
+
+        if (ty == DoraEventType::AllInputsClosed) {
+            break;
+        }
+        else if (ty == DoraEventType::Input) {
+            auto input = event_as_input(std::move(event));
+
+            // Replace with the node's processing
+            std::vector<uint8_t> output(input.data.begin(), input.data.end());
+
+            ::rust::Slice<const uint8_t> data{output.data(), output.size()};
+            auto result = send_output(dora_node.send_output, "output", data);
+            if (!std::string(result.error).empty()) {
+                std::cerr << "[ERROR] Failed to send output: " << std::string(result.error) << std::endl;
+            }
+        }
+        else {
+            std::cerr << "[WARN] Unknown event type " << static_cast<int>(ty) << std::endl;
+        }
+    }
+    return 0;
+}
+'''
+
+_WORKER_POOL_PROCESSOR = r'''#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * One input, as handed from the Dora event thread to a worker
+ */
+struct Job {
+    std::string id;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * One output, handed back to the Dora event thread in input order
+ */
+struct Result {
+    std::string id;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Process one input; called concurrently on the worker threads, so it must
+ * not touch shared state without synchronization
+ */
+Result process(Job& job);
+'''
+
+_WORKER_POOL_PROCESSOR_SOURCE = r'''#include "processor.h"
+
+#include <numeric>
+
+Result process(Job& job) {
+    // Replace with the node's processing; this placeholder appends the byte sum
+    Result result{job.id, std::move(job.data)};
+    result.data.push_back(static_cast<uint8_t>(std::accumulate(result.data.begin(), result.data.end(), 0u)));
+    return result;
+}
+'''
+
+_WORKER_POOL_NODE = r'''#include "dora-node-api.h"
+#include "doracxx_worker_pool.h"
+#include "processor.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main() {
+    auto dora_node = init_dora_node();
+
+    // NODE_WORKERS overrides the number of worker threads (default: all cores but one)
+    const char* workers = std::getenv("NODE_WORKERS");
+    doracxx::workers::WorkerPool<Job, Result> pool(process, workers ? std::strtoul(workers, nullptr, 10) : 0);
+    std::cout << "[INFO] Processing on " << pool.threads() << " worker thread(s)" << std::endl;
+
+    // Outputs are sent from this thread only, in the order their inputs arrived
+    auto send = [&](Result& result) {
+        ::rust::Slice<const uint8_t> data{result.data.data(), result.data.size()};
+        auto send_result = send_output(dora_node.send_output, "output", data);
+        if (!std::string(send_result.error).empty()) {
+            std::cerr << "[ERROR] Failed to send output: " << std::string(send_result.error) << std::endl;
+        }
+    };
+
+    for (;;) {
+        auto event = dora_node.events->next();
+        auto ty = event_type(event);
+
+        if (ty == DoraEventType::AllInputsClosed) {
+            break;
+        }
+        else if (ty == DoraEventType::Input) {
+            auto input = event_as_input(std::move(event));
+            pool.submit(Job{std::string(input.id), {input.data.begin(), input.data.end()}}, send);
+        }
+        else {
+            std::cerr << "[WARN] Unknown event type " << static_cast<int>(ty) << std::endl;
+        }
+
+        // Send whatever the workers finished meanwhile
+        pool.poll(send);
+    }
+
+    pool.drain(send);
+    return 0;
+}
+'''
+
+_ASYNC_NODE = r'''#include "dora-node-api.h"
+#include "doracxx_async.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using doracxx::async::NodeRuntime;
+using doracxx::async::Task;
+
+// Stands in for a call that waits, e.g. on a GPU or a remote service
+static std::vector<uint8_t> slow_call(std::vector<uint8_t> data) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return data;
+}
+
+// Each input is handled in its own task, so slow calls overlap and outputs
+// may leave in a different order than their inputs arrived
+Task<> handle_input(NodeRuntime& rt, DoraNode& node, DoraInput input) {
+    std::vector<uint8_t> data(input.data.begin(), input.data.end());
+    auto output = co_await rt.run_in_thread(slow_call, std::move(data));
+
+    auto result = co_await rt.send([&] {
+        return send_output(node.send_output, "output", ::rust::Slice<const uint8_t>{output.data(), output.size()});
+    });
+    if (!std::string(result.error).empty()) {
+        std::cerr << "[ERROR] Failed to send output: " << std::string(result.error) << std::endl;
+    }
+}
+
+Task<> event_loop(NodeRuntime& rt, DoraNode& node) {
+    while (auto event = co_await rt.next_event()) {
+        auto ty = event_type(*event);
+        if (ty == DoraEventType::AllInputsClosed) {
+            break;
+        }
+        else if (ty == DoraEventType::Input) {
+            rt.spawn(handle_input(rt, node, event_as_input(std::move(*event))));
+        }
+        else {
+            std::cerr << "[WARN] Unknown event type " << static_cast<int>(ty) << std::endl;
+        }
+    }
+    // Let the inputs still being handled finish
+    co_await rt.drain();
+}
+
+int main() {
+    auto dora_node = init_dora_node();
+    NodeRuntime rt(*dora_node.events);
+    rt.run(event_loop(rt, dora_node));
+    return 0;
+}
+'''
+
+TEMPLATES: Dict[str, NodeTemplate] = {
+    "basic": NodeTemplate(
+        description="Dora C++ node",
+        files={"src/node.cc": _BASIC_NODE},
+    ),
+    "worker-pool": NodeTemplate(
+        description="Dora C++ node processing inputs on a pool of worker threads",
+        files={
+            "include/processor.h": _WORKER_POOL_PROCESSOR,
+            "src/processor.cc": _WORKER_POOL_PROCESSOR_SOURCE,
+            "src/node.cc": _WORKER_POOL_NODE,
+        },
+        build_extra='include_dirs = ["include"]\n',
+    ),
+    "async": NodeTemplate(
+        description="Dora C++ node running C++20 coroutines",
+        files={"src/node.cc": _ASYNC_NODE},
+        std="c++20",
+    ),
+}
+
+
+def template_names() -> List[str]:
+    return list(TEMPLATES)
+
+
+def create_node(directory: Path, template: str = "basic", name: Optional[str] = None,
+                force: bool = False) -> List[Path]:
+    """Create a node project from a template.
+
+    Returns the files written. Raises FileExistsError, before writing
+    anything, if one of the files exists and force is not set.
+    """
+    if template not in TEMPLATES:
+        raise ValueError(f"Unknown template '{template}' (available: {', '.join(template_names())})")
+    spec = TEMPLATES[template]
+    directory = Path(directory)
+    name = name or directory.resolve().name
+
+    targets = [directory / "doracxx.toml"] + [directory / rel for rel in spec.files]
+    existing = [path for path in targets if path.exists()]
+    if existing and not force:
+        raise FileExistsError(", ".join(str(path) for path in existing))
+
+    directory.mkdir(parents=True, exist_ok=True)
+    written = [create_example_config(directory / "doracxx.toml", node_name=name,
+                                     description=spec.description, build_extra=spec.build_extra,
+                                     std=spec.std)]
+    for rel, content in spec.files.items():
+        path = directory / rel
+        path.parent.mkdir(parents=True, exist_ok=True)
+        path.write_text(content, encoding="utf-8")
+        written.append(path)
+    return written
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+"""
+Build timings for `doracxx build --timings`
+
+A process-wide recorder collects how long each phase of a build took: Dora
+and Arrow preparation, git clones, dependency builds, header copies, build
+resolution, every compile job (one lane per scheduler worker) and the link.
+With clang, each compiled unit also gets a -ftime-trace profile, merged
+under its compile job. The timeline is written under target/<profile> as
+a Chrome trace, doracxx-timings.json, which opens in chrome://tracing or
+https://ui.perfetto.dev. It also gets a self-contained HTML summary,
+doracxx-timings.html.
+
+When timings are off, recording costs a flag check per phase.
+"""
+
+import functools
+import html
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+TRACE_FILE = "doracxx-timings.json"
+REPORT_FILE = "doracxx-timings.html"
+
+# clang -ftime-trace events shown in the summary, aggregated by their detail
+_CLANG_SUMMARY_EVENTS = {"Source": "Header parsing (inclusive)",
+                         "InstantiateClass": "Class template instantiation",
+                         "InstantiateFunction": "Function template instantiation"}
+
+
+@dataclass
+class Span:
+    """A timed phase, in seconds since the recorder started"""
+    name: str
+    category: str
+    start: float
+    end: float
+    lane: int
+    args: Dict[str, str] = field(default_factory=dict)
+
+    @property
+    def duration(self) -> float:
+        return self.end - self.start
+
+
+class Timings:
+    """Collects the phases of one build and writes them as a trace and a report"""
+
+    def __init__(self):
+        self.enabled = False
+        self.origin = time.monotonic()
+        self.spans: List[Span] = []
+        self.clang_events: List[dict] = []  # Chrome trace events from -ftime-trace files
+        self._lanes: Dict[int, int] = {}
+        self._lock = threading.Lock()
+
+    def enable(self):
+        self.enabled = True
+        self.origin = time.monotonic()
+        self.spans.clear()
+        self.clang_events.clear()
+        self._lanes.clear()
+
+    def now(self) -> float:
+        return time.monotonic() - self.origin
+
+    def lane(self) -> int:
+        """Small lane number of the calling thread: 0 for the first one seen, usually the main thread"""
+        ident = threading.get_ident()
+        with self._lock:
+            return self._lanes.setdefault(ident, len(self._lanes))
+
+    def record(self, name: str, category: str, start: float, end: float, args: Optional[Dict] = None,
+               lane: Optional[int] = None):
+        if not self.enabled:
+            return
+        span = Span(name, category, start, end, self.lane() if lane is None else lane,
+                    {k: str(v) for k, v in (args or {}).items()})
+        with self._lock:
+            self.spans.append(span)
+
+    @contextmanager
+    def phase(self, name: str, category: str = "build", **args):
+        """Time the enclosed block as a phase"""
+        if not self.enabled:
+            yield
+            return
+        start = self.now()
+        try:
+            yield
+        finally:
+            self.record(name, category, start, self.now(), args)
+
+    def add_clang_trace(self, path: Path, start: float, lane: int):
+        """Merge a clang -ftime-trace file for a compile that started at `start` on `lane`"""
+        try:
+            data = json.loads(Path(path).read_text(encoding="utf-8"))
+        except (OSError, ValueError):
+            return
+        events = []
+        for event in data.get("traceEvents", []):
+            # "Total ..." events sum a kind of event over the whole compile and
+            # would not nest under it
+            if event.get("ph") != "X" or str(event.get("name", "")).startswith("Total"):
+                continue
+            events.append({"name": event.get("name", "?"), "cat": "clang", "ph": "X",
+                           "ts": start * 1e6 + event.get("ts", 0), "dur": event.get("dur", 0),
+                           "pid": 1, "tid": lane, "args": event.get("args", {})})
+        with self._lock:
+            self.clang_events.extend(events)
+
+    def trace(self) -> dict:
+        """The recorded timeline in the Chrome trace event format"""
+        events = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "doracxx build"}}]
+        for lane in sorted(set(self._lanes.values()) | {span.lane for span in self.spans}):
+            events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": lane,
+                           "args": {"name": "main" if lane == 0 else f"worker {lane}"}})
+        for span in self.spans:
+            events.append({"name": span.name, "cat": span.category, "ph": "X", "ts": span.start * 1e6,
+                           "dur": span.duration * 1e6, "pid": 1, "tid": span.lane, "args": span.args})
+        events.extend(self.clang_events)
+        return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+    def write(self, target_dir: Path) -> List[Path]:
+        """Write the Chrome trace and the HTML report into target_dir"""
+        target_dir.mkdir(parents=True, exist_ok=True)
+        trace_path = target_dir / TRACE_FILE
+        report_path = target_dir / REPORT_FILE
+        for path, content in [(trace_path, json.dumps(self.trace())), (report_path, render_report(self))]:
+            tmp = path.with_name(path.name + ".tmp")
+            tmp.write_text(content, encoding="utf-8")
+            os.replace(tmp, path)
+        return [trace_path, report_path]
+
+
+TIMINGS = Timings()
+
+
+def write_report(target_dir: Path):
+    """Write the trace and report of this build into target_dir and print where the time went"""
+    paths = TIMINGS.write(target_dir)
+    for category, seconds in category_totals(TIMINGS.spans):
+        print(f"[TIMINGS] {category:<10} {_seconds(seconds)}")
+    for path in paths:
+        print(f"[TIMINGS] Wrote {path}")
+
+
+def phase(name: str, category: str = "build", **args):
+    """Time a block as a phase of the current build (no-op unless --timings)"""
+    return TIMINGS.phase(name, category, **args)
+
+
+def timed(category: str, name: Optional[str] = None):
+    """Decorator recording every call of a function as a phase
+
+    The first two string or path arguments of a call are kept as the
+    phase's detail, e.g. the URL and destination of a clone.
+    """
+    def decorate(func):
+        label = name or func.__name__
+
+        @functools.wraps(func)
+        def wrapper(*args, **kwargs):
+            if not TIMINGS.enabled:
+                return func(*args, **kwargs)
+            detail = " ".join([str(a) for a in args if isinstance(a, (str, Path))][:2])
+            with TIMINGS.phase(label, category, **({"detail": detail} if detail else {})):
+                return func(*args, **kwargs)
+        return wrapper
+    return decorate
+
+
+def time_trace_flags(family: str) -> List[str]:
+    """Compiler flags writing a -ftime-trace profile per unit, for compilers that have it"""
+    return {"clang": ["-ftime-trace"], "clang-cl": ["/clang:-ftime-trace"]}.get(family, [])
+
+
+def _seconds(value: float) -> str:
+    return f"{value:.3f} s" if value >= 0.01 else f"{value * 1000:.1f} ms"
+
+
+def _table(title: str, headers: List[str], rows: List[List[str]], bars: Optional[List[float]] = None) -> str:
+    if not rows:
+        return ""
+    out = [f"<h2>{html.escape(title)}</h2>", "<table>", "<tr>" + "".join(f"<th>{html.escape(h)}</th>" for h in headers)
+           + ("<th></th>" if bars else "") + "</tr>"]
+    for i, row in enumerate(rows):
+        cells = "".join(f"<td>{html.escape(cell)}</td>" for cell in row)
+        if bars:
+            cells += f'<td class="bar"><div style="width:{bars[i] * 100:.1f}%"></div></td>'
+        out.append(f"<tr>{cells}</tr>")
+    out.append("</table>")
+    return "\n".join(out)
+
+
+def category_totals(spans: List[Span]) -> List[tuple]:
+    """(category, seconds) pairs, longest first
+
+    A phase nested in another phase of the same category on the same lane is
+    not counted again. Compile jobs on parallel lanes add up, so "compile"
+    is CPU time rather than wall time.
+    """
+    totals: Dict[str, float] = {}
+    for span in spans:
+        if not any(o is not span and o.lane == span.lane and o.category == span.category
+                   and o.start <= span.start and span.end <= o.end and o.duration > span.duration
+                   for o in spans):
+            totals[span.category] = totals.get(span.category, 0.0) + span.duration
+    return sorted(totals.items(), key=lambda item: -item[1])
+
+
+def render_report(timings: Timings) -> str:
+    """Self-contained HTML summary: where the time went, by category, phase and unit"""
+    spans = sorted(timings.spans, key=lambda s: s.start)
+    total = max((s.end for s in spans), default=0.0)
+    scale = total or 1.0
+
+    categories = category_totals(spans)
+
+    timeline = [s for s in spans if s.category != "compile"]
+    units = sorted((s for s in spans if s.category == "compile"), key=lambda s: -s.duration)
+
+    sections = [
+        _table("Time by category", ["Category", "Time"],
+               [[c, _seconds(t)] for c, t in categories], [t / scale for _, t in categories]),
+        _table("Phases", ["Phase", "Category", "Start", "Duration", "Detail"],
+               [[s.name, s.category, _seconds(s.start), _seconds(s.duration), s.args.get("detail", "")]
+                for s in timeline],
+               [s.duration / scale for s in timeline]),
+        _table(f"Slowest translation units ({len(units)} compiled)", ["Unit", "Duration", "Worker", "Note"],
+               [[s.name, _seconds(s.duration), str(s.lane), s.args.get("note", "")] for s in units[:30]],
+               [s.duration / (units[0].duration or 1.0) for s in units[:30]]),
+    ]
+
+    for event_name, title in _CLANG_SUMMARY_EVENTS.items():
+        totals: Dict[str, List[float]] = {}
+        for event in timings.clang_events:
+            if event["name"] == event_name:
+                detail = str(event.get("args", {}).get("detail", "?"))
+                entry = totals.setdefault(detail, [0.0, 0])
+                entry[0] += event["dur"] / 1e6
+                entry[1] += 1
+        top = sorted(totals.items(), key=lambda item: -item[1][0])[:20]
+        if top:
+            sections.append(_table(f"{title}, clang -ftime-trace", ["Name", "Time", "Count"],
+                                   [[name, _seconds(t), str(n)] for name, (t, n) in top],
+                                   [t / (top[0][1][0] or 1.0) for _, (t, _n) in top]))
+
+    return f"""<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>doracxx build timings</title>
+<style>
+body {{ font-family: sans-serif; margin: 2em; }}
+table {{ border-collapse: collapse; margin-bottom: 2em; }}
+th, td {{ text-align: left; padding: 2px 12px 2px 0; font-size: 13px; }}
+td.bar {{ width: 320px; }}
+td.bar div {{ background: #4a90d9; height: 10px; }}
+</style></head><body>
+<h1>doracxx build timings</h1>
+<p>Total {_seconds(total)}. Open <code>{TRACE_FILE}</code> in chrome://tracing or
+https://ui.perfetto.dev for the full timeline.</p>
+{chr(10).join(s for s in sections if s)}
+</body></html>
+"""
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""
+Compiler identification for doracxx builds
+
+compile_node only distinguishes MSVC-style from gcc-style command lines. A few
+features (precompiled headers, compiler caches) also need to know which
+compiler is behind a gcc-style driver, which is detected from its version
+banner.
+"""
+
+import os
+import platform
+import subprocess
+import threading
+from pathlib import Path
+from typing import Dict
+
+try:
+    from .incremental import uses_clang_cl
+except ImportError:
+    from incremental import uses_clang_cl
+
+_version_lock = threading.Lock()
+_compiler_versions: Dict[str, str] = {}
+
+
+def compiler_version(cc: str, kind: str) -> str:
+    """Return the compiler's version banner (cached per compiler path)"""
+    with _version_lock:
+        if cc in _compiler_versions:
+            return _compiler_versions[cc]
+    args = [cc] if kind == "msvc" and not uses_clang_cl(cc) else [cc, "--version"]
+    try:
+        result = subprocess.run(args, capture_output=True, text=True, errors="replace", timeout=30)
+        # cl.exe prints its banner on stderr and exits non-zero without input
+        version = (result.stdout + result.stderr).strip()
+    except (OSError, subprocess.SubprocessError):
+        version = ""
+    if not version:
+        try:
+            st = Path(cc).stat()
+            version = f"{cc}:{st.st_size}:{st.st_mtime_ns}"
+        except OSError:
+            version = cc
+    with _version_lock:
+        _compiler_versions[cc] = version
+    return version
+
+
+def compiler_family(cc: str, kind: str) -> str:
+    """Identify the compiler: "msvc", "clang-cl", "clang" or "gcc" """
+    if kind == "msvc":
+        return "clang-cl" if uses_clang_cl(cc) else "msvc"
+    if "clang" in Path(cc).name.lower() or "clang" in compiler_version(cc, kind).lower():
+        return "clang"
+    return "gcc"
+
+
+def compiler_target_arch(cc: str, kind: str) -> str:
+    """Architecture the compiler generates code for: "x86_64", "aarch64" or the raw machine name"""
+    machine = ""
+    if kind == "msvc":
+        # set by vcvarsall; otherwise assume a native compiler
+        machine = os.environ.get("VSCMD_ARG_TGT_ARCH", "") or platform.machine()
+    else:
+        try:
+            result = subprocess.run([cc, "-dumpmachine"], capture_output=True, text=True, timeout=30)
+            machine = result.stdout.strip().split("-")[0]
+        except (OSError, subprocess.SubprocessError):
+            pass
+        machine = machine or platform.machine()
+    machine = machine.lower()
+    if machine in ("x64", "amd64", "x86_64"):
+        return "x86_64"
+    if machine in ("arm64", "aarch64"):
+        return "aarch64"
+    return machine
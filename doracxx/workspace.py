@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""
+Workspace builds: every node of a dataflow in one doracxx process
+
+`doracxx build --dataflow dataflow.yml` builds the nodes whose `build:`
+command runs doracxx, and `doracxx build --workspace` the members listed in
+the [workspace] section of a doracxx.toml:
+
+    [workspace]
+    members = ["nodes/camera", "nodes/detector", "nodes/*-filter"]
+
+The nodes build concurrently and share what does not differ between them:
+
+    Dora, Arrow   prepared once; a node waiting on a cache lock finds the
+                  install ready and skips its own preparation
+    cxxbridge     the library of the generated Dora sources is built by the
+                  first node and linked by all of them
+    MSVC          vcvarsall runs once
+    jobs          the compile and link commands of all nodes together stay
+                  within --jobs
+
+Nodes sharing a project root (and so a target directory) build one after
+the other. A failing node does not stop the others; the exit code is
+non-zero when any of them failed.
+"""
+
+import glob
+import re
+import shlex
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Optional
+
+try:
+    import tomllib
+except ImportError:  # Python < 3.11
+    import tomli as tomllib
+
+try:
+    from .build_cxx_node import build_arg_parser, build_node, msvc_environment
+    from .config import find_project_root
+    from .jobs import default_job_count, share_job_slots
+    from .timings import write_report
+except ImportError:
+    sys.path.insert(0, str(Path(__file__).parent))
+    from build_cxx_node import build_arg_parser, build_node, msvc_environment
+    from config import find_project_root
+    from jobs import default_job_count, share_job_slots
+    from timings import write_report
+
+# Workspace-level options that apply to every node
+_SHARED_OPTIONS = ("profile", "jobs", "refresh", "timings", "no_auto_prepare", "install_clang")
+
+_DORACXX_COMMANDS = (["doracxx", "build"], ["doracxx", "b"], ["dora-cxx-build"])
+_YAML_ID = re.compile(r"^\s*-\s+id:\s*(.+?)\s*$")
+_YAML_BUILD = re.compile(r"^\s+build:\s*(.+?)\s*$")
+
+
+@dataclass
+class WorkspaceNode:
+    """A node to build: its name, directory and doracxx build arguments"""
+    name: str
+    node_dir: Path
+    args: List[str]
+
+
+def doracxx_build_args(command: str) -> Optional[List[str]]:
+    """The arguments of a doracxx build command line, or None for any other command"""
+    try:
+        words = shlex.split(command)
+    except ValueError:
+        return None
+    # `uv run doracxx build ...`, `uv run -- doracxx build ...`
+    if words[:2] == ["uv", "run"]:
+        words = words[2:]
+        if words[:1] == ["--"]:
+            words = words[1:]
+    for prefix in _DORACXX_COMMANDS:
+        if words[:len(prefix)] == prefix:
+            args = words[len(prefix):]
+            if args[:1] == ["--"]:
+                args = args[1:]
+            return args
+    return None
+
+
+def _scan_dataflow(text: str) -> List[Dict[str, str]]:
+    """id and build of each node, for dataflows read without PyYAML"""
+    nodes = []
+    for line in text.splitlines():
+        match = _YAML_ID.match(line)
+        if match:
+            nodes.append({"id": match.group(1).strip("\"'")})
+            continue
+        match = _YAML_BUILD.match(line)
+        if match and nodes:
+            nodes[-1]["build"] = match.group(1).strip("\"'")
+    return nodes
+
+
+def _read_dataflow(path: Path) -> List[Dict[str, str]]:
+    text = path.read_text(encoding="utf-8")
+    try:
+        import yaml
+    except ImportError:
+        return _scan_dataflow(text)
+    data = yaml.safe_load(text) or {}
+    return [node for node in data.get("nodes", []) if isinstance(node, dict)]
+
+
+def dataflow_nodes(path: Path) -> List[WorkspaceNode]:
+    """The nodes of a dataflow that are built with doracxx
+
+    Node directories are relative to the dataflow, which is where dora runs
+    the build commands.
+    """
+    path = Path(path).resolve()
+    nodes = []
+    for entry in _read_dataflow(path):
+        name = str(entry.get("id", "?"))
+        command = entry.get("build")
+        if not command:
+            continue
+        args = doracxx_build_args(str(command))
+        if args is None:
+            print(f"[WORKSPACE] Skipping {name}: not built with doracxx ({command})")
+            continue
+        node_dir = path.parent
+        if args and not args[0].startswith("-"):
+            node_dir = path.parent / args.pop(0)
+        elif "--node-dir" in args:
+            index = args.index("--node-dir")
+            if index + 1 < len(args):
+                node_dir = path.parent / args[index + 1]
+                del args[index:index + 2]
+        nodes.append(WorkspaceNode(name, node_dir.resolve(), args))
+    return nodes
+
+
+def workspace_members(path: Path) -> List[WorkspaceNode]:
+    """The [workspace] members of a doracxx.toml, with glob patterns expanded"""
+    path = Path(path).resolve()
+    with open(path, "rb") as f:
+        data = tomllib.load(f)
+    members = data.get("workspace", {}).get("members", [])
+    nodes = []
+    for member in members:
+        matches = sorted(glob.glob(str(path.parent / member))) if glob.has_magic(member) else [str(path.parent / member)]
+        if not matches:
+            print(f"[WARN] Workspace member '{member}' matches no directory")
+        for match in matches:
+            node_dir = Path(match).resolve()
+            if node_dir.is_dir():
+                nodes.append(WorkspaceNode(node_dir.name, node_dir, []))
+    return nodes
+
+
+def build_workspace(nodes: List[WorkspaceNode], options, jobs: Optional[int] = None) -> int:
+    """Build nodes concurrently; options are workspace-level build arguments. Returns the exit code"""
+    if not nodes:
+        print("[WORKSPACE] No doracxx nodes to build")
+        return 1
+    jobs = default_job_count(jobs)
+    share_job_slots(jobs)
+    msvc_environment()
+
+    # nodes writing into the same target directory build in turn
+    groups: Dict[Path, List[WorkspaceNode]] = {}
+    for node in nodes:
+        groups.setdefault(find_project_root(node.node_dir), []).append(node)
+
+    parser = build_arg_parser()
+    results: Dict[str, Optional[Path]] = {}
+    start = time.monotonic()
+
+    def build_group(group: List[WorkspaceNode]):
+        for node in group:
+            print(f"[WORKSPACE] Building {node.name} ({node.node_dir})")
+            try:
+                args = parser.parse_args(node.args)
+                for option in _SHARED_OPTIONS:
+                    value = getattr(options, option, None)
+                    if value:
+                        setattr(args, option, value)
+                results[node.name] = build_node(args, node.node_dir)
+            except BaseException as e:
+                print(f"[WORKSPACE] {node.name} failed: {e}")
+                results[node.name] = None
+
+    try:
+        with ThreadPoolExecutor(max_workers=max(1, min(len(groups), jobs))) as pool:
+            list(pool.map(build_group, groups.values()))
+    finally:
+        share_job_slots(None)
+
+    built = [name for name, out in results.items() if out is not None]
+    failed = [node.name for node in nodes if results.get(node.name) is None]
+    print(f"[WORKSPACE] Built {len(built)} of {len(nodes)} nodes in {time.monotonic() - start:.1f}s")
+    for name in failed:
+        print(f"[WORKSPACE]   failed: {name}")
+    return 1 if failed else 0
+
+
+def build_workspace_command(args) -> int:
+    """`doracxx build --dataflow` / `--workspace` with the parsed command-line args"""
+    source = Path(args.dataflow or args.workspace)
+    if not source.exists():
+        print(f"[ERROR] {source} not found")
+        return 1
+    nodes = dataflow_nodes(source) if args.dataflow else workspace_members(source)
+    try:
+        return build_workspace(nodes, args, args.jobs)
+    finally:
+        if args.timings:
+            write_report(source.resolve().parent / "target")
@@ -0,0 +1,54 @@
+// Micro-benchmarks of ArrowProcessor, run with `doracxx bench`
+#include "arrow_processor.h"
+#include "doracxx_bench.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Producers send doubles; random bytes would decode to NaNs and denormals,
+// which some CPUs sum much more slowly
+void fill_with_doubles(std::vector<doracxx::bench::Input>& inputs) {
+    for (auto& input : inputs) {
+        for (size_t offset = 0; offset + sizeof(double) <= input.data.size(); offset += sizeof(double)) {
+            const double value = static_cast<double>(offset / sizeof(double) % 1000) * 0.5;
+            std::memcpy(input.data.data() + offset, &value, sizeof(double));
+        }
+    }
+}
+
+std::string pool_kind() {
+    const char* kind = std::getenv("ARROW_NODE_MEMORY_POOL");
+    return kind ? kind : "default";
+}
+
+rust::Slice<const uint8_t> as_slice(const doracxx::bench::Input& input) {
+    return rust::Slice<const uint8_t>{input.data.data(), input.data.size()};
+}
+
+}  // namespace
+
+// The per-input path of the node: wrap the bytes, sum, copy the sum out
+DORACXX_BENCHMARK(process_with_arrow) {
+    ArrowProcessor processor(pool_kind());
+    fill_with_doubles(run.inputs());
+    run.each_input([&](const doracxx::bench::Input& input) {
+        doracxx::bench::do_not_optimize(processor.process_with_arrow(as_slice(input)));
+    });
+}
+
+// One input through process_array, which also updates the streaming statistics
+DORACXX_BENCHMARK(process_array) {
+    ArrowProcessor processor(pool_kind());
+    fill_with_doubles(run.inputs());
+    run.each_input([&](const doracxx::bench::Input& input) {
+        auto array = processor.wrap_input(as_slice(input));
+        if (!array.ok()) {
+            throw std::runtime_error(array.status().ToString());
+        }
+        doracxx::bench::do_not_optimize(processor.process_array(array.ValueOrDie()));
+    });
+}
@@ -3,7 +3,10 @@
 #include <arrow/api.h>
 #include <arrow/compute/api.h>
 #include <dora-node-api.h>
+#include <doracxx_arrow_memory.h>
+#include "streaming_stats.h"
 #include <memory>
+#include <string>
 #include <vector>
 #include <optional>
 
@@ -15,18 +18,68 @@
  */
 class ArrowProcessor {
 public:
-    ArrowProcessor();
+    /**
+     * @param pool_kind Memory pool used for every allocation of this processor:
+     *        "default", "system", "jemalloc", "mimalloc" or "arena"
+     *        (see doracxx_arrow_memory.h); falls back to "default" if the
+     *        pool is not available in this Arrow build
+     */
+    explicit ArrowProcessor(const std::string& pool_kind = "default");
     ~ArrowProcessor();
     
+    ArrowProcessor(const ArrowProcessor&) = delete;
+    ArrowProcessor& operator=(const ArrowProcessor&) = delete;
+    
+    /**
+     * Sum an input array received through the Arrow C Data Interface
+     *
+     * Doubles are summed in place, raw byte (uint8) inputs are viewed as
+     * doubles with wrap_input and other numeric types are cast first. The
+     * input is also folded into the running statistics (see stats()).
+     * @param input Input array imported from Dora
+     * @return One-element double array holding the sum, or error
+     */
+    arrow::Result<std::shared_ptr<arrow::Array>> process_array(
+        const std::shared_ptr<arrow::Array>& input);
+    
+    /**
+     * Sum every array of a batch of inputs with process_array
+     * @param inputs Input arrays, in arrival order
+     * @return Double array with one sum per input; null where an input
+     *         failed or had no values
+     */
+    arrow::Result<std::shared_ptr<arrow::Array>> process_batch(
+        const std::vector<std::shared_ptr<arrow::Array>>& inputs);
+    
     /**
      * Process input data using Arrow arrays
+     * @param input Raw input data, read in place (see wrap_input)
+     * @return Processed output data
+     */
+    std::optional<std::vector<uint8_t>> process_with_arrow(
+        rust::Slice<const uint8_t> input);
+    
+    /**
+     * Process input data copied into a vector
      * @param input Raw input data
-     * @param output Processed output data
-     * @return Status of the operation
+     * @return Processed output data
      */
     std::optional<std::vector<uint8_t>> process_with_arrow(
         const std::vector<uint8_t>& input);
     
+    /**
+     * View a Dora input buffer as an Arrow array of doubles without copying
+     *
+     * The returned array references the input's memory and must not outlive
+     * it. Trailing bytes that do not form a whole double are ignored. If the
+     * data is not aligned for doubles, it is copied once into a buffer from
+     * the processor's memory pool instead.
+     * @param input Raw input data from event_as_input
+     * @return Arrow double array or error
+     */
+    arrow::Result<std::shared_ptr<arrow::DoubleArray>> wrap_input(
+        rust::Slice<const uint8_t> input);
+    
     /**
      * Create an Arrow array from input data
      * @param data Input data vector
@@ -43,6 +96,30 @@ public:
     arrow::Result<std::shared_ptr<arrow::Array>> compute_sum(
         const std::shared_ptr<arrow::Array>& array);
     
+    /**
+     * Running statistics of every array passed to process_array
+     */
+    const StreamingStats& stats() const { return stats_; }
+    
+    /**
+     * Running statistics as a one-row record batch from the processor's pool
+     */
+    arrow::Result<std::shared_ptr<arrow::RecordBatch>> stats_batch() const;
+    
+    /**
+     * Allocation statistics of the processor's memory pool
+     * @return Live and peak bytes, cumulative bytes and allocation count
+     */
+    doracxx::arrow_memory::PoolStats pool_stats() const;
+    
+    /**
+     * Name of the allocator behind the processor's memory pool
+     */
+    std::string pool_backend() const;
+    
 private:
-    std::shared_ptr<arrow::MemoryPool> memory_pool_;
+    std::unique_ptr<arrow::MemoryPool> memory_pool_;
+    // Reused by every compute call instead of being rebuilt per event
+    arrow::compute::ExecContext exec_context_;
+    StreamingStats stats_;
 };
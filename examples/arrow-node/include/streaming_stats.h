@@ -0,0 +1,101 @@
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+
+/**
+ * Mergeable summary of a set of values
+ *
+ * Holds what is needed to combine summaries of separate chunks exactly
+ * (Chan et al. pairwise update), so that no chunk has to be kept around.
+ */
+struct Moments {
+    int64_t count = 0;
+    double sum = 0.0;
+    double m2 = 0.0;  // Sum of squared deviations from the mean
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    /** Mean of the values, NaN when empty */
+    double mean() const;
+
+    /**
+     * Variance of the values
+     * @param ddof Delta degrees of freedom: 0 for population, 1 for sample variance
+     * @return Variance, NaN when there are not more than ddof values
+     */
+    double variance(int ddof = 0) const;
+
+    /** Fold another summary into this one */
+    void merge(const Moments& other);
+};
+
+/**
+ * Running statistics over a stream of Arrow arrays
+ *
+ * Each incoming chunk is reduced with Arrow's compute kernels (Sum, MinMax,
+ * Variance), which are vectorized and dispatched to the best SIMD level of
+ * the CPU at runtime, and only its Moments are kept:
+ *
+ *  - total(): every value seen so far
+ *  - window(): the last window_chunks chunks
+ *  - ema(): exponential moving average of the chunk means
+ *
+ * Nulls are skipped; non-double numeric chunks are cast to double first.
+ */
+class StreamingStats {
+public:
+    /**
+     * @param window_chunks Number of most recent chunks covered by window()
+     * @param ema_alpha Weight of the newest chunk mean in ema(), in (0, 1]
+     */
+    explicit StreamingStats(size_t window_chunks = 16, double ema_alpha = 0.1);
+
+    /**
+     * Reduce a chunk and fold it into the running state
+     * @param chunk Numeric input array
+     * @param exec_context Compute context whose memory pool the kernels use
+     * @return Moments of the chunk, or error if it is not numeric
+     */
+    arrow::Result<Moments> update(const arrow::Array& chunk, arrow::compute::ExecContext* exec_context);
+
+    /**
+     * Reduce a single chunk
+     * @param chunk Numeric input array
+     * @param exec_context Compute context whose memory pool the kernels use
+     * @return Moments of the chunk or error
+     */
+    static arrow::Result<Moments> summarize(const arrow::Array& chunk,
+                                            arrow::compute::ExecContext* exec_context);
+
+    const Moments& total() const { return total_; }
+    Moments window() const;
+    /** NaN before the first non-empty chunk */
+    double ema() const { return ema_; }
+    int64_t chunks() const { return chunks_; }
+
+    /** Drop all state */
+    void reset();
+
+    /**
+     * Current statistics as a one-row record batch, for sending as an output
+     * @param pool Memory pool for the columns
+     * @return Record batch with count, sum, mean, min, max, variance,
+     *         window_mean, window_variance and ema columns
+     */
+    arrow::Result<std::shared_ptr<arrow::RecordBatch>> to_record_batch(
+        arrow::MemoryPool* pool = arrow::default_memory_pool()) const;
+
+private:
+    size_t window_chunks_;
+    double ema_alpha_;
+    Moments total_;
+    std::deque<Moments> window_;
+    double ema_;
+    int64_t chunks_ = 0;
+};
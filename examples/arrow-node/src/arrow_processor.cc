@@ -0,0 +1,205 @@
+#include "arrow_processor.h"
+#include <arrow/array.h>
+#include <arrow/builder.h>
+#include <arrow/compute/cast.h>
+#include <arrow/compute/exec.h>
+#include <arrow/memory_pool.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "doracxx_log.h"
+
+namespace {
+
+std::unique_ptr<arrow::MemoryPool> make_processor_pool(const std::string& kind) {
+    auto pool_result = doracxx::arrow_memory::make_memory_pool(kind);
+    if (pool_result.ok()) {
+        return std::move(pool_result).ValueOrDie();
+    }
+    DORACXX_LOG_WARN("Memory pool '", kind, "' unavailable (", pool_result.status().ToString(),
+                     "), using the default pool");
+    return doracxx::arrow_memory::make_memory_pool("default").ValueOrDie();
+}
+
+}  // namespace
+
+ArrowProcessor::ArrowProcessor(const std::string& pool_kind) 
+    : memory_pool_(make_processor_pool(pool_kind)),
+      exec_context_(memory_pool_.get()) {
+    DORACXX_LOG_INFO("Initialized Arrow processor with memory pool ", pool_backend());
+}
+
+ArrowProcessor::~ArrowProcessor() {
+    DORACXX_LOG_INFO("Pool stats: ", pool_stats().ToString());
+    DORACXX_LOG_INFO("Destroyed Arrow processor");
+}
+
+doracxx::arrow_memory::PoolStats ArrowProcessor::pool_stats() const {
+    return doracxx::arrow_memory::pool_stats(memory_pool_.get());
+}
+
+std::string ArrowProcessor::pool_backend() const {
+    return memory_pool_->backend_name();
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> ArrowProcessor::process_array(
+    const std::shared_ptr<arrow::Array>& input) {
+    
+    std::shared_ptr<arrow::Array> values = input;
+    if (input->type_id() == arrow::Type::UINT8) {
+        // Raw bytes: view them as doubles without copying
+        auto bytes = std::static_pointer_cast<arrow::UInt8Array>(input);
+        ::rust::Slice<const uint8_t> raw{bytes->raw_values(), static_cast<size_t>(bytes->length())};
+        ARROW_ASSIGN_OR_RAISE(values, wrap_input(raw));
+    } else if (input->type_id() != arrow::Type::DOUBLE) {
+        ARROW_ASSIGN_OR_RAISE(values, arrow::compute::Cast(*input, arrow::float64(),
+                                                           arrow::compute::CastOptions::Safe(), &exec_context_));
+    }
+    
+    DORACXX_LOG_DEBUG("Summing array with ", values->length(), " elements");
+    ARROW_ASSIGN_OR_RAISE(Moments moments, stats_.update(*values, &exec_context_));
+
+    // The statistics already summed the chunk; like Sum, no values give a null
+    arrow::DoubleBuilder sum(memory_pool_.get());
+    ARROW_RETURN_NOT_OK(moments.count > 0 ? sum.Append(moments.sum) : sum.AppendNull());
+    std::shared_ptr<arrow::Array> array;
+    ARROW_RETURN_NOT_OK(sum.Finish(&array));
+    return array;
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> ArrowProcessor::process_batch(
+    const std::vector<std::shared_ptr<arrow::Array>>& inputs) {
+    
+    arrow::DoubleBuilder sums(memory_pool_.get());
+    ARROW_RETURN_NOT_OK(sums.Reserve(static_cast<int64_t>(inputs.size())));
+    
+    for (const auto& input : inputs) {
+        auto result = process_array(input);
+        // A failed or empty input yields a null so positions match the inputs
+        if (!result.ok()) {
+            DORACXX_LOG_WARN("Skipping input: ", result.status().ToString());
+            sums.UnsafeAppendNull();
+        } else if (result.ValueOrDie()->IsNull(0)) {
+            sums.UnsafeAppendNull();
+        } else {
+            sums.UnsafeAppend(std::static_pointer_cast<arrow::DoubleArray>(result.ValueOrDie())->Value(0));
+        }
+    }
+    
+    std::shared_ptr<arrow::Array> array;
+    ARROW_RETURN_NOT_OK(sums.Finish(&array));
+    return array;
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> ArrowProcessor::stats_batch() const {
+    return stats_.to_record_batch(memory_pool_.get());
+}
+
+std::optional<std::vector<uint8_t>> ArrowProcessor::process_with_arrow(
+    const std::vector<uint8_t>& input) {
+    return process_with_arrow(::rust::Slice<const uint8_t>{input.data(), input.size()});
+}
+
+std::optional<std::vector<uint8_t>> ArrowProcessor::process_with_arrow(
+    rust::Slice<const uint8_t> input) {
+    
+    try {
+        // View the raw bytes as doubles for demonstration
+        std::shared_ptr<arrow::Array> array;
+        if (input.size() >= sizeof(double)) {
+            auto wrap_result = wrap_input(input);
+            if (!wrap_result.ok()) {
+                DORACXX_LOG_ERROR("Failed to wrap input: ", wrap_result.status().ToString());
+                return std::nullopt;
+            }
+            array = wrap_result.ValueOrDie();
+        } else {
+            // If no double values, create some example data
+            DORACXX_LOG_DEBUG("Using example data: [1.0, 2.0, 3.0, 4.0, 5.0]");
+            auto array_result = create_arrow_array({1.0, 2.0, 3.0, 4.0, 5.0});
+            if (!array_result.ok()) {
+                DORACXX_LOG_ERROR("Failed to create Arrow array: ", array_result.status().ToString());
+                return std::nullopt;
+            }
+            array = array_result.ValueOrDie();
+        }
+        
+        DORACXX_LOG_DEBUG("Created array with ", array->length(), " elements");
+        
+        // Perform computation
+        auto sum_result = compute_sum(array);
+        if (!sum_result.ok()) {
+            DORACXX_LOG_ERROR("Failed to compute sum: ", sum_result.status().ToString());
+            return std::nullopt;
+        }
+        auto sum_array = sum_result.ValueOrDie();
+        
+        // Convert result back to bytes
+        auto double_array = std::static_pointer_cast<arrow::DoubleArray>(sum_array);
+        double sum_value = double_array->Value(0);
+        
+        DORACXX_LOG_DEBUG("Computed sum: ", sum_value);
+        
+        // Convert result to output bytes
+        std::vector<uint8_t> output_data(sizeof(double));
+        std::memcpy(output_data.data(), &sum_value, sizeof(double));
+        
+        return output_data;
+        
+    } catch (const std::exception& e) {
+        DORACXX_LOG_ERROR("Arrow processing exception: ", e.what());
+        return std::nullopt;
+    }
+}
+
+arrow::Result<std::shared_ptr<arrow::DoubleArray>> ArrowProcessor::wrap_input(
+    rust::Slice<const uint8_t> input) {
+    
+    const int64_t length = static_cast<int64_t>(input.size() / sizeof(double));
+    const int64_t size = length * static_cast<int64_t>(sizeof(double));
+    
+    std::shared_ptr<arrow::Buffer> values;
+    if (reinterpret_cast<std::uintptr_t>(input.data()) % alignof(double) == 0) {
+        // Non-owning view: no copy, valid while the Dora input is alive
+        values = std::make_shared<arrow::Buffer>(input.data(), size);
+    } else {
+        // Misaligned doubles cannot be read in place; copy once into pool memory
+        DORACXX_LOG_DEBUG("Input is not aligned for doubles, copying ", size, " bytes");
+        ARROW_ASSIGN_OR_RAISE(std::unique_ptr<arrow::Buffer> copy, arrow::AllocateBuffer(size, memory_pool_.get()));
+        std::memcpy(copy->mutable_data(), input.data(), static_cast<size_t>(size));
+        values = std::move(copy);
+    }
+    
+    // No validity bitmap: every value is valid
+    auto data = arrow::ArrayData::Make(arrow::float64(), length, {nullptr, std::move(values)}, /*null_count=*/0);
+    return std::make_shared<arrow::DoubleArray>(std::move(data));
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> ArrowProcessor::create_arrow_array(
+    const std::vector<double>& data) {
+    
+    arrow::DoubleBuilder builder(memory_pool_.get());
+    ARROW_RETURN_NOT_OK(builder.Reserve(data.size()));
+    
+    for (double value : data) {
+        ARROW_RETURN_NOT_OK(builder.Append(value));
+    }
+    
+    std::shared_ptr<arrow::Array> array;
+    ARROW_RETURN_NOT_OK(builder.Finish(&array));
+    
+    return array;
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> ArrowProcessor::compute_sum(
+    const std::shared_ptr<arrow::Array>& array) {
+    
+    using namespace arrow::compute;
+    
+    // Compute sum using proper API, allocating from the processor's pool
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum sum_datum, Sum(array, ScalarAggregateOptions::Defaults(), &exec_context_));
+    
+    return sum_datum.make_array();
+}
@@ -1,159 +1,129 @@
 #include "arrow_processor.h"
 #include <arrow/array.h>
-#include <arrow/builder.h>
-#include <arrow/compute/exec.h>
-#include <arrow/memory_pool.h>
-#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 // Include Dora headers
 #include "dora-node-api.h"
+#include "doracxx_arrow_bridge.h"
+#include "doracxx_event_batch.h"
+#include "doracxx_log.h"
+#include "doracxx_metrics.h"
+
+namespace {
+
+// Print pool statistics every this many batches
+constexpr int kStatsInterval = 25;
+
+size_t env_size(const char* name, size_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(value, &end, 10);
+    if (*end != '\0') {
+        DORACXX_LOG_WARN("Ignoring invalid ", name, "=", value);
+        return fallback;
+    }
+    return static_cast<size_t>(parsed);
+}
+
+}  // namespace
 
 int main() {
-    std::cout << "[INFO] Starting Arrow-enabled Dora node" << std::endl;
+    DORACXX_LOG_INFO("Starting Arrow-enabled Dora node");
     
-    // Initialize Arrow processor
-    ArrowProcessor processor;
+    // Initialize Arrow processor; ARROW_NODE_MEMORY_POOL selects its allocator
+    const char* pool_kind = std::getenv("ARROW_NODE_MEMORY_POOL");
+    ArrowProcessor processor(pool_kind ? pool_kind : "default");
     
     // Initialize Dora node
     auto dora_node = init_dora_node();
     
-    for (int i = 0; i < 100; i++) {
-        auto event = dora_node.events->next();
-        auto ty = event_type(event);
-
-        if (ty == DoraEventType::AllInputsClosed) {
-            std::cout << "[INFO] All inputs closed, exiting" << std::endl;
-            break;
-        }
-        else if (ty == DoraEventType::Input) {
-            auto input = event_as_input(std::move(event));
-            
-            std::cout << "[PROCESS] Processing input with Arrow: " << std::string(input.id) << std::endl;
+    // Latency histograms and counters, when built with [metrics] enabled;
+    // exported to the file named by DORACXX_METRICS_FILE
+    doracxx::metrics::Metrics metrics("arrow-node");
+    auto&& events = metrics.events(*dora_node.events);
+    
+    // Events are handled in batches: everything already queued, plus what
+    // arrives within the latency budget of the batch's first event
+    doracxx::events::BatchOptions batch_options;
+    batch_options.max_batch = env_size("ARROW_NODE_MAX_BATCH", batch_options.max_batch);
+    batch_options.latency_budget = std::chrono::microseconds(
+        env_size("ARROW_NODE_BATCH_LATENCY_US", static_cast<size_t>(batch_options.latency_budget.count())));
+    doracxx::events::EventBatcher batcher(events, batch_options);
+    
+    int64_t batches = 0;
+    for (auto batch = batcher.next_batch(); !batch.empty(); batch = batcher.next_batch()) {
+        std::vector<std::shared_ptr<arrow::Array>> inputs;
+        inputs.reserve(batch.size());
+        
+        for (auto& event : batch) {
+            auto ty = event_type(event);
             
-            // Convert input data to vector
-            std::vector<uint8_t> input_data;
-            for (auto byte : input.data) {
-                input_data.push_back(byte);
+            if (ty == DoraEventType::AllInputsClosed) {
+                DORACXX_LOG_INFO("All inputs closed, exiting");
             }
-            
-            // Process with Arrow
-            auto result = processor.process_with_arrow(input_data);
-            if (!result.has_value()) {
-                std::cerr << "[ERROR] Arrow processing failed" << std::endl;
-                continue;
+            else if (ty == DoraEventType::Input) {
+                // Import the input's Arrow array; its buffers are shared, not copied
+                auto input_result = doracxx::arrow_bridge::input_array(std::move(event));
+                if (!input_result.ok()) {
+                    DORACXX_LOG_ERROR("Failed to import input: ", input_result.status().ToString());
+                    continue;
+                }
+                inputs.push_back(input_result.ValueOrDie());
             }
-            
-            // Send output
-            const auto& output_data = result.value();
-            ::rust::Slice<const uint8_t> data_slice{output_data.data(), output_data.size()};
-            auto send_result = send_output(dora_node.send_output, "arrow_output", data_slice);
-            if (!std::string(send_result.error).empty()) {
-                std::cerr << "[ERROR] Failed to send output: " << std::string(send_result.error) << std::endl;
-            } else {
-                std::cout << "[INFO] Successfully sent Arrow output" << std::endl;
+            else {
+                DORACXX_LOG_WARN("Unknown event type ", static_cast<int>(ty));
             }
         }
-        else {
-            std::cerr << "[WARN] Unknown event type " << static_cast<int>(ty) << std::endl;
-        }
-    }
-    
-    std::cout << "[INFO] Arrow-enabled Dora node finished" << std::endl;
-    return 0;
-}
-
-// ArrowProcessor implementation
-ArrowProcessor::ArrowProcessor() 
-    : memory_pool_(arrow::default_memory_pool()) {
-    std::cout << "[ARROW] Initialized Arrow processor with memory pool" << std::endl;
-}
-
-ArrowProcessor::~ArrowProcessor() {
-    std::cout << "[ARROW] Destroyed Arrow processor" << std::endl;
-}
-
-std::optional<std::vector<uint8_t>> ArrowProcessor::process_with_arrow(
-    const std::vector<uint8_t>& input) {
-    
-    try {
-        // Convert raw bytes to doubles for demonstration
-        std::vector<double> values;
-        for (size_t i = 0; i < input.size(); i += sizeof(double)) {
-            if (i + sizeof(double) <= input.size()) {
-                double value;
-                std::memcpy(&value, &input[i], sizeof(double));
-                values.push_back(value);
-            }
+        if (inputs.empty()) {
+            continue;
         }
         
-        // If no double values, create some example data
-        if (values.empty()) {
-            values = {1.0, 2.0, 3.0, 4.0, 5.0};
-            std::cout << "[ARROW] Using example data: [1.0, 2.0, 3.0, 4.0, 5.0]" << std::endl;
-        }
+        DORACXX_LOG_DEBUG("Processing ", inputs.size(), " input(s) with Arrow");
         
-        // Create Arrow array
-        auto array_result = create_arrow_array(values);
-        if (!array_result.ok()) {
-            std::cerr << "[ERROR] Failed to create Arrow array: " << array_result.status().ToString() << std::endl;
-            return std::nullopt;
+        // One output per batch: the sums of all its inputs, in arrival order
+        auto timer = metrics.process("batch");
+        auto result = processor.process_batch(inputs);
+        timer.stop();
+        if (!result.ok()) {
+            DORACXX_LOG_ERROR("Arrow processing failed: ", result.status().ToString());
+            continue;
         }
-        auto array = array_result.ValueOrDie();
-        
-        std::cout << "[ARROW] Created array with " << array->length() << " elements" << std::endl;
         
-        // Perform computation
-        auto sum_result = compute_sum(array);
-        if (!sum_result.ok()) {
-            std::cerr << "[ERROR] Failed to compute sum: " << sum_result.status().ToString() << std::endl;
-            return std::nullopt;
+        // Send the result array as-is through the C Data Interface
+        auto send_status = metrics.send("arrow_output", [&] {
+            return doracxx::arrow_bridge::send_array(dora_node.send_output, "arrow_output", *result.ValueOrDie());
+        });
+        if (!send_status.ok()) {
+            DORACXX_LOG_ERROR("Failed to send output: ", send_status.ToString());
         }
-        auto sum_array = sum_result.ValueOrDie();
-        
-        // Convert result back to bytes
-        auto double_array = std::static_pointer_cast<arrow::DoubleArray>(sum_array);
-        double sum_value = double_array->Value(0);
         
-        std::cout << "[ARROW] Computed sum: " << sum_value << std::endl;
-        
-        // Convert result to output bytes
-        std::vector<uint8_t> output_data(sizeof(double));
-        std::memcpy(output_data.data(), &sum_value, sizeof(double));
-        
-        return output_data;
+        // Running statistics over every input so far, as one record batch
+        auto stats_result = processor.stats_batch();
+        if (stats_result.ok()) {
+            send_status = metrics.send("arrow_stats", [&] {
+                return doracxx::arrow_bridge::send_record_batch(dora_node.send_output, "arrow_stats",
+                                                                *stats_result.ValueOrDie());
+            });
+        } else {
+            send_status = stats_result.status();
+        }
+        if (!send_status.ok()) {
+            DORACXX_LOG_ERROR("Failed to send statistics: ", send_status.ToString());
+        }
         
-    } catch (const std::exception& e) {
-        std::cerr << "[ERROR] Arrow processing exception: " << e.what() << std::endl;
-        return std::nullopt;
-    }
-}
-
-arrow::Result<std::shared_ptr<arrow::Array>> ArrowProcessor::create_arrow_array(
-    const std::vector<double>& data) {
-    
-    arrow::DoubleBuilder builder(arrow::default_memory_pool());
-    ARROW_RETURN_NOT_OK(builder.Reserve(data.size()));
-    
-    for (double value : data) {
-        ARROW_RETURN_NOT_OK(builder.Append(value));
+        if (++batches % kStatsInterval == 0) {
+            DORACXX_LOG_INFO("Pool stats: ", processor.pool_stats().ToString());
+        }
+        metrics.maybe_export();
     }
     
-    std::shared_ptr<arrow::Array> array;
-    ARROW_RETURN_NOT_OK(builder.Finish(&array));
-    
-    return array;
-}
-
-arrow::Result<std::shared_ptr<arrow::Array>> ArrowProcessor::compute_sum(
-    const std::shared_ptr<arrow::Array>& array) {
-    
-    using namespace arrow::compute;
-    
-    // Create compute context
-    ExecContext exec_context(arrow::default_memory_pool());
-    
-    // Compute sum using proper API
-    ARROW_ASSIGN_OR_RAISE(arrow::Datum sum_datum, Sum(array, ScalarAggregateOptions::Defaults(), &exec_context));
-    
-    return sum_datum.make_array();
+    DORACXX_LOG_INFO("Arrow-enabled Dora node finished");
+    return 0;
 }
@@ -0,0 +1,127 @@
+#include "streaming_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+double Moments::mean() const {
+    return count > 0 ? sum / static_cast<double>(count) : std::nan("");
+}
+
+double Moments::variance(int ddof) const {
+    return count > ddof ? m2 / static_cast<double>(count - ddof) : std::nan("");
+}
+
+void Moments::merge(const Moments& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+
+    const double n_a = static_cast<double>(count);
+    const double n_b = static_cast<double>(other.count);
+    const double delta = other.mean() - mean();
+    m2 += other.m2 + delta * delta * n_a * n_b / (n_a + n_b);
+    sum += other.sum;
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+StreamingStats::StreamingStats(size_t window_chunks, double ema_alpha)
+    : window_chunks_(std::max<size_t>(window_chunks, 1)),
+      ema_alpha_(ema_alpha),
+      ema_(std::nan("")) {}
+
+arrow::Result<Moments> StreamingStats::summarize(const arrow::Array& chunk,
+                                                 arrow::compute::ExecContext* exec_context) {
+    using namespace arrow::compute;
+
+    std::shared_ptr<arrow::Array> values;
+    if (chunk.type_id() == arrow::Type::DOUBLE) {
+        values = arrow::MakeArray(chunk.data());
+    } else if (arrow::is_numeric(chunk.type_id())) {
+        ARROW_ASSIGN_OR_RAISE(values, Cast(chunk, arrow::float64(), CastOptions::Safe(), exec_context));
+    } else {
+        return arrow::Status::TypeError("cannot compute statistics of ", chunk.type()->ToString());
+    }
+
+    Moments moments;
+    moments.count = values->length() - values->null_count();
+    if (moments.count == 0) {
+        return moments;
+    }
+
+    // One vectorized pass per kernel over the chunk, nothing is copied
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum sum, Sum(values, ScalarAggregateOptions::Defaults(), exec_context));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum min_max, MinMax(values, ScalarAggregateOptions::Defaults(), exec_context));
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum variance, Variance(values, VarianceOptions(/*ddof=*/0), exec_context));
+
+    const auto& extrema = min_max.scalar_as<arrow::StructScalar>();
+    moments.sum = sum.scalar_as<arrow::DoubleScalar>().value;
+    moments.min = static_cast<const arrow::DoubleScalar&>(*extrema.value[0]).value;
+    moments.max = static_cast<const arrow::DoubleScalar&>(*extrema.value[1]).value;
+    moments.m2 = variance.scalar_as<arrow::DoubleScalar>().value * static_cast<double>(moments.count);
+    return moments;
+}
+
+arrow::Result<Moments> StreamingStats::update(const arrow::Array& chunk, arrow::compute::ExecContext* exec_context) {
+    ARROW_ASSIGN_OR_RAISE(Moments moments, summarize(chunk, exec_context));
+
+    ++chunks_;
+    total_.merge(moments);
+    window_.push_back(moments);
+    if (window_.size() > window_chunks_) {
+        window_.pop_front();
+    }
+    if (moments.count > 0) {
+        ema_ = std::isnan(ema_) ? moments.mean() : ema_alpha_ * moments.mean() + (1.0 - ema_alpha_) * ema_;
+    }
+    return moments;
+}
+
+Moments StreamingStats::window() const {
+    Moments combined;
+    for (const Moments& moments : window_) {
+        combined.merge(moments);
+    }
+    return combined;
+}
+
+void StreamingStats::reset() {
+    total_ = Moments();
+    window_.clear();
+    ema_ = std::nan("");
+    chunks_ = 0;
+}
+
+arrow::Result<std::shared_ptr<arrow::RecordBatch>> StreamingStats::to_record_batch(
+    arrow::MemoryPool* pool) const {
+
+    const Moments recent = window();
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+
+    auto add_column = [&](const std::string& name, const arrow::Scalar& value) -> arrow::Status {
+        ARROW_ASSIGN_OR_RAISE(auto column, arrow::MakeArrayFromScalar(value, 1, pool));
+        fields.push_back(arrow::field(name, value.type));
+        columns.push_back(std::move(column));
+        return arrow::Status::OK();
+    };
+
+    ARROW_RETURN_NOT_OK(add_column("count", arrow::Int64Scalar(total_.count)));
+    ARROW_RETURN_NOT_OK(add_column("sum", arrow::DoubleScalar(total_.sum)));
+    ARROW_RETURN_NOT_OK(add_column("mean", arrow::DoubleScalar(total_.mean())));
+    ARROW_RETURN_NOT_OK(add_column("min", arrow::DoubleScalar(total_.min)));
+    ARROW_RETURN_NOT_OK(add_column("max", arrow::DoubleScalar(total_.max)));
+    ARROW_RETURN_NOT_OK(add_column("variance", arrow::DoubleScalar(total_.variance())));
+    ARROW_RETURN_NOT_OK(add_column("window_mean", arrow::DoubleScalar(recent.mean())));
+    ARROW_RETURN_NOT_OK(add_column("window_variance", arrow::DoubleScalar(recent.variance())));
+    ARROW_RETURN_NOT_OK(add_column("ema", arrow::DoubleScalar(ema_)));
+
+    return arrow::RecordBatch::Make(arrow::schema(std::move(fields)), 1, std::move(columns));
+}
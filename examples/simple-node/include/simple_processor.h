@@ -1,14 +1,54 @@
 #pragma once
 
 /**
- * Simple example header for demonstration
+ * Point cloud processing for the simple-node example
  */
 
+#include <Eigen/Dense>
+
+#include "doracxx_eigen.h"
+
+#include <cstddef>
+
 namespace example {
+    /// N x 3 points, one per row, as doracxx_eigen.h maps them
+    using Points = doracxx::eigen::Matrix<double, Eigen::RowMajor>;
+
+    /**
+     * Applies a rigid transform (rotation, then translation) to 3D points.
+     *
+     * process() reads and writes through Eigen::Ref, so the points can be
+     * mapped straight from a Dora input and the result written straight
+     * into an output buffer.
+     */
     class SimpleProcessor {
     public:
-        void process();
-        void initialize();
-        void cleanup();
+        SimpleProcessor(const Eigen::Matrix3d& rotation, const Eigen::Vector3d& translation)
+            : rotation_(rotation), translation_(translation) {}
+
+        /// Rotation by angle radians about the z axis, then translation
+        static SimpleProcessor rotation_z(double angle, const Eigen::Vector3d& translation = Eigen::Vector3d::Zero()) {
+            return SimpleProcessor(Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ()).toRotationMatrix(), translation);
+        }
+
+        /// out = points * R^T + t; out must have the shape of points (N x 3)
+        void process(const Eigen::Ref<const Points>& points, Eigen::Ref<Points> out) {
+            out.noalias() = points * rotation_.transpose();
+            out.rowwise() += translation_.transpose();
+            processed_ += static_cast<size_t>(points.rows());
+        }
+
+        /// Mean of the points
+        static Eigen::Vector3d centroid(const Eigen::Ref<const Points>& points) {
+            return points.colwise().mean().transpose();
+        }
+
+        /// Points transformed so far
+        size_t processed() const { return processed_; }
+
+    private:
+        Eigen::Matrix3d rotation_;
+        Eigen::Vector3d translation_;
+        size_t processed_ = 0;
     };
 }
@@ -1,42 +1,83 @@
 #include "dora-node-api.h"
+#include "doracxx_eigen.h"
+#include "doracxx_output_buffer.h"
+
+#include "simple_processor.h"
+
+#include <cmath>
+#include <cstdint>
 #include <iostream>
-#include <chrono>
-#include <thread>
+#include <string>
+
+// Points in the cloud generated on each tick when no "points" input is connected
+constexpr Eigen::Index kTickPoints = 4096;
 
-// Include Eigen3 for matrix operations
-#include <Eigen/Dense>
+// Fill out with a ring of points, as a lidar driver would write its scan
+static void generate_cloud(Eigen::Ref<example::Points> out, uint64_t tick) {
+    for (Eigen::Index i = 0; i < out.rows(); ++i) {
+        const double angle = 2.0 * EIGEN_PI * static_cast<double>(i) / static_cast<double>(out.rows());
+        out.row(i) << std::cos(angle), std::sin(angle), 0.01 * static_cast<double>(tick % 100);
+    }
+}
 
 int main() {
     std::cout << "Starting simple Dora C++ node with Eigen3..." << std::endl;
-    
-    // Demonstrate Eigen3 usage
-    std::cout << "Creating a 3x3 matrix with Eigen3:" << std::endl;
-    
-    Eigen::Matrix3d matrix;
-    matrix << 1, 2, 3,
-              4, 5, 6,
-              7, 8, 9;
-    
-    std::cout << "Matrix:\n" << matrix << std::endl;
-    
-    // Compute determinant
-    double det = matrix.determinant();
-    std::cout << "Determinant: " << det << std::endl;
-    
-    // Create a vector
-    Eigen::Vector3d vector(1, 2, 3);
-    std::cout << "Vector: " << vector.transpose() << std::endl;
-    
-    // Matrix-vector multiplication
-    Eigen::Vector3d result = matrix * vector;
-    std::cout << "Matrix * Vector: " << result.transpose() << std::endl;
-    
-    // Simulate some work
-    for (int i = 0; i < 5; ++i) {
-        std::cout << "Processing iteration " << (i + 1) << "/5" << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    auto dora_node = init_dora_node();
+    auto processor = example::SimpleProcessor::rotation_z(EIGEN_PI / 4, Eigen::Vector3d(0.5, 0.0, 0.0));
+    doracxx::output::BufferPool pool;
+    uint64_t ticks = 0;
+
+    // Transform points into a pooled buffer and send it as the "result" tensor
+    auto send_result = [&](const Eigen::Ref<const example::Points>& points) {
+        auto result = pool.acquire(doracxx::eigen::tensor_bytes<double>(points.size()));
+        auto out = doracxx::eigen::write_tensor<double, Eigen::RowMajor>(result, points.rows(), 3);
+        processor.process(points, out);
+        auto sent = result.send(dora_node.send_output, "result");
+        if (!std::string(sent.error).empty()) {
+            std::cerr << "[ERROR] Failed to send output: " << std::string(sent.error) << std::endl;
+        }
+    };
+
+    for (;;) {
+        auto event = dora_node.events->next();
+        auto ty = event_type(event);
+
+        if (ty == DoraEventType::AllInputsClosed) {
+            break;
+        }
+        else if (ty == DoraEventType::Input) {
+            auto input = event_as_input(std::move(event));
+            const std::string id(input.id);
+
+            if (id == "points") {
+                // N x 3 doubles sent by another node with doracxx_eigen.h, mapped without a copy
+                auto points = doracxx::eigen::view_tensor<double, Eigen::RowMajor>(input.data);
+                if (!points.ok() || points.cols() != 3) {
+                    std::cerr << "[WARN] Ignoring points input: "
+                              << (points.ok() ? "expected 3 columns" : points.error) << std::endl;
+                    continue;
+                }
+                send_result(points.matrix);
+            }
+            else if (id == "tick") {
+                auto cloud = pool.acquire(doracxx::eigen::tensor_bytes<double>(kTickPoints * 3));
+                auto points = doracxx::eigen::write_tensor<double, Eigen::RowMajor>(cloud, kTickPoints, 3);
+                generate_cloud(points, ticks++);
+                send_result(points);
+                if (ticks % 10 == 1) {
+                    std::cout << "tick " << ticks << ": centroid "
+                              << example::SimpleProcessor::centroid(points).transpose() << ", "
+                              << pool.allocations() << " buffer allocations for "
+                              << processor.processed() << " points" << std::endl;
+                }
+            }
+        }
+        else {
+            std::cerr << "[WARN] Unknown event type " << static_cast<int>(ty) << std::endl;
+        }
     }
-    
+
     std::cout << "Simple node with Eigen3 completed successfully!" << std::endl;
     return 0;
 }
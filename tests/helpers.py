@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Shared helpers for the doracxx test scripts
+
+Each tests/test_*.py script imports this module first: it puts the
+repository on sys.path, and provides the temporary project directories, the
+C++ compile-and-run helper and the runner the scripts have in common.
+"""
+
+import shutil
+import subprocess
+import sys
+import tempfile
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Callable, Dict, Iterable, List, Optional, Tuple
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+SUPPORT_DIR = REPO_ROOT / "doracxx" / "support"
+# Stand-in dora-node-api.h for compiling nodes and support headers
+STUB_DIR = Path(__file__).resolve().parent / "stubs"
+
+sys.path.insert(0, str(REPO_ROOT))
+
+
+@contextmanager
+def temp_dir():
+    """A temporary directory as a Path, removed afterwards"""
+    with tempfile.TemporaryDirectory() as tmp:
+        yield Path(tmp)
+
+
+def write_files(root: Path, files: Dict[str, str]) -> Path:
+    """Write files (relative path -> text) under root, creating directories"""
+    for rel, text in files.items():
+        path = root / rel
+        path.parent.mkdir(parents=True, exist_ok=True)
+        path.write_text(text)
+    return root
+
+
+def find_cxx(gcc_only: bool = False) -> Optional[str]:
+    """g++ (or clang++ unless gcc_only) from PATH"""
+    return shutil.which("g++") or (None if gcc_only else shutil.which("clang++"))
+
+
+def find_eigen() -> Optional[Path]:
+    """Include directory of a system Eigen 3 install"""
+    for directory in (Path("/usr/include/eigen3"), Path("/usr/local/include/eigen3"), Path("/opt/homebrew/include/eigen3")):
+        if (directory / "Eigen" / "Core").exists():
+            return directory
+    return None
+
+
+def find_arrow() -> Optional[Tuple[List[str], List[str]]]:
+    """(compile flags, libraries) of an Arrow C++ install known to pkg-config"""
+    if not shutil.which("pkg-config"):
+        return None
+    # Arrow 16 moved the compute kernels into their own library
+    packages = ["arrow"]
+    if subprocess.run(["pkg-config", "--exists", "arrow-compute"]).returncode == 0:
+        packages.append("arrow-compute")
+    cflags = subprocess.run(["pkg-config", "--cflags", *packages], capture_output=True, text=True)
+    libs = subprocess.run(["pkg-config", "--libs", *packages], capture_output=True, text=True)
+    if cflags.returncode != 0 or libs.returncode != 0:
+        return None
+    return cflags.stdout.split(), libs.stdout.split()
+
+
+def skipped(reason: str) -> bool:
+    """Report a skipped check; tests return this"""
+    print(f"  (skipped: {reason})")
+    return True
+
+
+def compile_cxx(cc: str, out_dir: Path, name: str, sources: Iterable = (), source_text: Optional[str] = None,
+                std: str = "c++17", flags: Iterable[str] = (), include_dirs: Iterable = (),
+                stub: bool = False, libs: Iterable[str] = ()) -> Path:
+    """Compile and link an executable out_dir/name with the support headers on the include path
+
+    source_text, when given, is written to out_dir/<name>.cc and goes ahead
+    of the other sources (and libraries) on the command line. stub puts the
+    stand-in dora-node-api.h first on the include path. libs follow the
+    sources.
+    """
+    sources = [str(s) for s in sources]
+    if source_text is not None:
+        source = out_dir / f"{name}.cc"
+        source.write_text(source_text)
+        sources.insert(0, str(source))
+    includes = ([STUB_DIR] if stub else []) + [SUPPORT_DIR] + list(include_dirs)
+    exe = out_dir / name
+    cmd = [cc, f"-std={std}", "-O1", "-pthread", "-Wall", *flags, *(f"-I{d}" for d in includes), *sources,
+           *libs, "-o", str(exe)]
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise AssertionError(f"compiling {name} failed:\n{result.stdout}{result.stderr}")
+    return exe
+
+
+def run_exe(exe: Path, *args: str, env: Optional[Dict[str, str]] = None,
+            check: bool = True) -> subprocess.CompletedProcess:
+    """Run a test executable, capturing its output as text"""
+    result = subprocess.run([str(exe), *args], env=env, capture_output=True, text=True, timeout=120)
+    if check and result.returncode != 0:
+        raise AssertionError(f"{Path(exe).name} exited with {result.returncode}:\n{result.stdout}{result.stderr}")
+    return result
+
+
+def run_tests(title: str, tests: List[Callable]) -> int:
+    """Run test functions, print a summary and return the exit code
+
+    A test fails by raising or returning False.
+    """
+    print("=" * 50)
+    print(title)
+    print("=" * 50)
+
+    passed = 0
+    failed = 0
+    for test in tests:
+        try:
+            result = test()
+            if result is not False:
+                passed += 1
+            else:
+                failed += 1
+        except Exception as e:
+            print(f"✗ {test.__name__} failed with exception: {e}")
+            failed += 1
+        print()
+
+    print("=" * 50)
+    print(f"RESULTS: {passed} passed, {failed} failed")
+    if failed == 0:
+        print("🎉 All tests passed!")
+        return 0
+    print("❌ Some tests failed. Please check the implementation.")
+    return 1
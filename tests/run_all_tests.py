@@ -8,6 +8,19 @@ import subprocess
 import sys
 from pathlib import Path
 
+# Scripts testing the build features, with their summary names
+FEATURE_TESTS = [
+    ("test_incremental.py", "Incremental compilation tests"),
+    ("test_jobs.py", "Job scheduler and workspace tests"),
+    ("test_object_cache.py", "Object cache tests"),
+    ("test_optimization.py", "Optimization tests"),
+    ("test_linker.py", "Linker and binary size tests"),
+    ("test_prepare.py", "Dora and Arrow preparation tests"),
+    ("test_support_headers.py", "Support header tests"),
+    ("test_bench.py", "Bench tests"),
+    ("test_examples.py", "Example and support header compile checks"),
+]
+
 def run_test_script(script_name, description):
     """Execute a test script"""
     print(f"\n{'='*60}")
@@ -38,6 +51,11 @@ def main():
     success = run_test_script("test_mock.py", "Tests with simulated Dora environment")
     tests_results.append(("Simulated tests", success))
     
+    # Test 3: Build features, one script each
+    for script, description in FEATURE_TESTS:
+        success = run_test_script(script, description)
+        tests_results.append((description, success))
+    
     # Final summary
     print(f"\n{'='*60}")
     print("📊 FINAL TEST SUMMARY")
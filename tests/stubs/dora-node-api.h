@@ -0,0 +1,186 @@
+// dora-node-api.h - stand-in for Dora's C++ node API in the doracxx tests
+//
+// Declares the part of the cxx-generated API that the support headers, the
+// node templates and the examples use, with the same shapes: init_dora_node(),
+// events->next(), event_type(), event_as_input(), send_output() and the
+// rust::Slice / String / Vec / Box types.
+//
+// The event stream is scripted. init_dora_node() delivers the inputs listed
+// in DORA_STUB_INPUTS (comma separated ids, default "tick,tick,tick"), each
+// carrying its id as data, DORA_STUB_INTERVAL_US apart, then AllInputsClosed.
+// Tests driving the API themselves fill Events::script instead. Outputs are
+// recorded in the OutputSender; the one of init_dora_node() prints
+// "[stub] sent <outputs> outputs, <bytes> bytes" to stderr when destroyed.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define CXXBRIDGE1_RUST_SLICE
+
+namespace rust {
+
+template <typename T>
+class Slice {
+public:
+    Slice() noexcept = default;
+    Slice(T* data, size_t size) noexcept : data_(data), size_(size) {}
+    T* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    size_t length() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    T& operator[](size_t i) const noexcept { return data_[i]; }
+    T* begin() const noexcept { return data_; }
+    T* end() const noexcept { return data_ + size_; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+class String {
+public:
+    String() = default;
+    String(const std::string& value) : value_(value) {}
+    String(const char* value) : value_(value) {}
+    explicit operator std::string() const { return value_; }
+    const char* data() const noexcept { return value_.data(); }
+    size_t size() const noexcept { return value_.size(); }
+    size_t length() const noexcept { return value_.size(); }
+
+private:
+    std::string value_;
+};
+
+template <typename T>
+class Vec : public std::vector<T> {
+public:
+    using std::vector<T>::vector;
+};
+
+template <typename T>
+class Box {
+public:
+    explicit Box(T value) : ptr_(new T(std::move(value))) {}
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_.get(); }
+
+private:
+    std::unique_ptr<T> ptr_;
+};
+
+}  // namespace rust
+
+enum class DoraEventType : uint8_t { Stop, Input, InputClosed, Error, Unknown, AllInputsClosed };
+
+struct DoraEvent {
+    DoraEventType type = DoraEventType::AllInputsClosed;
+    std::string id;
+    std::vector<uint8_t> data;
+};
+
+struct DoraInput {
+    rust::String id;
+    rust::Vec<uint8_t> data;
+};
+
+struct DoraResult {
+    rust::String error;
+};
+
+struct Events {
+    // handed out in order; AllInputsClosed once empty
+    std::deque<DoraEvent> script;
+    std::chrono::microseconds interval{0};
+    // events handed out so far; other threads may watch it
+    std::atomic<size_t> read{0};
+
+    Events() = default;
+    Events(Events&& other) : script(std::move(other.script)), interval(other.interval), read(other.read.load()) {}
+
+    void input(std::string id, std::vector<uint8_t> data) {
+        script.push_back(DoraEvent{DoraEventType::Input, std::move(id), std::move(data)});
+    }
+
+    rust::Box<DoraEvent> next() {
+        if (read++ && interval.count()) {
+            std::this_thread::sleep_for(interval);
+        }
+        if (script.empty()) {
+            return rust::Box<DoraEvent>(DoraEvent{});
+        }
+        DoraEvent event = std::move(script.front());
+        script.pop_front();
+        return rust::Box<DoraEvent>(std::move(event));
+    }
+};
+
+struct OutputSender {
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> sent;
+    bool report = false;
+
+    ~OutputSender() {
+        if (report) {
+            size_t bytes = 0;
+            for (const auto& output : sent) {
+                bytes += output.second.size();
+            }
+            std::fprintf(stderr, "[stub] sent %zu outputs, %zu bytes\n", sent.size(), bytes);
+        }
+    }
+};
+
+struct DoraNode {
+    rust::Box<Events> events;
+    rust::Box<OutputSender> send_output;
+};
+
+inline DoraNode init_dora_node() {
+    DoraNode node{rust::Box<Events>(Events{}), rust::Box<OutputSender>(OutputSender{})};
+    node.send_output->report = true;
+    const char* inputs = std::getenv("DORA_STUB_INPUTS");
+    std::string ids = inputs ? inputs : "tick,tick,tick";
+    for (size_t start = 0; start < ids.size();) {
+        size_t end = ids.find(',', start);
+        end = end == std::string::npos ? ids.size() : end;
+        if (end > start) {
+            const std::string id = ids.substr(start, end - start);
+            node.events->input(id, std::vector<uint8_t>(id.begin(), id.end()));
+        }
+        start = end + 1;
+    }
+    if (const char* interval = std::getenv("DORA_STUB_INTERVAL_US")) {
+        node.events->interval = std::chrono::microseconds(std::strtoll(interval, nullptr, 10));
+    }
+    return node;
+}
+
+inline DoraEventType event_type(const rust::Box<DoraEvent>& event) { return event->type; }
+
+inline DoraInput event_as_input(rust::Box<DoraEvent> event) {
+    return DoraInput{rust::String(event->id), rust::Vec<uint8_t>(event->data.begin(), event->data.end())};
+}
+
+inline DoraResult send_output(rust::Box<OutputSender>& sender, rust::String id, rust::Slice<const uint8_t> data) {
+    sender->sent.emplace_back(std::string(id), std::vector<uint8_t>(data.begin(), data.end()));
+    return DoraResult{};
+}
+
+// Arrow C Data Interface entry points, for doracxx_arrow_bridge.h
+inline DoraResult event_as_arrow_input(rust::Box<DoraEvent>, uint8_t*, uint8_t*) {
+    return DoraResult{"arrow inputs are not scripted by the stub"};
+}
+
+inline DoraResult send_arrow_output(rust::Box<OutputSender>&, rust::String, uint8_t*, uint8_t*) {
+    return DoraResult{"arrow outputs are not recorded by the stub"};
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+Tests for doracxx bench and doracxx_bench.h
+"""
+
+import sys
+
+from helpers import compile_cxx, find_cxx, run_exe, run_tests, skipped, temp_dir, write_files
+
+
+def test_bench_harness():
+    """Test doracxx bench: source selection, doracxx_bench.h and the baseline comparison"""
+    print("[TEST] Testing bench harness...")
+
+    import json
+    from doracxx.bench import BENCH_MAIN, bench_sources, compare_results
+    from doracxx.build_cxx_node import discover_node_sources
+    from doracxx.config import load_config
+
+    baseline = {"benchmarks": [{"name": "a", "events_per_second": 1000.0, "p50_ns": 100, "p99_ns": 200,
+                                "allocations_per_event": 0.0}]}
+    same = {"benchmarks": [dict(baseline["benchmarks"][0], p99_ns=210, allocations_per_event=0.5)]}
+    assert compare_results(same, baseline, 10.0) == []
+    slower = {"benchmarks": [dict(baseline["benchmarks"][0], events_per_second=800.0, p99_ns=300,
+                                  allocations_per_event=2.0)]}
+    regressions = compare_results(slower, baseline, 10.0)
+    assert len(regressions) == 3, regressions
+    assert compare_results({"benchmarks": [{"name": "new", "p99_ns": 1}]}, baseline, 10.0) == []
+
+    with temp_dir() as tmp:
+        write_files(tmp, {
+            "doracxx.toml": '[node]\nname = "n"\n[bench]\nsizes = [16, 256]\n',
+            "src/node.cc": '#include "work.h"\nint main() { return work(1) == 2 ? 0 : 1; }\n',
+            "src/work.h": "#include <cstddef>\n#include <vector>\nsize_t work(size_t n);\n",
+            "src/work.cc": '#include "work.h"\nsize_t work(size_t n) { std::vector<size_t> v(n, 2); return v[0] * n; }\n',
+            "bench/work_bench.cc": """
+#include "doracxx_bench.h"
+#include "work.h"
+DORACXX_BENCHMARK(work) {
+    run.each_input([&](const doracxx::bench::Input& input) {
+        doracxx::bench::do_not_optimize(work(input.data.size()));
+    });
+}
+""",
+        })
+        config = load_config(tmp / "doracxx.toml")
+        # The node itself leaves the benchmarks out, the bench executable its main()
+        assert sorted(p.name for p in discover_node_sources(tmp, config)) == ["node.cc", "work.cc"]
+        srcs = bench_sources(tmp, config)
+        assert [p.name for p in srcs] == ["work.cc", "work_bench.cc"], srcs
+
+        cc = find_cxx(gcc_only=True)
+        if not cc:
+            return skipped("bench run needs g++")
+
+        exe = compile_cxx(cc, tmp, "n-bench", srcs, source_text=BENCH_MAIN, flags=["-O2"],
+                          include_dirs=[tmp / "src"])
+        results_path = tmp / "results.json"
+        run_exe(exe, "--events", "500", "--warmup", "10", "--sizes", "16,256", "--json", str(results_path))
+        results = json.loads(results_path.read_text())
+        [work] = results["benchmarks"]
+        assert work["name"] == "work" and work["events"] == 500, work
+        # One vector per event, of 16 or 256 size_t in turn
+        assert work["allocations_per_event"] == 1.0, work
+        assert work["allocated_bytes_per_event"] == (16 + 256) * 8 / 2, work
+        assert work["p50_ns"] <= work["p99_ns"] <= work["p999_ns"] <= work["max_ns"], work
+        assert compare_results(results, results, 0.0) == []
+
+        bad = run_exe(exe, "--filter", "missing", check=False)
+        assert bad.returncode == 2, bad
+
+    print("✓ Bench harness works correctly")
+
+
+TESTS = [
+    test_bench_harness,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Bench Tests", TESTS))
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Compile checks of the example nodes and the support headers against the stand-in Dora API
+"""
+
+import os
+import sys
+
+from helpers import (REPO_ROOT, SUPPORT_DIR, compile_cxx, find_arrow, find_cxx, find_eigen, run_exe, run_tests,
+                     skipped, temp_dir)
+
+EXAMPLES_DIR = REPO_ROOT / "examples"
+
+
+def test_support_headers_compile():
+    """Test that every support header compiles on its own, free of warnings"""
+    print("[TEST] Testing support headers compile...")
+
+    cc = find_cxx(gcc_only=True)
+    if not cc:
+        return skipped("needs g++")
+
+    eigen = find_eigen()
+    arrow = find_arrow()
+    checked = []
+    with temp_dir() as tmp:
+        for header in sorted(SUPPORT_DIR.glob("*.h")):
+            std = "c++20" if header.name == "doracxx_async.h" else "c++17"
+            flags = ["-Wextra", "-Werror"]
+            include_dirs = []
+            libs = []
+            if header.name == "doracxx_eigen.h":
+                if not eigen:
+                    continue
+                include_dirs.append(eigen)
+            if header.name.startswith("doracxx_arrow_"):
+                if not arrow:
+                    continue
+                flags += arrow[0]
+                libs = arrow[1]
+            name = header.stem
+            compile_cxx(cc, tmp, name, std=std, flags=flags, include_dirs=include_dirs, stub=True, libs=libs,
+                        source_text=f'#include "dora-node-api.h"\n#include "{header.name}"\nint main() {{}}\n')
+            checked.append(header.name)
+
+    # the ones without third-party dependencies are always checked
+    for header in ("doracxx_async.h", "doracxx_bench.h", "doracxx_event_batch.h", "doracxx_log.h", "doracxx_metrics.h",
+                   "doracxx_output_buffer.h", "doracxx_worker_pool.h"):
+        assert header in checked, checked
+    if not arrow:
+        print("  (Arrow headers skipped: no Arrow C++ found by pkg-config)")
+
+    print("✓ Support headers compile correctly")
+
+
+def test_simple_node_example():
+    """Test that the simple-node example builds and runs against the stand-in API"""
+    print("[TEST] Testing simple-node example...")
+
+    cc = find_cxx(gcc_only=True)
+    eigen = find_eigen()
+    if not cc or not eigen:
+        return skipped("needs g++ and Eigen")
+
+    example = EXAMPLES_DIR / "simple-node"
+    with temp_dir() as tmp:
+        exe = compile_cxx(cc, tmp, "simple-node", [example / "src" / "node.cc"], flags=["-Wextra"],
+                          include_dirs=[example / "include", eigen], stub=True)
+        run_exe(exe, env={**os.environ, "DORA_STUB_INPUTS": "tick,tick,tick"})
+
+    print("✓ simple-node example works correctly")
+
+
+def test_arrow_node_example():
+    """Test that the arrow-node example and its benchmarks build against the stand-in API"""
+    print("[TEST] Testing arrow-node example...")
+
+    cc = find_cxx(gcc_only=True)
+    arrow = find_arrow()
+    if not cc or not arrow:
+        return skipped("needs g++ and an Arrow C++ install known to pkg-config")
+
+    example = EXAMPLES_DIR / "arrow-node"
+    with temp_dir() as tmp:
+        exe = compile_cxx(cc, tmp, "arrow-node", sorted((example / "src").glob("*.cc")), flags=["-Wextra", *arrow[0]],
+                          include_dirs=[example / "include"], stub=True, libs=arrow[1])
+        # the stand-in API has no Arrow inputs: the node reports them and carries on
+        run_exe(exe, env={**os.environ, "DORA_STUB_INPUTS": "data,data"})
+
+    print("✓ arrow-node example works correctly")
+
+
+TESTS = [
+    test_support_headers_compile,
+    test_simple_node_example,
+    test_arrow_node_example,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Example Tests", TESTS))
@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""
+Tests for per-translation-unit incremental compilation, build.ninja generation, the build manifest and header sync
+"""
+
+import os
+import sys
+import time
+from pathlib import Path
+
+from helpers import find_cxx, run_tests, skipped, temp_dir, write_files
+
+
+def test_parse_depfile():
+    """Test Makefile depfile parsing"""
+    print("[TEST] Testing depfile parsing...")
+
+    from doracxx.incremental import parse_depfile
+
+    text = "obj/main.cc.o: src/main.cc include/a.h \\\n  include/with\\ space.h \\\n  deps/dora-node-api.h\n\ninclude/a.h:\n"
+    deps = parse_depfile(text)
+    assert deps == ["src/main.cc", "include/a.h", "include/with space.h", "deps/dora-node-api.h"], deps
+
+    print("✓ Depfile parsing works correctly")
+
+
+def test_source_dependencies():
+    """Test MSVC /sourceDependencies JSON parsing"""
+    print("[TEST] Testing /sourceDependencies parsing...")
+
+    from doracxx.incremental import parse_source_dependencies
+
+    text = '{"Version": "1.1", "Data": {"Source": "c:\\\\node\\\\src\\\\main.cc", "Includes": ["c:\\\\node\\\\deps\\\\dora-node-api.h"]}}'
+    deps = parse_source_dependencies(text)
+    assert deps == ["c:\\node\\src\\main.cc", "c:\\node\\deps\\dora-node-api.h"], deps
+
+    print("✓ /sourceDependencies parsing works correctly")
+
+
+def test_object_paths():
+    """Test that sources map to distinct object paths"""
+    print("[TEST] Testing object path mapping...")
+
+    from doracxx.incremental import plan_translation_units
+
+    node_dir = Path("/tmp/node")
+    obj_dir = node_dir / "target" / "debug" / "build" / "obj"
+    srcs = [
+        node_dir / "src" / "node.cc",
+        node_dir / "src" / "node.c",
+        Path("/cache/dora/target/cxxbridge/dora-node-api-cxx/src/lib.rs.cc"),
+        Path("/cache/dora/target/cxxbridge/dora-operator-api-cxx/src/lib.rs.cc"),
+    ]
+    units = plan_translation_units(srcs, node_dir, obj_dir, "gcc")
+    objs = [u.obj for u in units]
+    assert len(set(objs)) == len(objs), objs
+    assert objs[0] == obj_dir / "src" / "node.cc.o"
+    assert all(str(o).startswith(str(obj_dir)) for o in objs)
+
+    msvc_units = plan_translation_units(srcs[:1], node_dir, obj_dir, "msvc")
+    assert msvc_units[0].obj.suffix == ".obj"
+
+    print("✓ Object path mapping works correctly")
+
+
+def test_incremental_rebuild():
+    """Test that only out-of-date translation units are recompiled"""
+    print("[TEST] Testing incremental recompilation...")
+
+    cc = find_cxx()
+    if not cc:
+        return skipped("no gcc/clang compiler available")
+
+    from doracxx.incremental import BuildState, plan_translation_units, compile_translation_units
+    from doracxx.jobs import JobScheduler
+
+    with temp_dir() as node_dir:
+        write_files(node_dir, {
+            "include/shared.h": "#pragma once\ninline int shared() { return 1; }\n",
+            "src/a.cc": '#include "shared.h"\nint a() { return shared(); }\n',
+            "src/b.cc": "int b() { return 2; }\n",
+        })
+
+        build_dir = node_dir / "target" / "debug" / "build"
+        units = plan_translation_units(sorted((node_dir / "src").glob("*.cc")), node_dir, build_dir / "obj", "gcc")
+        flags = ["-std=c++17", "-I", str(node_dir / "include")]
+
+        def build(flags):
+            state = BuildState.load(build_dir / "state.json")
+            return compile_translation_units(cc, "gcc", flags, units, state,
+                                             JobScheduler(max_jobs=2, cwd=node_dir), cwd=node_dir)
+
+        assert build(flags) == 2
+        assert build(flags) == 0
+
+        # Touching a header only rebuilds the units that include it
+        time.sleep(0.01)
+        header = node_dir / "include" / "shared.h"
+        header.write_text("#pragma once\ninline int shared() { return 3; }\n")
+        future = time.time() + 2
+        os.utime(header, (future, future))
+        assert build(flags) == 1
+
+        # Changing flags rebuilds everything
+        assert build(flags + ["-DDORACXX_TEST=1"]) == 2
+
+    print("✓ Incremental recompilation works correctly")
+
+
+def test_ninja_generation():
+    """Test build.ninja generation for the ninja backend"""
+    print("[TEST] Testing build.ninja generation...")
+
+    from doracxx.incremental import plan_translation_units
+    from doracxx.ninja_backend import generate_ninja, write_ninja_file, escape_path
+
+    assert escape_path("C:/a b/$x") == "C$:/a$ b/$$x"
+
+    with temp_dir() as node_dir:
+        build_dir = node_dir / "target" / "debug" / "build"
+        units = plan_translation_units([node_dir / "src" / "main.cc"], node_dir, build_dir / "obj", "gcc")
+        out = node_dir / "target" / "debug" / "node"
+        content = generate_ninja("g++", "gcc", ["-std=c++17", "-DNAME=$HOME"], units, ["g++"],
+                                 ["-lfoo", "-o", str(out)], out, [str(node_dir / "libfoo.a")], cwd=node_dir)
+        assert "deps = gcc" in content
+        assert "depfile = $out.d" in content
+        assert "-DNAME=$$HOME" in content
+        assert f"build {escape_path(units[0].obj)}: cxx {escape_path(units[0].source)}" in content
+        assert f"| {escape_path(node_dir / 'libfoo.a')}" in content
+
+        ninja_file = write_ninja_file(build_dir, content)
+        mtime = ninja_file.stat().st_mtime_ns
+        time.sleep(0.01)
+        write_ninja_file(build_dir, content)
+        assert ninja_file.stat().st_mtime_ns == mtime, "unchanged build.ninja was rewritten"
+
+        msvc = generate_ninja("cl", "msvc", ["/nologo"], units, ["cl", "/nologo"], ["/link"], out, [], cwd=node_dir)
+        assert "deps = msvc" in msvc and "/showIncludes" in msvc
+
+    print("✓ build.ninja generation works correctly")
+
+
+def test_build_manifest():
+    """Test that the build manifest is reused only while its inputs are unchanged"""
+    print("[TEST] Testing build manifest reuse...")
+
+    from doracxx.config import DoracxxConfig, NodeConfig
+    from doracxx.linker import linker_binaries
+    from doracxx.manifest import BuildManifest, build_fingerprint, package_digest
+
+    with temp_dir() as tmp:
+        header = tmp / "lib.rs.h"
+        header.write_text("// bridge\n")
+        config = DoracxxConfig(node=NodeConfig(name="node"))
+        fingerprint = build_fingerprint(node_dir=str(tmp), profile="debug", config=config)
+
+        manifest = BuildManifest.load(tmp / "manifest.json")
+        assert manifest.stale_reason(fingerprint) == "no manifest"
+        manifest.update(fingerprint, {"cc": "g++", "compile_flags": ["-std=c++17"]}, [header, tmp / "missing"])
+
+        manifest = BuildManifest.load(tmp / "manifest.json")
+        assert manifest.stale_reason(fingerprint) is None
+        assert manifest.resolved["compile_flags"] == ["-std=c++17"]
+
+        config.build.cxxflags.append("-O2")
+        changed = build_fingerprint(node_dir=str(tmp), profile="debug", config=config)
+        assert manifest.stale_reason(changed) == "configuration changed"
+
+        # another linker behind the same name resolves the build again
+        relinked = build_fingerprint(node_dir=str(tmp), profile="debug", config=config,
+                                     linkers={"ld.lld": "/usr/lib/llvm-16/bin/lld"})
+        assert relinked != build_fingerprint(node_dir=str(tmp), profile="debug", config=config,
+                                             linkers={"ld.lld": "/usr/lib/llvm-17/bin/lld"})
+        assert set(linker_binaries()) >= {"ld", "mold", "ld.lld", "ld.gold", "lld-link"}
+
+        # every doracxx module, not only the resolution code, is covered
+        digest = package_digest()
+        assert len(digest) == 64 and digest == package_digest()
+
+        future = time.time() + 2
+        os.utime(header, (future, future))
+        assert "lib.rs.h" in manifest.stale_reason(fingerprint)
+
+    print("✓ Build manifest reuse works correctly")
+
+
+def test_header_sync():
+    """Test that header sync copies changed headers only and removes stale ones"""
+    print("[TEST] Testing header sync...")
+
+    from doracxx.build_cxx_node import sync_project_headers, sync_headers
+
+    with temp_dir() as tmp:
+        node = write_files(tmp / "node", {
+            "include/a.h": "// a\n",
+            "include/detail/b.hpp": "// b\n",
+            "include/notes.txt": "not a header\n",
+        })
+        include = tmp / "target" / "include"
+        write_files(include, {"user.h": "// placed by hand\n"})
+
+        sync_project_headers(node, include)
+        assert (include / "a.h").read_text() == "// a\n"
+        assert (include / "detail" / "b.hpp").exists()
+        assert not (include / "notes.txt").exists()
+
+        # unchanged headers keep their mtime
+        old = (include / "a.h").stat().st_mtime_ns
+        time.sleep(0.01)
+        sync_project_headers(node, include)
+        assert (include / "a.h").stat().st_mtime_ns == old
+
+        # a header with the same size but new content is copied again
+        time.sleep(0.01)
+        (node / "include" / "a.h").write_text("// A\n")
+        sync_project_headers(node, include)
+        assert (include / "a.h").read_text() == "// A\n"
+
+        # deleted headers disappear, with the directories they leave empty;
+        # files doracxx did not put there stay
+        (node / "include" / "detail" / "b.hpp").unlink()
+        sync_project_headers(node, include)
+        assert not (include / "detail").exists()
+        assert (include / "user.h").exists()
+
+        # groups sharing a directory do not remove each other's headers
+        deps = tmp / "deps"
+        src = tmp / "lib.rs.h"
+        src.write_text("// bridge\n")
+        sync_headers({"dora-node-api.h": src}, deps, "cxxbridge")
+        sync_headers({"other.h": src}, deps, "dependencies")
+        assert (deps / "dora-node-api.h").exists() and (deps / "other.h").exists()
+        assert sync_headers({}, deps, "cxxbridge") == ([], ["dora-node-api.h"])
+        assert (deps / "other.h").exists()
+
+    print("✓ Header sync works correctly")
+
+
+TESTS = [
+    test_parse_depfile,
+    test_source_dependencies,
+    test_object_paths,
+    test_incremental_rebuild,
+    test_ninja_generation,
+    test_build_manifest,
+    test_header_sync,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Incremental Compilation Tests", TESTS))
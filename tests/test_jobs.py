@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+Tests for the job scheduler, workspace builds and build timings
+"""
+
+import os
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+from helpers import compile_cxx, find_cxx, run_exe, run_tests, temp_dir, write_files
+
+
+def test_scheduler_fail_fast():
+    """Test that a failing job stops the batch and is reported"""
+    print("[TEST] Testing job scheduler fail-fast...")
+
+    from doracxx.jobs import Job, JobScheduler
+
+    completed = []
+    jobs = [Job(label="ok", cmd=[sys.executable, "-c", "print('compiling ok')"],
+                on_success=lambda: completed.append("ok"))]
+    jobs.append(Job(label="bad", cmd=[sys.executable, "-c", "import sys; print('error: boom'); sys.exit(3)"]))
+    jobs.extend(Job(label=f"slow{i}", cmd=[sys.executable, "-c", "import time; time.sleep(30)"]) for i in range(4))
+
+    scheduler = JobScheduler(max_jobs=3)
+    start = time.monotonic()
+    try:
+        scheduler.run(jobs)
+        raise AssertionError("scheduler did not report the failing job")
+    except subprocess.CalledProcessError as e:
+        assert e.returncode == 3, e.returncode
+    assert time.monotonic() - start < 20, "running jobs were not cancelled"
+
+    print("✓ Job scheduler fail-fast works correctly")
+
+
+def test_workspace():
+    """Test dataflow parsing, workspace members, the shared cxxbridge library and the job slots"""
+    print("[TEST] Testing workspace builds...")
+
+    import threading
+    from doracxx import jobs
+    from doracxx.build_cxx_node import shared_bridge_flags, build_bridge_library, bridge_sources_to_compile
+    from doracxx.jobs import Job, JobScheduler, share_job_slots
+    from doracxx.workspace import dataflow_nodes, doracxx_build_args, workspace_members, _scan_dataflow
+
+    assert doracxx_build_args("doracxx build nodes/a --profile release") == ["nodes/a", "--profile", "release"]
+    assert doracxx_build_args("uv run -- doracxx b .") == ["."]
+    assert doracxx_build_args("cargo build -p x") is None
+
+    dataflow = """nodes:
+  - id: camera
+    build: doracxx build nodes/camera
+    path: nodes/camera/target/debug/camera
+  - id: detector
+    build: "uv run doracxx build --node-dir nodes/detector --profile release"
+  - id: plot
+    build: pip install dora-rerun
+  - id: timer
+    path: dora/timer
+"""
+    assert [n["id"] for n in _scan_dataflow(dataflow)] == ["camera", "detector", "plot", "timer"]
+
+    with temp_dir() as root:
+        (root / "dataflow.yml").write_text(dataflow)
+        nodes = dataflow_nodes(root / "dataflow.yml")
+        assert [(n.name, n.node_dir, n.args) for n in nodes] == [
+            ("camera", (root / "nodes" / "camera").resolve(), []),
+            ("detector", (root / "nodes" / "detector").resolve(), ["--profile", "release"])], nodes
+
+        for name in ["a-filter", "b-filter", "other"]:
+            (root / "nodes" / name).mkdir(parents=True)
+        (root / "doracxx.toml").write_text('[workspace]\nmembers = ["nodes/*-filter", "nodes/other"]\n')
+        assert [n.name for n in workspace_members(root / "doracxx.toml")] == ["a-filter", "b-filter", "other"]
+
+        # the node's own include dirs stay out of the shared cxxbridge flags
+        project = root / "nodes" / "camera"
+        flags = ["-std=c++17", "-I", str(project / "target" / "include"), "-I", "/opt/dora/cxxbridge",
+                 f"-I{project}/src", "-Iinclude", "-DX=1"]
+        assert shared_bridge_flags(flags, "gcc", project) == ["-std=c++17", "-I", "/opt/dora/cxxbridge", "-DX=1"]
+
+        # crates with a Dora staticlib already hold their generated sources
+        generated = root / "dora" / "target" / "cxxbridge"
+        node_api = generated / "dora-node-api-cxx" / "src" / "lib.rs.cc"
+        operator_api = generated / "dora-operator-api-cxx" / "src" / "lib.rs.cc"
+        write_files(root / "dora" / "target", {"release/libdora_node_api_cxx.a": ""})
+        assert bridge_sources_to_compile([node_api, operator_api], root / "dora" / "target", "debug", "gcc") \
+            == [operator_api]
+        assert bridge_sources_to_compile([node_api], root / "dora" / "target", "release", "msvc") == [node_api]
+        (root / "dora" / "target" / "release" / "libdora_node_api_cxx.a").unlink()
+
+        # two nodes with the same compiler and flags link one cxxbridge library
+        cxx = find_cxx()
+        if cxx and os.name != "nt":
+            dora_target = root / "dora" / "target"
+            bridge = write_files(dora_target, {"cxxbridge/lib.rs.cc": "int bridge_symbol() { return 1; }\n"}) \
+                / "cxxbridge" / "lib.rs.cc"
+            first = build_bridge_library(cxx, "gcc", "gcc", ["-O0"], [bridge], dora_target, "debug",
+                                         JobScheduler(max_jobs=1))
+            mtime = first.stat().st_mtime_ns
+            second = build_bridge_library(cxx, "gcc", "gcc", ["-O0"], [bridge], dora_target, "debug",
+                                          JobScheduler(max_jobs=1))
+            assert first == second and second.stat().st_mtime_ns == mtime
+            assert first.name == "libdoracxx_bridge.a" and first.parent.parent == dora_target / "doracxx-bridge"
+            other = build_bridge_library(cxx, "gcc", "gcc", ["-O1"], [bridge], dora_target, "release",
+                                         JobScheduler(max_jobs=1))
+            assert other != first and other.parent.name.startswith("release-")
+
+            exe = compile_cxx(cxx, root, "main", [first],
+                              source_text="int bridge_symbol();\nint main() { return bridge_symbol() - 1; }\n")
+            run_exe(exe)
+
+    # the job slots bound the commands of every scheduler together
+    running = []
+    peak = [0]
+    lock = threading.Lock()
+    for_real = jobs.subprocess.Popen
+
+    def counting_popen(*args, **kwargs):
+        with lock:
+            running.append(1)
+            peak[0] = max(peak[0], len(running))
+        process = for_real(*args, **kwargs)
+        original = process.communicate
+
+        def communicate(*a, **k):
+            try:
+                return original(*a, **k)
+            finally:
+                with lock:
+                    running.pop()
+        process.communicate = communicate
+        return process
+
+    def counting_precheck():
+        # the object cache's precheck preprocesses the unit: it holds a slot too
+        with lock:
+            running.append(1)
+            peak[0] = max(peak[0], len(running))
+        time.sleep(0.1)
+        with lock:
+            running.pop()
+        return False
+
+    sleep = [sys.executable, "-c", "import time; time.sleep(0.2)"]
+    share_job_slots(2)
+    jobs.subprocess.Popen = counting_popen
+    try:
+        schedulers = [JobScheduler(max_jobs=3) for _ in range(2)]
+        threads = [threading.Thread(target=s.run, args=([Job(f"sleep {i}", sleep, precheck=counting_precheck)
+                                                          for i in range(3)],)) for s in schedulers]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+    finally:
+        jobs.subprocess.Popen = for_real
+        share_job_slots(None)
+    assert peak[0] == 2, peak
+
+    print("✓ Workspace builds work correctly")
+
+
+def test_build_timings():
+    """Test the --timings recorder: phases, compile jobs, clang traces and the report"""
+    print("[TEST] Testing build timings...")
+
+    import json
+    from doracxx.jobs import Job, JobScheduler
+    from doracxx.timings import TIMINGS, TRACE_FILE, REPORT_FILE, phase, timed, time_trace_flags
+
+    assert time_trace_flags("clang") == ["-ftime-trace"]
+    assert time_trace_flags("gcc") == [] and time_trace_flags("msvc") == []
+
+    @timed("git")
+    def clone(url, dest):
+        return url
+
+    # Nothing is recorded unless enabled
+    clone("https://example.com/a.git", Path("a"))
+    assert TIMINGS.spans == []
+
+    TIMINGS.enable()
+    try:
+        with temp_dir() as tmp:
+            assert clone("https://example.com/a.git", Path("a")) == "https://example.com/a.git"
+            trace_file = tmp / "main.cc.json"
+            writer = ("import json, sys; json.dump({'traceEvents': ["
+                      "{'name': 'Source', 'ph': 'X', 'ts': 10, 'dur': 500, 'args': {'detail': 'vector'}},"
+                      "{'name': 'Total Source', 'ph': 'X', 'ts': 0, 'dur': 500},"
+                      "{'name': 'process_name', 'ph': 'M'}]}, open(sys.argv[1], 'w'))")
+            with phase("compile n", "build"):
+                JobScheduler(max_jobs=2).run([
+                    Job("main.cc", [sys.executable, "-c", writer, str(trace_file)], category="compile",
+                        trace_file=trace_file),
+                    Job("other.cc", [sys.executable, "-c", "pass"], category="compile",
+                        precheck=lambda: True),
+                ])
+
+            names = {s.name: s for s in TIMINGS.spans}
+            assert set(names) == {"clone", "compile n", "main.cc", "other.cc"}, names
+            assert names["clone"].category == "git" and "example.com" in names["clone"].args["detail"]
+            assert names["other.cc"].args == {"note": "restored from cache"}
+            # Only complete events are merged, offset to the start of their job
+            [source] = TIMINGS.clang_events
+            assert source["name"] == "Source" and source["tid"] == names["main.cc"].lane
+            assert source["ts"] >= names["main.cc"].start * 1e6
+
+            out = tmp / "target" / "debug"
+            TIMINGS.write(out)
+            trace = json.loads((out / TRACE_FILE).read_text())
+            phases = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+            assert len(phases) == 5, phases
+            report = (out / REPORT_FILE).read_text()
+            assert "main.cc" in report and "restored from cache" in report and "vector" in report
+    finally:
+        TIMINGS.enabled = False
+
+    print("✓ Build timings work correctly")
+
+
+TESTS = [
+    test_scheduler_fail_fast,
+    test_workspace,
+    test_build_timings,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Job and Workspace Tests", TESTS))
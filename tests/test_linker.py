@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""
+Tests for linker selection and the binary size options
+"""
+
+import os
+import sys
+from pathlib import Path
+
+from helpers import find_cxx, run_tests
+
+
+def test_size_options():
+    """Test size_opt flags, post-link strip/split commands and link map parsing"""
+    print("[TEST] Testing binary size options...")
+
+    from doracxx.optimization import size_flags
+    from doracxx.size import parse_link_map, post_link_commands, link_map_flags
+
+    gnu = size_flags("gcc", True)
+    assert gnu.compile == ["-ffunction-sections", "-fdata-sections"]
+    assert gnu.link in (["-Wl,--gc-sections"], ["-Wl,-dead_strip"])
+    msvc = size_flags("msvc", True)
+    assert msvc.linker == ["/OPT:REF", "/OPT:ICF"] and "/Gy" in msvc.compile
+    assert not size_flags("gcc", False).compile
+    assert link_map_flags("msvc", Path("m.map")) == ["/MAP:m.map"]
+
+    assert post_link_commands("gcc", Path("/t/node"), False, False) == []
+    assert post_link_commands("msvc", Path("/t/node.exe"), True, True) == []
+    split = post_link_commands("gcc", Path("/t/node"), True, True)
+    if split:  # needs objcopy
+        assert split[0][1:] == ["--only-keep-debug", "/t/node", "/t/node.debug"]
+        assert split[1][1:] == ["--strip-all", "--add-gnu-debuglink=/t/node.debug", "/t/node"]
+
+    gnu_map = """Discarded input sections
+
+ .text.unused   0x0000000000000000      0x400 /p/build/obj/main.cc.o
+
+Linker script and memory map
+
+ .interp        0x0000000000000318       0x1c /usr/lib/Scrt1.o
+ .text          0x0000000000001040       0x26 /usr/lib/Scrt1.o
+ .text._ZN5arrow10MemoryPool7DefaultEv
+                0x0000000000001100      0x200 /c/install/lib/libarrow.a(memory_pool.cc.o)
+                0x0000000000001100                _ZN5arrow10MemoryPool7DefaultEv
+ .text.main     0x0000000000001300       0x40 /p/build/obj/main.cc.o
+ *fill*         0x0000000000001340       0x10 
+ .debug_info    0x0000000000000000     0x9000 /p/build/obj/main.cc.o
+"""
+    sizes = parse_link_map(gnu_map, "/p/build/obj")
+    assert sizes == {"<linker generated>": 0x1c, "Scrt1.o": 0x26, "libarrow.a": 0x200, "<node objects>": 0x40}, sizes
+
+    lld_map = """             VMA              LMA     Size Align Out     In      Symbol
+          201000           201000      300    16 .text
+          201000           201000      200    16         /c/lib/libarrow.a(memory_pool.cc.o):(.text._ZN5arrow1fEv)
+          201200           201200       40    16         /p/build/obj/main.cc.o:(.text.main)
+               0                0      900     1         /p/build/obj/main.cc.o:(.debug_info)
+"""
+    assert parse_link_map(lld_map, "/p/build/obj") == {"libarrow.a": 0x200, "<node objects>": 0x40}
+
+    print("✓ Binary size options work correctly")
+
+
+def test_linker_selection():
+    """Test [build] linker selection and the threaded linker flags"""
+    print("[TEST] Testing linker selection...")
+
+    from doracxx.linker import select_linker, linker_flags, linker_available, probe_linker
+    from doracxx.size import parse_link_map
+
+    assert select_linker("g++", "gcc", "gcc", "system") is None
+    assert select_linker("g++", "gcc", "gcc", "bogus") is None
+    assert select_linker("cl", "msvc", "msvc", "auto") is None
+
+    assert linker_flags("gcc", "clang", "lld", 8).link == ["-fuse-ld=lld", "-Wl,--threads=8"]
+    assert linker_flags("gcc", "gcc", "mold", 4).link == ["-fuse-ld=mold", "-Wl,--thread-count=4"]
+    assert linker_flags("gcc", "gcc", None, 4).link == []
+    clang_cl = linker_flags("msvc", "clang-cl", "lld", 6)
+    assert clang_cl.link == ["-fuse-ld=lld"] and clang_cl.linker == ["/threads:6"]
+    assert linker_flags("msvc", "msvc", None, 16, lto="full").linker == ["/CGTHREADS:8"]
+
+    cxx = find_cxx()
+    if cxx and os.name != "nt":
+        chosen = select_linker(cxx, "gcc", "gcc", "auto")
+        if chosen:
+            assert linker_available(chosen) and probe_linker(cxx, chosen, linker_flags("gcc", "gcc", chosen, 1).link[1:])
+        assert not probe_linker(cxx, "no-such-linker")
+
+    # mold maps have lld's columns without the LMA
+    mold_map = """             VMA       Size Align Out                In                 Symbol
+          201000        200    16         /c/lib/libarrow.a(memory_pool.cc.o):(.text._ZN5arrow1fEv)
+"""
+    assert parse_link_map(mold_map) == {"libarrow.a": 0x200}
+
+    print("✓ Linker selection works correctly")
+
+
+TESTS = [
+    test_size_options,
+    test_linker_selection,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Linker Tests", TESTS))
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Tests for the built-in object cache and precompiled headers
+"""
+
+import os
+import sys
+import time
+from pathlib import Path
+
+from helpers import find_cxx, run_tests, skipped, temp_dir, write_files
+
+
+def test_object_cache():
+    """Test that the built-in object cache is shared between checkouts"""
+    print("[TEST] Testing built-in object cache...")
+
+    cc = find_cxx()
+    if not cc:
+        return skipped("no gcc/clang compiler available")
+
+    from doracxx.incremental import BuildState, plan_translation_units, compile_translation_units
+    from doracxx.jobs import JobScheduler
+    from doracxx.object_cache import ObjectCache, key_flags
+
+    assert key_flags(["-std=c++17", "-I", "/a", "-I/b", "-DX=1"]) == ["-std=c++17", "-DX=1"]
+
+    # base dirs are stripped only up to a path separator
+    stripping = ObjectCache(root=Path("/tmp/objects"), base_dirs=[Path("/home/a/node")])
+    assert stripping._strip_base_dirs('# 1 "/home/a/node/src/a.cc"') == '# 1 "/src/a.cc"'
+    assert stripping._strip_base_dirs('# 1 "/home/a/node-utils/u.h"') == '# 1 "/home/a/node-utils/u.h"'
+    assert stripping._strip_base_dirs("-fprofile-use=/home/a/node\\pgo") == "-fprofile-use=\\pgo"
+
+    with temp_dir() as tmp:
+        store = tmp / "objects"
+        caches = []
+        for checkout in ("a", "b"):
+            node_dir = write_files(tmp / checkout, {
+                "include/shared.h": "#pragma once\ninline int shared() { return 1; }\n",
+                "src/a.cc": '#include "shared.h"\nint a() { return shared(); }\n',
+            })
+
+            build_dir = node_dir / "target" / "debug" / "build"
+            units = plan_translation_units([node_dir / "src" / "a.cc"], node_dir, build_dir / "obj", "gcc")
+            cache = ObjectCache(root=store, base_dirs=[node_dir])
+            state = BuildState.load(build_dir / "state.json")
+            compile_translation_units(cc, "gcc", ["-std=c++17", "-I", str(node_dir / "include")], units, state,
+                                      JobScheduler(max_jobs=1, cwd=node_dir), cwd=node_dir, object_cache=cache)
+            assert units[0].obj.exists()
+            assert state.objects[str(units[0].obj)]["deps"], "dependencies not recorded"
+            caches.append(cache)
+
+        assert (caches[0].hits, caches[0].misses) == (0, 1)
+        assert (caches[1].hits, caches[1].misses) == (1, 0), "second checkout did not reuse the object"
+
+    print("✓ Built-in object cache works correctly")
+
+
+def test_precompiled_header():
+    """Test precompiled header planning and use"""
+    print("[TEST] Testing precompiled headers...")
+
+    from doracxx.incremental import BuildState, plan_translation_units, compile_translation_units
+    from doracxx.jobs import JobScheduler
+    from doracxx.pch import plan_pch, apply_pch
+
+    with temp_dir() as node_dir:
+        pch_dir = node_dir / "target" / "debug" / "build" / "pch"
+
+        msvc = plan_pch("cl", "msvc", "msvc", ["/nologo"], ["dora-node-api.h"], pch_dir)
+        assert "/Ycdoracxx_pch.h" in msvc.unit.command
+        assert "/Yudoracxx_pch.h" in msvc.use_flags and msvc.link_objects == [msvc.unit.obj]
+        c_units = plan_translation_units([node_dir / "a.c", node_dir / "b.cc"], node_dir, node_dir / "obj", "msvc")
+        apply_pch(msvc, c_units, "msvc", "msvc")
+        assert not c_units[0].extra_flags and c_units[1].extra_flags == msvc.use_flags
+
+        clang = plan_pch("clang++", "gcc", "clang", [], ["<vector>"], pch_dir)
+        assert clang.use_flags[0] == "-include-pch"
+        assert '#include <vector>' in (pch_dir / "doracxx_pch.h").read_text()
+
+        cc = find_cxx(gcc_only=True)
+        if not cc:
+            return skipped("g++ not available")
+
+        write_files(node_dir, {
+            "include/big.h": "#pragma once\n#include <vector>\ninline int big() { return 4; }\n",
+            "src/a.cc": "int a() { return big(); }\n",
+        })
+        flags = ["-std=c++17", "-I", str(node_dir / "include")]
+        pch = plan_pch(cc, "gcc", "gcc", flags, ["big.h"], pch_dir)
+        units = plan_translation_units([node_dir / "src" / "a.cc"], node_dir, node_dir / "obj", "gcc")
+        apply_pch(pch, units, "gcc", "gcc")
+
+        def build():
+            state = BuildState.load(pch_dir / "state.json")
+            scheduler = JobScheduler(max_jobs=1, cwd=node_dir)
+            built = compile_translation_units(cc, "gcc", flags, [pch.unit], state, scheduler, cwd=node_dir)
+            return built, compile_translation_units(cc, "gcc", flags, units, state, scheduler, cwd=node_dir)
+
+        assert build() == (1, 1)
+        assert (pch_dir / "doracxx_pch.h.gch").exists()
+        assert build() == (0, 0)
+
+        # Changing a precompiled header rebuilds the PCH and its users
+        header = node_dir / "include" / "big.h"
+        header.write_text("#pragma once\n#include <vector>\ninline int big() { return 5; }\n")
+        future = time.time() + 2
+        os.utime(header, (future, future))
+        assert build() == (1, 1)
+
+    print("✓ Precompiled headers work correctly")
+
+
+TESTS = [
+    test_object_cache,
+    test_precompiled_header,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Object Cache Tests", TESTS))
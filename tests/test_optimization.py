@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+Tests for LTO/PGO flags and CPU variants
+"""
+
+import os
+import sys
+
+from helpers import compile_cxx, find_cxx, run_exe, run_tests, skipped, temp_dir
+
+
+def test_optimization_flags():
+    """Test LTO/PGO flag mapping and PGO profile tracking"""
+    print("[TEST] Testing optimization flags...")
+
+    from doracxx.config import DoracxxConfig, NodeConfig
+    from doracxx.optimization import node_optimization_flags, prepare_profile_data, PROFILE_STAMP
+
+    with temp_dir() as tmp:
+        profile_dir = tmp / "target" / "pgo" / "node"
+        config = DoracxxConfig(node=NodeConfig(name="node"))
+        config.build.lto = "thin"
+        config.build.pgo = "generate"
+
+        gcc = node_optimization_flags("gcc", "gcc", config, "release", profile_dir, "node")
+        assert gcc.compile == ["-O2", "-flto=auto", f"-fprofile-generate={profile_dir}"], gcc.compile
+        assert gcc.link == ["-flto=auto", f"-fprofile-generate={profile_dir}"], gcc.link
+
+        # the shared cxxbridge library is built without the node's profile
+        shared = node_optimization_flags("gcc", "gcc", config, "release", profile_dir, "node", pgo=False)
+        assert shared.compile == ["-O2", "-flto=auto"], shared.compile
+
+        clang = node_optimization_flags("gcc", "clang", config, "release", profile_dir, "node")
+        assert "-flto=thin" in clang.compile and "-flto=thin" in clang.link
+
+        config.build.pgo = "use"
+        msvc = node_optimization_flags("msvc", "msvc", config, "release", profile_dir, "node")
+        assert msvc.compile == ["/O2", "/GL"], msvc.compile
+        assert msvc.linker == ["/LTCG", f"/USEPROFILE:PGD={profile_dir / 'node.pgd'}"], msvc.linker
+
+        # an explicit -O level in cxxflags wins over the release default
+        config.build.cxxflags = ["-O3"]
+        assert "-O2" not in node_optimization_flags("gcc", "gcc", config, "release", profile_dir, "node").compile
+
+        # new gcc profile data refreshes the stamp that units depend on
+        assert prepare_profile_data("use", "gcc", "g++", profile_dir, "node", tmp / "node") is None
+        (profile_dir / "main.cc.gcda").write_bytes(b"")
+        stamp = prepare_profile_data("use", "gcc", "g++", profile_dir, "node", tmp / "node")
+        assert stamp == profile_dir / PROFILE_STAMP and stamp.exists()
+
+    print("✓ Optimization flags work correctly")
+
+
+def test_cpu_variants():
+    """Test CPU flag mapping and the variant launcher"""
+    print("[TEST] Testing CPU variants...")
+
+    from doracxx.cpu import cpu_flags, arrow_simd_level, order_variants, render_launcher, variant_name
+
+    assert cpu_flags("gcc", "gcc", "x86-64-v3") == ["-march=x86-64-v3"]
+    assert cpu_flags("gcc", "clang", "cortex-a78") == ["-mcpu=cortex-a78"]
+    assert cpu_flags("msvc", "msvc", "x86-64-v4") == ["/arch:AVX512"]
+    assert cpu_flags("msvc", "clang-cl", "x86-64-v3") == ["/clang:-march=x86-64-v3"]
+    assert order_variants(["x86-64-v3", "x86-64", "armv8.2-a"], "x86_64") == ["x86-64", "x86-64-v3"]
+    assert arrow_simd_level(["x86-64-v3", "x86-64-v2"]) == "SSE4_2"
+    assert arrow_simd_level(["native"]) is None
+    assert variant_name("node", "armv8.2-a+dotprod") == "node-armv8.2-a_dotprod"
+
+    cc = find_cxx(gcc_only=True)
+    if not cc or os.name == "nt" or os.uname().machine != "x86_64":
+        return skipped("launcher run needs g++ on x86_64")
+
+    with temp_dir() as tmp:
+        variants = ["x86-64", "x86-64-v2"]
+        for variant in variants:
+            script = tmp / variant_name("node", variant)
+            script.write_text(f'#!/bin/sh\necho {variant} "$@"\n')
+            script.chmod(0o755)
+        launcher = compile_cxx(cc, tmp, "node", source_text=render_launcher("node", variants, "gcc", "x86_64"))
+
+        env = dict(os.environ, DORACXX_CPU_VARIANT="x86-64")
+        out = run_exe(launcher, "a b", env=env)
+        assert out.stdout.strip() == "x86-64 a b", out.stdout
+        out = run_exe(launcher)
+        assert out.stdout.strip() in variants, out.stdout
+
+        # every psABI level is detected as GCC itself does; v3 needs lzcnt, movbe and f16c
+        levels = ["x86-64", "x86-64-v2", "x86-64-v3", "x86-64-v4"]
+        source = render_launcher("node", levels, "gcc", "x86_64")
+        assert "cpu_has(0x80000001, 2, 5)" in source and "cpu_has(0x1, 2, 22)" in source
+        assert "cpu_has(0x1, 2, 29)" in source and "cpu_has(0x1, 2, 13)" in source
+        for variant in levels[2:]:
+            script = tmp / variant_name("node", variant)
+            script.write_text(f'#!/bin/sh\necho {variant}\n')
+            script.chmod(0o755)
+        launcher = compile_cxx(cc, tmp, "node", source_text=source, flags=["-Wextra", "-Werror"])
+        gcc_level = compile_cxx(cc, tmp, "level", source_text="""
+#include <cstdio>
+int main() {
+    __builtin_cpu_init();
+    const char* level = __builtin_cpu_supports("x86-64-v4") ? "x86-64-v4" : __builtin_cpu_supports("x86-64-v3")
+        ? "x86-64-v3" : __builtin_cpu_supports("x86-64-v2") ? "x86-64-v2" : "x86-64";
+    std::puts(level);
+}
+""")
+        assert run_exe(launcher).stdout.strip() == run_exe(gcc_level).stdout.strip()
+
+    print("✓ CPU variants work correctly")
+
+
+TESTS = [
+    test_optimization_flags,
+    test_cpu_variants,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Optimization Tests", TESTS))
@@ -0,0 +1,315 @@
+#!/usr/bin/env python3
+"""
+Tests for Dora/Arrow preparation: git mirrors, the prepare graph, artifacts and Arrow components
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+import time
+from pathlib import Path
+from unittest import mock
+
+from helpers import run_tests, skipped, temp_dir, write_files
+
+
+def test_git_mirror():
+    """Test shallow checkouts sharing one bare mirror"""
+    print("[TEST] Testing git mirror checkouts...")
+
+    from doracxx.git_mirror import checkout, is_commit_hash, mirror_path
+
+    if not shutil.which("git"):
+        return skipped("needs git")
+
+    def git(*args, cwd):
+        return subprocess.run(["git", "-c", "user.name=t", "-c", "user.email=t@t", *args], cwd=cwd,
+                              check=True, capture_output=True, text=True).stdout.strip()
+
+    with temp_dir() as tmp:
+        origin = tmp / "origin"
+        origin.mkdir()
+        git("init", "-q", "-b", "main", cwd=origin)
+        (origin / "version.txt").write_text("1\n")
+        git("add", "version.txt", cwd=origin)
+        git("commit", "-qm", "one", cwd=origin)
+        git("tag", "v1", cwd=origin)
+        first = git("rev-parse", "HEAD", cwd=origin)
+        (origin / "version.txt").write_text("2\n")
+        git("commit", "-qam", "two", cwd=origin)
+        assert is_commit_hash(first) and not is_commit_hash(first[:8]) and not is_commit_hash("main")
+
+        url = origin.as_uri()
+        mirrors = tmp / "mirrors"
+        tagged = checkout(url, tmp / "dep-v1", "v1", mirrors)
+        latest = checkout(url, tmp / "dep-main", None, mirrors)
+        pinned = checkout(url, tmp / "dep-pinned", first, mirrors)
+        assert (tagged / "version.txt").read_text() == "1\n"
+        assert (latest / "version.txt").read_text() == "2\n"
+        assert git("rev-parse", "HEAD", cwd=pinned) == first
+
+        # One mirror holds the objects, the checkouts are worktrees of it fetched at depth 1
+        mirror = mirror_path(url, mirrors)
+        assert [p.name for p in mirrors.iterdir() if p.is_dir()] == [mirror.name]
+        assert (tagged / ".git").is_file() and (latest / ".git").is_file()
+        assert (mirror / "shallow").exists()
+
+        # Abbreviated hashes cannot be fetched directly and fall back to the branches
+        short = checkout(url, tmp / "dep-short", first[:10], mirrors)
+        assert git("rev-parse", "HEAD", cwd=short) == first
+
+        # Existing checkouts move to the requested revision
+        checkout(url, tagged, "main", mirrors)
+        assert (tagged / "version.txt").read_text() == "2\n"
+
+        # A deleted checkout is pruned from the mirror and can be made again
+        shutil.rmtree(latest)
+        checkout(url, latest, None, mirrors)
+        assert (latest / "version.txt").read_text() == "2\n"
+
+        # Anything else in the way is reported instead of being built from
+        (tmp / "not-a-checkout" / "install").mkdir(parents=True)
+        try:
+            checkout(url, tmp / "not-a-checkout", None, mirrors)
+            raise AssertionError("checkout over a non-checkout directory should fail")
+        except RuntimeError:
+            pass
+
+    print("✓ Git mirror checkouts work correctly")
+
+
+def test_prepare_graph():
+    """Test concurrent preparation: ordering, job shares, failures and cache locks"""
+    print("[TEST] Testing prepare graph...")
+
+    import threading
+    from doracxx.cache import cache_lock
+    from doracxx.prepare import PrepareGraph
+
+    # Independent builds overlap and split the budget; later tasks see earlier results
+    started = {}
+    both_running = threading.Barrier(2, timeout=5)
+
+    def build(name):
+        def run(jobs):
+            started[name] = jobs
+            both_running.wait()
+            return name
+        return run
+
+    graph = PrepareGraph(jobs=8)
+    graph.add("dora", build("dora"), builds=True)
+    graph.add("arrow", build("arrow"), builds=True)
+    graph.add("headers", lambda jobs: (started["dora"], jobs), after=["dora", "arrow"])
+    results = graph.run()
+    assert started == {"dora": 4, "arrow": 4}, started
+    assert results == {"dora": "dora", "arrow": "arrow", "headers": (4, 1)}, results
+
+    # A failure is raised and the tasks after it never run
+    ran = []
+    graph = PrepareGraph(jobs=2)
+    graph.add("fetch", lambda jobs: (_ for _ in ()).throw(RuntimeError("no network")))
+    graph.add("build", lambda jobs: ran.append("build"), after=["fetch"])
+    try:
+        graph.run()
+        assert False, "expected the fetch failure"
+    except RuntimeError as e:
+        assert str(e) == "no network"
+    assert ran == []
+
+    graph = PrepareGraph()
+    graph.add("a", lambda jobs: None, after=["b"])
+    graph.add("b", lambda jobs: None, after=["a"])
+    try:
+        graph.run()
+        assert False, "expected a cycle error"
+    except ValueError as e:
+        assert "cycle" in str(e)
+
+    # Cache locks exclude other threads too
+    with temp_dir() as tmp:
+        entry = tmp / "dora-v1"
+        inside = []
+        holders = []
+
+        def prepare_entry():
+            with cache_lock(entry):
+                inside.append(1)
+                holders.append(len(inside))
+                time.sleep(0.05)
+                inside.pop()
+
+        threads = [threading.Thread(target=prepare_entry) for _ in range(3)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        assert holders == [1, 1, 1], holders
+        assert (tmp / "dora-v1.lock").exists()
+
+    print("✓ Prepare graph works correctly")
+
+
+def test_artifact_store():
+    """Test prebuilt install archives: names, local archives and a filesystem remote"""
+    print("[TEST] Testing artifact store...")
+
+    from doracxx.artifacts import ArtifactStore, artifact_name
+    from doracxx.config import load_config, validate_config
+
+    name = artifact_name("arrow", commit="abc", options=["-DARROW_CSV=ON"], compiler="g++ 12")
+    assert name.startswith("arrow-") and name == artifact_name("arrow", compiler="g++ 12", commit="abc",
+                                                                options=["-DARROW_CSV=ON"])
+    assert name != artifact_name("arrow", commit="abc", options=["-DARROW_CSV=OFF"], compiler="g++ 12")
+    assert name != artifact_name("arrow", commit="abd", options=["-DARROW_CSV=ON"], compiler="g++ 12")
+
+    with temp_dir() as tmp:
+        install = write_files(tmp / "arrow-15" / "install", {"include/arrow/api.h": "#pragma once\n"})
+        (install / "lib").mkdir()
+        (install / "lib" / "libarrow.so.1500").write_bytes(b"ELF")
+        if os.name != "nt":
+            os.symlink("libarrow.so.1500", install / "lib" / "libarrow.so")
+
+        remote = tmp / "remote"
+        builder = ArtifactStore(str(remote), push=True, local_dir=tmp / "builder")
+        builder.save(name, install)
+        assert (tmp / "builder" / f"{name}.tar.gz").exists()
+        assert (remote / f"{name}.tar.gz").exists()
+
+        # A fresh machine pulls from the remote, over a partial install
+        fresh = tmp / "fresh" / "install"
+        (fresh / "lib").mkdir(parents=True)
+        (fresh / "lib" / "partial.o").write_bytes(b"")
+        consumer = ArtifactStore(remote.as_uri(), local_dir=tmp / "consumer")
+        assert consumer.restore(name, fresh)
+        assert (fresh / "include" / "arrow" / "api.h").read_text() == "#pragma once\n"
+        assert not (fresh / "lib" / "partial.o").exists()
+        if os.name != "nt":
+            assert os.readlink(fresh / "lib" / "libarrow.so") == "libarrow.so.1500"
+        assert (tmp / "consumer" / f"{name}.tar.gz").exists()
+
+        # Without push nothing is uploaded; unknown archives and disabled stores restore nothing
+        ArtifactStore(str(remote), local_dir=tmp / "other").save("dependency-x", install)
+        assert not (remote / "dependency-x.tar.gz").exists()
+        assert not consumer.restore("arrow-missing", tmp / "missing")
+        assert not ArtifactStore(enabled=False, local_dir=tmp / "builder").restore(name, tmp / "off")
+
+        (tmp / "doracxx.toml").write_text('[node]\nname = "n"\n[artifacts]\nremote = "ftp://cache"\npush = true\n')
+        config = load_config(tmp / "doracxx.toml")
+        assert config.artifacts.enabled and config.artifacts.push
+        assert any("artifacts remote" in w for w in validate_config(config))
+
+    print("✓ Artifact store works correctly")
+
+
+def test_arrow_components():
+    """Test Arrow component selection: CMake options, install names and linked libraries"""
+    print("[TEST] Testing Arrow components...")
+
+    from doracxx.build_cxx_node import find_arrow_artifacts
+    from doracxx.cache import arrow_install_name
+    from doracxx.config import load_config, validate_config, resolve_arrow_components, DEFAULT_ARROW_COMPONENTS
+    from doracxx.prepare_arrow import arrow_cmake_options
+
+    assert resolve_arrow_components() == sorted(DEFAULT_ARROW_COMPONENTS)
+    assert resolve_arrow_components(["dataset"]) == ["acero", "compute", "dataset", "filesystem"]
+    options = arrow_cmake_options("release", components=["parquet", "zstd"])
+    assert "-DARROW_PARQUET=ON" in options and "-DARROW_IPC=ON" in options and "-DARROW_WITH_ZSTD=ON" in options
+    assert "-DARROW_CSV=OFF" in options and "-DARROW_WITH_LZ4=OFF" in options
+    assert arrow_cmake_options("release") == arrow_cmake_options("release", components=list(DEFAULT_ARROW_COMPONENTS))
+
+    # The default set keeps the regular install; any other set gets its own
+    assert arrow_install_name(components=list(reversed(DEFAULT_ARROW_COMPONENTS))) == "install"
+    assert arrow_install_name(components=["compute"]) != "install"
+    assert arrow_install_name(components=["compute"]) == arrow_install_name(components=["compute", "compute"])
+
+    with temp_dir() as tmp:
+        lib = tmp / "install" / "lib"
+        lib.mkdir(parents=True)
+        for name in ["arrow_bundled_dependencies", "arrow", "arrow_acero", "parquet"]:
+            (lib / f"lib{name}.a").write_bytes(b"!<arch>\n")
+
+        assert find_arrow_artifacts(tmp / "install", ["compute"])[2] == ["arrow", "arrow_bundled_dependencies"]
+        assert find_arrow_artifacts(tmp / "install", ["parquet", "acero"])[2] == [
+            "parquet", "arrow_acero", "arrow", "arrow_bundled_dependencies"]
+        assert find_arrow_artifacts(tmp / "install")[2] == [
+            "parquet", "arrow_acero", "arrow", "arrow_bundled_dependencies"]
+
+        (tmp / "doracxx.toml").write_text('[node]\nname = "n"\n[arrow]\ncomponents = ["parquet", "orc"]\n')
+        config = load_config(tmp / "doracxx.toml")
+        assert config.arrow.components == ["parquet", "orc"]
+        assert any("orc" in w for w in validate_config(config))
+
+    print("✓ Arrow components work correctly")
+
+
+def test_arrow_restore_then_build():
+    """Test building an Arrow flavour in a cache entry another flavour was restored into"""
+    print("[TEST] Testing Arrow restore then build...")
+
+    from doracxx.artifacts import ArtifactStore
+    from doracxx.build_cxx_node import ensure_arrow_prepared
+    from doracxx.cache import get_arrow_cache_path
+    from doracxx.prepare_arrow import arrow_artifact_name
+
+    if not shutil.which("git"):
+        return skipped("needs git")
+
+    def git(*args, cwd):
+        return subprocess.run(["git", "-c", "user.name=t", "-c", "user.email=t@t", *args], cwd=cwd,
+                              check=True, capture_output=True, text=True).stdout.strip()
+
+    def fake_install(install):
+        write_files(install, {f"include/arrow/{h}": "#pragma once\n" for h in ["api.h", "array.h", "buffer.h", "type.h"]})
+        (install / "lib").mkdir(exist_ok=True)
+        (install / "lib" / "libarrow.a").write_bytes(b"!<arch>\n")
+        return install
+
+    built = []
+
+    def fake_build(repo, profile, install_dir, linkage="static", **kwargs):
+        assert (repo / "cpp" / "CMakeLists.txt").exists(), f"no Arrow source in {repo}"
+        built.append(install_dir.name)
+        fake_install(install_dir)
+        return True
+
+    with temp_dir() as tmp, mock.patch.dict(os.environ, {"HOME": str(tmp / "home")}):
+        (tmp / "home").mkdir()
+        origin = write_files(tmp / "arrow", {"cpp/CMakeLists.txt": "project(arrow)\n"})
+        git("init", "-q", "-b", "main", cwd=origin)
+        git("add", ".", cwd=origin)
+        git("commit", "-qm", "arrow", cwd=origin)
+        commit = git("rev-parse", "HEAD", cwd=origin)
+        url = origin.as_uri()
+
+        store = ArtifactStore(str(tmp / "remote"), push=True, local_dir=tmp / "artifacts")
+        store.save(arrow_artifact_name(commit, "release"), fake_install(tmp / "prebuilt"))
+
+        with mock.patch("doracxx.prepare_arrow.build_arrow_cpp", fake_build):
+            # The default flavour comes from the store, so the entry holds an install and no checkout
+            restored = ensure_arrow_prepared(url, "main", "release", artifacts=store)
+            assert not built and (Path(restored) / "lib" / "libarrow.a").exists()
+
+            # Another flavour of the same revision still has a source tree to build from
+            other = ensure_arrow_prepared(url, "main", "release", artifacts=store, components=["compute"])
+            assert built == [Path(other).name] and Path(other) != Path(restored)
+
+        vendor = get_arrow_cache_path(url, "main", "static")
+        assert vendor.is_relative_to(tmp / "home")
+        assert git("rev-parse", "HEAD", cwd=vendor / "src") == commit
+
+    print("✓ Arrow restore then build works correctly")
+
+
+TESTS = [
+    test_git_mirror,
+    test_prepare_graph,
+    test_artifact_store,
+    test_arrow_components,
+    test_arrow_restore_then_build,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Preparation Tests", TESTS))
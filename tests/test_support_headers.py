@@ -0,0 +1,429 @@
+#!/usr/bin/env python3
+"""
+Tests for the support headers shipped into target/<profile>/deps and the node templates
+"""
+
+import os
+import sys
+
+from helpers import compile_cxx, find_cxx, find_eigen, run_exe, run_tests, skipped, temp_dir
+
+
+def test_worker_pool_template():
+    """Test the worker-pool node template and its ordered output handoff"""
+    print("[TEST] Testing worker-pool template...")
+
+    from doracxx.config import load_config
+    from doracxx.templates import create_node
+
+    with temp_dir() as tmp:
+        written = create_node(tmp / "pool-node", "worker-pool")
+        assert (tmp / "pool-node" / "src" / "node.cc") in written
+        config = load_config(tmp / "pool-node" / "doracxx.toml")
+        assert config.node.name == "pool-node"
+        assert config.build.include_dirs == ["include"]
+        try:
+            create_node(tmp / "pool-node", "worker-pool")
+            assert False, "existing files were overwritten"
+        except FileExistsError:
+            pass
+
+        cc = find_cxx(gcc_only=True)
+        if not cc:
+            return skipped("pool run needs g++")
+
+        exe = compile_cxx(cc, tmp, "pool", flags=["-O2"], source_text="""
+#include "doracxx_worker_pool.h"
+#include <cstdio>
+int main() {
+    doracxx::workers::WorkerPool<int, int> pool([](int& x) { return x * 2; }, 4, 8);
+    int expected = 0;
+    auto sink = [&](int& y) { if (y != expected * 2) { std::printf("out of order\\n"); std::exit(1); } ++expected; };
+    for (int i = 0; i < 10000; ++i) pool.submit(i, sink);
+    pool.drain(sink);
+    std::printf("%d\\n", expected);
+}
+""")
+        out = run_exe(exe)
+        assert out.stdout.strip() == "10000", out.stdout
+
+    print("✓ Worker-pool template works correctly")
+
+
+def test_async_support_header():
+    """Test that the coroutine runtime header is only shipped to C++20 nodes"""
+    print("[TEST] Testing async support header...")
+
+    from doracxx.build_cxx_node import cxx_standard_year, install_support_headers
+    from doracxx.config import load_config
+    from doracxx.templates import create_node
+
+    assert cxx_standard_year("c++17") == 2017
+    assert cxx_standard_year("gnu++2a") == 2020
+    assert cxx_standard_year("c++latest") == 9999
+    assert cxx_standard_year(None) == 2017
+
+    with temp_dir() as tmp:
+        deps = tmp / "deps"
+        deps.mkdir()
+        install_support_headers(deps, "c++20")
+        assert (deps / "doracxx_async.h").exists()
+        install_support_headers(deps, "c++17")
+        assert not (deps / "doracxx_async.h").exists()
+        assert (deps / "doracxx_worker_pool.h").exists()
+
+        create_node(tmp / "async-node", "async")
+        assert load_config(tmp / "async-node" / "doracxx.toml").build.std == "c++20"
+
+        cc = find_cxx(gcc_only=True)
+        if not cc:
+            return skipped("coroutine node run needs g++")
+
+        # the template node, against the stand-in Dora API: every input is
+        # handled in its own task and echoed back
+        exe = compile_cxx(cc, tmp, "async", [tmp / "async-node" / "src" / "node.cc"], std="c++20", stub=True)
+        out = run_exe(exe, env={**os.environ, "DORA_STUB_INPUTS": "aaaa,bbbb,cccc,dddd,eeee"})
+        assert "[stub] sent 5 outputs, 20 bytes" in out.stderr, out.stderr
+
+        exe = compile_cxx(cc, tmp, "runtime", std="c++20", stub=True, source_text="""
+#include "dora-node-api.h"
+#include "doracxx_async.h"
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace doracxx::async;
+static size_t total(std::vector<int> values, std::unique_ptr<int> scale) {
+    return values.size() * size_t(*scale);
+}
+Task<> ticker(NodeRuntime& rt, std::string& order) {
+    for (int i = 0; i < 3; ++i) {
+        co_await rt.sleep_for(std::chrono::milliseconds(5));
+        order += "t";
+    }
+}
+Task<> main_task(NodeRuntime& rt, std::string& order) {
+    int events = 0;
+    while (auto event = co_await rt.next_event()) {
+        if (event_type(*event) == DoraEventType::Input) ++events;
+    }
+    rt.spawn(ticker(rt, order));
+    std::vector<int> values(1000, 1);
+    const size_t sum = co_await rt.run_in_thread(total, std::move(values), std::make_unique<int>(2));
+    co_await rt.run_in_thread([&] { std::this_thread::sleep_for(std::chrono::milliseconds(200)); order += "w"; });
+    std::string error;
+    try {
+        co_await rt.run_in_thread([] { throw std::runtime_error("boom"); });
+    } catch (const std::runtime_error& e) {
+        error = e.what();
+    }
+    co_await rt.drain();
+    std::printf("%d %zu %zu %s %s\\n", events, values.size(), sum, error.c_str(), order.c_str());
+}
+int main() {
+    auto node = init_dora_node();
+    std::string order;
+    NodeRuntime rt(*node.events);
+    rt.run(main_task(rt, order));
+}
+""")
+        # the ticker keeps running while the blocking call waits on its thread
+        out = run_exe(exe, env={**os.environ, "DORA_STUB_INPUTS": "a,b"})
+        assert out.stdout.split() == ["2", "0", "2000", "boom", "tttw"], out.stdout
+
+    print("✓ Async support header works correctly")
+
+
+def test_log_settings():
+    """Test the [log] section and the doracxx_log.h macros it configures"""
+    print("[TEST] Testing log settings...")
+
+    from doracxx.build_cxx_node import log_defines
+    from doracxx.config import load_config
+
+    assert log_defines("gcc", None, "debug") == ["-DDORACXX_LOG_LEVEL=1"]
+    assert log_defines("gcc", None, "release") == ["-DDORACXX_LOG_LEVEL=2"]
+
+    with temp_dir() as tmp:
+        (tmp / "doracxx.toml").write_text('[node]\nname = "n"\n[log]\nlevel = "warn"\nrate_limit = 5\n')
+        config = load_config(tmp / "doracxx.toml")
+        assert config.log.level == "warn" and config.log.queue_size == 4096
+        assert log_defines("msvc", config, "debug") == [
+            "/DDORACXX_LOG_LEVEL=3", "/DDORACXX_LOG_RATE=5", "/DDORACXX_LOG_QUEUE_SIZE=4096"]
+
+        cc = find_cxx(gcc_only=True)
+        if not cc:
+            return skipped("log run needs g++")
+
+        exe = compile_cxx(cc, tmp, "log", flags=["-O2", *log_defines("gcc", config, "debug")], source_text="""
+#include "doracxx_log.h"
+#include <cstdio>
+int evaluated = 0;
+int touch() { return ++evaluated; }
+int main() {
+    DORACXX_LOG_INFO("compiled out ", touch());
+    for (int i = 0; i < 20; ++i) DORACXX_LOG_WARN("warn ", i, " ", 0.5);
+    doracxx::log::flush();
+    std::printf("evaluated %d\\n", evaluated);
+}
+""")
+        out = run_exe(exe)
+        assert out.stdout.strip() == "evaluated 0", out.stdout
+        assert out.stderr.splitlines() == [f"[WARN] warn {i} 0.5" for i in range(5)], out.stderr
+
+    print("✓ Log settings work correctly")
+
+
+def test_metrics_settings():
+    """Test the [metrics] section and the doracxx_metrics.h histograms"""
+    print("[TEST] Testing metrics settings...")
+
+    from doracxx.build_cxx_node import metrics_defines
+    from doracxx.config import load_config
+
+    assert metrics_defines("gcc", None) == []
+
+    with temp_dir() as tmp:
+        (tmp / "doracxx.toml").write_text('[node]\nname = "n"\n[metrics]\nenabled = true\ninterval_ms = 250\n')
+        config = load_config(tmp / "doracxx.toml")
+        defines = metrics_defines("gcc", config)
+        assert defines == ["-DDORACXX_METRICS=1", "-DDORACXX_METRICS_INTERVAL_MS=250"]
+
+        cc = find_cxx(gcc_only=True)
+        if not cc:
+            return skipped("metrics run needs g++")
+
+        exe = compile_cxx(cc, tmp, "metrics", flags=["-O2", *defines], source_text="""
+#include "doracxx_metrics.h"
+#include <cstdio>
+int main() {
+    doracxx::metrics::Histogram histogram;
+    for (uint64_t v = 1; v <= 100000; ++v) histogram.record(v);
+    const double p99 = static_cast<double>(histogram.quantile(0.99));
+    if (p99 < 99000 || p99 > 99000 * 1.04) { std::printf("p99 %f\\n", p99); return 1; }
+    doracxx::metrics::Metrics metrics("n");
+    metrics.send("out", 3, [] { return 0; });
+    std::fputs(metrics.to_prometheus().c_str(), stdout);
+}
+""")
+        out = run_exe(exe)
+        assert 'doracxx_output_bytes_total{node="n",output="out"} 3' in out.stdout, out.stdout
+        assert 'doracxx_send_seconds_count{node="n",output="out"} 1' in out.stdout, out.stdout
+
+    print("✓ Metrics settings work correctly")
+
+
+def test_output_buffer():
+    """Test that doracxx_output_buffer.h recycles output buffers"""
+    print("[TEST] Testing output buffer pool...")
+
+    cc = find_cxx(gcc_only=True)
+    if not cc:
+        return skipped("needs g++")
+
+    with temp_dir() as tmp:
+        exe = compile_cxx(cc, tmp, "output", stub=True, source_text="""
+#include "dora-node-api.h"
+#include "doracxx_output_buffer.h"
+#include <cassert>
+#include <cstdio>
+int main() {
+    auto node = init_dora_node();
+    node.send_output->report = false;
+    doracxx::output::BufferPool pool;
+    const uint8_t* first = nullptr;
+    size_t bytes = 0;
+    for (int frame = 0; frame < 100; ++frame) {
+        auto buffer = pool.acquire(1 << 20);
+        assert(reinterpret_cast<uintptr_t>(buffer.data()) % 64 == 0);
+        buffer.as<float>()[0] = float(frame);
+        if (!first) first = buffer.data();
+        assert(buffer.data() == first);
+        assert(std::string(buffer.send(node.send_output, "image").error).empty());
+        assert(buffer.data() == nullptr);
+        bytes += node.send_output->sent.back().second.size();
+    }
+    auto small = pool.acquire(100);
+    small.append("abc", 3);
+    assert(small.size() == 103 && small.data()[101] == 'b');
+    small.resize(10000);
+    small.reset();
+    small.resize(64);
+    std::printf("%zu %zu %zu %zu\\n", pool.allocations(), pool.reuses(), node.send_output->sent.size(), bytes);
+}
+""")
+        out = run_exe(exe)
+        # one megabyte buffer for all 100 frames; the small buffer grows once
+        # and comes back from the pool after reset()
+        assert out.stdout.split() == ["3", "100", "100", str(100 << 20)], out.stdout
+
+    print("✓ Output buffer pool works correctly")
+
+
+def test_event_batch():
+    """Test doracxx_event_batch.h batching, latency budget and read-ahead bound"""
+    print("[TEST] Testing event batching...")
+
+    cc = find_cxx(gcc_only=True)
+    if not cc:
+        return skipped("needs g++")
+
+    with temp_dir() as tmp:
+        exe = compile_cxx(cc, tmp, "batch", stub=True, source_text="""
+#include "dora-node-api.h"
+#include "doracxx_event_batch.h"
+#include <cstdio>
+#include <string>
+using namespace doracxx::events;
+using namespace std::chrono;
+static std::string run(size_t events_count, microseconds interval, BatchOptions options, bool slow_node) {
+    Events events;
+    events.interval = interval;
+    for (size_t i = 0; i < events_count; ++i) events.input("in", {uint8_t(i)});
+    EventBatcher<Events> batcher(events, options);
+    const size_t read_ahead = options.read_ahead ? options.read_ahead : options.max_batch;
+    std::string sizes;
+    size_t handed = 0;
+    for (;;) {
+        if (slow_node) {
+            // the reader fills the queue meanwhile, but takes no more than the read-ahead
+            std::this_thread::sleep_for(milliseconds(20));
+            if (events.read - handed > read_ahead) return "read " + std::to_string(events.read - handed) + " ahead";
+        }
+        auto batch = batcher.next_batch();
+        if (batch.empty()) break;
+        handed += batch.size();
+        sizes += (sizes.empty() ? "" : ",") + std::to_string(batch.size());
+        if (event_type(batch.back()) == DoraEventType::AllInputsClosed) sizes += "!";
+    }
+    return sizes;
+}
+int main() {
+    BatchOptions options;
+    options.max_batch = 16;
+    // a node slower than its inputs gets full batches
+    std::printf("%s\\n", run(40, microseconds(0), options, true).c_str());
+    options.read_ahead = 40;
+    std::printf("%s\\n", run(40, microseconds(0), options, true).c_str());
+    // a batch waits for more events within the budget of its first one, and no longer
+    options = BatchOptions();
+    options.max_batch = 4;
+    options.latency_budget = seconds(2);
+    std::printf("%s\\n", run(8, milliseconds(5), options, false).c_str());
+    options.latency_budget = milliseconds(30);
+    std::printf("%s\\n", run(3, milliseconds(150), options, false).c_str());
+}
+""")
+        out = run_exe(exe).stdout.splitlines()
+        # 40 inputs and AllInputsClosed
+        assert out[0] == "16,16,9!", out
+        assert out[1] == "16,16,9!", out
+        assert out[2] == "4,4,1!", out
+        assert out[3] == "1,1,1,1!", out
+
+    print("✓ Event batching works correctly")
+
+
+def test_eigen_support():
+    """Test the Eigen defines and the doracxx_eigen.h tensor views"""
+    print("[TEST] Testing Eigen support...")
+
+    from doracxx.build_cxx_node import eigen_defines, uses_eigen
+    from doracxx.config import load_config
+
+    with temp_dir() as tmp:
+        (tmp / "doracxx.toml").write_text('[node]\nname = "n"\n[dependencies.linalg]\ntype = "git"\n'
+                                          'url = "https://gitlab.com/libeigen/eigen.git"\ntag = "3.4.0"\n')
+        config = load_config(tmp / "doracxx.toml")
+        assert uses_eigen(config) and not uses_eigen(None)
+        assert eigen_defines("gcc", config, "release") == ["-DEIGEN_NO_DEBUG"]
+        assert eigen_defines("msvc", config, "release") == ["/DEIGEN_NO_DEBUG"]
+        assert eigen_defines("gcc", config, "debug") == []
+
+        cc = find_cxx(gcc_only=True)
+        eigen = find_eigen()
+        if not cc or not eigen:
+            return skipped("tensor views need g++ and Eigen")
+
+        exe = compile_cxx(cc, tmp, "eigen", include_dirs=[eigen], source_text="""
+#include "doracxx_eigen.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+using namespace doracxx;
+int main() {
+    output::BufferPool pool;
+    auto sent = pool.acquire(eigen::tensor_bytes<float>(12));
+    auto m = eigen::write_tensor<float, Eigen::RowMajor>(sent, 4, 3);
+    for (int i = 0; i < 12; ++i) m.data()[i] = float(i);
+    std::vector<uint8_t> input(sent.data(), sent.data() + sent.size());
+
+    auto view = eigen::view_tensor<float, Eigen::RowMajor>(input);
+    auto wrong_type = eigen::view_tensor<double, Eigen::RowMajor>(input);
+    auto wrong_order = eigen::view_tensor<float, Eigen::ColMajor>(input);
+    auto out = pool.acquire(0);
+    eigen::write_tensor(out, view.matrix * Eigen::Vector3f(1, 1, 1));
+    auto sums = eigen::view_tensor<float, Eigen::ColMajor>(out);
+    auto raw = eigen::view_matrix<float, Eigen::ColMajor>(input.data() + 64, 48, 3, 4);
+    std::printf("%d %ld %ld %g\\n", view.ok(), long(view.rows()), long(view.cols()), view.matrix(1, 2));
+    std::printf("%s|%s\\n", wrong_type.error.c_str(), wrong_order.error.c_str());
+    std::printf("%d %ld %g %g\\n", sums.ok(), long(sums.rows()), sums.matrix(3, 0), raw.matrix(0, 1));
+
+    // malformed headers: an element count that overflows when multiplied by
+    // the element size, and more rows than Eigen::Index holds
+    eigen::TensorHeader header;
+    header.dtype = static_cast<uint8_t>(eigen::DType::F64);
+    header.ndim = 1;
+    header.dims[0] = (uint64_t(1) << 61) + 1;
+    std::vector<uint8_t> bad(sizeof(header) + 8);
+    std::memcpy(bad.data(), &header, sizeof(header));
+    auto overflow = eigen::view_tensor<double>(bad);
+    header.ndim = 2;
+    header.dims[0] = uint64_t(1) << 63;
+    header.dims[1] = 0;
+    std::memcpy(bad.data(), &header, sizeof(header));
+    bad.resize(sizeof(header));
+    auto too_many_rows = eigen::view_tensor<double>(bad);
+    auto huge = eigen::view_matrix<double>(bad.data(), 8, Eigen::Index(1) << 62, 4);
+    std::printf("%d %d %d %s|%s\\n", overflow.ok(), too_many_rows.ok(), huge.ok(), overflow.error.c_str(),
+                too_many_rows.error.c_str());
+
+    // an empty point cloud keeps its columns, and they are bounded on their own
+    auto cloud = pool.acquire(eigen::tensor_bytes<float>(0));
+    eigen::write_tensor<float, Eigen::RowMajor>(cloud, 0, 3);
+    auto empty = eigen::view_tensor<float, Eigen::RowMajor>(cloud);
+    header.dims[0] = 0;
+    header.dims[1] = uint64_t(1) << 63;
+    std::memcpy(bad.data(), &header, sizeof(header));
+    auto too_many_cols = eigen::view_tensor<double>(bad);
+    std::printf("%d %ld %ld %d %s\\n", empty.ok(), long(empty.rows()), long(empty.cols()), too_many_cols.ok(),
+                too_many_cols.error.c_str());
+}
+""")
+        out = run_exe(exe).stdout.splitlines()
+        assert out[0] == "1 4 3 5", out
+        assert out[1] == ("tensor holds f32 elements, not f64|"
+                          "tensor is row-major; view it with that storage order"), out
+        # row 3 is 9 + 10 + 11; the raw column-major view reads element 3 as (0, 1)
+        assert out[2] == "1 4 30 3", out
+        assert out[3] == ("0 0 0 tensor payload of 8 bytes does not match its shape|"
+                          "tensor has more rows or columns than Eigen::Index can hold"), out
+        assert out[4] == "1 0 3 0 tensor has more rows or columns than Eigen::Index can hold", out
+
+    print("✓ Eigen support works correctly")
+
+
+TESTS = [
+    test_worker_pool_template,
+    test_async_support_header,
+    test_log_settings,
+    test_metrics_settings,
+    test_output_buffer,
+    test_event_batch,
+    test_eigen_support,
+]
+
+
+if __name__ == "__main__":
+    sys.exit(run_tests("doracxx Support Header Tests", TESTS))